@@ -0,0 +1,295 @@
+//
+//  MYASN1Benchmark.m
+//  MYCrypto
+//
+//  Created by Jens Alfke on 10/16/26.
+//  Copyright 2026 Jens Alfke. All rights reserved.
+//
+
+// Throughput benchmarks and a round-trip fuzz test for the ASN.1 layer (MYBERParser,
+// MYDEREncoder, MYOID, MYASN1Tree, MYX509Decoder).
+//
+// The fuzz test runs as an ordinary test case, mutating a corpus of certificates with a fixed
+// random seed. For coverage-guided fuzzing, compile this file and the ASN.1 sources with
+// libFuzzer and MYCRYPTO_LIBFUZZER defined, e.g.:
+//     clang -g -O1 -fobjc-arc -fsanitize=fuzzer,address -DMYCRYPTO_LIBFUZZER -DDEBUG=1 \
+//           MYASN1Benchmark.m MYBERParser.m MYDEREncoder.m MYASN1Object.m MYASN1Tree.m \
+//           MYASN1Time.m MYOID.m MYX509Decoder.m <MYUtilities sources> -framework Foundation
+//     ./a.out Tests/
+
+#import "MYBERParser.h"
+#import "MYDEREncoder.h"
+#import "MYASN1Object.h"
+#import "MYASN1Tree.h"
+#import "MYOID.h"
+#import "MYX509Decoder.h"
+#import "Test.h"
+
+#if !TARGET_OS_IPHONE
+#import <malloc/malloc.h>
+#endif
+
+
+#if DEBUG
+
+
+#pragma mark - ROUND-TRIP CHECK:
+
+
+/* Runs arbitrary input through every ASN.1 entry point, checking that they agree with each
+   other, and that parse->encode is stable after one round. Returns NO if the input
+   didn't parse; raises an assertion failure if any of the checks fail. */
+static BOOL roundTrip (const uint8_t *bytes, size_t length) {
+    NSData *input = [[NSData alloc] initWithBytesNoCopy: (void*)bytes length: length
+                                           freeWhenDone: NO];
+    // These have to handle any input without crashing, but their results aren't checked:
+    (void)MYBERGetLength(input, NULL);
+    MYX509Fields fields;
+    (void)MYX509DecodeCertificate(bytes, length, &fields, NULL);
+
+    id parsed = MYBERParse(input, NULL);
+    MYASN1Tree *tree = [[MYASN1Tree alloc] initWithBERData: input error: NULL];
+    if (!parsed)
+        return NO;
+    if (tree)
+        AssertEqual(tree.rootObject, parsed);
+
+    NSData *encoded = [MYDEREncoder encodeRootObject: parsed error: NULL];
+    if (!encoded)
+        return YES;     // Not everything parseable is encodable, e.g. dates outside 1..9999
+    id reparsed = MYBERParse(encoded, NULL);
+    Assert(reparsed, @"Couldn't re-parse encoder output %@", encoded);
+    // The first encoding may normalize the input (BER -> DER, fractional seconds, etc.)
+    // but after that the round trip must be lossless. (Not byte-for-byte, though, since the
+    // encoder writes SET items in whatever order NSSet enumerates them.)
+    NSData *reencoded = [MYDEREncoder encodeRootObject: reparsed error: NULL];
+    AssertEq(reencoded.length, encoded.length);
+    AssertEqual(MYBERParse(reencoded, NULL), reparsed);
+    return YES;
+}
+
+
+#ifdef MYCRYPTO_LIBFUZZER
+int LLVMFuzzerTestOneInput (const uint8_t *data, size_t size);
+
+int LLVMFuzzerTestOneInput (const uint8_t *data, size_t size) {
+    @autoreleasepool {
+        roundTrip(data, size);
+    }
+    return 0;
+}
+#endif
+
+
+#pragma mark - CORPUS:
+
+
+/* Builds a certificate-shaped value with the given number of name attributes and extensions,
+   and a key and signature of the given size. It's not signed properly, but it's valid DER. */
+static NSData* generateCert (unsigned nameCount, unsigned extensionCount, unsigned keyBytes) {
+    NSMutableArray *name = [NSMutableArray array];
+    for (unsigned i=0; i<nameCount; i++) {
+        MYOID *oid = [MYOID OIDWithKnownID: (i % 2) ? kMYOIDCommonName : kMYOIDDescription];
+        NSString *value = [NSString stringWithFormat: @"Attribute number %u", i];
+        [name addObject: [NSSet setWithObject: @[oid, value]]];
+    }
+    NSMutableArray *extensions = [NSMutableArray array];
+    for (unsigned i=0; i<extensionCount; i++) {
+        UInt32 components[] = {1, 3, 6, 1, 4, 1, 99999, i};
+        MYOID *oid = [[MYOID alloc] initWithComponents: components count: 8];
+        NSData *value = [MYDEREncoder encodeRootObject: @[@(i), @"extension value", $true]
+                                                 error: NULL];
+        [extensions addObject: @[oid, $false, value]];
+    }
+    NSMutableData *key = [NSMutableData dataWithLength: keyBytes];
+    for (unsigned i=0; i<keyBytes; i++)
+        ((uint8_t*)key.mutableBytes)[i] = (uint8_t)(i * 151 + 17);
+    MYOID *rsa = [MYOID OIDWithKnownID: kMYOIDRSAEncryption];
+    MYOID *sha256 = [MYOID OIDWithKnownID: kMYOIDRSAWithSHA256];
+    NSDate *from = [NSDate dateWithTimeIntervalSince1970: 1243900800];
+    NSArray *info = @[
+        [[MYASN1Object alloc] initWithTag: 0 ofClass: 2 components: @[@2]],
+        @(0x1234567),
+        @[sha256, [NSNull null]],
+        name,
+        @[from, [from dateByAddingTimeInterval: 365*86400]],
+        name,
+        @[ @[rsa, [NSNull null]], [MYBitString bitStringWithData: key] ],
+        [[MYASN1Object alloc] initWithTag: 3 ofClass: 2 components: @[extensions]],
+    ];
+    NSArray *cert = @[info, @[sha256, [NSNull null]], [MYBitString bitStringWithData: key]];
+    return [MYDEREncoder encodeRootObject: cert error: NULL];
+}
+
+/* The test certificates, plus generated ones ranging from tiny to ~100KB. */
+static NSDictionary* corpus (void) {
+    NSMutableDictionary *corpus = [NSMutableDictionary dictionary];
+    for (NSString *filename in @[@"selfsigned.cer", @"selfsigned_email.cer",
+                                 @"iphonedev.cer", @"generated.cer"]) {
+        NSData *cert = [NSData dataWithContentsOfFile: filename];
+        CAssert(cert, @"Couldn't read %@", filename);
+        corpus[filename] = cert;
+    }
+    corpus[@"gen-small"]  = generateCert(1, 0, 64);
+    corpus[@"gen-medium"] = generateCert(8, 16, 256);
+    corpus[@"gen-large"]  = generateCert(32, 256, 512);
+    corpus[@"gen-huge"]   = generateCert(64, 2048, 4096);
+    return corpus;
+}
+
+
+#pragma mark - BENCHMARKS:
+
+
+#if !TARGET_OS_IPHONE
+static size_t mallocBlocksInUse(void) {
+    malloc_statistics_t stats;
+    malloc_zone_statistics(NULL, &stats);
+    return stats.blocks_in_use;
+}
+#else
+static size_t mallocBlocksInUse(void) {return 0;}
+#endif
+
+
+/* Times `iterations` calls of the block, and counts the heap blocks allocated by one call
+   (including autoreleased ones, which are still alive when it's measured.) */
+static void measure (int iterations, double *outSeconds, size_t *outAllocs, void (^block)(void)) {
+    @autoreleasepool {
+        size_t before = mallocBlocksInUse();
+        block();
+        *outAllocs = mallocBlocksInUse() - before;
+    }
+    CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+    for (int i=0; i<iterations; i++) {
+        @autoreleasepool {
+            block();
+        }
+    }
+    *outSeconds = (CFAbsoluteTimeGetCurrent() - start) / iterations;
+}
+
+static void report (NSString *what, NSString *name, size_t bytes, size_t objects,
+                    double seconds, size_t allocs)
+{
+    Log(@"%-14s %-20s %8.1f MB/s  %7.1f ns/object  %5.2f allocs/object",
+        what.UTF8String, name.UTF8String,
+        bytes / seconds / 1e6, seconds / objects * 1e9, (double)allocs / objects);
+}
+
+
+TestCase(ASN1Benchmark) {
+    RequireTestCase(EncodeCert);
+    RequireTestCase(MYASN1Tree);
+    NSDictionary *certs = corpus();
+    for (NSString *name in [certs.allKeys sortedArrayUsingSelector: @selector(compare:)]) {
+        NSData *cert = certs[name];
+        size_t bytes = cert.length;
+        MYASN1Tree *tree = [[MYASN1Tree alloc] initWithBERData: cert error: NULL];
+        CAssert(tree, @"Couldn't parse %@", name);
+        size_t objects = tree.nodeCount;
+        int iterations = (int)MAX(10u, 20000000 / bytes);
+        double seconds;
+        size_t allocs;
+
+        __block id root = nil;
+        measure(iterations, &seconds, &allocs, ^{ root = MYBERParse(cert, NULL); });
+        report(@"MYBERParse", name, bytes, objects, seconds, allocs);
+
+        measure(iterations, &seconds, &allocs, ^{
+            (void)[[MYASN1Tree alloc] initWithBERData: cert error: NULL];
+        });
+        report(@"MYASN1Tree", name, bytes, objects, seconds, allocs);
+
+        measure(iterations, &seconds, &allocs, ^{ MYBERGetLength(cert, NULL); });
+        report(@"MYBERGetLength", name, bytes, 1, seconds, allocs);
+
+        measure(iterations, &seconds, &allocs, ^{
+            (void)[MYDEREncoder encodeRootObject: root error: NULL];
+        });
+        report(@"MYDEREncoder", name, bytes, objects, seconds, allocs);
+
+        // Collect the certificate's OIDs and time decoding them:
+        NSMutableArray *oids = [NSMutableArray array];
+        size_t oidBytes = 0;
+        for (MYASN1NodeIndex i=0; i<tree.nodeCount; i++) {
+            const MYASN1Node *node = [tree nodeAtIndex: i];
+            if (node->tag == 6 && node->flags == 0) {
+                [oids addObject: [tree contentsOfNode: i]];
+                oidBytes += node->length;
+            }
+        }
+        measure(iterations, &seconds, &allocs, ^{
+            for (NSData *oid in oids)
+                (void)[[MYOID alloc] initWithBEREncoding: oid];
+        });
+        report(@"MYOID", name, oidBytes, oids.count, seconds, allocs);
+    }
+}
+
+
+#pragma mark - FUZZ TEST:
+
+
+TestCase(ASN1Fuzz) {
+    RequireTestCase(EncodeCert);
+    RequireTestCase(MYASN1Tree);
+    RequireTestCase(X509Decoder);
+    static const int kMutationsPerInput = 2000;
+    srandom(12345);
+    int parsed = 0, total = 0;
+    NSDictionary *certs = corpus();
+    for (NSString *name in [certs.allKeys sortedArrayUsingSelector: @selector(compare:)]) {
+        NSData *cert = certs[name];
+        CAssert(roundTrip(cert.bytes, cert.length));
+        if (cert.length > 10000)
+            continue;
+        NSMutableData *mutant = [cert mutableCopy];
+        for (int i=0; i<kMutationsPerInput; i++) {
+            @autoreleasepool {
+                uint8_t *bytes = mutant.mutableBytes;
+                // Flip a few bytes, biased toward the start where the headers are dense:
+                int nChanges = 1 + (int)(random() % 4);
+                for (int c=0; c<nChanges; c++) {
+                    size_t pos = random() % mutant.length;
+                    if (random() % 2)
+                        pos %= 64;
+                    bytes[pos] = (random() % 3) ? (uint8_t)random() : bytes[pos] ^ 0x80;
+                }
+                size_t length = mutant.length - (random() % 4 ? 0 : random() % mutant.length);
+                if (roundTrip(bytes, length))
+                    parsed++;
+                total++;
+                memcpy(bytes, cert.bytes, cert.length);
+            }
+        }
+    }
+    Log(@"ASN1Fuzz: %d of %d mutated inputs parsed and round-tripped", parsed, total);
+}
+
+
+#endif // DEBUG
+
+
+
+/*
+ Copyright (c) 2009, Jens Alfke <jens@mooseyard.com>. All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification, are permitted
+ provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice, this list of conditions
+ and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions
+ and the following disclaimer in the documentation and/or other materials provided with the
+ distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRI-
+ BUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
@@ -43,12 +43,39 @@
 
 
 /* An ASN.1 "big" (arbitrary-length) integer.
-    The value contains the bytes of the integer, in big-endian order.
+    The value contains the bytes of the integer, in big-endian two's-complement order.
+    Integers of up to kMYASN1BigIntegerInlineSize bytes (which covers certificate serial numbers)
+    are stored inside the object itself; NSData objects are only created if asked for, and then
+    cached. The BER parser only creates these for integers too large for an NSNumber.
     This is mostly used internally by MYParsedCertificate. */
+#define kMYASN1BigIntegerInlineSize 24
+
 @interface MYASN1BigInteger : MYASN1Object
+{
+    @private
+    size_t _length;
+    uint8_t _inline[kMYASN1BigIntegerInlineSize];
+    NSData *_signedData, *_unsignedData;
+}
+
 - (id) initWithSignedData: (NSData*)signedData;
 - (id) initWithUnsignedData: (NSData*) unsignedData;
-@property (weak, readonly) NSData *signedData, *unsignedData;
+
+/** Initializes from signed big-endian bytes, exactly as given (redundant leading bytes aren't
+    removed.) The parser uses this to avoid creating an intermediate NSData. */
+- (id) initWithSignedBytes: (const void*)bytes length: (size_t)length;
+
+@property (readonly) NSData *signedData, *unsignedData;
+
+/** The signed big-endian bytes, without copying. The pointer is valid as long as the object. */
+- (const uint8_t*) signedBytes: (size_t*)outLength;
+
+/** The bytes without any leading zero bytes (i.e. the magnitude, if the number is positive),
+    without copying. The pointer is valid as long as the object. */
+- (const uint8_t*) unsignedBytes: (size_t*)outLength;
+
+@property (readonly) BOOL isNegative;
+
 @end
 
 
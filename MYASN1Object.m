@@ -14,9 +14,24 @@
 #import "Test.h"
 
 
+@interface MYASN1Object ()
+- (id) _initWithTag: (uint32_t)tag ofClass: (uint8_t)tagClass;
+@end
+
+
 @implementation MYASN1Object
 
 
+- (id) _initWithTag: (uint32_t)tag ofClass: (uint8_t)tagClass {
+    // For subclasses that store their value themselves and override -value.
+    self = [super init];
+    if (self != nil) {
+        _tag = tag;
+        _tagClass = tagClass;
+    }
+    return self;
+}
+
 - (id) initWithTag: (uint32_t)tag
            ofClass: (uint8_t)tagClass 
        constructed: (BOOL)constructed
@@ -54,14 +69,14 @@
 
 
 - (NSString*) ASCIIValue {
-    return [[NSString alloc] initWithData: _value encoding: NSASCIIStringEncoding];
+    return [[NSString alloc] initWithData: self.value encoding: NSASCIIStringEncoding];
 }
 
 - (NSString*)description {
     if (_components)
         return $sprintf(@"%@[%hhu/%u/%u]%@", self.class, _tagClass,(unsigned)_constructed,_tag, _components);
     else
-        return $sprintf(@"%@[%hhu/%u/%u, %u bytes]", self.class, _tagClass,(unsigned)_constructed,_tag, (unsigned)_value.length);
+        return $sprintf(@"%@[%hhu/%u/%u, %u bytes]", self.class, _tagClass,(unsigned)_constructed,_tag, (unsigned)self.value.length);
 }
 
 - (BOOL) isEqual: (id)object {
@@ -69,7 +84,7 @@
         && _tag==[(MYASN1Object*)object tag]
         && _tagClass==[object tagClass] 
         && _constructed==[object constructed] 
-        && $equal(_value,[object value])
+        && $equal(self.value,[object value])
         && $equal(_components,[object components]);
 }
 
@@ -113,44 +128,98 @@ static void dump(id object, NSMutableString *output, NSString *indent) {
 
 @implementation MYASN1BigInteger
 
+- (id) initWithSignedBytes: (const void*)bytes length: (size_t)length {
+    Assert(length > 0);
+    self = [super _initWithTag: 2 ofClass: 0];
+    if (self != nil) {
+        _length = length;
+        if (length <= kMYASN1BigIntegerInlineSize)
+            memcpy(_inline, bytes, length);
+        else
+            _signedData = [[NSData alloc] initWithBytes: bytes length: length];
+    }
+    return self;
+}
+
 - (id) initWithSignedData: (NSData*)signedData {
     // Skip unnecessary leading 00 (if positive) or FF (if negative) bytes:
     const SInt8 *start = signedData.bytes, *last = start + signedData.length - 1;
     const SInt8 *pos = start;
     while (pos<last && ((pos[0]==0 && pos[1]>=0) || (pos[0]==-1 && pos[1]<0)))
         pos++;
-    if (pos > start)
-        signedData = [NSData dataWithBytes: pos length: last-pos+1];
-    return [self initWithTag: 2 ofClass: 0 constructed: NO value: signedData];
+    return [self initWithSignedBytes: pos length: last-pos+1];
 }
 
 - (id) initWithUnsignedData: (NSData*) unsignedData {
     const UInt8 *start = unsignedData.bytes;
+    size_t length = unsignedData.length;
     if (*start >= 0x80) {
         // Prefix with 00 byte so high bit isn't misinterpreted as a sign bit:
-        NSMutableData *fixedData = [NSMutableData dataWithCapacity: unsignedData.length + 1];
-        UInt8 zero = 0;
-        [fixedData appendBytes: &zero length: 1];
-        [fixedData appendData: unsignedData];
-        unsignedData = fixedData;
+        UInt8 stackBuf[kMYASN1BigIntegerInlineSize];
+        UInt8 *fixed = length < sizeof(stackBuf) ? stackBuf : malloc(length + 1);
+        fixed[0] = 0;
+        memcpy(fixed+1, start, length);
+        self = [self initWithSignedBytes: fixed length: length + 1];
+        if (fixed != stackBuf)
+            free(fixed);
+        return self;
     }
     return [self initWithSignedData: unsignedData];
 }
 
+- (const uint8_t*) signedBytes: (size_t*)outLength {
+    *outLength = _length;
+    return _length <= kMYASN1BigIntegerInlineSize ? _inline : _signedData.bytes;
+}
+
+- (const uint8_t*) unsignedBytes: (size_t*)outLength {
+    // Skip any leading zero bytes that were inserted for sign-bit padding:
+    size_t length;
+    const uint8_t *start = [self signedBytes: &length], *pos = start;
+    while (length > 1 && *pos == 0) {
+        pos++;
+        length--;
+    }
+    *outLength = length;
+    return pos;
+}
+
+- (BOOL) isNegative {
+    size_t length;
+    return ([self signedBytes: &length][0] & 0x80) != 0;
+}
+
 - (NSData*) signedData {
-    return self.value;
+    @synchronized(self) {
+        if (!_signedData)
+            _signedData = [[NSData alloc] initWithBytes: _inline length: _length];
+        return _signedData;
+    }
 }
 
 - (NSData*) unsignedData {
-    // Strip any leading zero bytes that were inserted for sign-bit padding:
-    NSData *data = self.value;
-    const UInt8 *start = data.bytes, *last = start + data.length - 1;
-    const UInt8 *pos = start;
-    while (pos<last && *pos==0)
-        pos++;
-    if (pos > start)
-        data = [NSData dataWithBytes: pos length: last-pos+1];
-    return data;
+    size_t length;
+    const uint8_t *bytes = [self unsignedBytes: &length];
+    if (length == _length)
+        return self.signedData;
+    @synchronized(self) {
+        if (!_unsignedData)
+            _unsignedData = [[NSData alloc] initWithBytes: bytes length: length];
+        return _unsignedData;
+    }
+}
+
+- (NSData*) value {
+    return self.signedData;
+}
+
+- (BOOL) isEqual: (id)object {
+    if (![object isKindOfClass: [MYASN1BigInteger class]])
+        return [super isEqual: object];
+    size_t length, otherLength;
+    const uint8_t *bytes = [self signedBytes: &length];
+    const uint8_t *otherBytes = [object signedBytes: &otherLength];
+    return length == otherLength && memcmp(bytes, otherBytes, length) == 0;
 }
 
 @end
@@ -196,6 +265,43 @@ static void dump(id object, NSMutableString *output, NSString *indent) {
 
 
 
+#pragma mark -
+#pragma mark TEST CASES:
+
+
+TestCase(MYASN1BigInteger) {
+    const uint8_t serial[] = {0x00, 0x9C, 0x1F, 0x42, 0x77, 0x08, 0x31, 0xAA, 0x55, 0x10};
+    MYASN1BigInteger *n = [[MYASN1BigInteger alloc] initWithUnsignedData:
+                                    [NSData dataWithBytes: serial+1 length: sizeof(serial)-1]];
+    size_t length;
+    CAssert(memcmp([n signedBytes: &length], serial, sizeof(serial)) == 0);
+    CAssertEq(length, sizeof(serial));
+    CAssert(memcmp([n unsignedBytes: &length], serial+1, sizeof(serial)-1) == 0);
+    CAssertEq(length, sizeof(serial)-1);
+    CAssert(!n.isNegative);
+    CAssertEqual(n.signedData, [NSData dataWithBytes: serial length: sizeof(serial)]);
+    CAssert(n.signedData == n.signedData);          // cached, not recreated
+    CAssert(n.unsignedData == n.unsignedData);
+    CAssertEqual(n, [[MYASN1BigInteger alloc] initWithSignedBytes: serial length: sizeof(serial)]);
+
+    // Redundant sign bytes are removed:
+    const uint8_t negative[] = {0xFF, 0xFF, 0x80, 0x01};
+    n = [[MYASN1BigInteger alloc] initWithSignedData: [NSData dataWithBytes: negative length: 4]];
+    CAssert(n.isNegative);
+    CAssertEqual(n.signedData, [NSData dataWithBytes: negative+1 length: 3]);
+
+    // Too big to store inline:
+    NSMutableData *modulus = [NSMutableData dataWithLength: 256];
+    ((uint8_t*)modulus.mutableBytes)[0] = 0xC3;
+    n = [[MYASN1BigInteger alloc] initWithUnsignedData: modulus];
+    CAssertEq(n.signedData.length, (NSUInteger)257);
+    CAssertEqual(n.unsignedData, modulus);
+    CAssert(n.unsignedData == n.unsignedData);
+    CAssert([n unsignedBytes: &length] == (const uint8_t*)n.signedData.bytes + 1);
+}
+
+
+
 /*
  Copyright (c) 2009, Jens Alfke <jens@mooseyard.com>. All rights reserved.
  
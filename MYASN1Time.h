@@ -0,0 +1,39 @@
+//
+//  MYASN1Time.h
+//  MYCrypto
+//
+//  Created by Jens Alfke on 10/16/26.
+//  Copyright 2026 Jens Alfke. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+
+/** ASN.1 tag numbers of the two time types. */
+enum {
+    kMYASN1UTCTimeTag           = 23,
+    kMYASN1GeneralizedTimeTag   = 24,
+};
+
+/** Size of a buffer large enough for any time produced by MYASN1FormatTime. */
+#define kMYASN1TimeMaxLength 16
+
+
+/** Parses the contents of a UTCTime or GeneralizedTime value, returning the time as seconds
+    since 1/1/1970 UTC. All the forms in X.680 are accepted:
+    - UTCTime: "YYMMDDhhmm[ss]" followed by "Z" or a "+hhmm"/"-hhmm" offset. Two-digit years
+      from 50 to 99 are in the 1900s, per RFC 5280.
+    - GeneralizedTime: "YYYYMMDDhh[mm[ss]]", then an optional fraction (of the last field
+      present) starting with "." or ",", then "Z", "+hh[mm]", "-hh[mm]", or nothing. A time
+      without a zone is local time in principle, but is interpreted here as UTC.
+    This does not allocate memory, and is thread-safe.
+    @return  YES on success, NO if the string isn't a valid time. */
+BOOL MYASN1ParseTime (const void *chars, size_t length, unsigned tag, NSTimeInterval *outTime);
+
+/** Formats a time, in seconds since 1/1/1970 UTC, as the contents of a UTCTime ("YYMMDDhhmmssZ")
+    or GeneralizedTime ("YYYYMMDDhhmmssZ") value. Fractional seconds are truncated.
+    Does not write a trailing null byte.
+    @param outChars  A buffer of at least kMYASN1TimeMaxLength bytes.
+    @return  The number of characters written, or 0 if the year is out of range for the tag
+        (1950-2049 for UTCTime, 1-9999 for GeneralizedTime.) */
+size_t MYASN1FormatTime (NSTimeInterval time, unsigned tag, char *outChars);
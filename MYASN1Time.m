@@ -0,0 +1,333 @@
+//
+//  MYASN1Time.m
+//  MYCrypto
+//
+//  Created by Jens Alfke on 10/16/26.
+//  Copyright 2026 Jens Alfke. All rights reserved.
+//
+
+#import "MYASN1Time.h"
+#import "MYBERParser.h"
+#import "Test.h"
+#import <math.h>
+
+
+/* Describes one numeric field of a time string. */
+typedef struct {
+    uint8_t digits;         // Number of digits
+    uint16_t min, max;      // Range of valid values
+    BOOL optional;          // If true, the string may end (or go on to the zone) before this field
+    uint32_t unit;          // Length of one unit of this field in seconds, for fractions
+} TimeField;
+
+enum {kYear, kMonth, kDay, kHour, kMinute, kSecond, kFieldCount};
+
+static const TimeField kUTCTimeFields[kFieldCount] = {
+    {2,    0,   99,     NO,     0},
+    {2,    1,   12,     NO,     0},
+    {2,    1,   31,     NO,     0},
+    {2,    0,   23,     NO,     3600},
+    {2,    0,   59,     NO,     60},
+    {2,    0,   60,     YES,    1},     // (60 allows for a leap second)
+};
+
+static const TimeField kGeneralizedTimeFields[kFieldCount] = {
+    {4,    1,   9999,   NO,     0},
+    {2,    1,   12,     NO,     0},
+    {2,    1,   31,     NO,     0},
+    {2,    0,   23,     NO,     3600},
+    {2,    0,   59,     YES,    60},
+    {2,    0,   60,     YES,    1},
+};
+
+static const uint8_t kDaysInMonth[12] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+
+static const char kDigitPairs[201] =
+    "0001020304050607080910111213141516171819"
+    "2021222324252627282930313233343536373839"
+    "4041424344454647484950515253545556575859"
+    "6061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+
+static inline BOOL isDigit (uint8_t c) {
+    return (unsigned)(c - '0') <= 9;
+}
+
+/* Reads exactly n decimal digits, advancing *pos past them. */
+static inline BOOL readDigits (const uint8_t **pos, const uint8_t *end, unsigned n,
+                               unsigned *outValue)
+{
+    if ((size_t)(end - *pos) < n)
+        return NO;
+    unsigned value = 0;
+    for (unsigned i=0; i<n; i++) {
+        uint8_t c = (*pos)[i];
+        if (!isDigit(c))
+            return NO;
+        value = 10*value + (c - '0');
+    }
+    *pos += n;
+    *outValue = value;
+    return YES;
+}
+
+static inline BOOL isLeapYear (int year) {
+    return (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+}
+
+/* Number of days from 1/1/1970 to the given date (proleptic Gregorian calendar.)
+   This and civilFromDays use Howard Hinnant's algorithms, which work in 400-year eras. */
+static int64_t daysFromCivil (int64_t y, unsigned m, unsigned d) {
+    y -= (m <= 2);
+    int64_t era = (y >= 0 ? y : y - 399) / 400;
+    unsigned yoe = (unsigned)(y - era * 400);
+    unsigned doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+    unsigned doe = yoe * 365 + yoe/4 - yoe/100 + doy;
+    return era * 146097 + doe - 719468;
+}
+
+static void civilFromDays (int64_t z, int64_t *outYear, unsigned *outMonth, unsigned *outDay) {
+    z += 719468;
+    int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+    unsigned doe = (unsigned)(z - era * 146097);
+    unsigned yoe = (doe - doe/1460 + doe/36524 - doe/146096) / 365;
+    unsigned doy = doe - (365*yoe + yoe/4 - yoe/100);
+    unsigned mp = (5*doy + 2) / 153;
+    *outDay = doy - (153*mp + 2)/5 + 1;
+    *outMonth = mp < 10 ? mp + 3 : mp - 9;
+    *outYear = yoe + era * 400 + (*outMonth <= 2);
+}
+
+
+BOOL MYASN1ParseTime (const void *chars, size_t length, unsigned tag, NSTimeInterval *outTime) {
+    const BOOL utc = (tag == kMYASN1UTCTimeTag);
+    if (!utc && tag != kMYASN1GeneralizedTimeTag)
+        return NO;
+    const TimeField *fields = utc ? kUTCTimeFields : kGeneralizedTimeFields;
+    const uint8_t *pos = chars, *end = pos + length;
+
+    // Read the numeric fields:
+    unsigned value[kFieldCount] = {0};
+    int nFields;
+    for (nFields = 0; nFields < kFieldCount; nFields++) {
+        const TimeField *field = &fields[nFields];
+        if (field->optional && (pos >= end || !isDigit(*pos)))
+            break;
+        if (!readDigits(&pos, end, field->digits, &value[nFields]))
+            return NO;
+        if (value[nFields] < field->min || value[nFields] > field->max)
+            return NO;
+    }
+
+    int year = value[kYear];
+    if (utc)
+        year += (year >= 50) ? 1900 : 2000;
+    unsigned month = value[kMonth], day = value[kDay];
+    if (day > kDaysInMonth[month-1] + (month == 2 && isLeapYear(year)))
+        return NO;
+    NSTimeInterval time = daysFromCivil(year, month, day) * 86400.0
+                        + value[kHour] * 3600 + value[kMinute] * 60 + value[kSecond];
+
+    // A GeneralizedTime may have a fraction of whatever its last field was:
+    if (!utc && pos < end && (*pos == '.' || *pos == ',')) {
+        const uint8_t *digits = ++pos;
+        double fraction = 0.0, scale = 1.0;
+        for (; pos < end && isDigit(*pos); pos++) {
+            scale *= 0.1;
+            fraction += (*pos - '0') * scale;
+        }
+        if (pos == digits)
+            return NO;
+        time += fraction * fields[nFields-1].unit;
+    }
+
+    // Time zone:
+    if (pos < end) {
+        uint8_t c = *pos++;
+        if (c == '+' || c == '-') {
+            unsigned hours, minutes = 0;
+            if (!readDigits(&pos, end, 2, &hours) || hours > 23)
+                return NO;
+            if (utc || pos < end)
+                if (!readDigits(&pos, end, 2, &minutes) || minutes > 59)
+                    return NO;
+            // The offset is local time minus UTC:
+            NSTimeInterval offset = hours * 3600 + minutes * 60;
+            time += (c == '+') ? -offset : offset;
+        } else if (c != 'Z') {
+            return NO;
+        }
+    } else if (utc) {
+        return NO;      // UTCTime always has a zone
+    }
+    if (pos != end)
+        return NO;
+    *outTime = time;
+    return YES;
+}
+
+
+static inline char* writePair (char *dst, unsigned n) {
+    dst[0] = kDigitPairs[2*n];
+    dst[1] = kDigitPairs[2*n + 1];
+    return dst + 2;
+}
+
+size_t MYASN1FormatTime (NSTimeInterval time, unsigned tag, char *outChars) {
+    if (!(fabs(time) < 1e15))       // (also rejects NaN)
+        return 0;
+    int64_t secs = (int64_t)floor(time);
+    int64_t days = secs / 86400;
+    int64_t secOfDay = secs % 86400;
+    if (secOfDay < 0) {
+        secOfDay += 86400;
+        days--;
+    }
+    int64_t year;
+    unsigned month, day;
+    civilFromDays(days, &year, &month, &day);
+
+    char *dst = outChars;
+    if (tag == kMYASN1UTCTimeTag) {
+        if (year < 1950 || year > 2049)
+            return 0;
+        dst = writePair(dst, year % 100);
+    } else if (tag == kMYASN1GeneralizedTimeTag) {
+        if (year < 1 || year > 9999)
+            return 0;
+        dst = writePair(dst, (unsigned)(year / 100));
+        dst = writePair(dst, year % 100);
+    } else {
+        return 0;
+    }
+    dst = writePair(dst, month);
+    dst = writePair(dst, day);
+    dst = writePair(dst, (unsigned)(secOfDay / 3600));
+    dst = writePair(dst, (secOfDay / 60) % 60);
+    dst = writePair(dst, secOfDay % 60);
+    *dst++ = 'Z';
+    return dst - outChars;
+}
+
+
+
+
+#pragma mark -
+#pragma mark TEST CASES:
+
+
+static BOOL parseString (NSString *str, unsigned tag, NSTimeInterval *outTime) {
+    const char *chars = str.UTF8String;
+    return MYASN1ParseTime(chars, strlen(chars), tag, outTime);
+}
+
+TestCase(ASN1Time) {
+    static const struct {const char *str; unsigned tag; NSTimeInterval time;} kValid[] = {
+        {"090602000000Z",           23, 1243900800},
+        {"4912312359Z",             23, 2524607940},
+        {"500101000000Z",           23, -631152000},
+        {"0906020130+0130",         23, 1243900800},
+        {"090601223000-0130",       23, 1243900800},
+        {"20090602000000Z",         24, 1243900800},
+        {"2009060200Z",             24, 1243900800},
+        {"200906020030Z",           24, 1243902600},
+        {"20090602000000.5Z",       24, 1243900800.5},
+        {"20090602000000,25Z",      24, 1243900800.25},
+        {"2009060200.5Z",           24, 1243902600},    // (fraction of an hour)
+        {"20090602000000",          24, 1243900800},
+        {"20090602020000+02",       24, 1243900800},
+        {"20000229120000Z",         24, 951825600},
+        {"19691231235959Z",         24, -1},
+        {"16010101000000Z",         24, -11644473600},
+    };
+    for (unsigned i=0; i<sizeof(kValid)/sizeof(kValid[0]); i++) {
+        NSTimeInterval time = NAN;
+        CAssert(MYASN1ParseTime(kValid[i].str, strlen(kValid[i].str), kValid[i].tag, &time),
+                @"Couldn't parse '%s'", kValid[i].str);
+        CAssertEq(time, kValid[i].time);
+    }
+
+    NSTimeInterval time;
+    for (NSString *bad in @[@"", @"090602000000", @"0906020000000Z", @"090230000000Z",
+                            @"20090602240000Z", @"090602006000Z", @"090602000061Z",
+                            @"090602000000.5Z", @"090602000000+01", @"20090602000000.Z",
+                            @"20090602000000Q", @"20090602000000Z ", @"20090229000000Z",
+                            @"19001329000000Z", @"00000101000000Z", @"2009O602000000Z",
+                            @"20090602Z"]) {
+        CAssert(!parseString(bad, 24, &time) && !parseString(bad, 23, &time),
+                @"Accepted bad time '%@'", bad);
+    }
+
+    char buf[kMYASN1TimeMaxLength];
+    CAssertEq(MYASN1FormatTime(1243900800.75, 24, buf), (size_t)15);
+    CAssert(memcmp(buf, "20090602000000Z", 15) == 0);
+    CAssertEq(MYASN1FormatTime(1243900800, 23, buf), (size_t)13);
+    CAssert(memcmp(buf, "090602000000Z", 13) == 0);
+    CAssertEq(MYASN1FormatTime(-1, 24, buf), (size_t)15);
+    CAssert(memcmp(buf, "19691231235959Z", 15) == 0);
+    CAssertEq(MYASN1FormatTime(2524608000, 23, buf), (size_t)0);      // 2050 doesn't fit
+    CAssertEq(MYASN1FormatTime(NAN, 24, buf), (size_t)0);
+
+    // Round trip, and agreement with NSDateFormatter:
+    NSDateFormatter *fmt = MYBERGeneralizedTimeFormatter();
+    for (NSTimeInterval t = -2e9; t < 4e9; t += 86400*97 + 3607) {
+        size_t len = MYASN1FormatTime(t, 24, buf);
+        CAssertEq(len, (size_t)15);
+        CAssert(MYASN1ParseTime(buf, len, 24, &time));
+        CAssertEq(time, t);
+        NSString *str = [[NSString alloc] initWithBytes: buf length: len
+                                               encoding: NSASCIIStringEncoding];
+        CAssertEqual(str, [fmt stringFromDate: [NSDate dateWithTimeIntervalSince1970: t]]);
+    }
+}
+
+
+TestCase(ASN1TimeBenchmark) {
+    RequireTestCase(ASN1Time);
+    static const int kIterations = 100000;
+    const char *str = "20090602123456Z";
+    NSString *nsstr = @(str);
+    NSDateFormatter *fmt = MYBERGeneralizedTimeFormatter();
+    CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+    for (int i=0; i<kIterations; i++) {
+        @autoreleasepool {
+            (void)[fmt dateFromString: nsstr];
+        }
+    }
+    CFAbsoluteTime fmtTime = CFAbsoluteTimeGetCurrent() - start;
+    start = CFAbsoluteTimeGetCurrent();
+    NSTimeInterval total = 0, time;
+    for (int i=0; i<kIterations; i++) {
+        MYASN1ParseTime(str, 15, kMYASN1GeneralizedTimeTag, &time);
+        total += time;
+    }
+    CFAbsoluteTime parseTime = CFAbsoluteTimeGetCurrent() - start;
+    CAssertEq(total, 1243946096.0 * kIterations);
+    Log(@"Parsing time: NSDateFormatter %.0fns, MYASN1ParseTime %.0fns",
+        fmtTime/kIterations*1e9, parseTime/kIterations*1e9);
+}
+
+
+
+/*
+ Copyright (c) 2009, Jens Alfke <jens@mooseyard.com>. All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification, are permitted
+ provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice, this list of conditions
+ and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions
+ and the following disclaimer in the documentation and/or other materials provided with the
+ distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRI-
+ BUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
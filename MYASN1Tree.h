@@ -0,0 +1,79 @@
+//
+//  MYASN1Tree.h
+//  MYCrypto
+//
+//  Created by Jens Alfke on 10/16/26.
+//  Copyright 2026 Jens Alfke. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+#import "MYBERParser.h"
+
+
+/** Index of a node within a MYASN1Tree. The root is always node 0. */
+typedef uint32_t MYASN1NodeIndex;
+
+/** Returned in place of a node index when there is no such node. */
+#define kMYASN1NoNode UINT32_MAX
+
+/** Flags stored in a MYASN1Node. The low two bits hold the tag class. */
+enum {
+    kMYASN1NodeClassMask    = 0x03,
+    kMYASN1NodeConstructed  = 0x04,
+    kMYASN1NodeIndefinite   = 0x08,
+};
+
+/** A compact fixed-size record describing one value in a MYASN1Tree.
+    Offsets are relative to the start of the tree's data; children are linked by index. */
+typedef struct {
+    uint32_t tag;
+    uint16_t flags;
+    uint16_t headerLength;
+    uint32_t offset;                ///< Offset of the contents, just past the header
+    uint32_t length;                ///< Length of the contents
+    MYASN1NodeIndex firstChild;     ///< First nested value, or kMYASN1NoNode
+    MYASN1NodeIndex nextSibling;    ///< Next value in the same parent, or kMYASN1NoNode
+} MYASN1Node;
+
+
+/** A parsed BER/DER value represented as a flat array of MYASN1Node records.
+    All nodes of one parse live in a single block of memory that's freed at once, and no value
+    is copied out of the input. This is far cheaper than MYBERParse, which allocates an object
+    for every value; objects can still be created on demand for individual nodes. */
+@interface MYASN1Tree : NSObject
+{
+    @private
+    NSData *_data;
+    MYASN1Node *_nodes;
+    uint32_t _count, _capacity;
+}
+
+/** Parses BER data into a tree. The data is retained, not copied, so it must not be mutated. */
+- (id) initWithBERData: (NSData*)data error: (NSError**)outError;
+
+/** The data that was parsed. */
+@property (readonly) NSData *data;
+
+/** The number of nodes in the tree. */
+@property (readonly) uint32_t nodeCount;
+
+/** Returns a pointer to a node record. The root is node 0. */
+- (const MYASN1Node*) nodeAtIndex: (MYASN1NodeIndex)index;
+
+/** Returns the index of the n'th child of a constructed node, or kMYASN1NoNode. */
+- (MYASN1NodeIndex) childOfNode: (MYASN1NodeIndex)index atIndex: (unsigned)n;
+
+/** Returns a zero-copy slice describing the node, usable with the MYBERCursor functions. */
+- (MYBERSlice) sliceForNode: (MYASN1NodeIndex)index;
+
+/** Copies a node's contents into a new NSData. */
+- (NSData*) contentsOfNode: (MYASN1NodeIndex)index;
+
+/** Materializes a node as the same objects MYBERParse would have returned for it
+    (NSArray, NSNumber, MYOID, MYASN1Object, etc.) */
+- (id) objectForNode: (MYASN1NodeIndex)index;
+
+/** Materializes the entire tree, equivalent to calling MYBERParse on the data. */
+@property (readonly) id rootObject;
+
+@end
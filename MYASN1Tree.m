@@ -0,0 +1,277 @@
+//
+//  MYASN1Tree.m
+//  MYCrypto
+//
+//  Created by Jens Alfke on 10/16/26.
+//  Copyright 2026 Jens Alfke. All rights reserved.
+//
+
+#import "MYASN1Tree.h"
+#import "MYASN1Object.h"
+#import "MYErrorUtils.h"
+#import "Test.h"
+
+#if !TARGET_OS_IPHONE
+#import <malloc/malloc.h>
+#endif
+
+
+#define kMaxDepth 64
+
+
+@implementation MYASN1Tree
+
+
+/* Appends a node to the arena, growing it if necessary. Returns kMYASN1NoNode on failure. */
+static MYASN1NodeIndex addNode(MYASN1Tree *tree, const MYBERSlice *slice, const uint8_t *base) {
+    if (tree->_count >= tree->_capacity) {
+        uint32_t capacity = 2 * tree->_capacity;
+        MYASN1Node *nodes = realloc(tree->_nodes, capacity * sizeof(MYASN1Node));
+        if (!nodes)
+            return kMYASN1NoNode;
+        tree->_nodes = nodes;
+        tree->_capacity = capacity;
+    }
+    MYASN1NodeIndex index = tree->_count++;
+    MYASN1Node *node = &tree->_nodes[index];
+    node->tag = slice->tag;
+    node->flags = slice->tagClass
+                | (slice->isConstructed ? kMYASN1NodeConstructed : 0)
+                | (slice->isIndefinite ? kMYASN1NodeIndefinite : 0);
+    node->headerLength = (uint16_t)slice->headerLength;
+    node->offset = (uint32_t)(slice->contents - base);
+    node->length = (uint32_t)slice->length;
+    node->firstChild = node->nextSibling = kMYASN1NoNode;
+    return index;
+}
+
+
+/* Reads all the values from the cursor, appending them as nodes, and sets *outFirst to the index
+   of the first one (or kMYASN1NoNode if there were none.) Descends into constructed values. */
+static BOOL addNodes(MYASN1Tree *tree, MYBERCursor cursor, const uint8_t *base, unsigned depth,
+                     MYASN1NodeIndex *outFirst, NSError **outError)
+{
+    if (depth > kMaxDepth) {
+        if (outError) *outError = MYError(1, MYASN1ErrorDomain, @"Values nested too deeply");
+        return NO;
+    }
+    *outFirst = kMYASN1NoNode;
+    MYASN1NodeIndex prev = kMYASN1NoNode;
+    MYBERSlice slice;
+    while (MYBERCursorNext(&cursor, &slice, outError)) {
+        MYASN1NodeIndex index = addNode(tree, &slice, base);
+        if (index == kMYASN1NoNode) {
+            if (outError) *outError = MYError(1, MYASN1ErrorDomain, @"Out of memory");
+            return NO;
+        }
+        if (prev == kMYASN1NoNode)
+            *outFirst = index;
+        else
+            tree->_nodes[prev].nextSibling = index;
+        prev = index;
+        if (slice.isConstructed) {
+            MYASN1NodeIndex firstChild;
+            if (!addNodes(tree, MYBERSliceGetCursor(&slice), base, depth+1, &firstChild, outError))
+                return NO;
+            tree->_nodes[index].firstChild = firstChild;    // (_nodes may have been realloced)
+        }
+    }
+    return MYBERCursorAtEnd(&cursor);
+}
+
+
+- (id) initWithBERData: (NSData*)data error: (NSError**)outError {
+    Assert(data);
+    self = [super init];
+    if (self != nil) {
+        if (data.length > UINT32_MAX) {
+            if (outError) *outError = MYError(1, MYASN1ErrorDomain, @"Data too large");
+            return nil;
+        }
+        _data = [data copy];
+        // Start with a guess at the node count; values average around ten bytes in certificates.
+        _capacity = (uint32_t)MAX(16u, _data.length / 8);
+        _nodes = malloc(_capacity * sizeof(MYASN1Node));
+        if (!_nodes) {
+            if (outError) *outError = MYError(1, MYASN1ErrorDomain, @"Out of memory");
+            return nil;
+        }
+        const uint8_t *base = _data.bytes;
+        MYBERCursor cursor = MYBERCursorMake(base, _data.length);
+        MYBERSlice slice;
+        MYASN1NodeIndex root;
+        // Only the first top-level value is parsed, as with MYBERParse.
+        if (!MYBERCursorNext(&cursor, &slice, outError)) {
+            if (outError && !*outError)
+                *outError = MYError(1, MYASN1ErrorDomain, @"Unexpected EOF on input");
+            return nil;
+        }
+        cursor = MYBERCursorMake(MYBERSliceGetEncoding(&slice), MYBERSliceGetEncodingLength(&slice));
+        if (!addNodes(self, cursor, base, 0, &root, outError))
+            return nil;
+    }
+    return self;
+}
+
+- (void) dealloc {
+    free(_nodes);
+}
+
+
+@synthesize data=_data, nodeCount=_count;
+
+
+- (const MYASN1Node*) nodeAtIndex: (MYASN1NodeIndex)index {
+    Assert(index < _count);
+    return &_nodes[index];
+}
+
+- (MYASN1NodeIndex) childOfNode: (MYASN1NodeIndex)index atIndex: (unsigned)n {
+    Assert(index < _count);
+    MYASN1NodeIndex child = _nodes[index].firstChild;
+    for (; n > 0 && child != kMYASN1NoNode; n--)
+        child = _nodes[child].nextSibling;
+    return child;
+}
+
+- (MYBERSlice) sliceForNode: (MYASN1NodeIndex)index {
+    Assert(index < _count);
+    const MYASN1Node *node = &_nodes[index];
+    MYBERSlice slice = {
+        .tag = node->tag,
+        .tagClass = node->flags & kMYASN1NodeClassMask,
+        .isConstructed = (node->flags & kMYASN1NodeConstructed) != 0,
+        .isIndefinite = (node->flags & kMYASN1NodeIndefinite) != 0,
+        .headerLength = node->headerLength,
+        .contents = (const uint8_t*)_data.bytes + node->offset,
+        .length = node->length
+    };
+    return slice;
+}
+
+- (NSData*) contentsOfNode: (MYASN1NodeIndex)index {
+    MYBERSlice slice = [self sliceForNode: index];
+    return MYBERSliceCopyContents(&slice);
+}
+
+- (id) objectForNode: (MYASN1NodeIndex)index {
+    MYBERSlice slice = [self sliceForNode: index];
+    return MYBERSliceParse(&slice, NULL);
+}
+
+- (id) rootObject {
+    return [self objectForNode: 0];
+}
+
+
+@end
+
+
+
+
+#pragma mark -
+#pragma mark TEST CASES:
+
+
+TestCase(MYASN1Tree) {
+    RequireTestCase(BERCursor);
+    const uint8_t bytes[] = {0x30, 0x0F,
+                                0x02, 0x01, 0x48,
+                                0x30, 0x80,  0x01, 0x01, 0xFF,  0x00, 0x00,
+                                0x04, 0x03, 'a', 'b', 'c'};
+    NSData *ber = [NSData dataWithBytes: bytes length: sizeof(bytes)];
+    MYASN1Tree *tree = [[MYASN1Tree alloc] initWithBERData: ber error: NULL];
+    CAssert(tree);
+    CAssertEq(tree.nodeCount, 5u);
+    const MYASN1Node *root = [tree nodeAtIndex: 0];
+    CAssertEq(root->tag, 16u);
+    CAssert(root->flags & kMYASN1NodeConstructed);
+    CAssertEq(root->length, 15u);
+    MYASN1NodeIndex seq = [tree childOfNode: 0 atIndex: 1];
+    CAssert([tree nodeAtIndex: seq]->flags & kMYASN1NodeIndefinite);
+    CAssertEqual([tree objectForNode: seq], @[$true]);
+    MYASN1NodeIndex str = [tree childOfNode: 0 atIndex: 2];
+    CAssertEqual([tree contentsOfNode: str], [@"abc" dataUsingEncoding: NSASCIIStringEncoding]);
+    CAssertEq([tree childOfNode: 0 atIndex: 3], kMYASN1NoNode);
+    CAssertEqual(tree.rootObject, MYBERParse(ber, NULL));
+
+    NSError *error = nil;
+    CAssertNil([[MYASN1Tree alloc] initWithBERData: [ber subdataWithRange: NSMakeRange(0, 9)]
+                                             error: &error]);
+    CAssertEqual(error.domain, MYASN1ErrorDomain);
+}
+
+
+#if !TARGET_OS_IPHONE
+static size_t mallocBlocksInUse(void) {
+    malloc_statistics_t stats;
+    malloc_zone_statistics(NULL, &stats);
+    return stats.blocks_in_use;
+}
+
+TestCase(MYASN1TreeBenchmark) {
+    RequireTestCase(MYASN1Tree);
+    static const int kIterations = 2000;
+    for (NSString *filename in @[@"selfsigned.cer", @"selfsigned_email.cer",
+                                 @"iphonedev.cer", @"generated.cer"]) {
+        NSData *cert = [NSData dataWithContentsOfFile: filename];
+        CAssert(cert, @"Couldn't read %@", filename);
+
+        // Count the heap blocks each representation allocates (keeping the results alive):
+        size_t treeAllocs, arenaAllocs;
+        @autoreleasepool {
+            size_t before = mallocBlocksInUse();
+            id root = MYBERParse(cert, NULL);
+            treeAllocs = mallocBlocksInUse() - before;
+            before = mallocBlocksInUse();
+            MYASN1Tree *tree = [[MYASN1Tree alloc] initWithBERData: cert error: NULL];
+            arenaAllocs = mallocBlocksInUse() - before;
+            CAssertEqual(tree.rootObject, root);
+        }
+        CAssert(arenaAllocs * 5 <= treeAllocs,
+                @"Only reduced allocations from %zu to %zu", treeAllocs, arenaAllocs);
+
+        CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+        for (int i=0; i<kIterations; i++) {
+            @autoreleasepool {
+                MYBERParse(cert, NULL);
+            }
+        }
+        CFAbsoluteTime treeTime = CFAbsoluteTimeGetCurrent() - start;
+        start = CFAbsoluteTimeGetCurrent();
+        for (int i=0; i<kIterations; i++) {
+            @autoreleasepool {
+                (void)[[MYASN1Tree alloc] initWithBERData: cert error: NULL];
+            }
+        }
+        CFAbsoluteTime arenaTime = CFAbsoluteTimeGetCurrent() - start;
+
+        Log(@"%@: MYBERParse %zu allocs, %.2fus; MYASN1Tree %zu allocs, %.2fus",
+            filename, treeAllocs, treeTime/kIterations*1e6, arenaAllocs, arenaTime/kIterations*1e6);
+    }
+}
+#endif
+
+
+
+/*
+ Copyright (c) 2009, Jens Alfke <jens@mooseyard.com>. All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification, are permitted
+ provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice, this list of conditions
+ and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions
+ and the following disclaimer in the documentation and/or other materials provided with the
+ distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRI-
+ BUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
@@ -16,9 +16,73 @@
     This is mostly used internally by MYCertificateInfo. */
 id MYBERParse (NSData *ber, NSError **outError);
 
+/** Returns the length of the contents of the BER value at the start of the data.
+    If the value has indefinite length, this scans ahead to find the end-of-contents marker. */
 size_t MYBERGetLength (NSData *ber, NSError **outError);
 const void* MYBERGetContents (NSData *ber, NSError **outError);
 
-/** A date formatter with the format string "yyyyMMddHHmmss'Z'" */
+
+/** A view of a single BER-encoded value within a larger buffer.
+    Nothing is copied: the pointers refer directly into the caller's bytes, so a slice is only
+    valid as long as that buffer is. */
+typedef struct {
+    uint32_t tag;               ///< The tag number
+    uint8_t tagClass;           ///< 0=universal, 1=application, 2=context-specific, 3=private
+    BOOL isConstructed;         ///< YES if the contents consist of nested values
+    BOOL isIndefinite;          ///< YES if the value has indefinite length (ends with 00 00)
+    size_t headerLength;        ///< Length of the tag and length bytes preceding the contents
+    const uint8_t *contents;    ///< Pointer to the first byte of the contents
+    size_t length;              ///< Length of the contents, not counting any end-of-contents marker
+} MYBERSlice;
+
+/** Iterates over a series of consecutive BER values in a buffer, without parsing or copying
+    them. To descend into a constructed value, create a new cursor with MYBERSliceGetCursor. */
+typedef struct {
+    const uint8_t *nextChar;
+    const uint8_t *end;
+} MYBERCursor;
+
+/** Creates a cursor positioned at the start of the buffer. */
+MYBERCursor MYBERCursorMake (const void *bytes, size_t length);
+
+/** Returns YES if there are no more values to read. */
+static inline BOOL MYBERCursorAtEnd (const MYBERCursor *cursor) {
+    return cursor->nextChar >= cursor->end;
+}
+
+/** Reads the header of the next value, fills in the slice, and advances past the value.
+    Returns NO at the end of the input or if the header is invalid; in the latter case the
+    error is also returned through outError. */
+BOOL MYBERCursorNext (MYBERCursor *cursor, MYBERSlice *outSlice, NSError **outError);
+
+/** Skips the given number of values. Returns NO if the input ends first or is invalid. */
+BOOL MYBERCursorSkip (MYBERCursor *cursor, unsigned count, NSError **outError);
+
+/** Returns a cursor over the nested values inside a constructed value. */
+MYBERCursor MYBERSliceGetCursor (const MYBERSlice *slice);
+
+/** Returns a pointer to the start of the value's encoding, i.e. its header. */
+static inline const uint8_t* MYBERSliceGetEncoding (const MYBERSlice *slice) {
+    return slice->contents - slice->headerLength;
+}
+
+/** Returns the total length of the value's encoding, including header and end-of-contents. */
+static inline size_t MYBERSliceGetEncodingLength (const MYBERSlice *slice) {
+    return slice->headerLength + slice->length + (slice->isIndefinite ? 2 : 0);
+}
+
+/** Fully parses the value into objects, exactly as MYBERParse would. */
+id MYBERSliceParse (const MYBERSlice *slice, NSError **outError);
+
+/** Copies the value's contents into a new NSData object. */
+NSData* MYBERSliceCopyContents (const MYBERSlice *slice);
+
+/** Reads the contents of an INTEGER or ENUMERATED value as a signed 64-bit integer, without
+    allocating. Returns NO if the contents are empty or too long to fit in 64 bits. */
+BOOL MYBERSliceGetInteger (const MYBERSlice *slice, int64_t *outValue);
+
+/** A date formatter with the format string "yyyyMMddHHmmss'Z'".
+    The parser and encoder no longer use this; MYASN1ParseTime and MYASN1FormatTime are much
+    faster and handle all the time formats. */
 NSDateFormatter* MYBERGeneralizedTimeFormatter(void);
 NSDateFormatter* MYBERUTCTimeFormatter(void);
@@ -11,6 +11,7 @@
 
 #import "MYBERParser.h"
 #import "MYASN1Object.h"
+#import "MYASN1Time.h"
 #import "MYOID.h"
 #import "MYErrorUtils.h"
 #import "CollectionUtils.h"
@@ -21,14 +22,6 @@
 
 
 
-typedef struct {
-    unsigned tag            :5;
-    unsigned isConstructed  :1;
-    unsigned tagClass       :2;
-    unsigned length         :7;
-    unsigned isLengthLong   :1;
-} BERHeader;
-
 typedef struct {
     const uint8_t *nextChar;
     size_t length;
@@ -66,87 +59,165 @@ static NSString* readStringOrDie(InputData *input, size_t length, NSStringEncodi
 }    
 
 
-static uint32_t readBigEndianUnsignedInteger (InputData *input, size_t length) {
-    if (length == 0 || length > 4)
-        [NSException raise: MYBERParserException format: @"Invalid integer length"];
-    uint32_t result = 0;
-    memcpy(((uint8_t*)&result)+(4-length), readOrDie(input, length), length);
-    return result;
+/* Decodes a big-endian two's-complement integer of 1 to 8 bytes. */
+static int64_t decodeSignedInteger (const uint8_t *bytes, size_t length) {
+    uint64_t result = (uint64_t)(int64_t)(int8_t)bytes[0];    // sign-extend the first byte
+    for (size_t i = 1; i < length; i++)
+        result = (result << 8) | bytes[i];
+    return (int64_t)result;
 }
 
-static int32_t readBigEndianSignedInteger (InputData *input, size_t length) {
-    int32_t result = (int32_t) readBigEndianUnsignedInteger(input,length);
-    uint8_t *dst = ((uint8_t*)&result)+(4-length);
-    if (*dst & 0x80) { // sign-extend negative value
-        while (--dst >= (uint8_t*)&result)
-            *dst = 0xFF;
-    }
-    return result;
+static int64_t readBigEndianSignedInteger (InputData *input, size_t length) {
+    if (length == 0 || length > 8)
+        [NSException raise: MYBERParserException format: @"Invalid integer length"];
+    return decodeSignedInteger(readOrDie(input, length), length);
 }
 
 
 NSDateFormatter* MYBERGeneralizedTimeFormatter(void) {
     static NSDateFormatter *sFmt;
-    if (!sFmt) {
+    static dispatch_once_t once;
+    dispatch_once(&once, ^{
         sFmt = [[NSDateFormatter alloc] init];
         sFmt.dateFormat = @"yyyyMMddHHmmss'Z'";
         sFmt.timeZone = [NSTimeZone timeZoneWithName: @"GMT"];
-    }
+    });
     return sFmt;
 }
 
 NSDateFormatter* MYBERUTCTimeFormatter(void) {
     static NSDateFormatter *sFmt;
-    if (!sFmt) {
+    static dispatch_once_t once;
+    dispatch_once(&once, ^{
         sFmt = [[NSDateFormatter alloc] init];
         sFmt.dateFormat = @"yyMMddHHmmss'Z'";
         sFmt.timeZone = [NSTimeZone timeZoneWithName: @"GMT"];
-    }
+    });
     return sFmt;
 }
 
-static NSDate* parseDate (NSString *dateStr, unsigned tag) {
-    //FIX: There are more date formats possible; need to try them all. (see "Layman's Guide", 5.17)
-    NSDateFormatter *fmt = (tag==23 ?MYBERUTCTimeFormatter() :MYBERGeneralizedTimeFormatter());
-    NSDate *date = [fmt dateFromString: dateStr];
-    if (!date)
-        [NSException raise: MYBERParserException format: @"Unparseable date '%@'", dateStr];
-    return date;
+static NSDate* parseDate (const void *chars, size_t length, unsigned tag) {
+    NSTimeInterval time;
+    if (!MYASN1ParseTime(chars, length, tag, &time))
+        [NSException raise: MYBERParserException format: @"Unparseable date '%.*s'",
+                                                         (int)length, (const char*)chars];
+    return [NSDate dateWithTimeIntervalSince1970: time];
 }
 
 
-static size_t readHeader(InputData *input, BERHeader *header) {
-    memcpy(header, readOrDie(input,2), 2);
-    if (header->tag == 0x1F)
-        [NSException raise: MYBERParserException format: @"Long tags not supported"];
-    if (!header->isLengthLong)
-        return header->length;
-    else {
-        if (header->length == 0)
-            [NSException raise: MYBERParserException format: @"Indefinite length not supported"];
-        return NSSwapBigIntToHost(readBigEndianUnsignedInteger(input,header->length));
+/* Decodes the tag and length at the start of the input into a slice, and advances past them.
+   Does not raise exceptions, so it can be used by the cursor API; instead it returns an
+   error message, or nil on success.
+   For an indefinite-length value, the slice's length is left at 0; see measureIndefinite. */
+static NSString* decodeHeader(InputData *input, MYBERSlice *header) {
+    const uint8_t *start = input->nextChar, *pos = start, *end = start + input->length;
+    if (end - pos < 2)
+        return @"Unexpected EOF on input";
+    uint8_t byte = *pos++;
+    header->tag = byte & 0x1F;
+    header->isConstructed = (byte & 0x20) != 0;
+    header->tagClass = byte >> 6;
+    if (header->tag == 0x1F) {
+        // High tag number: base-128 digits follow, most significant first
+        uint32_t tag = 0;
+        do {
+            if (pos >= end)
+                return @"Unexpected EOF on input";
+            if (tag > (UINT32_MAX >> 7))
+                return @"Tag number too large";
+            byte = *pos++;
+            tag = (tag << 7) | (byte & 0x7F);
+        } while (byte & 0x80);
+        header->tag = tag;
+        if (pos >= end)
+            return @"Unexpected EOF on input";
     }
+
+    size_t length = *pos++;
+    header->isIndefinite = (length == 0x80);
+    if (header->isIndefinite) {
+        if (!header->isConstructed)
+            return @"Indefinite length on primitive value";
+        length = 0;
+    } else if (length & 0x80) {
+        size_t lengthSize = length & 0x7F;
+        if (lengthSize > 4)
+            return @"Invalid integer length";
+        if ((size_t)(end - pos) < lengthSize)
+            return @"Unexpected EOF on input";
+        length = 0;
+        while (lengthSize-- > 0)
+            length = (length << 8) | *pos++;
+    }
+    header->headerLength = pos - start;
+    header->contents = pos;
+    header->length = length;
+    input->nextChar = pos;
+    input->length = end - pos;
+    return nil;
+}
+
+
+/* Is the input positioned at an end-of-contents marker (two zero bytes)? */
+static BOOL atEndOfContents(const InputData *input) {
+    return input->length >= 2 && input->nextChar[0] == 0 && input->nextChar[1] == 0;
+}
+
+
+/* Given the input positioned just after the header of an indefinite-length value, scans ahead
+   to its end-of-contents marker and sets the header's length to that of the contents.
+   The input is not advanced. Returns an error message, or nil on success. */
+static NSString* measureIndefinite(InputData input, MYBERSlice *header, unsigned depth) {
+    if (depth > 64)
+        return @"Indefinite-length values nested too deeply";
+    const uint8_t *contents = input.nextChar;
+    while (!atEndOfContents(&input)) {
+        MYBERSlice item;
+        NSString *errorMessage = decodeHeader(&input, &item);
+        if (!errorMessage && item.isIndefinite)
+            errorMessage = measureIndefinite(input, &item, depth+1);
+        if (errorMessage)
+            return errorMessage;
+        size_t itemLength = item.length + (item.isIndefinite ? 2 : 0);
+        if (itemLength > input.length)
+            return @"Unexpected EOF on input";
+        input.nextChar += itemLength;
+        input.length -= itemLength;
+    }
+    header->length = input.nextChar - contents;
+    return nil;
+}
+
+
+static size_t readHeader(InputData *input, MYBERSlice *header) {
+    NSString *errorMessage = decodeHeader(input, header);
+    if (errorMessage)
+        [NSException raise: MYBERParserException format: @"%@", errorMessage];
+    return header->length;
 }
 
 
 static id parseBER(InputData *input) {
-    BERHeader header;
+    MYBERSlice header;
     size_t length = readHeader(input,&header);
     
-    Class defaultClass = [MYASN1Object class];
-    
     // Tag values can be found in <Security/x509defs.h>. I'm not using them here because that
     // header does not exist on iPhone!
     
     if (header.isConstructed) {
         // Constructed:
         NSMutableArray *items = $marray();
-        InputData subInput = {input->nextChar, length};
-        while (subInput.length > 0) {
-            [items addObject: parseBER(&subInput)];
+        if (header.isIndefinite) {
+            // Items continue up to an end-of-contents marker:
+            while (!atEndOfContents(input))
+                [items addObject: parseBER(input)];
+            readOrDie(input, 2);
+        } else {
+            InputData subInput = {readOrDie(input, length), length};
+            while (subInput.length > 0) {
+                [items addObject: parseBER(&subInput)];
+            }
         }
-        input->nextChar += length;
-        input->length -= length;
 
         if (header.tagClass == 0) {
             switch (header.tag) {
@@ -173,13 +244,14 @@ static id parseBER(InputData *input) {
             case 2: // integer
             case 10: // enum
             {
-                if (length <= 4) {
-                    int32_t value = NSSwapBigIntToHost(readBigEndianSignedInteger(input,length));
-                    return @(value);
+                if (length <= 8) {
+                    return @(readBigEndianSignedInteger(input,length));
+                } else if (header.tag == 2) {
+                    // Big integer! Its bytes go straight into the object, with no NSData:
+                    return [[MYASN1BigInteger alloc] initWithSignedBytes: readOrDie(input, length)
+                                                                  length: length];
                 } else {
-                    // Big integer!
-                    defaultClass = [MYASN1BigInteger class];
-                    break;
+                    break;  // absurdly large enum; fall back to generic MYASN1Object
                 }
             }
             case 3: // bitstring
@@ -196,7 +268,7 @@ static id parseBER(InputData *input) {
                 requireLength(length,0);
                 return [NSNull null];
             case 6: // OID
-                return [[MYOID alloc] initWithBEREncoding: readDataOrDie(input, length)];
+                return [MYOID OIDWithBERBytes: readOrDie(input, length) length: length];
             case 12: // UTF8String
                 return readStringOrDie(input,length,NSUTF8StringEncoding);
             case 18: // numeric string
@@ -212,7 +284,7 @@ static id parseBER(InputData *input) {
             }
             case 23: // UTC time:
             case 24: // Generalized time:
-                return parseDate(readStringOrDie(input,length,NSASCIIStringEncoding), header.tag);
+                return parseDate(readOrDie(input,length), length, header.tag);
             default:
                 Warn(@"MYBERParser: Unrecognized primitive tag %u", header.tag);
                 break;
@@ -221,10 +293,10 @@ static id parseBER(InputData *input) {
     
     // Generic case -- create and return a MYASN1Object:
     NSData *value = readDataOrDie(input, length);
-    return [[defaultClass alloc] initWithTag: header.tag
-                                      ofClass: header.tagClass 
-                                  constructed: header.isConstructed
-                                        value: value];
+    return [[MYASN1Object alloc] initWithTag: header.tag
+                                     ofClass: header.tagClass 
+                                 constructed: header.isConstructed
+                                       value: value];
 }
     
     
@@ -255,8 +327,14 @@ size_t MYBERGetLength (NSData *ber, NSError **outError) {
     CAssert(ber);
     @try{
         InputData input = {ber.bytes, ber.length};
-        BERHeader header;
-        return readHeader(&input,&header);
+        MYBERSlice header;
+        readHeader(&input,&header);
+        if (header.isIndefinite) {
+            NSString *errorMessage = measureIndefinite(input, &header, 0);
+            if (errorMessage)
+                [NSException raise: MYBERParserException format: @"%@", errorMessage];
+        }
+        return header.length;
     }@catch (NSException *x) {
         exceptionToError(x,outError);
     }
@@ -266,7 +344,7 @@ size_t MYBERGetLength (NSData *ber, NSError **outError) {
 const void* MYBERGetContents (NSData *ber, NSError **outError) {
     @try{
         InputData input = {ber.bytes, ber.length};
-        BERHeader header;
+        MYBERSlice header;
         readHeader(&input,&header);
         return input.nextChar;
     }@catch (NSException *x) {
@@ -277,6 +355,74 @@ const void* MYBERGetContents (NSData *ber, NSError **outError) {
 
 
 
+#pragma mark -
+#pragma mark CURSORS:
+
+
+MYBERCursor MYBERCursorMake (const void *bytes, size_t length) {
+    MYBERCursor cursor = {bytes, (const uint8_t*)bytes + length};
+    return cursor;
+}
+
+
+BOOL MYBERCursorNext (MYBERCursor *cursor, MYBERSlice *outSlice, NSError **outError) {
+    if (cursor->nextChar >= cursor->end)
+        return NO;
+    InputData input = {cursor->nextChar, cursor->end - cursor->nextChar};
+    NSString *errorMessage = decodeHeader(&input, outSlice);
+    if (!errorMessage && outSlice->isIndefinite)
+        errorMessage = measureIndefinite(input, outSlice, 0);
+    if (!errorMessage && outSlice->length + (outSlice->isIndefinite ? 2 : 0) > input.length)
+        errorMessage = @"Unexpected EOF on input";
+    if (errorMessage) {
+        if (outError)
+            *outError = MYError(1,MYASN1ErrorDomain, @"%@", errorMessage);
+        return NO;
+    }
+    cursor->nextChar = MYBERSliceGetEncoding(outSlice) + MYBERSliceGetEncodingLength(outSlice);
+    return YES;
+}
+
+
+BOOL MYBERCursorSkip (MYBERCursor *cursor, unsigned count, NSError **outError) {
+    MYBERSlice slice;
+    for (; count > 0; count--) {
+        if (!MYBERCursorNext(cursor, &slice, outError))
+            return NO;
+    }
+    return YES;
+}
+
+
+MYBERCursor MYBERSliceGetCursor (const MYBERSlice *slice) {
+    return MYBERCursorMake(slice->contents, slice->length);
+}
+
+
+id MYBERSliceParse (const MYBERSlice *slice, NSError **outError) {
+    @try{
+        InputData input = {MYBERSliceGetEncoding(slice), MYBERSliceGetEncodingLength(slice)};
+        return parseBER(&input);
+    }@catch (NSException *x) {
+        exceptionToError(x,outError);
+    }
+    return nil;
+}
+
+
+NSData* MYBERSliceCopyContents (const MYBERSlice *slice) {
+    return [NSData dataWithBytes: slice->contents length: slice->length];
+}
+
+BOOL MYBERSliceGetInteger (const MYBERSlice *slice, int64_t *outValue) {
+    if (slice->isConstructed || slice->length == 0 || slice->length > 8)
+        return NO;
+    *outValue = decodeSignedInteger(slice->contents, slice->length);
+    return YES;
+}
+
+
+
 #pragma mark -
 #pragma mark TEST CASES:
 
@@ -310,6 +456,19 @@ TestCase(ParseBER) {
                  @(-123456789));
     CAssertEqual(MYBERParse($data(0x02, 0x04, 0xF8, 0xA4, 0x32, 0xEB), nil),
                  @(-123456789));
+    CAssertEqual(MYBERParse($data(0x02, 0x05, 0x00, 0x80, 0x00, 0x00, 0x00), nil),
+                 @(2147483648LL));
+    CAssertEqual(MYBERParse($data(0x02, 0x06, 0xFF, 0x7F, 0xFF, 0xFF, 0xFF, 0xFF), nil),
+                 @(-140737488355329LL));
+    CAssertEqual(MYBERParse($data(0x02, 0x08, 0x7F, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF), nil),
+                 @(INT64_MAX));
+    CAssertEqual(MYBERParse($data(0x02, 0x08, 0x80, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00), nil),
+                 @(INT64_MIN));
+    MYASN1BigInteger *big = MYBERParse($data(0x02, 0x09, 0x00, 0x80, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01), nil);
+    CAssert([big isKindOfClass: [MYASN1BigInteger class]]);
+    CAssertEqual(big.signedData, $data(0x00, 0x80, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01));
+    CAssertEqual(big.unsignedData, $data(0x80, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01));
+    CAssertNil(MYBERParse($data(0x02, 0x00), nil));
     
     // octet strings:
     CAssertEqual(MYBERParse($data(0x04, 0x05, 'h', 'e', 'l', 'l', 'o'), nil),
@@ -322,6 +481,18 @@ TestCase(ParseBER) {
     // sequences:
     CAssertEqual(MYBERParse($data(0x30, 0x06,  0x02, 0x01, 0x48,  0x01, 0x01, 0xFF), nil),
                  (@[@(72), $true]));
+    CAssertEqual(MYBERParse($data(0x30, 0x80,  0x02, 0x01, 0x48,  0x01, 0x01, 0xFF,  0x00, 0x00), nil),
+                 (@[@(72), $true]));
+    CAssertEqual(MYBERParse($data(0x30, 0x80,  0x30, 0x80, 0x05, 0x00, 0x00, 0x00,  0x00, 0x00), nil),
+                 (@[ @[[NSNull null]] ]));
+    CAssertNil(MYBERParse($data(0x30, 0x80,  0x02, 0x01, 0x48), nil));
+    CAssertNil(MYBERParse($data(0x04, 0x80,  0x00, 0x00), nil));
+
+    // high tag numbers:
+    MYASN1Object *obj = MYBERParse($data(0x9F, 0x81, 0x00, 0x01, 0x2A), nil);
+    CAssertEq(obj.tag, 128u);
+    CAssertEq(obj.tagClass, 2);
+    CAssertEqual(obj.value, $data(0x2A));
     CAssertEqual(MYBERParse($data(0x30, 0x10,  
                                   0x30, 0x06,  0x02, 0x01, 0x48,  0x01, 0x01, 0xFF,
                                   0x30, 0x06,  0x02, 0x01, 0x48,  0x01, 0x01, 0xFF), nil),
@@ -329,6 +500,58 @@ TestCase(ParseBER) {
 }
 
 
+TestCase(BERCursor) {
+    RequireTestCase(ParseBER);
+    NSData *ber = $data(0x30, 0x0B,  0x02, 0x01, 0x48,  0x01, 0x01, 0xFF,  0x04, 0x03, 'a', 'b', 'c');
+    MYBERCursor cursor = MYBERCursorMake(ber.bytes, ber.length);
+    MYBERSlice slice;
+    CAssert(MYBERCursorNext(&cursor, &slice, NULL));
+    CAssert(MYBERCursorAtEnd(&cursor));
+    CAssertEq(slice.tag, 16u);
+    CAssertEq(slice.tagClass, 0);
+    CAssert(slice.isConstructed);
+    CAssertEq(slice.headerLength, (size_t)2);
+    CAssertEq(slice.length, (size_t)11);
+    CAssert(MYBERSliceGetEncoding(&slice) == ber.bytes);
+    CAssertEqual(MYBERSliceParse(&slice, NULL), (@[@(72), $true, [@"abc" dataUsingEncoding: NSASCIIStringEncoding]]));
+
+    MYBERCursor contents = MYBERSliceGetCursor(&slice);
+    MYBERCursor first = contents;
+    MYBERSlice intSlice;
+    int64_t intValue = 0;
+    CAssert(MYBERCursorNext(&first, &intSlice, NULL));
+    CAssert(MYBERSliceGetInteger(&intSlice, &intValue));
+    CAssertEq(intValue, 72LL);
+    CAssert(MYBERCursorSkip(&contents, 2, NULL));
+    CAssert(MYBERCursorNext(&contents, &slice, NULL));
+    CAssertEq(slice.tag, 4u);
+    CAssert(!slice.isConstructed);
+    CAssert(slice.contents == (const uint8_t*)ber.bytes + 10);
+    CAssertEqual(MYBERSliceCopyContents(&slice), [@"abc" dataUsingEncoding: NSASCIIStringEncoding]);
+    CAssert(MYBERCursorAtEnd(&contents));
+    CAssert(!MYBERCursorNext(&contents, &slice, NULL));
+
+    // Indefinite length:
+    ber = $data(0x30, 0x80,  0x02, 0x01, 0x48,  0x00, 0x00,  0x05, 0x00);
+    cursor = MYBERCursorMake(ber.bytes, ber.length);
+    CAssert(MYBERCursorNext(&cursor, &slice, NULL));
+    CAssert(slice.isIndefinite);
+    CAssertEq(slice.length, (size_t)3);
+    CAssertEq(MYBERSliceGetEncodingLength(&slice), (size_t)7);
+    CAssertEqual(MYBERSliceParse(&slice, NULL), (@[@(72)]));
+    CAssert(MYBERCursorNext(&cursor, &slice, NULL));
+    CAssertEq(slice.tag, 5u);
+    CAssert(MYBERCursorAtEnd(&cursor));
+
+    // Truncated input:
+    NSError *error = nil;
+    ber = $data(0x04, 0x05, 'a', 'b');
+    cursor = MYBERCursorMake(ber.bytes, ber.length);
+    CAssert(!MYBERCursorNext(&cursor, &slice, &error));
+    CAssertEqual(error.domain, MYASN1ErrorDomain);
+}
+
+
 #import "MYCertificate.h"
 #import "MYPublicKey.h"
 
@@ -357,6 +580,67 @@ TestCase(ParseCert) {
 }
 
 
+/* Locates the serial number, issuer, validity and subject of a certificate -- the fields most
+   clients actually look at -- without materializing anything. */
+static BOOL getCertFields (NSData *cert, MYBERSlice fields[4]) {
+    MYBERCursor cursor = MYBERCursorMake(cert.bytes, cert.length);
+    MYBERSlice slice;
+    if (!MYBERCursorNext(&cursor, &slice, NULL))            // Certificate
+        return NO;
+    cursor = MYBERSliceGetCursor(&slice);
+    if (!MYBERCursorNext(&cursor, &slice, NULL))            // TBSCertificate
+        return NO;
+    cursor = MYBERSliceGetCursor(&slice);
+    if (!MYBERCursorNext(&cursor, &fields[0], NULL))
+        return NO;
+    if (fields[0].tagClass == 2 && fields[0].tag == 0) {    // optional [0] version
+        if (!MYBERCursorNext(&cursor, &fields[0], NULL))
+            return NO;
+    }
+    return MYBERCursorSkip(&cursor, 1, NULL)                // signature algorithm
+        && MYBERCursorNext(&cursor, &fields[1], NULL)
+        && MYBERCursorNext(&cursor, &fields[2], NULL)
+        && MYBERCursorNext(&cursor, &fields[3], NULL);
+}
+
+TestCase(BERCursorBenchmark) {
+    RequireTestCase(BERCursor);
+    RequireTestCase(ParseCert);
+    static const int kIterations = 2000;
+    for (NSString *filename in @[@"selfsigned.cer", @"selfsigned_email.cer",
+                                 @"iphonedev.cer", @"generated.cer"]) {
+        NSData *cert = [NSData dataWithContentsOfFile: filename];
+        CAssert(cert, @"Couldn't read %@", filename);
+
+        // Check that both paths find the same fields:
+        MYBERSlice fields[4];
+        CAssert(getCertFields(cert, fields));
+        NSArray *info = MYBERParse(cert, NULL)[0];
+        CAssertEqual(MYBERSliceParse(&fields[3], NULL), info[info.count > 6 ? 5 : 4]);
+
+        CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+        for (int i=0; i<kIterations; i++) {
+            @autoreleasepool {
+                NSArray *root = MYBERParse(cert, NULL);
+                info = root[0];
+            }
+        }
+        CFAbsoluteTime treeTime = CFAbsoluteTimeGetCurrent() - start;
+
+        start = CFAbsoluteTimeGetCurrent();
+        BOOL ok = YES;
+        for (int i=0; i<kIterations; i++)
+            ok &= getCertFields(cert, fields);
+        CFAbsoluteTime cursorTime = CFAbsoluteTimeGetCurrent() - start;
+        CAssert(ok);
+
+        Log(@"%@ (%u bytes): MYBERParse %.2fus, cursor %.2fus per cert (%.0fx faster)",
+            filename, (unsigned)cert.length,
+            treeTime/kIterations*1e6, cursorTime/kIterations*1e6, treeTime/cursorTime);
+    }
+}
+
+
 
 /*
  Copyright (c) 2009, Jens Alfke <jens@mooseyard.com>. All rights reserved.
@@ -0,0 +1,108 @@
+//
+//  MYBERStreamParser.h
+//  MYCrypto
+//
+//  Created by Jens Alfke on 10/16/26.
+//  Copyright 2026 Jens Alfke. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+@protocol MYBERStreamParserDelegate;
+
+
+/** Value passed as the length of a constructed value whose length isn't known in advance. */
+#define MYBERIndefiniteLength SIZE_MAX
+
+
+/** An incremental ("push") BER parser. Instead of requiring the entire encoded message up front,
+    like MYBERParse, it accepts input in arbitrary chunks and reports the structure to its delegate
+    as soon as it's been read. Indefinite-length values and high tag numbers are supported.
+    Memory use is bounded: only partial headers, the stack of open constructed values, and
+    primitive values up to maxBufferedLength bytes are ever buffered. */
+@interface MYBERStreamParser : NSObject
+{
+    @private
+    __weak id<MYBERStreamParserDelegate> _delegate;
+    size_t _maxBufferedLength;
+    unsigned _maxDepth;
+    UInt64 _position;
+    uint8_t _headerBuf[16];
+    size_t _headerBufLength;
+    struct MYBERStreamContainer *_stack;
+    unsigned _depth, _stackCapacity;
+    uint32_t _primTag;
+    uint8_t _primClass;
+    BOOL _inPrimitive, _streamingPrimitive;
+    UInt64 _primRemaining;
+    NSMutableData *_primBuffer;
+    NSError *_error;
+}
+
+- (id) initWithDelegate: (id<MYBERStreamParserDelegate>)delegate;
+
+@property (weak, readonly) id<MYBERStreamParserDelegate> delegate;
+
+/** Primitive values longer than this are not buffered; instead they're delivered in pieces
+    to the delegate's partial-primitive method. If the delegate doesn't implement that method,
+    a longer value is treated as an error. Defaults to 64KB. */
+@property size_t maxBufferedLength;
+
+/** The maximum nesting depth of constructed values. Defaults to 64. */
+@property unsigned maxDepth;
+
+/** Parses the next chunk of input, calling the delegate as values are read.
+    Returns NO if the input is invalid; after that, the parser rejects any further input. */
+- (BOOL) parseBytes: (const void*)bytes length: (size_t)length error: (NSError**)outError;
+
+- (BOOL) parseData: (NSData*)data error: (NSError**)outError;
+
+/** Call this at the end of the input. Returns NO if the input stopped partway through a value. */
+- (BOOL) finish: (NSError**)outError;
+
+/** The number of constructed values currently open. */
+@property (readonly) unsigned depth;
+
+/** The total number of bytes parsed so far. */
+@property (readonly) UInt64 bytesParsed;
+
+/** The error that stopped the parser, if any. */
+@property (readonly, strong) NSError *error;
+
+@end
+
+
+
+@protocol MYBERStreamParserDelegate <NSObject>
+
+/** Called when the header of a constructed value has been read.
+    The length is MYBERIndefiniteLength if the value has indefinite length. */
+- (void) berParser: (MYBERStreamParser*)parser
+    didStartConstructedTag: (uint32_t)tag
+                     class: (uint8_t)tagClass
+                    length: (size_t)length;
+
+/** Called when the last item in a constructed value has been read. */
+- (void) berParser: (MYBERStreamParser*)parser
+    didEndConstructedTag: (uint32_t)tag
+                   class: (uint8_t)tagClass;
+
+/** Called when a complete primitive value has been read.
+    The bytes are only valid for the duration of the call; copy them if you need them later. */
+- (void) berParser: (MYBERStreamParser*)parser
+    didReadPrimitiveTag: (uint32_t)tag
+                  class: (uint8_t)tagClass
+                  bytes: (const void*)bytes
+                 length: (size_t)length;
+
+@optional
+
+/** Called with successive pieces of a primitive value longer than the parser's maxBufferedLength.
+    `final` is YES on the last piece. The bytes are only valid for the duration of the call. */
+- (void) berParser: (MYBERStreamParser*)parser
+    didReadPartialPrimitiveTag: (uint32_t)tag
+                         class: (uint8_t)tagClass
+                         bytes: (const void*)bytes
+                        length: (size_t)length
+                         final: (BOOL)final;
+
+@end
@@ -0,0 +1,424 @@
+//
+//  MYBERStreamParser.m
+//  MYCrypto
+//
+//  Created by Jens Alfke on 10/16/26.
+//  Copyright 2026 Jens Alfke. All rights reserved.
+//
+
+// Reference:
+// <http://luca.ntop.org/Teaching/Appunti/asn1.html> "Layman's Guide To ASN.1/BER/DER"
+
+#import "MYBERStreamParser.h"
+#import "MYBERParser.h"
+#import "MYErrorUtils.h"
+#import "Test.h"
+
+
+/* An open constructed value. */
+struct MYBERStreamContainer {
+    uint32_t tag;
+    uint8_t tagClass;
+    BOOL indefinite;
+    UInt64 limit;           // Position of end of innermost definite-length container (or self)
+};
+
+typedef struct {
+    uint32_t tag;
+    uint8_t tagClass;
+    BOOL isConstructed;
+    BOOL isIndefinite;
+    UInt64 length;
+} StreamHeader;
+
+enum {
+    kHeaderInvalid = -1,
+    kHeaderIncomplete = 0,
+    kHeaderComplete = 1
+};
+
+
+/* Tries to decode a header from the bytes buffered so far. Returns kHeaderIncomplete if more
+   bytes are needed, or kHeaderInvalid (and an error message) if the bytes can't be a header. */
+static int decodeStreamHeader(const uint8_t *buf, size_t len, StreamHeader *h, NSString **outMessage) {
+    const uint8_t *pos = buf, *end = buf + len;
+    if (pos >= end)
+        return kHeaderIncomplete;
+    uint8_t byte = *pos++;
+    h->tag = byte & 0x1F;
+    h->isConstructed = (byte & 0x20) != 0;
+    h->tagClass = byte >> 6;
+    if (h->tag == 0x1F) {
+        // High tag number: base-128 digits follow, most significant first
+        uint32_t tag = 0;
+        do {
+            if (pos >= end)
+                return kHeaderIncomplete;
+            if (tag > (UINT32_MAX >> 7)) {
+                *outMessage = @"Tag number too large";
+                return kHeaderInvalid;
+            }
+            byte = *pos++;
+            tag = (tag << 7) | (byte & 0x7F);
+        } while (byte & 0x80);
+        h->tag = tag;
+    }
+
+    if (pos >= end)
+        return kHeaderIncomplete;
+    UInt64 length = *pos++;
+    h->isIndefinite = (length == 0x80);
+    if (h->isIndefinite) {
+        if (!h->isConstructed) {
+            *outMessage = @"Indefinite length on primitive value";
+            return kHeaderInvalid;
+        }
+        length = 0;
+    } else if (length & 0x80) {
+        size_t lengthSize = length & 0x7F;
+        if (lengthSize > 4) {
+            *outMessage = @"Invalid integer length";
+            return kHeaderInvalid;
+        }
+        if ((size_t)(end - pos) < lengthSize)
+            return kHeaderIncomplete;
+        length = 0;
+        while (lengthSize-- > 0)
+            length = (length << 8) | *pos++;
+    }
+    h->length = length;
+    return kHeaderComplete;
+}
+
+
+
+@implementation MYBERStreamParser
+
+
+- (id) initWithDelegate: (id<MYBERStreamParserDelegate>)delegate {
+    self = [super init];
+    if (self != nil) {
+        _delegate = delegate;
+        _maxBufferedLength = 64*1024;
+        _maxDepth = 64;
+    }
+    return self;
+}
+
+- (void) dealloc {
+    free(_stack);
+}
+
+
+@synthesize delegate=_delegate, maxBufferedLength=_maxBufferedLength, maxDepth=_maxDepth,
+            depth=_depth, bytesParsed=_position, error=_error;
+
+
+- (void) _fail: (NSString*)message {
+    if (!_error)
+        _error = MYError(1, MYASN1ErrorDomain, @"%@ (at offset %llu)", message, _position);
+}
+
+
+/* Pops every definite-length container whose contents have all been read. */
+- (void) _closeFinishedContainers {
+    while (_depth > 0) {
+        struct MYBERStreamContainer *top = &_stack[_depth-1];
+        if (top->indefinite || _position < top->limit)
+            break;
+        _depth--;
+        [_delegate berParser: self didEndConstructedTag: top->tag class: top->tagClass];
+    }
+}
+
+
+- (void) _startValue: (const StreamHeader*)h {
+    struct MYBERStreamContainer *top = _depth ? &_stack[_depth-1] : NULL;
+    UInt64 limit = top ? top->limit : UINT64_MAX;
+    if (_position > limit || h->length > limit - _position) {
+        [self _fail: @"Value overruns its container"];
+        return;
+    }
+
+    if (h->tag == 0 && h->tagClass == 0 && !h->isConstructed) {
+        // End-of-contents marker:
+        if (h->length != 0 || !top || !top->indefinite) {
+            [self _fail: @"Unexpected end-of-contents marker"];
+            return;
+        }
+        _depth--;
+        [_delegate berParser: self didEndConstructedTag: top->tag class: top->tagClass];
+        [self _closeFinishedContainers];
+
+    } else if (h->isConstructed) {
+        if (_depth >= _maxDepth) {
+            [self _fail: @"Values nested too deeply"];
+            return;
+        }
+        if (_depth >= _stackCapacity) {
+            unsigned capacity = MAX(8u, 2*_stackCapacity);
+            void *stack = realloc(_stack, capacity * sizeof(struct MYBERStreamContainer));
+            if (!stack) {
+                [self _fail: @"Out of memory"];
+                return;
+            }
+            _stack = stack;
+            _stackCapacity = capacity;
+            top = _depth ? &_stack[_depth-1] : NULL;
+        }
+        struct MYBERStreamContainer *c = &_stack[_depth++];
+        c->tag = h->tag;
+        c->tagClass = h->tagClass;
+        c->indefinite = h->isIndefinite;
+        c->limit = h->isIndefinite ? limit : _position + h->length;
+        [_delegate berParser: self didStartConstructedTag: h->tag
+                       class: h->tagClass
+                      length: (h->isIndefinite ? MYBERIndefiniteLength : (size_t)h->length)];
+        [self _closeFinishedContainers];
+
+    } else {
+        _inPrimitive = YES;
+        _primTag = h->tag;
+        _primClass = h->tagClass;
+        _primRemaining = h->length;
+        _streamingPrimitive = (h->length > _maxBufferedLength);
+        if (_streamingPrimitive && ![_delegate respondsToSelector: @selector(berParser:didReadPartialPrimitiveTag:class:bytes:length:final:)]) {
+            [self _fail: @"Primitive value too large to buffer"];
+            return;
+        }
+        if (h->length == 0) {
+            _inPrimitive = NO;
+            [_delegate berParser: self didReadPrimitiveTag: _primTag class: _primClass
+                           bytes: NULL length: 0];
+            [self _closeFinishedContainers];
+        }
+    }
+}
+
+
+- (const uint8_t*) _readHeader: (const uint8_t*)pos end: (const uint8_t*)end {
+    while (pos < end) {
+        if (_headerBufLength >= sizeof(_headerBuf)) {
+            [self _fail: @"Invalid header"];
+            return end;
+        }
+        _headerBuf[_headerBufLength++] = *pos++;
+        _position++;
+        StreamHeader h;
+        NSString *message = nil;
+        int status = decodeStreamHeader(_headerBuf, _headerBufLength, &h, &message);
+        if (status == kHeaderComplete) {
+            _headerBufLength = 0;
+            [self _startValue: &h];
+            break;
+        } else if (status == kHeaderInvalid) {
+            [self _fail: message];
+            break;
+        }
+    }
+    return pos;
+}
+
+
+- (const uint8_t*) _readPrimitiveContents: (const uint8_t*)pos end: (const uint8_t*)end {
+    size_t n = (size_t) MIN((UInt64)(end - pos), _primRemaining);
+    _primRemaining -= n;
+    _position += n;
+    BOOL done = (_primRemaining == 0);
+    if (_streamingPrimitive) {
+        [_delegate berParser: self didReadPartialPrimitiveTag: _primTag class: _primClass
+                       bytes: pos length: n final: done];
+    } else if (done && _primBuffer.length == 0) {
+        // The entire value is in this chunk, so pass it on without copying it:
+        [_delegate berParser: self didReadPrimitiveTag: _primTag class: _primClass
+                       bytes: pos length: n];
+    } else {
+        if (!_primBuffer)
+            _primBuffer = [[NSMutableData alloc] initWithCapacity: 256];
+        [_primBuffer appendBytes: pos length: n];
+        if (done)
+            [_delegate berParser: self didReadPrimitiveTag: _primTag class: _primClass
+                           bytes: _primBuffer.bytes length: _primBuffer.length];
+    }
+    if (done) {
+        _inPrimitive = NO;
+        _primBuffer.length = 0;
+        [self _closeFinishedContainers];
+    }
+    return pos + n;
+}
+
+
+- (BOOL) parseBytes: (const void*)bytes length: (size_t)length error: (NSError**)outError {
+    const uint8_t *pos = bytes, *end = pos + length;
+    while (pos < end && !_error) {
+        if (_inPrimitive)
+            pos = [self _readPrimitiveContents: pos end: end];
+        else
+            pos = [self _readHeader: pos end: end];
+    }
+    if (_error) {
+        if (outError) *outError = _error;
+        return NO;
+    }
+    return YES;
+}
+
+- (BOOL) parseData: (NSData*)data error: (NSError**)outError {
+    return [self parseBytes: data.bytes length: data.length error: outError];
+}
+
+
+- (BOOL) finish: (NSError**)outError {
+    if (!_error && (_headerBufLength > 0 || _inPrimitive || _depth > 0))
+        [self _fail: @"Unexpected EOF on input"];
+    if (_error) {
+        if (outError) *outError = _error;
+        return NO;
+    }
+    return YES;
+}
+
+
+@end
+
+
+
+
+#pragma mark -
+#pragma mark TEST CASES:
+
+
+#define $data(BYTES...)    ({const uint8_t bytes[] = {BYTES}; [NSData dataWithBytes: bytes length: sizeof(bytes)];})
+
+
+/* Test delegate that records the events it receives as a string. */
+@interface MYBERStreamRecorder : NSObject <MYBERStreamParserDelegate>
+{
+    @public
+    NSMutableString *_log;
+}
+@end
+
+@implementation MYBERStreamRecorder
+
+- (id) init {
+    self = [super init];
+    if (self)
+        _log = [[NSMutableString alloc] init];
+    return self;
+}
+
+- (void) _logBytes: (const void*)bytes length: (size_t)length {
+    for (size_t i=0; i<length; i++)
+        [_log appendFormat: @"%02x", ((const uint8_t*)bytes)[i]];
+}
+
+- (void) berParser: (MYBERStreamParser*)parser didStartConstructedTag: (uint32_t)tag
+             class: (uint8_t)tagClass length: (size_t)length {
+    if (length == MYBERIndefiniteLength)
+        [_log appendFormat: @"[%u/%u* ", tagClass, tag];
+    else
+        [_log appendFormat: @"[%u/%u ", tagClass, tag];
+}
+
+- (void) berParser: (MYBERStreamParser*)parser didEndConstructedTag: (uint32_t)tag
+             class: (uint8_t)tagClass {
+    [_log appendFormat: @"] "];
+}
+
+- (void) berParser: (MYBERStreamParser*)parser didReadPrimitiveTag: (uint32_t)tag
+             class: (uint8_t)tagClass bytes: (const void*)bytes length: (size_t)length {
+    [_log appendFormat: @"%u/%u=", tagClass, tag];
+    [self _logBytes: bytes length: length];
+    [_log appendString: @" "];
+}
+
+- (void) berParser: (MYBERStreamParser*)parser didReadPartialPrimitiveTag: (uint32_t)tag
+             class: (uint8_t)tagClass bytes: (const void*)bytes length: (size_t)length
+             final: (BOOL)final {
+    [_log appendFormat: @"%u/%u~", tagClass, tag];
+    [self _logBytes: bytes length: length];
+    [_log appendString: (final ? @" " : @"~")];
+}
+
+@end
+
+
+static NSString* streamParse(NSData *input, size_t chunkSize, size_t maxBuffered, NSError **outError) {
+    MYBERStreamRecorder *recorder = [[MYBERStreamRecorder alloc] init];
+    MYBERStreamParser *parser = [[MYBERStreamParser alloc] initWithDelegate: recorder];
+    if (maxBuffered)
+        parser.maxBufferedLength = maxBuffered;
+    const uint8_t *bytes = input.bytes;
+    for (size_t pos = 0; pos < input.length; pos += chunkSize) {
+        if (![parser parseBytes: bytes + pos length: MIN(chunkSize, input.length - pos) error: outError])
+            return nil;
+    }
+    if (![parser finish: outError])
+        return nil;
+    return recorder->_log;
+}
+
+
+TestCase(BERStreamParser) {
+    NSData *input = $data(0x30, 0x80,
+                              0x02, 0x01, 0x48,
+                              0x24, 0x80,
+                                  0x04, 0x02, 'a', 'b',
+                                  0x04, 0x01, 'c',
+                              0x00, 0x00,
+                              0x30, 0x00,
+                          0x00, 0x00,
+                          0x9F, 0x81, 0x00, 0x01, 0x2A);
+    NSString *expected = @"[0/16* 0/2=48 [0/4* 0/4=6162 0/4=63 ] [0/16 ] ] 2/128=2a ";
+    CAssertEqual(streamParse(input, input.length, 0, NULL), expected);
+    CAssertEqual(streamParse(input, 1, 0, NULL), expected);
+    CAssertEqual(streamParse(input, 3, 0, NULL), expected);
+    CAssertEqual(streamParse(input, 1, 1, NULL),
+                 @"[0/16* 0/2=48 [0/4* 0/4~61~0/4~62 0/4=63 ] [0/16 ] ] 2/128=2a ");
+
+    // Errors:
+    NSError *error = nil;
+    CAssertNil(streamParse($data(0x30, 0x80, 0x05, 0x00), 1, 0, &error));
+    CAssertEqual(error.domain, MYASN1ErrorDomain);
+    CAssertNil(streamParse($data(0x30, 0x02, 0x04, 0x01, 0x00), 2, 0, NULL));
+    CAssertNil(streamParse($data(0x00, 0x00), 2, 0, NULL));
+    CAssertNil(streamParse($data(0x04, 0x03, 'a', 'b'), 2, 0, NULL));
+}
+
+
+TestCase(BERStreamParseCert) {
+    RequireTestCase(BERStreamParser);
+    NSData *cert = [NSData dataWithContentsOfFile: @"selfsigned_email.cer"];
+    CAssert(cert);
+    NSString *whole = streamParse(cert, cert.length, 0, NULL);
+    CAssert(whole);
+    Log(@"Stream-parsed selfsigned_email.cer: %@", whole);
+    for (size_t chunkSize = 1; chunkSize < 20; chunkSize += 3)
+        CAssertEqual(streamParse(cert, chunkSize, 0, NULL), whole);
+}
+
+
+
+/*
+ Copyright (c) 2009, Jens Alfke <jens@mooseyard.com>. All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification, are permitted
+ provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice, this list of conditions
+ and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions
+ and the following disclaimer in the documentation and/or other materials provided with the
+ distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRI-
+ BUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
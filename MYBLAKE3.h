@@ -0,0 +1,35 @@
+//
+//  MYBLAKE3.h
+//  MYCrypto
+//
+//  Created by Jens Alfke on 10/16/26.
+//  Copyright 2026 Jens Alfke. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+
+/*  A portable implementation of the BLAKE3 hash function, producing the default 32-byte output.
+    BLAKE3 splits its input into 1KB chunks that are hashed independently and then combined in a
+    binary tree, so MYBLAKE3() hashes large inputs on all available cores.
+    The context is a plain struct, so it can be copied with memcpy to fork a digest. */
+
+
+/** State of an incremental BLAKE3 digest. Initialize with MYBLAKE3Init. */
+typedef struct {
+    uint32_t cv[8];             // Chaining value of the current chunk
+    uint64_t chunkCounter;      // Index of the current chunk
+    uint8_t block[64];          // Partial block
+    uint8_t blockLength;        // Number of bytes in block
+    uint8_t blocksCompressed;   // Number of complete blocks of the current chunk already compressed
+    uint8_t cvStackLength;
+    uint32_t cvStack[54][8];    // Chaining values of completed subtrees, awaiting their siblings
+} MYBLAKE3Context;
+
+void MYBLAKE3Init (MYBLAKE3Context *context);
+void MYBLAKE3Update (MYBLAKE3Context *context, const void *bytes, size_t length);
+void MYBLAKE3Final (const MYBLAKE3Context *context, void *outDigest);
+
+/** Computes the 32-byte BLAKE3 digest of a buffer. Inputs larger than a few hundred KB are
+    hashed in parallel. */
+void MYBLAKE3 (const void *bytes, size_t length, void *outDigest);
@@ -0,0 +1,392 @@
+//
+//  MYBLAKE3.m
+//  MYCrypto
+//
+//  Created by Jens Alfke on 10/16/26.
+//  Copyright 2026 Jens Alfke. All rights reserved.
+//
+
+// References:
+// <https://github.com/BLAKE3-team/BLAKE3-specs/blob/master/blake3.pdf> "BLAKE3"
+// <https://github.com/BLAKE3-team/BLAKE3/blob/master/reference_impl/reference_impl.rs>
+
+#import "MYBLAKE3.h"
+#import "Test.h"
+
+
+#define kChunkLength 1024
+#define kBlockLength 64
+
+/* Domain separation flags. */
+enum {
+    kChunkStart = 1 << 0,
+    kChunkEnd   = 1 << 1,
+    kParent     = 1 << 2,
+    kRoot       = 1 << 3,
+};
+
+/* MYBLAKE3() hands each dispatch_apply work item this many chunks (a complete 64KB subtree), and
+   only goes parallel if there are at least three work items. */
+#define kChunksPerWorkItem 64
+#define kMinParallelLength (3 * kChunksPerWorkItem * kChunkLength)
+
+
+static const uint32_t kIV[8] = {
+    0x6A09E667, 0xBB67AE85, 0x3C6EF372, 0xA54FF53A, 0x510E527F, 0x9B05688C, 0x1F83D9AB, 0x5BE0CD19
+};
+
+/* The message word order of each of the 7 rounds: the spec's permutation, applied 0..6 times. */
+static const uint8_t kMessageSchedule[7][16] = {
+    { 0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14, 15},
+    { 2,  6,  3, 10,  7,  0,  4, 13,  1, 11, 12,  5,  9, 14, 15,  8},
+    { 3,  4, 10, 12, 13,  2,  7, 14,  6,  5,  9,  0, 11, 15,  8,  1},
+    {10,  7, 12,  9, 14,  3, 13, 15,  4,  0, 11,  2,  5,  8,  1,  6},
+    {12, 13,  9, 11, 15, 10, 14,  8,  7,  2,  5,  3,  0,  1,  6,  4},
+    { 9, 14, 11,  5,  8, 12, 15,  1, 13,  3,  0, 10,  2,  6,  4,  7},
+    {11, 15,  5,  0,  1,  9,  8,  6, 14, 10,  2, 12,  3,  4,  7, 13},
+};
+
+
+static inline uint32_t ror32 (uint32_t x, unsigned n)   {return (x >> n) | (x << (32 - n));}
+
+static inline uint32_t readLE32 (const uint8_t *p) {
+    return (uint32_t)p[3] << 24 | (uint32_t)p[2] << 16 | (uint32_t)p[1] << 8 | p[0];
+}
+
+static inline void writeLE32 (uint8_t *p, uint32_t n) {
+    p[0] = (uint8_t)n;  p[1] = (uint8_t)(n >> 8);  p[2] = (uint8_t)(n >> 16);  p[3] = (uint8_t)(n >> 24);
+}
+
+
+#pragma mark -
+#pragma mark COMPRESSION:
+
+
+#define G(A, B, C, D, X, Y) do {                        \
+    s[A] += s[B] + (X);  s[D] = ror32(s[D] ^ s[A], 16); \
+    s[C] += s[D];        s[B] = ror32(s[B] ^ s[C], 12); \
+    s[A] += s[B] + (Y);  s[D] = ror32(s[D] ^ s[A], 8);  \
+    s[C] += s[D];        s[B] = ror32(s[B] ^ s[C], 7);  \
+} while (0)
+
+/* The compression function, truncated to the 8 words that are used as a chaining value or as the
+   32-byte root output. outCV may be the same as cv. */
+static void compress (const uint32_t cv[8], const uint32_t m[16],
+                      uint64_t counter, uint32_t blockLength, uint32_t flags,
+                      uint32_t outCV[8])
+{
+    uint32_t s[16] = {
+        cv[0], cv[1], cv[2], cv[3], cv[4], cv[5], cv[6], cv[7],
+        kIV[0], kIV[1], kIV[2], kIV[3],
+        (uint32_t)counter, (uint32_t)(counter >> 32), blockLength, flags
+    };
+    for (int r = 0; r < 7; r++) {
+        const uint8_t *sched = kMessageSchedule[r];
+        G(0, 4,  8, 12, m[sched[ 0]], m[sched[ 1]]);
+        G(1, 5,  9, 13, m[sched[ 2]], m[sched[ 3]]);
+        G(2, 6, 10, 14, m[sched[ 4]], m[sched[ 5]]);
+        G(3, 7, 11, 15, m[sched[ 6]], m[sched[ 7]]);
+        G(0, 5, 10, 15, m[sched[ 8]], m[sched[ 9]]);
+        G(1, 6, 11, 12, m[sched[10]], m[sched[11]]);
+        G(2, 7,  8, 13, m[sched[12]], m[sched[13]]);
+        G(3, 4,  9, 14, m[sched[14]], m[sched[15]]);
+    }
+    for (int i = 0; i < 8; i++)
+        outCV[i] = s[i] ^ s[i + 8];
+}
+
+#undef G
+
+
+/* Compresses a block of bytes, which must be zero-padded to 64 bytes if blockLength is less. */
+static inline void compressBlock (const uint32_t cv[8], const uint8_t block[kBlockLength],
+                                  uint64_t counter, uint32_t blockLength, uint32_t flags,
+                                  uint32_t outCV[8])
+{
+    uint32_t m[16];
+    for (int i = 0; i < 16; i++)
+        m[i] = readLE32(block + 4*i);
+    compress(cv, m, counter, blockLength, flags, outCV);
+}
+
+/* Combines the chaining values of two sibling subtrees. outCV may be the same as left or right. */
+static inline void parentCV (const uint32_t left[8], const uint32_t right[8], uint32_t flags,
+                             uint32_t outCV[8])
+{
+    uint32_t m[16];
+    memcpy(m, left, 32);
+    memcpy(m + 8, right, 32);
+    compress(kIV, m, 0, kBlockLength, kParent | flags, outCV);
+}
+
+/* Computes the chaining value of a complete chunk (or of the final, possibly partial, one.) */
+static void chunkCV (const uint8_t *chunk, size_t length, uint64_t counter, uint32_t flags,
+                     uint32_t outCV[8])
+{
+    memcpy(outCV, kIV, 32);
+    uint32_t startFlag = kChunkStart;
+    for (; length > kBlockLength; chunk += kBlockLength, length -= kBlockLength) {
+        compressBlock(outCV, chunk, counter, kBlockLength, flags | startFlag, outCV);
+        startFlag = 0;
+    }
+    uint8_t block[kBlockLength] = {0};
+    memcpy(block, chunk, length);
+    compressBlock(outCV, block, counter, (uint32_t)length, flags | startFlag | kChunkEnd, outCV);
+}
+
+/* Reduces a level of chaining values to a single one, pairing them up level by level with the
+   odd one out passed up unchanged; this gives the same tree shape as the spec's left-complete
+   tree. The last parent gets the given flags. Overwrites the array. */
+static void reduceCVs (uint32_t cvs[][8], size_t count, uint32_t flags, uint32_t outCV[8]) {
+    if (count == 1) {
+        memcpy(outCV, cvs[0], 32);
+        return;
+    }
+    for (; count > 2; count = (count + 1) / 2) {
+        for (size_t i = 0; i < count / 2; i++)
+            parentCV(cvs[2*i], cvs[2*i + 1], 0, cvs[i]);
+        if (count & 1)
+            memcpy(cvs[count / 2], cvs[count - 1], 32);
+    }
+    parentCV(cvs[0], cvs[1], flags, outCV);
+}
+
+static void writeDigest (const uint32_t cv[8], void *outDigest) {
+    for (int i = 0; i < 8; i++)
+        writeLE32((uint8_t*)outDigest + 4*i, cv[i]);
+}
+
+
+#pragma mark -
+#pragma mark CONTEXTS:
+
+
+static inline size_t chunkLength (const MYBLAKE3Context *context) {
+    return context->blocksCompressed * kBlockLength + context->blockLength;
+}
+
+static inline uint32_t startFlag (const MYBLAKE3Context *context) {
+    return context->blocksCompressed == 0 ? kChunkStart : 0;
+}
+
+/* Adds a completed chunk's chaining value to the stack, first merging it with every completed
+   subtree it's the right sibling of. (The number of merges is the number of trailing zero bits
+   of the total chunk count.) */
+static void pushChunkCV (MYBLAKE3Context *context, uint32_t cv[8], uint64_t totalChunks) {
+    for (; (totalChunks & 1) == 0; totalChunks >>= 1)
+        parentCV(context->cvStack[--context->cvStackLength], cv, 0, cv);
+    memcpy(context->cvStack[context->cvStackLength++], cv, 32);
+}
+
+
+void MYBLAKE3Init (MYBLAKE3Context *context) {
+    memcpy(context->cv, kIV, sizeof(context->cv));
+    context->chunkCounter = 0;
+    context->blockLength = 0;
+    context->blocksCompressed = 0;
+    context->cvStackLength = 0;
+}
+
+void MYBLAKE3Update (MYBLAKE3Context *context, const void *bytes, size_t length) {
+    const uint8_t *input = bytes;
+    while (length > 0) {
+        // The last block of a chunk can't be compressed until it's known whether it's the last
+        // block of the input, which gets the root flag; so chunks are finished lazily.
+        if (chunkLength(context) == kChunkLength) {
+            uint32_t cv[8];
+            compressBlock(context->cv, context->block, context->chunkCounter,
+                          kBlockLength, kChunkEnd, cv);
+            pushChunkCV(context, cv, ++context->chunkCounter);
+            memcpy(context->cv, kIV, sizeof(context->cv));
+            context->blocksCompressed = 0;
+            context->blockLength = 0;
+        }
+        if (context->blockLength == kBlockLength) {
+            compressBlock(context->cv, context->block, context->chunkCounter,
+                          kBlockLength, startFlag(context), context->cv);
+            context->blocksCompressed++;
+            context->blockLength = 0;
+        }
+        // Compress whole blocks straight from the input, except a chunk's last block:
+        while (context->blockLength == 0 && length > kBlockLength
+                    && context->blocksCompressed < kChunkLength / kBlockLength - 1) {
+            compressBlock(context->cv, input, context->chunkCounter,
+                          kBlockLength, startFlag(context), context->cv);
+            context->blocksCompressed++;
+            input += kBlockLength;
+            length -= kBlockLength;
+        }
+        size_t n = MIN(length, (size_t)(kBlockLength - context->blockLength));
+        memcpy(context->block + context->blockLength, input, n);
+        context->blockLength += (uint8_t)n;
+        input += n;
+        length -= n;
+    }
+}
+
+void MYBLAKE3Final (const MYBLAKE3Context *context, void *outDigest) {
+    uint8_t block[kBlockLength] = {0};
+    memcpy(block, context->block, context->blockLength);
+    uint32_t flags = startFlag(context) | kChunkEnd;
+    uint32_t cv[8];
+    if (context->cvStackLength == 0) {
+        compressBlock(context->cv, block, context->chunkCounter, context->blockLength,
+                      flags | kRoot, cv);
+    } else {
+        compressBlock(context->cv, block, context->chunkCounter, context->blockLength, flags, cv);
+        for (int i = context->cvStackLength - 1; i >= 0; i--)
+            parentCV(context->cvStack[i], cv, (i == 0 ? kRoot : 0), cv);
+    }
+    writeDigest(cv, outDigest);
+}
+
+
+void MYBLAKE3 (const void *bytes, size_t length, void *outDigest) {
+    if (length < kMinParallelLength) {
+        MYBLAKE3Context context;
+        MYBLAKE3Init(&context);
+        MYBLAKE3Update(&context, bytes, length);
+        MYBLAKE3Final(&context, outDigest);
+        return;
+    }
+
+    // Each work item computes the chaining value of an aligned 64-chunk subtree (the last one
+    // may be partial), then those are combined into the root:
+    static const size_t kWorkItemLength = kChunksPerWorkItem * kChunkLength;
+    size_t nWorkItems = (length + kWorkItemLength - 1) / kWorkItemLength;
+    uint32_t (*subtreeCVs)[8] = malloc(nWorkItems * sizeof(*subtreeCVs));
+    Assert(subtreeCVs);
+    dispatch_apply(nWorkItems, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0),
+                   ^(size_t item) {
+        const uint8_t *start = (const uint8_t*)bytes + item * kWorkItemLength;
+        size_t itemLength = MIN(kWorkItemLength, length - item * kWorkItemLength);
+        uint32_t cvs[kChunksPerWorkItem][8];
+        size_t nChunks = 0;
+        for (size_t pos = 0; pos < itemLength; pos += kChunkLength, nChunks++)
+            chunkCV(start + pos, MIN((size_t)kChunkLength, itemLength - pos),
+                    item * kChunksPerWorkItem + nChunks, 0, cvs[nChunks]);
+        reduceCVs(cvs, nChunks, 0, subtreeCVs[item]);
+    });
+    uint32_t root[8];
+    reduceCVs(subtreeCVs, nWorkItems, kRoot, root);
+    free(subtreeCVs);
+    writeDigest(root, outDigest);
+}
+
+
+
+#pragma mark -
+#pragma mark TEST CASES:
+
+
+static NSString* hexDigest (const void *bytes, size_t length) {
+    NSMutableString *hex = [NSMutableString string];
+    for (size_t i = 0; i < length; i++)
+        [hex appendFormat: @"%02x", ((const uint8_t*)bytes)[i]];
+    return hex;
+}
+
+/* The official test vectors use input bytes 0, 1, ..., 250, 0, 1, ... */
+static NSData* testInput (size_t length) {
+    NSMutableData *data = [NSMutableData dataWithLength: length];
+    uint8_t *bytes = data.mutableBytes;
+    for (size_t i = 0; i < length; i++)
+        bytes[i] = (uint8_t)(i % 251);
+    return data;
+}
+
+
+TestCase(MYBLAKE3) {
+    // From the official test_vectors.json (the first 32 bytes of each extended output):
+    static const struct {size_t length; const char *hash;} kVectors[] = {
+        {0,     "af1349b9f5f9a1a6a0404dea36dcc9499bcb25c9adc112b7cc9a93cae41f3262"},
+        {1,     "2d3adedff11b61f14c886e35afa036736dcd87a74d27b5c1510225d0f592e213"},
+        {1023,  "10108970eeda3eb932baac1428c7a2163b0e924c9a9e25b35bba72b28f70bd11"},
+        {1024,  "42214739f095a406f3fc83deb889744ac00df831c10daa55189b5d121c855af7"},
+        {1025,  "d00278ae47eb27b34faecf67b4fe263f82d5412916c1ffd97c8cb7fb814b8444"},
+        {2048,  "e776b6028c7cd22a4d0ba182a8bf62205d2ef576467e838ed6f2529b85fba24a"},
+        {2049,  "5f4d72f40d7a5f82b15ca2b2e44b1de3c2ef86c426c95c1af0b6879522563030"},
+        {3072,  "b98cb0ff3623be03326b373de6b9095218513e64f1ee2edd2525c7ad1e5cffd2"},
+        {3073,  "7124b49501012f81cc7f11ca069ec9226cecb8a2c850cfe644e327d22d3e1cd3"},
+        {4096,  "015094013f57a5277b59d8475c0501042c0b642e531b0a1c8f58d2163229e969"},
+        {4097,  "9b4052b38f1c5fc8b1f9ff7ac7b27cd242487b3d890d15c96a1c25b8aa0fb995"},
+        {8192,  "aae792484c8efe4f19e2ca7d371d8c467ffb10748d8a5a1ae579948f718a2a63"},
+        {8193,  "bab6c09cb8ce8cf459261398d2e7aef35700bf488116ceb94a36d0f5f1b7bc3b"},
+        {16384, "f875d6646de28985646f34ee13be9a576fd515f76b5b0a26bb324735041ddde4"},
+        {31744, "62b6960e1a44bcc1eb1a611a8d6235b6b4b78f32e7abc4fb4c6cdcce94895c47"},
+        {102400, "bc3e3d41a1146b069abffad3c0d44860cf664390afce4d9661f7902e7943e085"},
+    };
+    for (size_t i = 0; i < sizeof(kVectors) / sizeof(kVectors[0]); i++) {
+        NSData *input = testInput(kVectors[i].length);
+        uint8_t digest[32];
+        MYBLAKE3(input.bytes, input.length, digest);
+        CAssertEqual(hexDigest(digest, 32), @(kVectors[i].hash));
+
+        // Incremental updates in odd-sized pieces:
+        MYBLAKE3Context context;
+        MYBLAKE3Init(&context);
+        for (size_t pos = 0, n = 1; pos < input.length; pos += n, n = n * 2 + 1)
+            MYBLAKE3Update(&context, (const uint8_t*)input.bytes + pos, MIN(n, input.length - pos));
+        MYBLAKE3Final(&context, digest);
+        CAssertEqual(hexDigest(digest, 32), @(kVectors[i].hash));
+    }
+
+    // The parallel path must agree with the serial one, including on partial last subtrees:
+    for (size_t length = kMinParallelLength - 1; length < 2*kMinParallelLength;
+                length += 7 * kChunkLength + 333) {
+        NSData *input = testInput(length);
+        uint8_t parallel[32], serial[32];
+        MYBLAKE3(input.bytes, input.length, parallel);
+        MYBLAKE3Context context;
+        MYBLAKE3Init(&context);
+        MYBLAKE3Update(&context, input.bytes, input.length);
+        MYBLAKE3Final(&context, serial);
+        CAssert(memcmp(parallel, serial, 32) == 0, @"BLAKE3 of %zu bytes", length);
+    }
+}
+
+
+TestCase(MYBLAKE3Benchmark) {
+    RequireTestCase(MYBLAKE3);
+    static const size_t kSize = 64 * 1024 * 1024;
+    void *buffer = malloc(kSize);
+    memset(buffer, 0x55, kSize);
+    uint8_t digest[32];
+
+    MYBLAKE3Context context;
+    MYBLAKE3Init(&context);
+    CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+    MYBLAKE3Update(&context, buffer, kSize);
+    MYBLAKE3Final(&context, digest);
+    CFAbsoluteTime serialTime = CFAbsoluteTimeGetCurrent() - start;
+    start = CFAbsoluteTimeGetCurrent();
+    MYBLAKE3(buffer, kSize, digest);
+    CFAbsoluteTime parallelTime = CFAbsoluteTimeGetCurrent() - start;
+    Log(@"BLAKE3: %6.0f MB/sec serial, %6.0f MB/sec parallel",
+        kSize / serialTime / 1e6, kSize / parallelTime / 1e6);
+    free(buffer);
+}
+
+
+
+/*
+ Copyright (c) 2009, Jens Alfke <jens@mooseyard.com>. All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification, are permitted
+ provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice, this list of conditions
+ and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions
+ and the following disclaimer in the documentation and/or other materials provided with the
+ distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRI-
+ BUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
@@ -0,0 +1,114 @@
+//
+//  MYCRL.h
+//  MYCrypto
+//
+//  Created by Jens Alfke on 10/16/26.
+//  Copyright 2026 Jens Alfke. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+@class MYCertificateInfo, MYCanonicalName, MYPublicKey, MYOID;
+
+
+/** An X.509 certificate revocation list.
+    The revoked serial numbers are indexed when the CRL is loaded, into a sorted array searched by
+    binary search (through a small sampled copy of the keys first), fronted by a Bloom filter. The common case of checking a serial number that
+    isn't revoked usually costs only a hash and a few memory reads, even for CRLs with millions
+    of entries. Instances are immutable, so they can be used from any thread. */
+@interface MYCRL : NSObject
+{
+    @private
+    NSData *_data, *_issuerData;
+    struct MYX509CRLFields *_fields;
+    MYCanonicalName *_canonicalIssuer;
+    NSData *_index, *_fence;
+    size_t _keyLength, _count;
+    NSData *_bloom;
+    uint32_t _bloomMask;
+}
+
+/** Parses a DER-encoded CRL and indexes its entries.
+    The signature is not checked; call -verifySignatureWithKey: for that. */
+- (id) initWithCRLData: (NSData*)data error: (NSError**)outError;
+
+/** The encoded CRL this was parsed from. */
+@property (readonly) NSData *CRLData;
+
+/** The DER-encoded name of the CRL's issuer. */
+@property (readonly) NSData *issuerData;
+
+/** The canonical form of the issuer's name, for matching against certificates' issuers. */
+@property (readonly) MYCanonicalName *canonicalIssuer;
+
+/** The date this CRL was issued. */
+@property (readonly) NSDate *thisUpdate;
+
+/** The date by which the next CRL will be issued, or nil if not specified. */
+@property (readonly) NSDate *nextUpdate;
+
+@property (readonly) MYOID *signatureAlgorithmID;
+
+/** The number of revoked certificates listed. */
+@property (readonly) NSUInteger count;
+
+/** Verifies the CRL's signature, using the issuer's public key. */
+- (BOOL) verifySignatureWithKey: (MYPublicKey*)issuerPublicKey;
+
+/** Returns YES if the certificate with the given serial number is listed as revoked.
+    The serial number is in the form of -[MYCertificateInfo serialNumber]. */
+- (BOOL) isSerialNumberRevoked: (NSData*)serialNumber;
+
+/** Lower-level version of -isSerialNumberRevoked: that doesn't require an NSData. */
+- (BOOL) isSerialNumberRevoked: (const void*)bytes length: (size_t)length;
+
+/** The date the certificate with the given serial number was revoked, or nil if it isn't. */
+- (NSDate*) revocationDateOfSerialNumber: (NSData*)serialNumber;
+
+/** Returns YES if the certificate was issued by this CRL's issuer and is listed as revoked. */
+- (BOOL) isCertificateRevoked: (MYCertificateInfo*)certificate;
+
+@end
+
+
+
+typedef enum {
+    kMYRevocationUnknown,           ///< No current CRL is loaded for the certificate's issuer
+    kMYRevocationGood,              ///< The issuer's CRL doesn't list the certificate
+    kMYRevocationRevoked            ///< The issuer's CRL lists the certificate as revoked
+} MYRevocationStatus;
+
+
+/** Checks certificates against a set of CRLs, one per issuer.
+    CRLs can be loaded or replaced at any time without blocking checks in progress on other
+    threads: each change publishes a new immutable table, and a check uses whichever table was
+    current when it started. */
+@interface MYRevocationChecker : NSObject
+{
+    @private
+    id _snapshot;
+}
+
+/** All the loaded CRLs. */
+@property (readonly) NSArray *CRLs;
+
+/** Adds a CRL, replacing any existing CRL from the same issuer unless that one is newer.
+    Returns NO if the CRL wasn't used because a newer one is already loaded. */
+- (BOOL) addCRL: (MYCRL*)crl;
+
+/** Parses a CRL, verifies its signature with the issuer's public key, and adds it.
+    This is the way to reload a CRL: the old one stays in use until the new one is ready. */
+- (BOOL) loadCRLData: (NSData*)data
+           issuerKey: (MYPublicKey*)issuerPublicKey
+               error: (NSError**)outError;
+
+/** Removes the CRL of the given issuer. */
+- (BOOL) removeCRLForIssuer: (MYCanonicalName*)issuer;
+
+/** The CRL from the given issuer, or nil. */
+- (MYCRL*) CRLForIssuer: (MYCanonicalName*)issuer;
+
+/** Looks up the certificate in its issuer's CRL. If that CRL's nextUpdate date has passed,
+    the status is unknown. */
+- (MYRevocationStatus) statusOfCertificate: (MYCertificateInfo*)certificate;
+
+@end
@@ -0,0 +1,608 @@
+//
+//  MYCRL.m
+//  MYCrypto
+//
+//  Created by Jens Alfke on 10/16/26.
+//  Copyright 2026 Jens Alfke. All rights reserved.
+//
+
+// References:
+// <http://tools.ietf.org/html/rfc5280#section-5> "CRL and CRL Extensions Profile"
+
+#import "MYCRL.h"
+#import "MYCrypto_Private.h"
+#import "MYX509Decoder.h"
+#import "MYCanonicalName.h"
+#import "MYOID.h"
+#import "MYErrorUtils.h"
+#import "CollectionUtils.h"
+#import "Test.h"
+
+
+/* RFC 5280 limits serial numbers to 20 bytes, but some CAs have issued longer ones. */
+#define kMaxSerialLength 64
+
+/* Every 8th key's first 8 bytes are copied into a "fence" array, which is small enough to stay
+   in cache. Binary-searching that first means the big index is only touched at the end. */
+#define kFenceStride 8
+
+/* The Bloom filter uses about 10 bits per entry and 7 probes, for a false-positive rate of ~1%. */
+#define kBloomBitsPerEntry 10
+#define kBloomProbes 7
+
+
+/* Each entry of the index is a fixed-size record: a key consisting of the serial number's length
+   followed by its bytes (zero-padded to the longest length in the CRL), then the 32-bit offset
+   of the entry in the CRL data. Comparing keys with memcmp gives a consistent total order, and
+   two keys are equal only if the serial numbers are. */
+
+static inline size_t recordSize (size_t keyLength) {
+    return keyLength + sizeof(uint32_t);
+}
+
+static inline void makeKey (const uint8_t *serial, size_t length, uint8_t *key, size_t keyLength) {
+    key[0] = (uint8_t)length;
+    memcpy(key + 1, serial, length);
+    memset(key + 1 + length, 0, keyLength - 1 - length);
+}
+
+
+/* The first 8 bytes of a key as a big-endian integer, so it sorts the same way the key does. */
+static inline uint64_t keyPrefix (const uint8_t *key, size_t keyLength) {
+    uint64_t prefix = 0;
+    for (size_t i = 0; i < 8; i++)
+        prefix = (prefix << 8) | (i < keyLength ? key[i] : 0);
+    return prefix;
+}
+
+
+static inline uint64_t hashSerial (const uint8_t *serial, size_t length) {
+    uint64_t h = 14695981039346656037ull;       // FNV-1a...
+    for (size_t i = 0; i < length; i++)
+        h = (h ^ serial[i]) * 1099511628211ull;
+    h ^= h >> 33;                               // ...then MurmurHash3's finalizer to mix the bits
+    h *= 0xff51afd7ed558ccdull;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ull;
+    h ^= h >> 33;
+    return h;
+}
+
+/* Bloom filter probes are derived from one 64-bit hash by double hashing. */
+#define FOR_EACH_PROBE(HASH, MASK, BIT) \
+    for (uint32_t _i = 0, _h1 = (uint32_t)(HASH), _h2 = (uint32_t)((HASH) >> 32) | 1, \
+                  BIT = _h1 & (MASK); \
+         _i < kBloomProbes; \
+         ++_i, BIT = (_h1 + _i * _h2) & (MASK))
+
+
+@implementation MYCRL
+
+
+- (id) initWithCRLData: (NSData*)data error: (NSError**)outError {
+    if (outError) *outError = nil;
+    self = [super init];
+    if (self) {
+        _data = [data copy];
+        _fields = malloc(sizeof(MYX509CRLFields));
+        if (!_fields) {
+            if (outError) *outError = MYError(1, MYASN1ErrorDomain, @"Out of memory");
+            return nil;
+        }
+        if (!MYX509DecodeCRL(_data.bytes, _data.length, _fields, outError))
+            return nil;
+        _issuerData = [NSData dataWithBytes: MYBERSliceGetEncoding(&_fields->issuer)
+                                     length: MYBERSliceGetEncodingLength(&_fields->issuer)];
+        _canonicalIssuer = [[MYCanonicalName alloc] initWithEncodedName: _issuerData];
+        if (!_canonicalIssuer) {
+            if (outError) *outError = MYError(2, MYASN1ErrorDomain, @"Invalid CRL: bad issuer name");
+            return nil;
+        }
+        if (![self _buildIndex: outError])
+            return nil;
+    }
+    return self;
+}
+
+- (void) dealloc {
+    free(_fields);
+}
+
+
+- (BOOL) _buildIndex: (NSError**)outError {
+    if (!MYX509FieldIsPresent(&_fields->revokedCertificates)) {
+        _keyLength = 1;
+        return YES;
+    }
+    // First pass: count the entries and find the longest serial number:
+    MYBERCursor cursor = MYBERSliceGetCursor(&_fields->revokedCertificates);
+    MYBERSlice serial;
+    size_t maxLength = 0;
+    while (MYX509NextRevokedCertificate(&cursor, &serial, NULL)) {
+        ++_count;
+        maxLength = MAX(maxLength, serial.length);
+    }
+    if (!MYBERCursorAtEnd(&cursor) || maxLength > kMaxSerialLength || _data.length > UINT32_MAX) {
+        if (outError) *outError = MYError(2, MYASN1ErrorDomain,
+                                          @"Invalid CRL: bad revoked certificate entry");
+        return NO;
+    }
+    _keyLength = 1 + maxLength;
+
+    // Second pass: fill in the index records and the Bloom filter:
+    size_t bloomBits = 64;
+    while (bloomBits < _count * kBloomBitsPerEntry && bloomBits < (1ull << 32))
+        bloomBits *= 2;
+    _bloomMask = (uint32_t)(bloomBits - 1);
+    NSMutableData *bloom = [NSMutableData dataWithLength: bloomBits / 8];
+    uint64_t *bloomWords = bloom.mutableBytes;
+
+    size_t size = recordSize(_keyLength);
+    NSMutableData *index = [NSMutableData dataWithLength: _count * size];
+    uint8_t *record = index.mutableBytes;
+    const uint8_t *start = _data.bytes;
+    cursor = MYBERSliceGetCursor(&_fields->revokedCertificates);
+    for (size_t i = 0; i < _count; i++) {
+        uint32_t offset = (uint32_t)(cursor.nextChar - start);
+        MYX509NextRevokedCertificate(&cursor, &serial, NULL);
+        makeKey(serial.contents, serial.length, record, _keyLength);
+        memcpy(record + _keyLength, &offset, sizeof(offset));
+        record += size;
+
+        uint64_t hash = hashSerial(serial.contents, serial.length);
+        FOR_EACH_PROBE(hash, _bloomMask, bit) {
+            bloomWords[bit >> 6] |= 1ull << (bit & 63);
+        }
+    }
+
+    size_t keyLength = _keyLength;
+    qsort_b(index.mutableBytes, _count, size, ^int(const void *a, const void *b) {
+        return memcmp(a, b, keyLength);
+    });
+
+    size_t fenceCount = (_count + kFenceStride - 1) / kFenceStride;
+    NSMutableData *fence = [NSMutableData dataWithLength: fenceCount * sizeof(uint64_t)];
+    uint64_t *fenceKeys = fence.mutableBytes;
+    for (size_t i = 0; i < fenceCount; i++)
+        fenceKeys[i] = keyPrefix((const uint8_t*)index.bytes + i * kFenceStride * size, _keyLength);
+
+    _index = index;
+    _fence = fence;
+    _bloom = bloom;
+    return YES;
+}
+
+
+/* Returns a pointer to the index record for a serial number, or NULL if it's not revoked. */
+- (const uint8_t*) _findSerialNumber: (const void*)bytes length: (size_t)length {
+    if (length == 0 || length >= _keyLength)
+        return NULL;
+    uint64_t hash = hashSerial(bytes, length);
+    const uint64_t *bloomWords = _bloom.bytes;
+    FOR_EACH_PROBE(hash, _bloomMask, bit) {
+        if (!(bloomWords[bit >> 6] & (1ull << (bit & 63))))
+            return NULL;
+    }
+
+    uint8_t key[1 + kMaxSerialLength];
+    makeKey(bytes, length, key, _keyLength);
+
+    // Find the range of fence entries whose prefix matches; the key can only be in the index
+    // between the fence entry before that range and the end of it:
+    uint64_t prefix = keyPrefix(key, _keyLength);
+    const uint64_t *fenceKeys = _fence.bytes;
+    size_t fenceCount = _fence.length / sizeof(uint64_t);
+    size_t lo = 0, hi = fenceCount;
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        if (fenceKeys[mid] < prefix)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    size_t first = lo > 0 ? lo - 1 : 0;
+    hi = fenceCount;
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        if (fenceKeys[mid] <= prefix)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    hi = MIN(lo * kFenceStride, _count);
+    lo = first * kFenceStride;
+
+    const uint8_t *records = _index.bytes;
+    size_t size = recordSize(_keyLength);
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        const uint8_t *record = records + mid * size;
+        int cmp = memcmp(key, record, _keyLength);
+        if (cmp == 0)
+            return record;
+        else if (cmp < 0)
+            hi = mid;
+        else
+            lo = mid + 1;
+    }
+    return NULL;
+}
+
+
+- (NSData*) CRLData                 {return _data;}
+- (NSData*) issuerData              {return _issuerData;}
+- (MYCanonicalName*) canonicalIssuer {return _canonicalIssuer;}
+- (NSUInteger) count                {return _count;}
+
+- (NSDate*) thisUpdate {
+    return [NSDate dateWithTimeIntervalSince1970: _fields->thisUpdate];
+}
+
+- (NSDate*) nextUpdate {
+    if (_fields->nextUpdate == 0)
+        return nil;
+    return [NSDate dateWithTimeIntervalSince1970: _fields->nextUpdate];
+}
+
+- (MYOID*) signatureAlgorithmID {
+    const MYBERSlice *oid = &_fields->signatureAlgorithmOID;
+    return [MYOID OIDWithBERBytes: oid->contents length: oid->length];
+}
+
+
+- (BOOL) verifySignatureWithKey: (MYPublicKey*)issuerPublicKey {
+    const MYBERSlice *tbs = &_fields->tbsCertList;
+    NSData *signedData = [NSData dataWithBytesNoCopy: (void*)MYBERSliceGetEncoding(tbs)
+                                              length: MYBERSliceGetEncodingLength(tbs)
+                                        freeWhenDone: NO];
+    size_t sigLength;
+    const uint8_t *sig = MYX509BitStringBytes(&_fields->signature, &sigLength);
+    NSData *signature = [NSData dataWithBytesNoCopy: (void*)sig length: sigLength freeWhenDone: NO];
+    return MYVerifySignedData(signedData, signature, self.signatureAlgorithmID, issuerPublicKey);
+}
+
+
+- (BOOL) isSerialNumberRevoked: (const void*)bytes length: (size_t)length {
+    return [self _findSerialNumber: bytes length: length] != NULL;
+}
+
+- (BOOL) isSerialNumberRevoked: (NSData*)serialNumber {
+    return [self _findSerialNumber: serialNumber.bytes length: serialNumber.length] != NULL;
+}
+
+- (NSDate*) revocationDateOfSerialNumber: (NSData*)serialNumber {
+    const uint8_t *record = [self _findSerialNumber: serialNumber.bytes
+                                             length: serialNumber.length];
+    if (!record)
+        return nil;
+    uint32_t offset;
+    memcpy(&offset, record + _keyLength, sizeof(offset));
+    MYBERCursor cursor = MYBERCursorMake((const uint8_t*)_data.bytes + offset,
+                                         _data.length - offset);
+    MYBERSlice serial;
+    NSTimeInterval date;
+    if (!MYX509NextRevokedCertificate(&cursor, &serial, &date))
+        return nil;
+    return [NSDate dateWithTimeIntervalSince1970: date];
+}
+
+- (BOOL) isCertificateRevoked: (MYCertificateInfo*)certificate {
+    return [certificate.canonicalIssuer isEqual: _canonicalIssuer]
+        && [self isSerialNumberRevoked: certificate.serialNumber];
+}
+
+
+- (NSString*) description {
+    return $sprintf(@"%@[%@, %lu revoked]", self.class, _canonicalIssuer, (unsigned long)_count);
+}
+
+
+@end
+
+
+
+
+@interface MYRevocationChecker ()
+@property (strong) id _snapshot;        // atomic, so readers can get it without locking
+@end
+
+
+@implementation MYRevocationChecker
+
+
+- (id) init {
+    self = [super init];
+    if (self) {
+        _snapshot = @{};
+    }
+    return self;
+}
+
+
+@synthesize _snapshot;
+
+
+/* Applies a change to a copy of the current table of CRLs (keyed by canonical issuer name),
+   then publishes the copy if the block returns YES. Writers are serialized; readers are
+   unaffected. */
+- (BOOL) _update: (BOOL(^)(NSMutableDictionary*))block {
+    @synchronized(self) {
+        NSMutableDictionary *crls = [self._snapshot mutableCopy];
+        if (!block(crls))
+            return NO;
+        self._snapshot = [crls copy];
+        return YES;
+    }
+}
+
+
+- (NSArray*) CRLs {
+    return [self._snapshot allValues];
+}
+
+- (MYCRL*) CRLForIssuer: (MYCanonicalName*)issuer {
+    return issuer ? self._snapshot[issuer] : nil;
+}
+
+
+- (BOOL) addCRL: (MYCRL*)crl {
+    return [self _update: ^BOOL(NSMutableDictionary *crls) {
+        MYCRL *existing = crls[crl.canonicalIssuer];
+        if ([existing.thisUpdate compare: crl.thisUpdate] == NSOrderedDescending)
+            return NO;
+        crls[crl.canonicalIssuer] = crl;
+        return YES;
+    }];
+}
+
+- (BOOL) loadCRLData: (NSData*)data
+           issuerKey: (MYPublicKey*)issuerPublicKey
+               error: (NSError**)outError
+{
+    MYCRL *crl = [[MYCRL alloc] initWithCRLData: data error: outError];
+    if (!crl)
+        return NO;
+    if (![crl verifySignatureWithKey: issuerPublicKey]) {
+        if (outError) *outError = MYError(4, MYASN1ErrorDomain, @"CRL signature is not valid");
+        return NO;
+    }
+    if (![self addCRL: crl]) {
+        if (outError) *outError = MYError(5, MYASN1ErrorDomain, @"A newer CRL is already loaded");
+        return NO;
+    }
+    return YES;
+}
+
+- (BOOL) removeCRLForIssuer: (MYCanonicalName*)issuer {
+    return [self _update: ^BOOL(NSMutableDictionary *crls) {
+        if (!crls[issuer])
+            return NO;
+        [crls removeObjectForKey: issuer];
+        return YES;
+    }];
+}
+
+
+- (MYRevocationStatus) statusOfCertificate: (MYCertificateInfo*)certificate {
+    MYCRL *crl = self._snapshot[certificate.canonicalIssuer];
+    if (!crl)
+        return kMYRevocationUnknown;
+    NSDate *nextUpdate = crl.nextUpdate;
+    if (nextUpdate && nextUpdate.timeIntervalSinceNow < 0)
+        return kMYRevocationUnknown;        // CRL is out of date; a newer one may list the cert
+    return [crl isSerialNumberRevoked: certificate.serialNumber] ? kMYRevocationRevoked
+                                                                 : kMYRevocationGood;
+}
+
+
+@end
+
+
+
+
+#pragma mark -
+#pragma mark TEST CASES:
+
+#define $data(BYTES...)    ({const uint8_t bytes[] = {BYTES}; [NSData dataWithBytes: bytes length: sizeof(bytes)];})
+
+
+static MYCertificateInfo* readCert (NSString *name) {
+    NSData *data = [NSData dataWithContentsOfFile: [name stringByAppendingPathExtension: @"cer"]];
+    CAssert(data, @"Couldn't read %@", name);
+    MYCertificateInfo *cert = [[MYCertificateInfo alloc] initWithCertificateData: data error: NULL];
+    CAssert(cert);
+    return cert;
+}
+
+
+TestCase(MYCRL) {
+    RequireTestCase(X509DecodeCRL);
+    RequireTestCase(MYCanonicalName);
+    NSData *data = [NSData dataWithContentsOfFile: @"testca.crl"];
+    NSError *error = nil;
+    MYCRL *crl = [[MYCRL alloc] initWithCRLData: data error: &error];
+    CAssert(crl, @"Couldn't parse CRL: %@", error);
+    Log(@"CRL = %@", crl);
+    CAssertEq(crl.count, (NSUInteger)4);
+    CAssert(crl.nextUpdate != nil);
+    CAssertEq(crl.signatureAlgorithmID.knownID, kMYOIDRSAWithSHA256);
+
+    CAssert([crl isSerialNumberRevoked: $data(0x07)]);
+    CAssert([crl isSerialNumberRevoked: $data(0x00, 0xFF)]);
+    CAssert([crl isSerialNumberRevoked: $data(0x12, 0x34)]);
+    CAssert([crl isSerialNumberRevoked: $data(0x01,0x23,0x45,0x67,0x89,0xAB,0xCD,0xEF,
+                                              0x01,0x23,0x45,0x67,0x89,0xAB,0xCD,0xEF)]);
+    CAssert(![crl isSerialNumberRevoked: $data(0x12, 0x35)]);
+    CAssert(![crl isSerialNumberRevoked: $data(0x08)]);
+    CAssert(![crl isSerialNumberRevoked: $data(0xFF)]);             // -1, not 255
+    CAssert(![crl isSerialNumberRevoked: $data(0x00, 0x07)]);
+    CAssert(![crl isSerialNumberRevoked: [NSData data]]);
+    CAssert(![crl isSerialNumberRevoked: [NSMutableData dataWithLength: 100]]);
+    CAssertEqual([crl revocationDateOfSerialNumber: $data(0x12, 0x34)],
+                 [NSDate dateWithTimeIntervalSince1970: 1790856000]);    // 2026-10-01 12:00:00Z
+    CAssertEqual([crl revocationDateOfSerialNumber: $data(0x12, 0x35)], nil);
+
+    MYCertificateInfo *ca = readCert(@"testca");
+    MYCertificateInfo *revoked = readCert(@"testca_revoked");
+    MYCertificateInfo *good = readCert(@"testca_good");
+    MYCertificateInfo *other = readCert(@"selfsigned");
+    CAssertEqual(crl.canonicalIssuer, ca.canonicalSubject);
+    CAssertEqual(revoked.serialNumber, $data(0x12, 0x34));
+    CAssert([crl isCertificateRevoked: revoked]);
+    CAssert(![crl isCertificateRevoked: good]);
+    CAssert(![crl isCertificateRevoked: other]);
+
+    CAssert([crl verifySignatureWithKey: ca.subjectPublicKey]);
+    CAssert(![crl verifySignatureWithKey: other.subjectPublicKey]);
+    NSMutableData *altered = [data mutableCopy];
+    ((uint8_t*)altered.mutableBytes)[altered.length - 1] ^= 0x01;
+    MYCRL *alteredCRL = [[MYCRL alloc] initWithCRLData: altered error: NULL];
+    CAssert(![alteredCRL verifySignatureWithKey: ca.subjectPublicKey]);
+
+    MYRevocationChecker *checker = [[MYRevocationChecker alloc] init];
+    CAssertEq([checker statusOfCertificate: revoked], kMYRevocationUnknown);
+    CAssert(![checker loadCRLData: altered issuerKey: ca.subjectPublicKey error: &error]);
+    CAssertEqual(error.domain, MYASN1ErrorDomain);
+    CAssert([checker loadCRLData: data issuerKey: ca.subjectPublicKey error: &error],
+            @"Couldn't load CRL: %@", error);
+    CAssertEq(checker.CRLs.count, (NSUInteger)1);
+    CAssertEq([checker CRLForIssuer: ca.canonicalSubject].count, (NSUInteger)4);
+    CAssertEq([checker statusOfCertificate: revoked], kMYRevocationRevoked);
+    CAssertEq([checker statusOfCertificate: good], kMYRevocationGood);
+    CAssertEq([checker statusOfCertificate: other], kMYRevocationUnknown);
+    // Reloading the same CRL replaces it:
+    CAssert([checker addCRL: crl]);
+    CAssertEq([checker CRLForIssuer: ca.canonicalSubject], crl);
+    CAssert([checker removeCRLForIssuer: ca.canonicalSubject]);
+    CAssert(![checker removeCRLForIssuer: ca.canonicalSubject]);
+    CAssertEq([checker statusOfCertificate: revoked], kMYRevocationUnknown);
+
+    // A CRL whose nextUpdate has passed can't vouch for anything:
+    NSMutableData *stale = [data mutableCopy];
+    NSRange date = [stale rangeOfData: [@"461011232539Z" dataUsingEncoding: NSASCIIStringEncoding]
+                              options: 0 range: NSMakeRange(0, stale.length)];
+    CAssert(date.length > 0);
+    [stale replaceBytesInRange: NSMakeRange(date.location, 2) withBytes: "16"];
+    MYCRL *staleCRL = [[MYCRL alloc] initWithCRLData: stale error: &error];
+    CAssert(staleCRL, @"Couldn't parse stale CRL: %@", error);
+    CAssert(staleCRL.nextUpdate.timeIntervalSinceNow < 0);
+    CAssert([checker addCRL: staleCRL]);
+    CAssertEq([checker statusOfCertificate: good], kMYRevocationUnknown);
+    CAssertEq([checker statusOfCertificate: revoked], kMYRevocationUnknown);
+}
+
+
+/* Appends a DER header for a value with the given tag and content length. */
+static void appendHeader (NSMutableData *output, uint8_t tag, size_t length) {
+    uint8_t header[6] = {tag};
+    size_t headerLength = 2;
+    if (length < 0x80) {
+        header[1] = (uint8_t)length;
+    } else {
+        unsigned nBytes = (length > 0xFFFFFF) ? 4 : (length > 0xFFFF) ? 3 : (length > 0xFF) ? 2 : 1;
+        header[1] = 0x80 | nBytes;
+        for (unsigned i = 0; i < nBytes; i++)
+            header[2 + i] = (uint8_t)(length >> (8 * (nBytes - 1 - i)));
+        headerLength += nBytes;
+    }
+    [output appendBytes: header length: headerLength];
+}
+
+static NSData* wrap (uint8_t tag, NSData *contents) {
+    NSMutableData *output = [NSMutableData dataWithCapacity: contents.length + 6];
+    appendHeader(output, tag, contents.length);
+    [output appendData: contents];
+    return output;
+}
+
+static void randomSerial (uint64_t *state, uint8_t serial[16]) {
+    for (int i = 0; i < 16; i += 8) {
+        *state ^= *state << 13; *state ^= *state >> 7; *state ^= *state << 17;   // xorshift64
+        memcpy(serial + i, state, 8);
+    }
+    serial[0] = (serial[0] & 0x7F) | 0x01;       // positive, and no leading zero byte
+}
+
+
+TestCase(MYCRLBenchmark) {
+    RequireTestCase(MYCRL);
+    static const size_t kEntries = 1000000, kLookups = 1000000;
+
+    // Build an (unsigned) CRL with a million entries, borrowing the fields of the test CRL:
+    NSData *testData = [NSData dataWithContentsOfFile: @"testca.crl"];
+    MYX509CRLFields f;
+    CAssert(MYX509DecodeCRL(testData.bytes, testData.length, &f, NULL));
+    static const char kDate[] = "\x17\x0d" "260101000000Z";
+    NSMutableData *entries = [NSMutableData dataWithCapacity: kEntries * 35];
+    uint64_t state = 88172645463325252ull;
+    uint8_t serial[16];
+    for (size_t i = 0; i < kEntries; i++) {
+        randomSerial(&state, serial);
+        appendHeader(entries, 0x30, 2 + sizeof(serial) + sizeof(kDate) - 1);
+        appendHeader(entries, 0x02, sizeof(serial));
+        [entries appendBytes: serial length: sizeof(serial)];
+        [entries appendBytes: kDate length: sizeof(kDate) - 1];
+    }
+    NSMutableData *tbs = [NSMutableData dataWithBytes: "\x02\x01\x01" length: 3];
+    [tbs appendBytes: MYBERSliceGetEncoding(&f.tbsSignatureAlgorithm)
+              length: MYBERSliceGetEncodingLength(&f.tbsSignatureAlgorithm)];
+    [tbs appendBytes: MYBERSliceGetEncoding(&f.issuer)
+              length: MYBERSliceGetEncodingLength(&f.issuer)];
+    [tbs appendBytes: kDate length: sizeof(kDate) - 1];
+    [tbs appendData: wrap(0x30, entries)];
+    NSMutableData *crlContents = [wrap(0x30, tbs) mutableCopy];
+    [crlContents appendBytes: MYBERSliceGetEncoding(&f.signatureAlgorithm)
+                      length: MYBERSliceGetEncodingLength(&f.signatureAlgorithm)];
+    [crlContents appendData: wrap(0x03, [NSData dataWithBytes: "\0\0" length: 2])];
+    NSData *data = wrap(0x30, crlContents);
+
+    CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+    MYCRL *crl = [[MYCRL alloc] initWithCRLData: data error: NULL];
+    CFAbsoluteTime loadTime = CFAbsoluteTimeGetCurrent() - start;
+    CAssert(crl);
+    CAssertEq(crl.count, kEntries);
+    Log(@"Loaded %zu-entry CRL (%.1f MB) in %.0f ms", kEntries, data.length/1e6, loadTime*1e3);
+
+    // Look up serials that are revoked (the same sequence again), then ones that aren't:
+    state = 88172645463325252ull;
+    start = CFAbsoluteTimeGetCurrent();
+    for (size_t i = 0; i < kLookups; i++) {
+        randomSerial(&state, serial);
+        if (![crl isSerialNumberRevoked: serial length: sizeof(serial)])
+            CAssert(NO, @"Lookup %zu failed", i);
+    }
+    CFAbsoluteTime revokedTime = CFAbsoluteTimeGetCurrent() - start;
+    size_t found = 0;
+    start = CFAbsoluteTimeGetCurrent();
+    for (size_t i = 0; i < kLookups; i++) {
+        randomSerial(&state, serial);
+        if ([crl isSerialNumberRevoked: serial length: sizeof(serial)])
+            ++found;
+    }
+    CFAbsoluteTime goodTime = CFAbsoluteTimeGetCurrent() - start;
+    CAssertEq(found, (size_t)0);
+    Log(@"Lookups: revoked %.0f ns, not revoked %.0f ns",
+        revokedTime/kLookups*1e9, goodTime/kLookups*1e9);
+}
+
+/*
+ Copyright (c) 2009, Jens Alfke <jens@mooseyard.com>. All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification, are permitted
+ provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice, this list of conditions
+ and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions
+ and the following disclaimer in the documentation and/or other materials provided with the
+ distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRI-
+ BUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
@@ -0,0 +1,35 @@
+//
+//  MYCanonicalName.h
+//  MYCrypto
+//
+//  Created by Jens Alfke on 10/16/26.
+//  Copyright 2026 Jens Alfke. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+
+/** The canonical form of an X.509 Name, for comparing names the way RFC 5280 (section 7.1)
+    specifies: string attribute values are converted to UTF-8, case-folded, and have leading,
+    trailing and repeated whitespace removed, and the attributes within each RDN are sorted.
+    Two names that match have identical canonical bytes.
+    Instances are immutable values with a precomputed 64-bit hash, so comparing them is usually
+    a single integer compare, and they make cheap dictionary keys. */
+@interface MYCanonicalName : NSObject <NSCopying>
+{
+    @private
+    NSData *_data;
+    uint64_t _hash64;
+}
+
+/** Canonicalizes a DER-encoded Name. Returns nil if the encoding is malformed. */
+- (id) initWithEncodedName: (NSData*)encodedName;
+
+/** The canonical byte string: the concatenated DER encodings of the canonicalized RDNs, without
+    the enclosing SEQUENCE header. (For ASCII names this is the same as OpenSSL's form.) */
+@property (readonly) NSData *data;
+
+/** A stable 64-bit hash of the canonical bytes; it's the same on every run and platform. */
+@property (readonly) uint64_t hash64;
+
+@end
@@ -0,0 +1,333 @@
+//
+//  MYCanonicalName.m
+//  MYCrypto
+//
+//  Created by Jens Alfke on 10/16/26.
+//  Copyright 2026 Jens Alfke. All rights reserved.
+//
+
+// References:
+// <http://tools.ietf.org/html/rfc5280#section-7.1> "Internationalized Names in Distinguished Names"
+// <http://tools.ietf.org/html/rfc4518> "LDAP: Internationalized String Preparation"
+
+#import "MYCanonicalName.h"
+#import "MYBERParser.h"
+#import "Test.h"
+
+
+enum {
+    kUTF8StringTag      = 12,
+    kPrintableStringTag = 19,
+    kT61StringTag       = 20,
+    kIA5StringTag       = 22,
+    kVisibleStringTag   = 26,
+    kUniversalStringTag = 28,
+    kBMPStringTag       = 30,
+};
+
+
+static inline BOOL isASCIISpace (uint8_t c) {
+    return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+static void appendHeader (NSMutableData *output, uint8_t tag, size_t length) {
+    uint8_t header[10] = {tag};
+    size_t headerLength;
+    if (length < 0x80) {
+        header[1] = (uint8_t)length;
+        headerLength = 2;
+    } else {
+        unsigned nBytes = 0;
+        for (size_t n = length; n > 0; n >>= 8)
+            nBytes++;
+        header[1] = 0x80 | nBytes;
+        for (unsigned i = 0; i < nBytes; i++)
+            header[2 + i] = (uint8_t)(length >> (8 * (nBytes - 1 - i)));
+        headerLength = 2 + nBytes;
+    }
+    [output appendBytes: header length: headerLength];
+}
+
+
+/* The fast path for the usual case of an ASCII string: folds case and compresses whitespace.
+   dst must have room for length bytes. Returns the number of bytes written. */
+static size_t canonicalizeASCII (const uint8_t *src, size_t length, uint8_t *dst) {
+    uint8_t *start = dst;
+    BOOL pendingSpace = NO;
+    for (size_t i = 0; i < length; i++) {
+        uint8_t c = src[i];
+        if (isASCIISpace(c)) {
+            pendingSpace = (dst > start);       // (leading space is dropped)
+            continue;
+        }
+        if (pendingSpace) {
+            *dst++ = ' ';
+            pendingSpace = NO;
+        }
+        if (c >= 'A' && c <= 'Z')
+            c += 'a' - 'A';
+        *dst++ = c;
+    }
+    return dst - start;
+}
+
+/* The general case: compatibility-normalizes, folds case and compresses whitespace. */
+static NSData* canonicalizeString (const uint8_t *src, size_t length, NSStringEncoding encoding) {
+    NSMutableString *str = [[NSMutableString alloc] initWithBytes: src length: length encoding: encoding];
+    if (!str)
+        return nil;
+    CFStringNormalize((__bridge CFMutableStringRef)str, kCFStringNormalizationFormKC);
+    CFStringFold((__bridge CFMutableStringRef)str, kCFCompareCaseInsensitive, NULL);
+    NSArray *words = [str componentsSeparatedByCharactersInSet:
+                                        [NSCharacterSet whitespaceAndNewlineCharacterSet]];
+    words = [words filteredArrayUsingPredicate: [NSPredicate predicateWithFormat: @"length > 0"]];
+    return [[words componentsJoinedByString: @" "] dataUsingEncoding: NSUTF8StringEncoding];
+}
+
+
+/* Appends the canonical form of an attribute value: a string type becomes a canonicalized
+   UTF8String; anything else is copied as-is. */
+static BOOL appendCanonicalValue (NSMutableData *output, const MYBERSlice *value) {
+    NSStringEncoding encoding;
+    BOOL mayBeASCII = YES;
+    if (value->tagClass != 0 || value->isConstructed) {
+        encoding = 0;
+    } else {
+        switch (value->tag) {
+            case kUTF8StringTag:        encoding = NSUTF8StringEncoding; break;
+            case kPrintableStringTag:
+            case kIA5StringTag:
+            case kVisibleStringTag:     encoding = NSASCIIStringEncoding; break;
+            case kT61StringTag:         encoding = NSISOLatin1StringEncoding; break;
+            case kBMPStringTag:         encoding = NSUTF16BigEndianStringEncoding; mayBeASCII = NO; break;
+            case kUniversalStringTag:   encoding = NSUTF32BigEndianStringEncoding; mayBeASCII = NO; break;
+            default:                    encoding = 0; break;
+        }
+    }
+    if (!encoding) {
+        [output appendBytes: MYBERSliceGetEncoding(value) length: MYBERSliceGetEncodingLength(value)];
+        return YES;
+    }
+
+    if (mayBeASCII) {
+        size_t i;
+        for (i = 0; i < value->length && value->contents[i] < 0x80; i++)
+            ;
+        if (i == value->length) {
+            uint8_t buf[256];
+            uint8_t *dst = value->length <= sizeof(buf) ? buf : malloc(value->length);
+            size_t length = canonicalizeASCII(value->contents, value->length, dst);
+            appendHeader(output, kUTF8StringTag, length);
+            [output appendBytes: dst length: length];
+            if (dst != buf)
+                free(dst);
+            return YES;
+        }
+    }
+    NSData *utf8 = canonicalizeString(value->contents, value->length, encoding);
+    if (!utf8)
+        return NO;
+    appendHeader(output, kUTF8StringTag, utf8.length);
+    [output appendData: utf8];
+    return YES;
+}
+
+/*  AttributeTypeAndValue ::= SEQUENCE {
+        type     AttributeType,
+        value    AttributeValue } */
+static BOOL appendCanonicalAVA (NSMutableData *output, const MYBERSlice *ava) {
+    MYBERCursor items = MYBERSliceGetCursor(ava);
+    MYBERSlice type, value;
+    if (ava->tag != 16 || ava->tagClass != 0 || !ava->isConstructed
+            || !MYBERCursorNext(&items, &type, NULL) || type.tag != 6 || type.isConstructed
+            || !MYBERCursorNext(&items, &value, NULL))
+        return NO;
+    NSMutableData *contents = [NSMutableData dataWithCapacity: ava->length];
+    [contents appendBytes: MYBERSliceGetEncoding(&type) length: MYBERSliceGetEncodingLength(&type)];
+    if (!appendCanonicalValue(contents, &value))
+        return NO;
+    appendHeader(output, 0x30, contents.length);
+    [output appendData: contents];
+    return YES;
+}
+
+/* DER orders the elements of a SET OF by their encodings. */
+static NSComparisonResult compareEncodings (NSData *a, NSData *b) {
+    int cmp = memcmp(a.bytes, b.bytes, MIN(a.length, b.length));
+    if (cmp == 0)
+        cmp = (a.length > b.length) - (a.length < b.length);
+    return cmp < 0 ? NSOrderedAscending : (cmp > 0 ? NSOrderedDescending : NSOrderedSame);
+}
+
+/*  Name ::= SEQUENCE OF RelativeDistinguishedName
+    RelativeDistinguishedName ::= SET SIZE (1..MAX) OF AttributeTypeAndValue */
+static NSData* canonicalizeName (NSData *encodedName) {
+    MYBERCursor cursor = MYBERCursorMake(encodedName.bytes, encodedName.length);
+    MYBERSlice name, rdn, ava;
+    if (!MYBERCursorNext(&cursor, &name, NULL) || name.tag != 16 || name.tagClass != 0 || !name.isConstructed)
+        return nil;
+    NSMutableData *output = [NSMutableData dataWithCapacity: name.length];
+    MYBERCursor rdns = MYBERSliceGetCursor(&name);
+    while (MYBERCursorNext(&rdns, &rdn, NULL)) {
+        if (rdn.tag != 17 || rdn.tagClass != 0 || !rdn.isConstructed)
+            return nil;
+        NSMutableArray *avas = [NSMutableArray arrayWithCapacity: 1];
+        size_t length = 0;
+        MYBERCursor items = MYBERSliceGetCursor(&rdn);
+        while (MYBERCursorNext(&items, &ava, NULL)) {
+            NSMutableData *avaData = [NSMutableData dataWithCapacity: ava.length + 8];
+            if (!appendCanonicalAVA(avaData, &ava))
+                return nil;
+            [avas addObject: avaData];
+            length += avaData.length;
+        }
+        if (!MYBERCursorAtEnd(&items) || avas.count == 0)
+            return nil;
+        if (avas.count > 1)
+            [avas sortUsingComparator: ^NSComparisonResult(NSData *a, NSData *b) {
+                return compareEncodings(a, b);
+            }];
+        appendHeader(output, 0x31, length);
+        for (NSData *avaData in avas)
+            [output appendData: avaData];
+    }
+    if (!MYBERCursorAtEnd(&rdns))
+        return nil;
+    return output;
+}
+
+
+static uint64_t hashBytes64 (const uint8_t *bytes, size_t length) {
+    uint64_t hash = 14695981039346656037ull;        // FNV-1a
+    for (size_t i = 0; i < length; i++)
+        hash = (hash ^ bytes[i]) * 1099511628211ull;
+    return hash;
+}
+
+
+
+@implementation MYCanonicalName
+
+
+- (id) initWithEncodedName: (NSData*)encodedName {
+    self = [super init];
+    if (self) {
+        _data = canonicalizeName(encodedName);
+        if (!_data)
+            return nil;
+        _hash64 = hashBytes64(_data.bytes, _data.length);
+    }
+    return self;
+}
+
+- (id) copyWithZone: (NSZone*)zone {
+    return self;
+}
+
+
+@synthesize data=_data, hash64=_hash64;
+
+
+- (NSUInteger) hash {
+    return (NSUInteger)_hash64;
+}
+
+- (BOOL) isEqual: (id)object {
+    if (object == self)
+        return YES;
+    if (![object isKindOfClass: [MYCanonicalName class]])
+        return NO;
+    MYCanonicalName *other = object;
+    return _hash64 == other->_hash64
+        && _data.length == other->_data.length
+        && memcmp(_data.bytes, other->_data.bytes, _data.length) == 0;
+}
+
+- (NSString*) description {
+    return [NSString stringWithFormat: @"%@[%016llx]", [self class], _hash64];
+}
+
+
+@end
+
+
+
+
+#pragma mark -
+#pragma mark TEST CASES:
+
+
+static MYCanonicalName* canonicalize (const char *hex) {
+    NSMutableData *data = [NSMutableData data];
+    for (const char *c = hex; c[0] && c[1]; c += 2) {
+        if (*c == ' ') {
+            --c;
+            continue;
+        }
+        unsigned byte;
+        sscanf(c, "%2x", &byte);
+        uint8_t b = (uint8_t)byte;
+        [data appendBytes: &b length: 1];
+    }
+    return [[MYCanonicalName alloc] initWithEncodedName: data];
+}
+
+
+TestCase(MYCanonicalName) {
+    // SEQUENCE { SET { SEQUENCE { 2.5.4.3, PrintableString "Foo  Bar " } } }
+    MYCanonicalName *name1 = canonicalize("3014 3112 3010 0603550403 1309 466f6f2020426172 20");
+    CAssert(name1);
+    // The expected form: UTF8String "foo bar"
+    CAssertEqual(name1.data, [NSData dataWithBytes: "\x31\x10\x30\x0e\x06\x03\x55\x04\x03"
+                                                     "\x0c\x07" "foo bar" length: 18]);
+    // UTF8String " FOO\tbar":
+    MYCanonicalName *name2 = canonicalize("3013 3111 300f 0603550403 0c08 20464f4f09626172");
+    CAssertEqual(name2, name1);
+    CAssertEq(name2.hash64, name1.hash64);
+    // BMPString "foo BAR":
+    MYCanonicalName *name3 = canonicalize("3019 3117 3015 0603550403 1e0e 0066006f006f0020004200410052");
+    CAssertEqual(name3, name1);
+    // Non-ASCII UTF8String "ÉTÉ" matches "été":
+    CAssertEqual(canonicalize("3010 310e 300c 0603550403 0c05 c389 54 c389"),
+                 canonicalize("3010 310e 300c 0603550403 0c05 c3a9 74 c3a9"));
+    // Different strings don't match:
+    CAssert(![canonicalize("3013 3111 300f 0603550403 0c08 466f6f2042617a21") isEqual: name1]);
+    // Attribute order within an RDN doesn't matter, but RDN order does:
+    MYCanonicalName *multi1 = canonicalize("3018 3116 3009 0603550403 0c0261 61 3009 0603550404 0c02 6262");
+    MYCanonicalName *multi2 = canonicalize("3018 3116 3009 0603550404 0c02 4242 3009 0603550403 0c02 4141");
+    CAssert(multi1 && multi2);
+    CAssertEqual(multi1, multi2);
+    MYCanonicalName *seq1 = canonicalize("301a 310b 3009 0603550403 0c02 6161 310b 3009 0603550404 0c02 6262");
+    MYCanonicalName *seq2 = canonicalize("301a 310b 3009 0603550404 0c02 6262 310b 3009 0603550403 0c02 6161");
+    CAssert(seq1 && seq2);
+    CAssert(![seq1 isEqual: seq2]);
+    // Malformed:
+    CAssertNil(canonicalize("3005 3103 0c0161"));
+    CAssertNil(canonicalize("3102 3100"));
+    // The empty name is valid:
+    CAssertEq(canonicalize("3000").data.length, (NSUInteger)0);
+}
+
+
+
+/*
+ Copyright (c) 2009, Jens Alfke <jens@mooseyard.com>. All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification, are permitted
+ provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice, this list of conditions
+ and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions
+ and the following disclaimer in the documentation and/or other materials provided with the
+ distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRI-
+ BUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
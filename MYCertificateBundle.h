@@ -0,0 +1,30 @@
+//
+//  MYCertificateBundle.h
+//  MYCrypto
+//
+//  Created by Jens Alfke on 10/16/26.
+//  Copyright 2026 Jens Alfke. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+
+/** Parses a bundle of certificates, such as a CA bundle or a dump of a certificate log, without
+    going through the keychain. The bundle can be either a series of concatenated DER-encoded
+    certificates, or PEM text containing "-----BEGIN CERTIFICATE-----" blocks; other kinds of PEM
+    blocks, and any text outside them, are skipped.
+    The records are found in a quick sequential pass, then parsed in parallel on all cores.
+    @return  An array with one item per certificate record, in the order they appear in the
+        bundle. Each item is either a MYCertificateInfo, or an NSError describing why that record
+        couldn't be parsed; a bad record doesn't stop the rest from being parsed.
+        (A DER record whose length can't be read makes the rest of the bundle unreadable, so it
+        produces a single error item for the remaining data. So does running out of memory
+        while finding the records.) */
+NSArray* MYReadCertificateBundle (NSData *bundle);
+
+/** Memory-maps a file and parses it with MYReadCertificateBundle.
+    The certificates parsed from a DER bundle point into the mapped file instead of copying it, so
+    the mapping stays alive as long as any of them do.
+    @return  The array of certificates and errors, or nil if the file couldn't be read. */
+NSArray* MYReadCertificateBundleFile (NSString *path, NSError **outError);
+
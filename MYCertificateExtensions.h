@@ -0,0 +1,79 @@
+//
+//  MYCertificateExtensions.h
+//  MYCrypto
+//
+//  Created by Jens Alfke on 10/16/26.
+//  Copyright 2026 Jens Alfke. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+#import "MYOID.h"
+
+
+/** The extensions of a certificate, indexed by OID. The standard extensions that are used in
+    path validation are decoded up front into typed values, so checking them doesn't allocate or
+    parse anything. Instances are immutable.
+    (You'll usually get one from MYCertificateInfo's 'extensions' property.) */
+@interface MYCertificateExtensions : NSObject
+{
+    @private
+    NSArray *_items;
+    uint8_t _knownIndex[kMYOIDKnownCount];     // index+1 into _items, or 0 if not present
+    NSDictionary *_unknownIndex;               // MYOID -> NSNumber index, for other OIDs
+    BOOL _isCertificateAuthority;
+    NSInteger _pathLengthConstraint;
+    UInt16 _keyUsage;
+    NSSet *_extendedKeyUsage;
+    NSDictionary *_subjectAlternativeName;
+    NSData *_subjectKeyIdentifier, *_authorityKeyIdentifier;
+    NSArray *_CRLDistributionPoints, *_OCSPResponders;
+}
+
+/** Indexes an array of extensions. Each item is an array of the extension's MYOID, optionally
+    a critical flag as an NSNumber, and the DER-encoded value as NSData -- the form the BER
+    parser produces. If an OID appears more than once, the first occurrence wins. */
+- (id) initWithExtensions: (NSArray*)extensions;
+
+/** The OIDs of all the extensions, in their original order. */
+@property (readonly) NSArray *OIDs;
+
+@property (readonly) NSUInteger count;
+
+/** Returns the DER-encoded value of an extension, or nil if it isn't present. */
+- (NSData*) valueForOID: (MYOID*)oid isCritical: (BOOL*)outIsCritical;
+
+/** Returns the extension's item from the array the receiver was initialized with. */
+- (NSArray*) itemForOID: (MYOID*)oid;
+
+
+/** YES if the BasicConstraints extension is present and its "cA" flag is true. */
+@property (readonly) BOOL isCertificateAuthority;
+
+/** The BasicConstraints pathLenConstraint, or -1 if there is none. */
+@property (readonly) NSInteger pathLengthConstraint;
+
+/** The KeyUsage flags, or kKeyUsageUnspecified if the extension isn't present. */
+@property (readonly) UInt16 keyUsage;
+
+/** The ExtendedKeyUsage extension as a set of MYOIDs, or nil if it isn't present. */
+@property (readonly) NSSet *extendedKeyUsage;
+
+/** The SubjectAlternativeName extension, in the form described by
+    -[MYCertificateInfo subjectAlternativeName]; nil if it isn't present. */
+@property (readonly) NSDictionary *subjectAlternativeName;
+
+/** The SubjectKeyIdentifier, or nil if it isn't present. */
+@property (readonly) NSData *subjectKeyIdentifier;
+
+/** The keyIdentifier of the AuthorityKeyIdentifier, or nil if it isn't present. */
+@property (readonly) NSData *authorityKeyIdentifier;
+
+/** The URIs (as NSStrings) listed in the CRLDistributionPoints extension, or nil if it isn't
+    present. Distribution points named relative to the CRL issuer are skipped. */
+@property (readonly) NSArray *CRLDistributionPoints;
+
+/** The URIs (as NSStrings) of the OCSP responders listed in the AuthorityInfoAccess extension,
+    or nil if it isn't present. */
+@property (readonly) NSArray *OCSPResponders;
+
+@end
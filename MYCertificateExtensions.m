@@ -0,0 +1,427 @@
+//
+//  MYCertificateExtensions.m
+//  MYCrypto
+//
+//  Created by Jens Alfke on 10/16/26.
+//  Copyright 2026 Jens Alfke. All rights reserved.
+//
+
+// References:
+// <http://tools.ietf.org/html/rfc5280#section-4.2> "Certificate Extensions"
+
+#import "MYCertificateExtensions.h"
+#import "MYCertificateInfo.h"
+#import "MYBERParser.h"
+#import "CollectionUtils.h"
+#import "Test.h"
+
+
+/* Reads the single top-level value of an extension. */
+static BOOL getValue (NSData *ber, MYBERSlice *outValue) {
+    MYBERCursor cursor = MYBERCursorMake(ber.bytes, ber.length);
+    return ber && MYBERCursorNext(&cursor, outValue, NULL);
+}
+
+static inline BOOL isUniversal (const MYBERSlice *slice, uint32_t tag, BOOL constructed) {
+    return slice->tagClass == 0 && slice->tag == tag && slice->isConstructed == constructed;
+}
+
+static inline BOOL isContext (const MYBERSlice *slice, uint32_t tag) {
+    return slice->tagClass == 2 && slice->tag == tag;
+}
+
+static NSString* ASCIIString (const MYBERSlice *slice) {
+    return [[NSString alloc] initWithBytes: slice->contents
+                                    length: slice->length
+                                  encoding: NSASCIIStringEncoding];
+}
+
+
+@implementation MYCertificateExtensions
+
+
+- (id) initWithExtensions: (NSArray*)extensions {
+    self = [super init];
+    if (self) {
+        _items = extensions ?[extensions copy] :@[];
+        _pathLengthConstraint = -1;
+        _keyUsage = kKeyUsageUnspecified;
+
+        NSMutableDictionary *unknownIndex = nil;
+        NSUInteger index = 0;
+        for (NSArray *item in _items) {
+            MYOID *oid = $castIf(MYOID, $castIf(NSArray, item).firstObject);
+            MYOIDKnownID knownID = oid.knownID;
+            if (knownID != kMYOIDUnknown) {
+                if (!_knownIndex[knownID] && index < UINT8_MAX)
+                    _knownIndex[knownID] = (uint8_t)(index + 1);
+            } else if (oid) {
+                if (!unknownIndex)
+                    unknownIndex = $mdict();
+                if (!unknownIndex[oid])
+                    unknownIndex[oid] = @(index);
+            }
+            index++;
+        }
+        _unknownIndex = [unknownIndex copy];
+
+        [self _decodeBasicConstraints];
+        [self _decodeKeyUsage];
+        [self _decodeExtendedKeyUsage];
+        [self _decodeSubjectAltName];
+        [self _decodeKeyIdentifiers];
+        [self _decodeCRLDistributionPoints];
+        [self _decodeAuthorityInfoAccess];
+    }
+    return self;
+}
+
+
+@synthesize isCertificateAuthority=_isCertificateAuthority,
+            pathLengthConstraint=_pathLengthConstraint, keyUsage=_keyUsage,
+            extendedKeyUsage=_extendedKeyUsage, subjectAlternativeName=_subjectAlternativeName,
+            subjectKeyIdentifier=_subjectKeyIdentifier,
+            authorityKeyIdentifier=_authorityKeyIdentifier,
+            CRLDistributionPoints=_CRLDistributionPoints, OCSPResponders=_OCSPResponders;
+
+
+- (NSUInteger) count {
+    return _items.count;
+}
+
+- (NSArray*) OIDs {
+    NSMutableArray* oids = $marray();
+    for (id item in _items) {
+        MYOID* oid = $castIf(MYOID, $castIf(NSArray, item).firstObject);
+        if (oid)
+            [oids addObject:oid];
+    }
+    return oids;
+}
+
+- (NSArray*) itemForOID: (MYOID*)oid {
+    MYOIDKnownID knownID = oid.knownID;
+    if (knownID != kMYOIDUnknown) {
+        unsigned index = _knownIndex[knownID];
+        return index ?_items[index - 1] :nil;
+    }
+    NSNumber *index = _unknownIndex[oid];
+    return index ?_items[index.unsignedIntegerValue] :nil;
+}
+
+- (NSData*) _valueForKnownID: (MYOIDKnownID)knownID {
+    unsigned index = _knownIndex[knownID];
+    return index ?$castIf(NSData, [_items[index - 1] lastObject]) :nil;
+}
+
+- (NSData*) valueForOID: (MYOID*)oid isCritical: (BOOL*)outIsCritical {
+    NSArray *item = [self itemForOID: oid];
+    if (outIsCritical)
+        *outIsCritical = item.count >= 3 && [$castIf(NSNumber, item[1]) boolValue];
+    return $castIf(NSData, item.lastObject);
+}
+
+
+#pragma mark DECODING:
+
+
+/*  BasicConstraints ::= SEQUENCE {
+        cA                      BOOLEAN DEFAULT FALSE,
+        pathLenConstraint       INTEGER (0..MAX) OPTIONAL } */
+- (void) _decodeBasicConstraints {
+    MYBERSlice seq, item;
+    if (!getValue([self _valueForKnownID: kMYOIDBasicConstraints], &seq)
+            || !isUniversal(&seq, 16, YES))
+        return;
+    MYBERCursor items = MYBERSliceGetCursor(&seq);
+    if (!MYBERCursorNext(&items, &item, NULL))
+        return;
+    if (isUniversal(&item, 1, NO) && item.length == 1) {
+        _isCertificateAuthority = (item.contents[0] != 0);
+        if (!MYBERCursorNext(&items, &item, NULL))
+            return;
+    }
+    int64_t pathLength;
+    if (isUniversal(&item, 2, NO) && MYBERSliceGetInteger(&item, &pathLength) && pathLength >= 0)
+        _pathLengthConstraint = (NSInteger)MIN(pathLength, NSIntegerMax);
+}
+
+
+/*  KeyUsage ::= BIT STRING    (RFC 5280 sec. 4.2.1.3) */
+- (void) _decodeKeyUsage {
+    MYBERSlice bits;
+    if (!getValue([self _valueForKnownID: kMYOIDKeyUsage], &bits)
+            || !isUniversal(&bits, 3, NO) || bits.length < 1)
+        return;
+    size_t nBytes = bits.length - 1;
+    size_t bitCount = 8*nBytes - MIN(bits.contents[0], 8*nBytes);
+    UInt16 value = nBytes > 0 ?bits.contents[1] :0;
+    if (bitCount > 8)      // 9 bits are defined, so the value could be multi-byte
+        value |= bits.contents[2] << 8;
+    _keyUsage = value;
+}
+
+
+/*  ExtKeyUsageSyntax ::= SEQUENCE SIZE (1..MAX) OF KeyPurposeId
+    KeyPurposeId ::= OBJECT IDENTIFIER    (RFC 5280 sec. 4.2.1.12) */
+- (void) _decodeExtendedKeyUsage {
+    MYBERSlice seq, oid;
+    if (!getValue([self _valueForKnownID: kMYOIDExtendedKeyUsage], &seq)
+            || !isUniversal(&seq, 16, YES))
+        return;
+    NSMutableSet *oids = [NSMutableSet set];
+    MYBERCursor items = MYBERSliceGetCursor(&seq);
+    while (MYBERCursorNext(&items, &oid, NULL)) {
+        if (isUniversal(&oid, 6, NO))
+            [oids addObject: [MYOID OIDWithBERBytes: oid.contents length: oid.length]];
+    }
+    _extendedKeyUsage = [oids copy];
+}
+
+
+/*  SubjectAltName ::= GeneralNames
+    GeneralNames ::= SEQUENCE SIZE (1..MAX) OF GeneralName
+    GeneralName ::= CHOICE {
+        otherName                 [0] OtherName,
+        rfc822Name                [1] IA5String,
+        dNSName                   [2] IA5String,
+        ...
+        uniformResourceIdentifier [6] IA5String,
+        ... }    (RFC 5280 sec. 4.2.1.6) */
+- (void) _decodeSubjectAltName {
+    MYBERSlice seq, name;
+    if (!getValue([self _valueForKnownID: kMYOIDSubjectAltName], &seq)
+            || !isUniversal(&seq, 16, YES))
+        return;
+    NSMutableDictionary* result = $mdict();
+    MYBERCursor names = MYBERSliceGetCursor(&seq);
+    while (MYBERCursorNext(&names, &name, NULL)) {
+        if (name.tagClass != 2)
+            continue;
+        id key, value;
+        switch (name.tag) {
+            case 1:  key = @"RFC822"; break;
+            case 2:  key = @"DNS";    break;
+            case 6:  key = @"URI";    break;
+            default: key = @(name.tag); break;
+        }
+        if ([key isKindOfClass: [NSString class]])
+            value = name.isConstructed ?nil :ASCIIString(&name);
+        else
+            value = MYBERSliceParse(&name, NULL);
+        if (value) {
+            NSMutableArray* values = result[key];
+            if (!values) {
+                values = $marray();
+                result[key] = values;
+            }
+            [values addObject: value];
+        }
+    }
+    NSMutableDictionary *frozen = $mdict();
+    for (id key in result)
+        frozen[key] = [result[key] copy];
+    _subjectAlternativeName = [frozen copy];
+}
+
+
+/*  SubjectKeyIdentifier ::= KeyIdentifier
+    KeyIdentifier ::= OCTET STRING
+    AuthorityKeyIdentifier ::= SEQUENCE {
+        keyIdentifier             [0] KeyIdentifier           OPTIONAL,
+        authorityCertIssuer       [1] GeneralNames            OPTIONAL,
+        authorityCertSerialNumber [2] CertificateSerialNumber OPTIONAL  } */
+- (void) _decodeKeyIdentifiers {
+    MYBERSlice keyID, seq;
+    if (getValue([self _valueForKnownID: kMYOIDSubjectKeyIdentifier], &keyID)
+            && isUniversal(&keyID, 4, NO))
+        _subjectKeyIdentifier = MYBERSliceCopyContents(&keyID);
+
+    if (getValue([self _valueForKnownID: kMYOIDAuthorityKeyIdentifier], &seq)
+            && isUniversal(&seq, 16, YES)) {
+        MYBERCursor items = MYBERSliceGetCursor(&seq);
+        if (MYBERCursorNext(&items, &keyID, NULL) && isContext(&keyID, 0) && !keyID.isConstructed)
+            _authorityKeyIdentifier = MYBERSliceCopyContents(&keyID);
+    }
+}
+
+
+/*  CRLDistributionPoints ::= SEQUENCE SIZE (1..MAX) OF DistributionPoint
+    DistributionPoint ::= SEQUENCE {
+        distributionPoint       [0]     DistributionPointName OPTIONAL,
+        reasons                 [1]     ReasonFlags OPTIONAL,
+        cRLIssuer               [2]     GeneralNames OPTIONAL }
+    DistributionPointName ::= CHOICE {
+        fullName                [0]     GeneralNames,
+        nameRelativeToCRLIssuer [1]     RelativeDistinguishedName }    (RFC 5280 sec. 4.2.1.13) */
+- (void) _decodeCRLDistributionPoints {
+    MYBERSlice seq, point, pointName, fullName, name;
+    if (!getValue([self _valueForKnownID: kMYOIDCRLDistributionPoints], &seq)
+            || !isUniversal(&seq, 16, YES))
+        return;
+    NSMutableArray *uris = $marray();
+    MYBERCursor points = MYBERSliceGetCursor(&seq);
+    while (MYBERCursorNext(&points, &point, NULL)) {
+        if (!isUniversal(&point, 16, YES))
+            continue;
+        MYBERCursor fields = MYBERSliceGetCursor(&point);
+        if (!MYBERCursorNext(&fields, &pointName, NULL)
+                || !isContext(&pointName, 0) || !pointName.isConstructed)
+            continue;
+        MYBERCursor choice = MYBERSliceGetCursor(&pointName);
+        if (!MYBERCursorNext(&choice, &fullName, NULL)
+                || !isContext(&fullName, 0) || !fullName.isConstructed)
+            continue;
+        MYBERCursor names = MYBERSliceGetCursor(&fullName);
+        while (MYBERCursorNext(&names, &name, NULL)) {
+            if (isContext(&name, 6) && !name.isConstructed) {
+                NSString *uri = ASCIIString(&name);
+                if (uri)
+                    [uris addObject: uri];
+            }
+        }
+    }
+    _CRLDistributionPoints = [uris copy];
+}
+
+
+/*  AuthorityInfoAccessSyntax ::= SEQUENCE SIZE (1..MAX) OF AccessDescription
+    AccessDescription ::= SEQUENCE {
+        accessMethod          OBJECT IDENTIFIER,
+        accessLocation        GeneralName  }    (RFC 5280 sec. 4.2.2.1) */
+- (void) _decodeAuthorityInfoAccess {
+    MYBERSlice seq, description, method, location;
+    if (!getValue([self _valueForKnownID: kMYOIDAuthorityInfoAccess], &seq)
+            || !isUniversal(&seq, 16, YES))
+        return;
+    NSMutableArray *uris = $marray();
+    MYBERCursor descriptions = MYBERSliceGetCursor(&seq);
+    while (MYBERCursorNext(&descriptions, &description, NULL)) {
+        if (!isUniversal(&description, 16, YES))
+            continue;
+        MYBERCursor fields = MYBERSliceGetCursor(&description);
+        if (MYBERCursorNext(&fields, &method, NULL) && isUniversal(&method, 6, NO)
+                && [MYOID OIDWithBERBytes: method.contents length: method.length].knownID == kMYOIDOCSP
+                && MYBERCursorNext(&fields, &location, NULL)
+                && isContext(&location, 6) && !location.isConstructed) {
+            NSString *uri = ASCIIString(&location);
+            if (uri)
+                [uris addObject: uri];
+        }
+    }
+    _OCSPResponders = [uris copy];
+}
+
+
+- (NSString*) description {
+    return $sprintf(@"%@%@", self.class, self.OIDs);
+}
+
+
+@end
+
+
+
+#pragma mark -
+#pragma mark TEST CASES:
+
+
+#define $data(BYTES...)    ({const uint8_t bytes[] = {BYTES}; [NSData dataWithBytes: bytes length: sizeof(bytes)];})
+
+static MYCertificateExtensions* extensionsOf (NSString *filename) {
+    NSData *data = [NSData dataWithContentsOfFile: [filename stringByAppendingPathExtension: @"cer"]];
+    CAssert(data, @"Couldn't read %@", filename);
+    MYCertificateInfo *info = [[MYCertificateInfo alloc] initWithCertificateData: data error: NULL];
+    CAssert(info);
+    return info.extensions;
+}
+
+
+TestCase(MYCertificateExtensions) {
+    MYCertificateExtensions *ext = extensionsOf(@"iphonedev");
+    CAssertEq(ext.count, (NSUInteger)8);
+    CAssertEq(ext.OIDs.count, (NSUInteger)8);
+    BOOL critical = NO;
+    CAssert([ext valueForOID: [MYOID OIDWithKnownID: kMYOIDBasicConstraints] isCritical: &critical]);
+    CAssert(critical);
+    CAssert([ext valueForOID: [MYOID OIDWithKnownID: kMYOIDCRLDistributionPoints] isCritical: &critical]);
+    CAssert(!critical);
+    CAssertEqual([ext valueForOID: [MYOID OIDWithKnownID: kMYOIDSubjectAltName] isCritical: &critical], nil);
+    CAssert(!critical);
+    // Apple's code-signing extension, 1.2.840.113635.100.6.1.2, isn't a well-known OID:
+    MYOID *appleOID = [MYOID OIDWithBERBytes: "\x2a\x86\x48\x86\xf7\x63\x64\x06\x01\x02" length: 10];
+    CAssertEq(appleOID.knownID, kMYOIDUnknown);
+    CAssert([ext valueForOID: appleOID isCritical: &critical]);
+    CAssert(critical);
+
+    CAssert(!ext.isCertificateAuthority);
+    CAssertEq(ext.pathLengthConstraint, (NSInteger)-1);
+    CAssertEq(ext.keyUsage, kKeyUsageDigitalSignature);
+    CAssertEqual(ext.extendedKeyUsage, [NSSet setWithObject: kExtendedKeyUsageCodeSigningOID]);
+    CAssertEqual(ext.subjectAlternativeName, nil);
+    CAssertEqual(ext.subjectKeyIdentifier, $data(0x26,0x2C,0x0F,0x41,0x39,0xE3,0x25,0xF7,0xD6,0xDB,
+                                                 0xCB,0x00,0xBF,0xF3,0x14,0x61,0x14,0x78,0x48,0x85));
+    CAssertEqual(ext.authorityKeyIdentifier, $data(0x88,0x27,0x17,0x09,0xA9,0xB6,0x18,0x60,0x8B,0xEC,
+                                                   0xEB,0xBA,0xF6,0x47,0x59,0xC5,0x52,0x54,0xA3,0xB7));
+    CAssertEqual(ext.CRLDistributionPoints,
+                 @[@"http://developer.apple.com/certificationauthority/wwdrca.crl"]);
+
+    ext = extensionsOf(@"selfsigned_email");
+    CAssertEq(ext.keyUsage, kKeyUsageDigitalSignature | kKeyUsageDataEncipherment);
+    CAssertEqual(ext.subjectAlternativeName, (@{@"RFC822": @[@"jens@mooseyard.com"],
+                                                @"URI": @[@"http://jens.mooseyard.com"],
+                                                @"DNS": @[@"mooseyard.com"]}));
+    CAssertEqual(ext.subjectKeyIdentifier, nil);
+    CAssertEqual(ext.CRLDistributionPoints, nil);
+
+    // AuthorityInfoAccess with a CA-issuers URI and an OCSP URI:
+    MYOID *aiaOID = [MYOID OIDWithKnownID: kMYOIDAuthorityInfoAccess];
+    ext = [[MYCertificateExtensions alloc] initWithExtensions: @[
+                @[aiaOID, $data(0x30,0x2a,
+                                0x30,0x13, 0x06,0x08,0x2b,0x06,0x01,0x05,0x05,0x07,0x30,0x02,
+                                           0x86,0x07,'h','t','t','p',':','/','a',
+                                0x30,0x13, 0x06,0x08,0x2b,0x06,0x01,0x05,0x05,0x07,0x30,0x01,
+                                           0x86,0x07,'h','t','t','p',':','/','o')] ]];
+    CAssertEqual(ext.OCSPResponders, @[@"http:/o"]);
+
+    // Hand-built extensions: a CA with a path length, a duplicate OID, and a multi-byte KeyUsage.
+    MYOID *bcOID = [MYOID OIDWithKnownID: kMYOIDBasicConstraints];
+    MYOID *kuOID = [MYOID OIDWithKnownID: kMYOIDKeyUsage];
+    ext = [[MYCertificateExtensions alloc] initWithExtensions: @[
+                @[bcOID, $true, $data(0x30,0x06, 0x01,0x01,0xFF, 0x02,0x01,0x02)],
+                @[bcOID, $data(0x30,0x00)],
+                @[kuOID, $data(0x03,0x03, 0x00,0x86,0x01)] ]];
+    CAssertEq(ext.count, (NSUInteger)3);
+    CAssert(ext.isCertificateAuthority);
+    CAssertEq(ext.pathLengthConstraint, (NSInteger)2);
+    CAssertEq(ext.keyUsage, kKeyUsageDigitalSignature | kKeyUsageKeyCertSign | kKeyUsageCRLSign
+                            | kKeyUsageDecipherOnly);
+    CAssertEqual(ext.extendedKeyUsage, nil);
+
+    ext = [[MYCertificateExtensions alloc] initWithExtensions: nil];
+    CAssertEq(ext.count, (NSUInteger)0);
+    CAssertEqual(ext.OIDs, @[]);
+    CAssertEq(ext.keyUsage, kKeyUsageUnspecified);
+}
+
+/*
+ Copyright (c) 2009, Jens Alfke <jens@mooseyard.com>. All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification, are permitted
+ provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice, this list of conditions
+ and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions
+ and the following disclaimer in the documentation and/or other materials provided with the
+ distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRI-
+ BUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
@@ -8,20 +8,36 @@
 
 #import <Foundation/Foundation.h>
 @class MYCertificateName, MYCertificateExtensions, MYCertificate, MYIdentity, MYPublicKey, MYPrivateKey, MYOID;
+@class MYSHA1Digest, MYCanonicalName, MYCertificateTemplate;
+struct MYX509Fields;
 
 /** A parsed X.509 certificate; provides access to the names and metadata. */
 @interface MYCertificateInfo : NSObject 
 {
     @private
     NSArray *_root;
+    NSArray *_tbsInfo;
     NSArray *_extensions;
+    MYCertificateExtensions *_extensionTable;
     NSData *_data;
+    struct MYX509Fields *_fields;
+    MYCertificateName *_subject, *_issuer;
+    NSData *_signedData, *_subjectData, *_issuerData, *_serialNumber;
+    NSData *_subjectPublicKeyInfo, *_subjectPublicKeyData, *_signature;
+    MYCanonicalName *_canonicalSubject, *_canonicalIssuer;
 }
 
 /** Initialize by parsing X.509 certificate data.
     (More commonly you'll get an instance via MYCertificate's 'info' property.) */
 - (id) initWithCertificateData: (NSData*)data error: (NSError**)outError;
 
+/** The encoded certificate this was parsed from. (nil for a MYCertificateRequest.) */
+@property (readonly) NSData *certificateData;
+
+/** The certificate's serial number: the contents of its DER-encoded INTEGER, i.e. a big-endian
+    two's-complement number. (nil for a MYCertificateRequest.) */
+@property (readonly) NSData *serialNumber;
+
 /** The date/time at which the certificate first becomes valid. */
 @property (strong, readonly) NSDate *validFrom;
 
@@ -29,15 +45,23 @@
 @property (strong, readonly) NSDate *validTo;
 
 /** Information about the identity of the owner of this certificate. */
-@property (weak, readonly) MYCertificateName *subject;
+@property (readonly) MYCertificateName *subject;
 
 /** Information about the identity that signed/authorized this certificate. */
-@property (weak, readonly) MYCertificateName *issuer;
+@property (readonly) MYCertificateName *issuer;
+
+/** The canonical forms of the subject and issuer names, for fast comparison and lookup. */
+@property (readonly) MYCanonicalName *canonicalSubject, *canonicalIssuer;
 
-/** Returns YES if the issuer is the same as the subject. (Aka a "self-signed" certificate.) */
+/** Returns YES if the issuer is the same as the subject, as compared by RFC 5280 rules.
+    (Aka a "self-signed" certificate.) */
 @property (readonly) BOOL isRoot;
 
 
+/** The certificate's extensions, indexed by OID, with the standard ones already decoded.
+    This is built the first time it's needed; the extension accessors below all use it. */
+@property (readonly) MYCertificateExtensions *extensions;
+
 /** The list of raw extension names, each a MYOID object. */
 @property (weak, readonly) NSArray* extensionOIDs;
 
@@ -47,6 +71,17 @@
     @return  The parsed ASN.1 value, or nil if the extension is not present. This could be an NSValue or NSString, or any of the classes defined in MYASN1Object.h. */
 - (id) extensionForOID: (MYOID*)oid isCritical: (BOOL*)outIsCritical;
 
+/** The value of the SubjectKeyIdentifier extension, which identifies the certificate's public
+    key, or nil if the extension is not present. */
+@property (readonly) NSData *subjectKeyIdentifier;
+
+/** The keyIdentifier of the AuthorityKeyIdentifier extension -- the SubjectKeyIdentifier of the
+    issuer's certificate -- or nil if not present. */
+@property (readonly) NSData *authorityKeyIdentifier;
+
+/** The SHA-1 digest of the subject public key data. */
+@property (readonly) MYSHA1Digest *publicKeyDigest;
+
 /** Is this certificate authorized to sign certificates (i.e. serve as an issuer)?
     Returns YES if the BasicConstraints extension is present and its "cA" flag is true. */
 @property (readonly) BOOL isCertificateAuthority;
@@ -81,7 +116,8 @@
 @property (weak, readonly) NSArray* emailAddresses;
 
 /** Verifies the certificate's signature, using the given public key.
-    If the certificate is root/self-signed, use the cert's own subject public key. */
+    If the certificate is root/self-signed, use the cert's own subject public key.
+    Successful verifications are remembered in MYSignatureCache's shared cache. */
 - (BOOL) verifySignatureWithKey: (MYPublicKey*)issuerPublicKey;
 
 @end
@@ -134,6 +170,15 @@
     and returns a MYIdentity representing the paired certificate and private key. */
 - (MYIdentity*) createSelfSignedIdentityWithPrivateKey: (MYPrivateKey*)privateKey
                                                  error: (NSError**)outError;
+
+/** Prepares a template for issuing many certificates like this one, which differ only in serial
+    number, validity period, subject common name and public key. (This request's own serial
+    number, dates and public key aren't used.) See MYCertificateTemplate.
+    @param issuer  The issuer's certificate, whose subject becomes the issuer name of the
+            certificates; or nil to use this request's subject.
+    @param signingKey  The issuer's private key, which will sign the certificates. */
+- (MYCertificateTemplate*) templateWithIssuer: (MYCertificateInfo*)issuer
+                                   signingKey: (MYPrivateKey*)signingKey;
 @end
 
 
@@ -145,8 +190,14 @@
 {
     @private
     NSArray *_components;
+    NSData *_encoding;
+    MYCanonicalName *_canonicalName;
+    NSMutableDictionary *_pairsByOID;
 }
 
+/** The canonical form of the name. Two names are equal if their canonical forms are. */
+@property (readonly) MYCanonicalName *canonicalName;
+
 /** The "common name" (nickname, whatever). */
 @property (copy) NSString *commonName;
 
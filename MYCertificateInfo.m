@@ -15,10 +15,16 @@
 
 #import "MYCertificateInfo.h"
 #import "MYCrypto.h"
+#import "MYCrypto_Private.h"
 #import "MYASN1Object.h"
 #import "MYOID.h"
 #import "MYBERParser.h"
 #import "MYDEREncoder.h"
+#import "MYX509Decoder.h"
+#import "MYCertificateExtensions.h"
+#import "MYSignatureCache.h"
+#import "MYCanonicalName.h"
+#import "MYCertificateTemplate.h"
 #import "MYErrorUtils.h"
 #import "CollectionUtils.h"
 #import "Test.h"
@@ -40,12 +46,22 @@ static id $atIf(NSArray *array, NSUInteger index) {
 }
 
 
+/* Returns an NSData that points to bytes within `data` instead of copying them. The NSData keeps
+   `data` alive, so it remains valid after the caller lets go of `data`. */
+static NSData* sliceOfData (NSData *data, const void *bytes, size_t length) {
+    return [[NSData alloc] initWithBytesNoCopy: (void*)bytes
+                                        length: length
+                                   deallocator: ^(void *b, NSUInteger len) {(void)data;}];
+}
+
+
 @interface MYCertificateName ()
-- (id) _initWithComponents: (NSArray*)components;
+- (id) _initWithComponents: (NSArray*)components encoding: (NSData*)encoding;
 @end
 
 @interface MYCertificateInfo ()
 @property (strong) NSArray *_root;
+- (void) _extensionsChanged;
 @end
 
 
@@ -64,45 +80,25 @@ MYOID *kBasicConstraintsOID, *kKeyUsageOID, *kExtendedKeyUsageOID,
 
 + (void) initialize {
     if (!kEmailOID) {
-        kRSAAlgorithmID = [[MYOID alloc] initWithComponents: (UInt32[]){1, 2, 840, 113549, 1, 1, 1,}
-                                                      count: 7];
-        kRSAWithSHA1AlgorithmID = [[MYOID alloc] initWithComponents: (UInt32[]){1, 2, 840, 113549, 1, 1, 5}
-                                                              count: 7];
-        kRSAWithSHA256AlgorithmID = [[MYOID alloc] initWithComponents: (UInt32[]){1, 2, 840, 113549, 1, 1, 11}
-                                                                count:7];
-        kRSAWithMD5AlgorithmID = [[MYOID alloc] initWithComponents: (UInt32[]){1, 2, 840, 113549, 1, 1, 4 }
-                                                             count:7];
-        kRSAWithMD2AlgorithmID = [[MYOID alloc] initWithComponents: (UInt32[]){1, 2, 840, 113549, 1, 1, 2}
-                                                             count:7];
-        kCommonNameOID = [[MYOID alloc] initWithComponents: (UInt32[]){2, 5, 4, 3}
-                                                     count: 4];
-        kGivenNameOID = [[MYOID alloc] initWithComponents: (UInt32[]){2, 5, 4, 42}
-                                                    count: 4];
-        kSurnameOID = [[MYOID alloc] initWithComponents: (UInt32[]){2, 5, 4, 4}
-                                                  count: 4];
-        kDescriptionOID = [[MYOID alloc] initWithComponents: (UInt32[]){2, 5, 4, 13}
-                                                count: 4];
-        kEmailOID = [[MYOID alloc] initWithComponents: (UInt32[]){1, 2, 840, 113549, 1, 9, 1}
-                                                count: 7];
-        kBasicConstraintsOID = [[MYOID alloc] initWithComponents: (UInt32[]){2, 5, 29, 19}
-                                                           count: 4];
-        kKeyUsageOID = [[MYOID alloc] initWithComponents: (UInt32[]){2, 5, 29, 15}
-                                                           count: 4];
-        kExtendedKeyUsageOID = [[MYOID alloc] initWithComponents: (UInt32[]){2, 5, 29, 37}
-                                                           count: 4];
-
-        kExtendedKeyUsageServerAuthOID = [[MYOID alloc] initWithComponents: (UInt32[]){1, 3, 6, 1, 5, 5, 7, 3, 1}
-                                                           count: 9];
-        kExtendedKeyUsageClientAuthOID = [[MYOID alloc] initWithComponents: (UInt32[]){1, 3, 6, 1, 5, 5, 7, 3, 2}
-                                                                     count: 9];
-        kExtendedKeyUsageCodeSigningOID = [[MYOID alloc] initWithComponents: (UInt32[]){1, 3, 6, 1, 5, 5, 7, 3, 3}
-                                                                     count: 9];
-        kExtendedKeyUsageEmailProtectionOID = [[MYOID alloc] initWithComponents: (UInt32[]){1, 3, 6, 1, 5, 5, 7, 3, 4}
-                                                                          count: 9];
-        kExtendedKeyUsageAnyOID = [[MYOID alloc] initWithComponents: (UInt32[]){2, 5, 29, 37, 0}
-                                                                          count: 5];
-        kSubjectAltNameOID = [[MYOID alloc] initWithComponents: (UInt32[]){2, 5, 29, 17}
-                                                         count: 4];
+        kRSAAlgorithmID = [MYOID OIDWithKnownID: kMYOIDRSAEncryption];
+        kRSAWithSHA1AlgorithmID = [MYOID OIDWithKnownID: kMYOIDRSAWithSHA1];
+        kRSAWithSHA256AlgorithmID = [MYOID OIDWithKnownID: kMYOIDRSAWithSHA256];
+        kRSAWithMD5AlgorithmID = [MYOID OIDWithKnownID: kMYOIDRSAWithMD5];
+        kRSAWithMD2AlgorithmID = [MYOID OIDWithKnownID: kMYOIDRSAWithMD2];
+        kCommonNameOID = [MYOID OIDWithKnownID: kMYOIDCommonName];
+        kGivenNameOID = [MYOID OIDWithKnownID: kMYOIDGivenName];
+        kSurnameOID = [MYOID OIDWithKnownID: kMYOIDSurname];
+        kDescriptionOID = [MYOID OIDWithKnownID: kMYOIDDescription];
+        kEmailOID = [MYOID OIDWithKnownID: kMYOIDEmailAddress];
+        kBasicConstraintsOID = [MYOID OIDWithKnownID: kMYOIDBasicConstraints];
+        kKeyUsageOID = [MYOID OIDWithKnownID: kMYOIDKeyUsage];
+        kExtendedKeyUsageOID = [MYOID OIDWithKnownID: kMYOIDExtendedKeyUsage];
+        kExtendedKeyUsageServerAuthOID = [MYOID OIDWithKnownID: kMYOIDServerAuth];
+        kExtendedKeyUsageClientAuthOID = [MYOID OIDWithKnownID: kMYOIDClientAuth];
+        kExtendedKeyUsageCodeSigningOID = [MYOID OIDWithKnownID: kMYOIDCodeSigning];
+        kExtendedKeyUsageEmailProtectionOID = [MYOID OIDWithKnownID: kMYOIDEmailProtection];
+        kExtendedKeyUsageAnyOID = [MYOID OIDWithKnownID: kMYOIDAnyExtendedKeyUsage];
+        kSubjectAltNameOID = [MYOID OIDWithKnownID: kMYOIDSubjectAltName];
     }
 }
 
@@ -116,50 +112,40 @@ MYOID *kBasicConstraintsOID, *kKeyUsageOID, *kExtendedKeyUsageOID,
     return self;
 }
 
-+ (NSString*) validate: (id)root {
-    NSArray *top = $castIf(NSArray,root);
-    if (top.count < 3)
-        return @"Too few top-level components";
-    NSArray *info = $castIf(NSArray, top[0]);
-    if (info.count < 6) {
-        return @"Too few identity components";      // there should be 7, but version has a default
-    } else if (info.count > 6) {
-        MYASN1Object *version = $castIf(MYASN1Object, info[0]);
-        if (!version || version.tag != 0)
-            return @"Missing or invalid version";
-        NSArray *versionComps = $castIf(NSArray, version.components);
-        if (!versionComps || versionComps.count != 1)
-            return @"Invalid version";
-        NSNumber *versionNum = $castIf(NSNumber, versionComps[0]);
-        if (!versionNum || versionNum.intValue < 0 || versionNum.intValue > 2)
-            return @"Unrecognized version number";
-    }
-    return nil;
-}
-
-
 - (id) initWithCertificateData: (NSData*)data error: (NSError**)outError;
 {
     if (outError) *outError = nil;
-    id root = MYBERParse(data,outError);
-    NSString *errorMsg = [[self class] validate: root];
-    if (errorMsg) {
-        if (outError && !*outError)
-            *outError = MYError(2, MYASN1ErrorDomain, @"Invalid certificate: %@", errorMsg);
-        return nil;
-    }
-
-    self = [self initWithRoot: root];
+    self = [super init];
     if (self) {
+        // Just decode the field locations; the object tree is only built if it's needed.
         _data = [data copy];
+        _fields = malloc(sizeof(MYX509Fields));
+        if (!_fields) {
+            if (outError) *outError = MYError(1, MYASN1ErrorDomain, @"Out of memory");
+            return nil;
+        }
+        if (!MYX509DecodeCertificate(_data.bytes, _data.length, _fields, outError))
+            return nil;
     }
     return self;
 }
 
+- (void) dealloc {
+    free(_fields);
+}
+
+- (NSData*) certificateData {
+    return _data;
+}
+
 
 - (BOOL) isEqual: (id)object {
-    return [object isKindOfClass: [MYCertificateInfo class]]
-        && [_root isEqual: ((MYCertificateInfo*)object)->_root];
+    if (![object isKindOfClass: [MYCertificateInfo class]])
+        return NO;
+    MYCertificateInfo *other = object;
+    if (_fields && other->_fields)
+        return [_data isEqual: other->_data];
+    return [self._root isEqual: other._root];
 }
 
 /* _info returns an NSArray representing the thing called TBSCertificate in the spec:
@@ -177,45 +163,181 @@ MYOID *kBasicConstraintsOID, *kKeyUsageOID, *kExtendedKeyUsageOID,
         }
 */
 - (NSArray*) _info {
-    NSArray* info = $castIf(NSArray,$atIf(_root,0));
+    NSArray* info = $castIf(NSArray,$atIf(self._root,0));
     if (info.count >= 7)
         return info;
-    // If version field is missing, insert it explicitly so the array indices will be normal:
-    NSMutableArray* minfo = [info mutableCopy];
-    [minfo insertObject: @(0) atIndex: 0];
-    return minfo;
+    @synchronized(self) {
+        if (!_tbsInfo) {
+            // If version field is missing, insert it explicitly so the array indices will be normal:
+            NSMutableArray* minfo = [info mutableCopy];
+            [minfo insertObject: @(0) atIndex: 0];
+            _tbsInfo = minfo;
+        }
+        return _tbsInfo;
+    }
 }
 
 - (NSArray*) _validDates {return $castIf(NSArray, (self._info)[4]);}
 
-@synthesize _root;
+/* The certificate parsed into an object tree. When initialized from data, this isn't created
+   until something asks for it. */
+- (NSArray*) _root {
+    @synchronized(self) {
+        if (!_root && _data)
+            _root = $castIf(NSArray, MYBERParse(_data, NULL));
+        return _root;
+    }
+}
 
+- (void) set_root: (NSArray*)root {
+    @synchronized(self) {
+        _root = root;
+    }
+}
 
-- (NSDate*) validFrom       {return $castIf(NSDate, $atIf(self._validDates, 0));}
-- (NSDate*) validTo         {return $castIf(NSDate, $atIf(self._validDates, 1));}
+
+- (NSDate*) validFrom {
+    if (_fields)
+        return [NSDate dateWithTimeIntervalSince1970: _fields->notBefore];
+    return $castIf(NSDate, $atIf(self._validDates, 0));
+}
+
+- (NSDate*) validTo {
+    if (_fields)
+        return [NSDate dateWithTimeIntervalSince1970: _fields->notAfter];
+    return $castIf(NSDate, $atIf(self._validDates, 1));
+}
+
+/* Returns a cached NSData pointing into the certificate data, creating it on first use. */
+- (NSData*) _slice: (NSData* __strong*)cache bytes: (const void*)bytes length: (size_t)length {
+    @synchronized(self) {
+        if (!*cache)
+            *cache = sliceOfData(_data, bytes, length);
+        return *cache;
+    }
+}
+
+- (NSData*) _slice: (NSData* __strong*)cache encodingOf: (const MYBERSlice*)field {
+    return [self _slice: cache
+                  bytes: MYBERSliceGetEncoding(field)
+                 length: MYBERSliceGetEncodingLength(field)];
+}
+
+- (const MYX509Fields*) x509Fields {
+    return _fields;
+}
+
+
+/* Names of a parsed certificate are decoded directly from their fields, and cached. The ones in
+   a request are views of its mutable object tree, so they're created fresh each time. */
+- (MYCertificateName*) _name: (MYCertificateName* __strong*)cache
+                       field: (const MYBERSlice*)field
+                       index: (NSUInteger)index
+{
+    if (!_fields)
+        return [[MYCertificateName alloc] _initWithComponents: (self._info)[index] encoding: nil];
+    @synchronized(self) {
+        if (!*cache) {
+            NSArray *components = $castIf(NSArray, MYBERSliceParse(field, NULL));
+            NSData *encoding = sliceOfData(_data, MYBERSliceGetEncoding(field),
+                                           MYBERSliceGetEncodingLength(field));
+            if (components)
+                *cache = [[MYCertificateName alloc] _initWithComponents: components
+                                                               encoding: encoding];
+        }
+        return *cache;
+    }
+}
 
 - (MYCertificateName*) subject {
-    return [[MYCertificateName alloc] _initWithComponents: (self._info)[5]];
+    return [self _name: &_subject field: (_fields ? &_fields->subject : NULL) index: 5];
 }
 
 - (MYCertificateName*) issuer {
-    return [[MYCertificateName alloc] _initWithComponents: (self._info)[3]];
+    return [self _name: &_issuer field: (_fields ? &_fields->issuer : NULL) index: 3];
+}
+
+- (NSData*) subjectData {
+    return _fields ? [self _slice: &_subjectData encodingOf: &_fields->subject] : nil;
+}
+
+- (NSData*) issuerData {
+    return _fields ? [self _slice: &_issuerData encodingOf: &_fields->issuer] : nil;
+}
+
+- (NSData*) serialNumber {
+    if (!_fields)
+        return nil;
+    return [self _slice: &_serialNumber bytes: _fields->serialNumber.contents
+                 length: _fields->serialNumber.length];
+}
+
+- (BOOL) isSigned           {return _fields != NULL || [self._root count] >= 3;}
+
+- (MYCanonicalName*) _canonicalName: (MYCanonicalName* __strong*)cache encoding: (NSData*)encoding {
+    @synchronized(self) {
+        if (!*cache)
+            *cache = [[MYCanonicalName alloc] initWithEncodedName: encoding];
+        return *cache;
+    }
 }
 
-- (BOOL) isSigned           {return [_root count] >= 3;}
+- (MYCanonicalName*) canonicalSubject {
+    if (!_fields)
+        return self.subject.canonicalName;
+    return [self _canonicalName: &_canonicalSubject encoding: self.subjectData];
+}
+
+- (MYCanonicalName*) canonicalIssuer {
+    if (!_fields)
+        return self.issuer.canonicalName;
+    return [self _canonicalName: &_canonicalIssuer encoding: self.issuerData];
+}
 
 - (BOOL) isRoot {
+    if (_fields) {
+        const MYBERSlice *issuer = &_fields->issuer, *subject = &_fields->subject;
+        if (issuer->length == 0
+                || (issuer->length == subject->length
+                    && memcmp(issuer->contents, subject->contents, issuer->length) == 0))
+            return YES;
+        // The encodings differ, but the names may still match after canonicalization:
+        MYCanonicalName *canonicalIssuer = self.canonicalIssuer;
+        return canonicalIssuer && [canonicalIssuer isEqual: self.canonicalSubject];
+    }
     id issuer = $atIf(self._info,3);
-    return $equal(issuer, $atIf(self._info,5)) || $equal(issuer, @[]);
+    return $equal(issuer, @[]) || [self.issuer isEqual: self.subject];
 }
 
 
+- (NSData*) subjectPublicKeyBits {
+    if (_fields) {
+        size_t length;
+        const uint8_t *bytes = MYX509BitStringBytes(&_fields->publicKey, &length);
+        return [self _slice: &_subjectPublicKeyData bytes: bytes length: length];
+    }
+    NSArray *keyInfo = $cast(NSArray, $atIf(self._info, 6));
+    return $castIf(MYBitString, $atIf(keyInfo, 1)).bits;
+}
+
 - (NSData*) subjectPublicKeyData {
+    if (_fields) {
+        const MYBERSlice *oid = &_fields->publicKeyAlgorithmOID;
+        if ([MYOID OIDWithBERBytes: oid->contents length: oid->length].knownID != kMYOIDRSAEncryption)
+            return nil;
+        return self.subjectPublicKeyBits;
+    }
     NSArray *keyInfo = $cast(NSArray, $atIf(self._info, 6));
     MYOID *keyAlgorithmID = $castIf(MYOID, $atIf($castIf(NSArray,$atIf(keyInfo,0)), 0));
-    if (!$equal(keyAlgorithmID, kRSAAlgorithmID))
+    if (keyAlgorithmID.knownID != kMYOIDRSAEncryption)
         return nil;
-    return $cast(MYBitString, $atIf(keyInfo, 1)).bits;
+    return self.subjectPublicKeyBits;
+}
+
+- (NSData*) subjectPublicKeyInfoData {
+    if (!_fields)
+        return nil;
+    return [self _slice: &_subjectPublicKeyInfo encodingOf: &_fields->subjectPublicKeyInfo];
 }
 
 - (MYPublicKey*) subjectPublicKey {
@@ -225,27 +347,26 @@ MYOID *kBasicConstraintsOID, *kKeyUsageOID, *kExtendedKeyUsageOID,
 }
 
 - (NSData*) signedData {
-    if (!_data)
-        return nil;
-    // The root object is a sequence; we want to extract the 1st object of that sequence.
-    const UInt8 *certStart = _data.bytes;
-    const UInt8 *start = MYBERGetContents(_data, nil);
-    if (!start) return nil;
-    size_t length = MYBERGetLength([NSData dataWithBytesNoCopy: (void*)start
-                                                        length: _data.length - (start-certStart)
-                                                  freeWhenDone: NO],
-                                   NULL);
-    if (length==0)
+    if (!_fields)
         return nil;
-    return [NSData dataWithBytes: start length: (start + length - certStart)];
+    return [self _slice: &_signedData encodingOf: &_fields->tbsCertificate];
 }
 
 - (MYOID*) signatureAlgorithmID {
-    return $castIf(MYOID, $atIf($castIf(NSArray,$atIf(_root,1)), 0));
+    if (_fields) {
+        const MYBERSlice *oid = &_fields->signatureAlgorithmOID;
+        return [MYOID OIDWithBERBytes: oid->contents length: oid->length];
+    }
+    return $castIf(MYOID, $atIf($castIf(NSArray,$atIf(self._root,1)), 0));
 }
 
 - (NSData*) signature {
-    id signature = $atIf(_root,2);
+    if (_fields) {
+        size_t length;
+        const uint8_t *bytes = MYX509BitStringBytes(&_fields->signature, &length);
+        return [self _slice: &_signature bytes: bytes length: length];
+    }
+    id signature = $atIf(self._root,2);
     if ([signature isKindOfClass: [MYBitString class]])
         signature = [signature bits];
     return $castIf(NSData,signature);
@@ -256,133 +377,176 @@ MYOID *kBasicConstraintsOID, *kKeyUsageOID, *kExtendedKeyUsageOID,
     NSData *signature = self.signature;
     if (!signedData || !signature)
         return NO;
-    
+    return MYVerifySignedData(signedData, signature, self.signatureAlgorithmID, issuerPublicKey);
+}
+
+
+BOOL MYVerifySignedData (NSData *signedData, NSData *signature, MYOID *algID,
+                         MYPublicKey *issuerPublicKey)
+{
 #if !MYCRYPTO_USE_IPHONE_API
     // Determine which signature algorithm to use:
     CSSM_ALGORITHMS algorithm;
-    MYOID* algID = self.signatureAlgorithmID;
-    if ($equal(algID, kRSAWithSHA1AlgorithmID))
-        algorithm = CSSM_ALGID_SHA1WithRSA;
-    else if ($equal(algID, kRSAWithSHA256AlgorithmID))
-        algorithm = CSSM_ALGID_SHA256WithRSA;
-    else if ($equal(algID, kRSAWithMD5AlgorithmID))
-        algorithm = CSSM_ALGID_MD5WithRSA;
-    else if ($equal(algID, kRSAWithMD2AlgorithmID))
-        algorithm = CSSM_ALGID_MD2WithRSA;
-    else {
-        Warn(@"MYCertificateInfo can't verify: unknown signature algorithm %@", algID);
-        return NO;
+    switch (algID.knownID) {
+        case kMYOIDRSAWithSHA1:     algorithm = CSSM_ALGID_SHA1WithRSA; break;
+        case kMYOIDRSAWithSHA256:   algorithm = CSSM_ALGID_SHA256WithRSA; break;
+        case kMYOIDRSAWithSHA384:   algorithm = CSSM_ALGID_SHA384WithRSA; break;
+        case kMYOIDRSAWithSHA512:   algorithm = CSSM_ALGID_SHA512WithRSA; break;
+        case kMYOIDRSAWithMD5:      algorithm = CSSM_ALGID_MD5WithRSA; break;
+        case kMYOIDRSAWithMD2:      algorithm = CSSM_ALGID_MD2WithRSA; break;
+        default:
+            Warn(@"MYCrypto can't verify: unknown signature algorithm %@", algID);
+            return NO;
     }
 #endif
     
-    return [issuerPublicKey verifySignature: signature
-                                     ofData: signedData
+    // Intermediate certs get verified over and over, so remember the ones that checked out:
+    return [[MYSignatureCache sharedCache] verifySignature: signature
+                                                    ofData: signedData
+                                                 algorithm: algID
+                                           issuerKeyDigest: issuerPublicKey.publicKeyDigest
+                                                usingBlock: ^BOOL{
+        return [issuerPublicKey verifySignature: signature
+                                         ofData: signedData
 #if !MYCRYPTO_USE_IPHONE_API
-                              withAlgorithm: algorithm
+                                  withAlgorithm: algorithm
 #endif
-            ];
+                ];
+    }];
 }
 
 
 #pragma mark EXTENSIONS:
 
 
+/* Decodes the extensions of a parsed certificate from their field, without parsing the rest of
+   the certificate. Each item is in the same form the BER parser produces: the OID, the critical
+   flag if present, and the extension value as NSData (pointing into the certificate data.)
+        Extension ::= SEQUENCE {
+            extnID      OBJECT IDENTIFIER,
+            critical    BOOLEAN DEFAULT FALSE,
+            extnValue   OCTET STRING  } */
+- (NSArray*) _decodeExtensions {
+    NSMutableArray *extensions = $marray();
+    MYBERCursor cursor = MYBERSliceGetCursor(&_fields->extensions);
+    MYBERSlice extension;
+    while (MYBERCursorNext(&cursor, &extension, NULL)) {
+        MYBERCursor items = MYBERSliceGetCursor(&extension);
+        MYBERSlice oid, item;
+        if (!extension.isConstructed
+                || !MYBERCursorNext(&items, &oid, NULL) || oid.tag != 6 || oid.isConstructed
+                || !MYBERCursorNext(&items, &item, NULL))
+            continue;
+        id critical = nil;
+        if (item.tag == 1 && item.length == 1) {
+            critical = item.contents[0] ?$true :$false;
+            if (!MYBERCursorNext(&items, &item, NULL))
+                continue;
+        }
+        if (item.tag != 4 || item.isConstructed)
+            continue;
+        MYOID *extnID = [MYOID OIDWithBERBytes: oid.contents length: oid.length];
+        NSData *value = sliceOfData(_data, item.contents, item.length);
+        [extensions addObject: (critical ? @[extnID, critical, value] : @[extnID, value])];
+    }
+    return extensions;
+}
+
 - (NSArray*)_extensions {
-    if (!_extensions) {
-        // The extensions field doesn't have a fixed index:
-        // it comes after the 7 fixed info fields, and is identified by a tag value of 3.
-        NSArray* info = self._info;
-        for (NSUInteger i=7; i<info.count; i++) {
-            MYASN1Object* obj = $castIf(MYASN1Object, info[i]);
-            if (obj.tag == 3) {
-                _extensions = $castIf(NSArray, $atIf(obj.components, 0));
-                break;
+    @synchronized(self) {
+        if (!_extensions) {
+            if (_fields) {
+                if (MYX509FieldIsPresent(&_fields->extensions))
+                    _extensions = [self _decodeExtensions];
+            } else {
+                // The extensions field doesn't have a fixed index:
+                // it comes after the 7 fixed info fields, and is identified by a tag value of 3.
+                NSArray* info = self._info;
+                for (NSUInteger i=7; i<info.count; i++) {
+                    MYASN1Object* obj = $castIf(MYASN1Object, info[i]);
+                    if (obj.tag == 3) {
+                        _extensions = $castIf(NSArray, $atIf(obj.components, 0));
+                        break;
+                    }
+                }
             }
         }
+        return _extensions;
     }
-    return _extensions;
 }
 
 
-- (NSArray*) _itemForOID: (MYOID*)oid {
-    for (id item in self._extensions) {
-        NSArray* extension = $castIf(NSArray, item);
-        if ([$atIf(extension, 0) isEqual: oid])
-            return extension;
+- (MYCertificateExtensions*) extensions {
+    @synchronized(self) {
+        if (!_extensionTable)
+            _extensionTable = [[MYCertificateExtensions alloc] initWithExtensions: self._extensions];
+        return _extensionTable;
     }
-    return nil;
+}
+
+/* Called by MYCertificateRequest after it modifies the extensions. */
+- (void) _extensionsChanged {
+    @synchronized(self) {
+        _extensionTable = nil;
+    }
+}
+
+
+- (NSArray*) _itemForOID: (MYOID*)oid {
+    return [self.extensions itemForOID: oid];
 }
 
 
 - (NSArray*) extensionOIDs {
-    NSMutableArray* oids = $marray();
-    for (id item in self._extensions) {
-        NSArray* extension = $castIf(NSArray, item);
-        MYOID* oid = $castIf(MYOID, $atIf(extension, 0));
-        if (oid)
-            [oids addObject:oid];
-    }
-    return oids;
+    return self.extensions.OIDs;
 }
 
 
 - (id) extensionForOID: (MYOID*)oid isCritical: (BOOL*)outIsCritical {
-    NSArray* extension = [self _itemForOID:oid];
-    if (!extension)
-        return nil;
-    if (outIsCritical)
-        *outIsCritical = extension.count >= 3 &&
-                            [$castIf(NSNumber, extension[1]) boolValue];
-    NSData* ber = $castIf(NSData, [extension lastObject]);
+    NSData* ber = [self.extensions valueForOID: oid isCritical: outIsCritical];
     if (!ber)
         return nil;
     return MYBERParse(ber, NULL);
 }
 
 
+- (NSData*) subjectKeyIdentifier {
+    return self.extensions.subjectKeyIdentifier;
+}
+
+- (NSData*) authorityKeyIdentifier {
+    return self.extensions.authorityKeyIdentifier;
+}
+
+- (MYSHA1Digest*) publicKeyDigest {
+    return self.subjectPublicKeyData.my_SHA1Digest;
+}
+
+
 - (BOOL) isCertificateAuthority {
-    id ext = [self extensionForOID:kBasicConstraintsOID
-                        isCritical:NULL];
-    NSArray* constraints = $castIf(NSArray, ext);
-    Assert(!(ext && !constraints)); // type mismatch
-    if (!constraints || [constraints count] < 1)
-        return NO;
-    return [$castIf(NSNumber, constraints[0]) boolValue];
+    return self.extensions.isCertificateAuthority;
 }
 
 
 - (UInt16) keyUsage {
     // RFC 3280 sec. 4.2.1.3
-    MYBitString* bits = $castIf(MYBitString, [self extensionForOID:kKeyUsageOID isCritical:NULL]);
-    if (!bits)
-        return kKeyUsageUnspecified;
-    const UInt8* bytes = [bits.bits bytes];
-    UInt16 value = bytes[0];
-    if (bits.bitCount > 8)      // 9 bits are defined, so the value could be multi-byte
-        value |= bytes[1] << 8;
-    return value;
+    return self.extensions.keyUsage;
 }
 
 - (BOOL) allowsKeyUsage: (UInt16)requestedKeyUsage {
-    if ([self extensionForOID: kKeyUsageOID isCritical:NULL]) {
-        if ((self.keyUsage & requestedKeyUsage) != requestedKeyUsage)
-            return NO;
-    }
-    return YES;
+    // (If the extension is absent, keyUsage is kKeyUsageUnspecified, which has every bit set.)
+    return (self.keyUsage & requestedKeyUsage) == requestedKeyUsage;
 }
 
 
 - (NSSet*) extendedKeyUsage {
     // RFC 3280 sec. 4.2.1.13
-    NSArray* oids = $castIf(NSArray, [self extensionForOID: kExtendedKeyUsageOID isCritical: NULL]);
-    if (!oids)
-        return nil;
-    return [NSSet setWithArray:oids];
+    return self.extensions.extendedKeyUsage;
 }
 
 - (BOOL) allowsExtendedKeyUsage: (NSSet*) requestedKeyUsage {
-    if ([self extensionForOID: kExtendedKeyUsageOID isCritical:NULL]) {
-        NSSet* keyUsage = self.extendedKeyUsage;
+    NSSet* keyUsage = self.extendedKeyUsage;
+    if (keyUsage) {
         if (![requestedKeyUsage isSubsetOfSet: keyUsage]
                 && ![keyUsage containsObject: kExtendedKeyUsageAnyOID])
             return NO;
@@ -393,47 +557,12 @@ MYOID *kBasicConstraintsOID, *kKeyUsageOID, *kExtendedKeyUsageOID,
 
 - (NSDictionary*) subjectAlternativeName {
     // RFC 3280 sec. 4.2.1.7
-    NSArray* names = $castIf(NSArray, [self extensionForOID: kSubjectAltNameOID isCritical:NULL]);
-    if (!names)
-        return nil;
-    NSMutableDictionary* result = $mdict();
-    for (id entry in names) {
-        MYASN1Object* name = $castIf(MYASN1Object, entry);
-        if (name && name.tagClass == 2) {
-            id key, value;
-            switch(name.tag) {
-                case 1:
-                    key = @"RFC822";
-                    value = name.ASCIIValue;
-                    break;
-                case 2:
-                    key = @"DNS";
-                    value = name.ASCIIValue;
-                    break;
-                case 6:
-                    key = @"URI";
-                    value = name.ASCIIValue;
-                    break;
-                default:
-                    key = @(name.tag);
-                    value = name;
-            }
-            if (value) {
-                NSMutableArray* values = result[key];
-                if (!values) {
-                    values = $marray();
-                    result[key] = values;
-                }
-                [values addObject: value];
-            }
-        }
-    }
-    return result;
+    return self.extensions.subjectAlternativeName;
 }
 
 
 - (NSArray*) emailAddresses {
-    NSMutableArray* addrs = [self subjectAlternativeName][@"RFC822"];
+    NSMutableArray* addrs = [[self subjectAlternativeName][@"RFC822"] mutableCopy];
     NSString* subjectEmail = self.subject.emailAddress;
     if (subjectEmail) {
         if (addrs)
@@ -505,13 +634,14 @@ MYOID *kBasicConstraintsOID, *kKeyUsageOID, *kExtendedKeyUsageOID,
     NSMutableArray* extension = (NSMutableArray*) [self _itemForOID:oid];
     if (extension) {
         if (item)
-            [extension replaceObjectsInRange:NSMakeRange(0,2) withObjectsFromArray:item];
+            [extension setArray: item];
         else
-            [extensions removeObject: extension];
+            [extensions removeObjectIdenticalTo: extension];
     } else {
         if (item)
             [extensions addObject: item];
     }
+    [self _extensionsChanged];
 }
 
 
@@ -610,6 +740,18 @@ MYOID *kBasicConstraintsOID, *kKeyUsageOID, *kExtendedKeyUsageOID,
 }
 
 
+- (MYCertificateTemplate*) templateWithIssuer: (MYCertificateInfo*)issuer
+                                   signingKey: (MYPrivateKey*)signingKey
+{
+    NSArray *info = self._info;
+    NSData *issuerData = issuer ? issuer.subjectData
+                                : [MYDEREncoder encodeRootObject: info[5] error: NULL];
+    return [[MYCertificateTemplate alloc] initWithTBSCertificate: info
+                                                      issuerData: issuerData
+                                                      signingKey: signingKey];
+}
+
+
 @end
 
 
@@ -617,31 +759,63 @@ MYOID *kBasicConstraintsOID, *kKeyUsageOID, *kExtendedKeyUsageOID,
 #pragma mark -
 @implementation MYCertificateName
 
-- (id) _initWithComponents: (NSArray*)components
+- (id) _initWithComponents: (NSArray*)components encoding: (NSData*)encoding
 {
     self = [super init];
     if (self != nil) {
         _components = components;
+        _encoding = encoding;
     }
     return self;
 }
 
 
+/* A name from a certificate has its original encoding, and is immutable, so its canonical form
+   is computed once. A request's name is mutable, so it's encoded on demand. */
+- (MYCanonicalName*) canonicalName {
+    @synchronized(self) {
+        if (_canonicalName)
+            return _canonicalName;
+        NSData *encoding = _encoding ?: [MYDEREncoder encodeRootObject: _components error: NULL];
+        MYCanonicalName *canonicalName = [[MYCanonicalName alloc] initWithEncodedName: encoding];
+        if (_encoding)
+            _canonicalName = canonicalName;
+        return canonicalName;
+    }
+}
+
 - (BOOL) isEqual: (id)object {
-    return [object isKindOfClass: [MYCertificateName class]]
-        && [_components isEqual: ((MYCertificateName*)object)->_components];
+    if (![object isKindOfClass: [MYCertificateName class]])
+        return NO;
+    MYCanonicalName *canonical = self.canonicalName;
+    MYCanonicalName *otherCanonical = ((MYCertificateName*)object).canonicalName;
+    if (canonical && otherCanonical)
+        return [canonical isEqual: otherCanonical];
+    return [_components isEqual: ((MYCertificateName*)object)->_components];
+}
+
+- (NSUInteger) hash {
+    return self.canonicalName.hash;
 }
 
+/* Returns the first [oid, value] pair with the given OID. The pairs are indexed by OID on the
+   first call. */
 - (NSArray*) _pairForOID: (MYOID*)oid {
-    for (id nameEntry in _components) {
-        for (id pair in $castIf(NSSet,nameEntry)) {
-            if ([pair isKindOfClass: [NSArray class]] && [pair count] == 2) {
-                if ($equal(oid, pair[0]))
-                    return pair;
+    @synchronized(self) {
+        if (!_pairsByOID) {
+            _pairsByOID = [[NSMutableDictionary alloc] init];
+            for (id nameEntry in _components) {
+                for (id pair in $castIf(NSSet,nameEntry)) {
+                    if ([pair isKindOfClass: [NSArray class]] && [pair count] == 2) {
+                        MYOID *pairOID = $castIf(MYOID, pair[0]);
+                        if (pairOID && !_pairsByOID[pairOID])
+                            _pairsByOID[pairOID] = pair;
+                    }
+                }
             }
         }
+        return _pairsByOID[oid];
     }
-    return nil;
 }
 
 - (NSString*) stringForOID: (MYOID*)oid {
@@ -656,8 +830,13 @@ MYOID *kBasicConstraintsOID, *kKeyUsageOID, *kExtendedKeyUsageOID,
         else
             Assert(NO,@"-setString:forOID: removing strings is unimplemented");//FIX
     } else {
-        if (value)
-            [(NSMutableArray*)_components addObject: [NSSet setWithObject: $marray(oid,value)]];
+        if (value) {
+            NSMutableArray *newPair = $marray(oid,value);
+            [(NSMutableArray*)_components addObject: [NSSet setWithObject: newPair]];
+            @synchronized(self) {
+                _pairsByOID[oid] = newPair;
+            }
+        }
     }
 }
 
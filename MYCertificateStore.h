@@ -0,0 +1,77 @@
+//
+//  MYCertificateStore.h
+//  MYCrypto
+//
+//  Created by Jens Alfke on 10/16/26.
+//  Copyright 2026 Jens Alfke. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+@class MYCertificateInfo, MYCertificateName, MYSHA1Digest;
+
+
+/** An in-memory collection of certificates, independent of any keychain, indexed for fast lookup
+    by subject name, subject and authority key identifiers, and public key digest -- the things
+    needed to find a certificate's issuer when building a chain.
+    Lookups never block: each change builds a new immutable copy of the indexes and swaps it in,
+    so readers on any number of threads see a consistent snapshot. That makes changes O(n), so add
+    certificates in batches where possible. */
+@interface MYCertificateStore : NSObject
+{
+    @private
+    id _snapshot;
+}
+
+- (id) init;
+
+/** Initializes a store containing the given MYCertificateInfo objects. */
+- (id) initWithCertificates: (NSArray*)certificates;
+
+/** All the certificates, in the order they were added. */
+@property (readonly) NSArray *certificates;
+
+@property (readonly) NSUInteger count;
+
+- (BOOL) containsCertificate: (MYCertificateInfo*)certificate;
+
+/** Adds a certificate. Returns NO if an identical certificate is already present, or if it isn't
+    a certificate parsed from data (such as a MYCertificateRequest.) */
+- (BOOL) addCertificate: (MYCertificateInfo*)certificate;
+
+/** Adds a number of certificates at once, which is much faster than adding them one at a time.
+    Returns the number that were added. */
+- (NSUInteger) addCertificates: (NSArray*)certificates;
+
+/** Removes a certificate. Returns NO if it wasn't present. */
+- (BOOL) removeCertificate: (MYCertificateInfo*)certificate;
+
+- (void) removeAllCertificates;
+
+
+/** The certificates whose subject matches the given name, by RFC 5280 rules. */
+- (NSArray*) certificatesWithSubject: (MYCertificateName*)name;
+
+/** The certificates with the given SubjectKeyIdentifier extension. */
+- (NSArray*) certificatesWithSubjectKeyIdentifier: (NSData*)keyID;
+
+/** The certificates with the given AuthorityKeyIdentifier, i.e. the ones issued by the holder of
+    the key with that SubjectKeyIdentifier. */
+- (NSArray*) certificatesWithAuthorityKeyIdentifier: (NSData*)keyID;
+
+/** The certificates whose subject public key has the given digest. */
+- (NSArray*) certificatesWithPublicKeyDigest: (MYSHA1Digest*)digest;
+
+
+/** The certificates that could have issued the given one: those whose subject matches its
+    issuer and, if it has an AuthorityKeyIdentifier, whose SubjectKeyIdentifier matches that.
+    Signatures are not checked. */
+- (NSArray*) issuersOfCertificate: (MYCertificateInfo*)certificate;
+
+/** Builds a certificate chain by following issuers from the given certificate, stopping at a
+    self-signed certificate or when no issuer is found. If there are several candidate issuers,
+    the first one added is used.
+    Signatures are not checked; use -[MYCertificateInfo verifySignatureWithKey:] on each link.
+    @return  An array starting with the given certificate and ending with the topmost issuer found. */
+- (NSArray*) chainForCertificate: (MYCertificateInfo*)certificate;
+
+@end
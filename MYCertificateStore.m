@@ -0,0 +1,364 @@
+//
+//  MYCertificateStore.m
+//  MYCrypto
+//
+//  Created by Jens Alfke on 10/16/26.
+//  Copyright 2026 Jens Alfke. All rights reserved.
+//
+
+#import "MYCertificateStore.h"
+#import "MYCertificateInfo.h"
+#import "MYCrypto_Private.h"
+#import "MYDigest.h"
+#import "MYCanonicalName.h"
+#import "CollectionUtils.h"
+#import "Test.h"
+
+
+#define kMaxChainLength 16
+
+
+/** One immutable state of a MYCertificateStore. Each index maps a key to an NSArray of
+    certificates. A new snapshot is built by copying the previous one's containers (but not the
+    arrays in them, which are replaced instead of modified); once published it's never changed. */
+@interface MYCertificateStoreSnapshot : NSObject
+{
+    @public
+    NSMutableArray *_certificates;
+    NSMutableDictionary *_byData, *_bySubject, *_bySKI, *_byAKI, *_byKeyDigest;
+}
+- (id) initWithSnapshot: (MYCertificateStoreSnapshot*)snapshot;
+- (BOOL) addCertificate: (MYCertificateInfo*)cert;
+- (BOOL) removeCertificate: (MYCertificateInfo*)cert;
+@end
+
+
+@implementation MYCertificateStoreSnapshot
+
+- (id) initWithSnapshot: (MYCertificateStoreSnapshot*)snapshot {
+    self = [super init];
+    if (self) {
+        if (snapshot) {
+            _certificates = [snapshot->_certificates mutableCopy];
+            _byData = [snapshot->_byData mutableCopy];
+            _bySubject = [snapshot->_bySubject mutableCopy];
+            _bySKI = [snapshot->_bySKI mutableCopy];
+            _byAKI = [snapshot->_byAKI mutableCopy];
+            _byKeyDigest = [snapshot->_byKeyDigest mutableCopy];
+        } else {
+            _certificates = $marray();
+            _byData = $mdict();
+            _bySubject = $mdict();
+            _bySKI = $mdict();
+            _byAKI = $mdict();
+            _byKeyDigest = $mdict();
+        }
+    }
+    return self;
+}
+
+
+static void addToIndex (NSMutableDictionary *index, id key, MYCertificateInfo *cert) {
+    if (!key)
+        return;
+    NSArray *certs = index[key];
+    index[key] = certs ? [certs arrayByAddingObject: cert] : @[cert];
+}
+
+static void removeFromIndex (NSMutableDictionary *index, id key, MYCertificateInfo *cert) {
+    if (!key)
+        return;
+    NSMutableArray *certs = [index[key] mutableCopy];
+    [certs removeObjectIdenticalTo: cert];
+    if (certs.count > 0)
+        index[key] = [certs copy];
+    else
+        [index removeObjectForKey: key];
+}
+
+
+- (BOOL) addCertificate: (MYCertificateInfo*)cert {
+    NSData *data = cert.certificateData;
+    if (!data || _byData[data])
+        return NO;
+    _byData[data] = cert;
+    [_certificates addObject: cert];
+    addToIndex(_bySubject, cert.canonicalSubject, cert);
+    addToIndex(_bySKI, cert.subjectKeyIdentifier, cert);
+    addToIndex(_byAKI, cert.authorityKeyIdentifier, cert);
+    addToIndex(_byKeyDigest, cert.publicKeyDigest, cert);
+    return YES;
+}
+
+- (BOOL) removeCertificate: (MYCertificateInfo*)cert {
+    NSData *data = cert.certificateData;
+    cert = data ? _byData[data] : nil;          // use the identical instance that was added
+    if (!cert)
+        return NO;
+    [_byData removeObjectForKey: data];
+    [_certificates removeObjectIdenticalTo: cert];
+    removeFromIndex(_bySubject, cert.canonicalSubject, cert);
+    removeFromIndex(_bySKI, cert.subjectKeyIdentifier, cert);
+    removeFromIndex(_byAKI, cert.authorityKeyIdentifier, cert);
+    removeFromIndex(_byKeyDigest, cert.publicKeyDigest, cert);
+    return YES;
+}
+
+@end
+
+
+
+
+@interface MYCertificateStore ()
+@property (strong) id _snapshot;        // atomic, so readers can get it without locking
+@end
+
+
+@implementation MYCertificateStore
+
+
+- (id) init {
+    return [self initWithCertificates: nil];
+}
+
+- (id) initWithCertificates: (NSArray*)certificates {
+    self = [super init];
+    if (self) {
+        MYCertificateStoreSnapshot *snapshot = [[MYCertificateStoreSnapshot alloc] initWithSnapshot: nil];
+        for (MYCertificateInfo *cert in certificates)
+            [snapshot addCertificate: cert];
+        _snapshot = snapshot;
+    }
+    return self;
+}
+
+
+@synthesize _snapshot;
+
+
+/* Applies a change to a copy of the current snapshot, then publishes the copy if anything
+   changed. Writers are serialized; readers are unaffected. */
+- (NSUInteger) _update: (NSUInteger(^)(MYCertificateStoreSnapshot*))block {
+    @synchronized(self) {
+        MYCertificateStoreSnapshot *snapshot = [[MYCertificateStoreSnapshot alloc]
+                                                        initWithSnapshot: self._snapshot];
+        NSUInteger changes = block(snapshot);
+        if (changes > 0)
+            self._snapshot = snapshot;
+        return changes;
+    }
+}
+
+
+- (NSArray*) certificates {
+    MYCertificateStoreSnapshot *snapshot = self._snapshot;
+    return [snapshot->_certificates copy];
+}
+
+- (NSUInteger) count {
+    MYCertificateStoreSnapshot *snapshot = self._snapshot;
+    return snapshot->_certificates.count;
+}
+
+- (BOOL) containsCertificate: (MYCertificateInfo*)certificate {
+    MYCertificateStoreSnapshot *snapshot = self._snapshot;
+    NSData *data = certificate.certificateData;
+    return data && snapshot->_byData[data] != nil;
+}
+
+- (BOOL) addCertificate: (MYCertificateInfo*)certificate {
+    return [self addCertificates: @[certificate]] > 0;
+}
+
+- (NSUInteger) addCertificates: (NSArray*)certificates {
+    return [self _update: ^NSUInteger(MYCertificateStoreSnapshot *snapshot) {
+        NSUInteger added = 0;
+        for (MYCertificateInfo *cert in certificates)
+            if ([snapshot addCertificate: cert])
+                ++added;
+        return added;
+    }];
+}
+
+- (BOOL) removeCertificate: (MYCertificateInfo*)certificate {
+    return [self _update: ^NSUInteger(MYCertificateStoreSnapshot *snapshot) {
+        return [snapshot removeCertificate: certificate];
+    }] > 0;
+}
+
+- (void) removeAllCertificates {
+    @synchronized(self) {
+        self._snapshot = [[MYCertificateStoreSnapshot alloc] initWithSnapshot: nil];
+    }
+}
+
+
+#pragma mark LOOKUP:
+
+
+- (NSArray*) certificatesWithSubject: (MYCertificateName*)name {
+    MYCertificateStoreSnapshot *snapshot = self._snapshot;
+    MYCanonicalName *key = name.canonicalName;
+    return (key ? snapshot->_bySubject[key] : nil) ?: @[];
+}
+
+- (NSArray*) certificatesWithSubjectKeyIdentifier: (NSData*)keyID {
+    MYCertificateStoreSnapshot *snapshot = self._snapshot;
+    return snapshot->_bySKI[keyID] ?: @[];
+}
+
+- (NSArray*) certificatesWithAuthorityKeyIdentifier: (NSData*)keyID {
+    MYCertificateStoreSnapshot *snapshot = self._snapshot;
+    return snapshot->_byAKI[keyID] ?: @[];
+}
+
+- (NSArray*) certificatesWithPublicKeyDigest: (MYSHA1Digest*)digest {
+    MYCertificateStoreSnapshot *snapshot = self._snapshot;
+    return snapshot->_byKeyDigest[digest] ?: @[];
+}
+
+
+static NSArray* issuersInSnapshot (MYCertificateStoreSnapshot *snapshot, MYCertificateInfo *cert) {
+    MYCanonicalName *issuerName = cert.canonicalIssuer;
+    NSArray *candidates = issuerName ? snapshot->_bySubject[issuerName] : nil;
+    NSData *authorityKeyID = cert.authorityKeyIdentifier;
+    if (!authorityKeyID || !candidates)
+        return candidates ?: @[];
+    // A candidate with a different key identifier can't be the issuer:
+    NSMutableArray *issuers = $marray();
+    for (MYCertificateInfo *candidate in candidates) {
+        NSData *keyID = candidate.subjectKeyIdentifier;
+        if (!keyID || [keyID isEqual: authorityKeyID])
+            [issuers addObject: candidate];
+    }
+    return issuers;
+}
+
+- (NSArray*) issuersOfCertificate: (MYCertificateInfo*)certificate {
+    return issuersInSnapshot(self._snapshot, certificate);
+}
+
+- (NSArray*) chainForCertificate: (MYCertificateInfo*)certificate {
+    MYCertificateStoreSnapshot *snapshot = self._snapshot;     // use one snapshot throughout
+    NSMutableArray *chain = $marray(certificate);
+    MYCertificateInfo *cert = certificate;
+    while (!cert.isRoot && chain.count < kMaxChainLength) {
+        MYCertificateInfo *issuer = nil;
+        for (MYCertificateInfo *candidate in issuersInSnapshot(snapshot, cert)) {
+            if (![chain containsObject: candidate]) {       // don't loop
+                issuer = candidate;
+                break;
+            }
+        }
+        if (!issuer)
+            break;
+        [chain addObject: issuer];
+        cert = issuer;
+    }
+    return chain;
+}
+
+
+@end
+
+
+
+
+#pragma mark -
+#pragma mark TEST CASES:
+
+
+static MYCertificateInfo* readCert (NSString *name) {
+    NSData *data = [NSData dataWithContentsOfFile: [name stringByAppendingPathExtension: @"cer"]];
+    CAssert(data, @"Couldn't read %@", name);
+    MYCertificateInfo *cert = [[MYCertificateInfo alloc] initWithCertificateData: data error: NULL];
+    CAssert(cert);
+    return cert;
+}
+
+
+TestCase(MYCertificateStore) {
+    RequireTestCase(ParsedCert);
+    MYCertificateInfo *selfSigned = readCert(@"selfsigned");
+    MYCertificateInfo *email = readCert(@"selfsigned_email");
+    MYCertificateInfo *generated = readCert(@"generated");
+    MYCertificateInfo *dev = readCert(@"iphonedev");
+
+    MYCertificateStore *store = [[MYCertificateStore alloc] initWithCertificates: @[selfSigned, email]];
+    CAssertEq(store.count, (NSUInteger)2);
+    CAssert([store addCertificate: dev]);
+    CAssertEq([store addCertificates: @[generated, dev, readCert(@"selfsigned")]], (NSUInteger)1);
+    CAssertEq(store.count, (NSUInteger)4);
+    CAssertEqual(store.certificates, (@[selfSigned, email, dev, generated]));
+    CAssert([store containsCertificate: readCert(@"iphonedev")]);
+
+    // Indexes:
+    CAssertEqual([store certificatesWithSubject: selfSigned.subject], @[selfSigned]);
+    CAssertEqual([store certificatesWithSubject: dev.issuer], @[]);
+    CAssertEqual([store certificatesWithPublicKeyDigest: email.publicKeyDigest], @[email]);
+    const uint8_t kDevSKI[20] = {0x26, 0x2C, 0x0F, 0x41, 0x39, 0xE3, 0x25, 0xF7, 0xD6, 0xDB,
+                                 0xCB, 0x00, 0xBF, 0xF3, 0x14, 0x61, 0x14, 0x78, 0x48, 0x85};
+    const uint8_t kDevAKI[20] = {0x88, 0x27, 0x17, 0x09, 0xA9, 0xB6, 0x18, 0x60, 0x8B, 0xEC,
+                                 0xEB, 0xBA, 0xF6, 0x47, 0x59, 0xC5, 0x52, 0x54, 0xA3, 0xB7};
+    NSData *devSKI = [NSData dataWithBytes: kDevSKI length: sizeof(kDevSKI)];
+    NSData *devAKI = [NSData dataWithBytes: kDevAKI length: sizeof(kDevAKI)];
+    CAssertEqual(dev.subjectKeyIdentifier, devSKI);
+    CAssertEqual(dev.authorityKeyIdentifier, devAKI);
+    CAssertNil(selfSigned.subjectKeyIdentifier);
+    CAssertEqual([store certificatesWithSubjectKeyIdentifier: devSKI], @[dev]);
+    CAssertEqual([store certificatesWithAuthorityKeyIdentifier: devAKI], @[dev]);
+    CAssertEqual([store certificatesWithAuthorityKeyIdentifier: devSKI], @[]);
+
+    // Chains:
+    CAssertEqual([store issuersOfCertificate: selfSigned], @[selfSigned]);
+    CAssertEqual([store chainForCertificate: selfSigned], @[selfSigned]);
+    CAssertEqual([store issuersOfCertificate: dev], @[]);
+    CAssertEqual([store chainForCertificate: dev], @[dev]);
+
+    // Removal:
+    CAssert([store removeCertificate: readCert(@"iphonedev")]);
+    CAssert(![store removeCertificate: dev]);
+    CAssertEqual([store certificatesWithSubjectKeyIdentifier: devSKI], @[]);
+    CAssertEq(store.count, (NSUInteger)3);
+
+    // Readers see consistent snapshots while a writer changes the store:
+    dispatch_queue_t queue = dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0);
+    dispatch_apply(1000, queue, ^(size_t i) {
+        if (i % 10 == 0) {
+            if ((i / 10) % 2)
+                [store removeCertificate: dev];
+            else
+                [store addCertificate: dev];
+        } else {
+            NSArray *found = [store certificatesWithAuthorityKeyIdentifier: devAKI];
+            CAssert(found.count == 0 || [found isEqual: @[dev]]);
+            CAssertEqual([store chainForCertificate: email], @[email]);
+        }
+    });
+    [store removeAllCertificates];
+    CAssertEq(store.count, (NSUInteger)0);
+}
+
+
+
+/*
+ Copyright (c) 2009, Jens Alfke <jens@mooseyard.com>. All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification, are permitted
+ provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice, this list of conditions
+ and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions
+ and the following disclaimer in the documentation and/or other materials provided with the
+ distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRI-
+ BUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
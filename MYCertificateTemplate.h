@@ -0,0 +1,64 @@
+//
+//  MYCertificateTemplate.h
+//  MYCrypto
+//
+//  Created by Jens Alfke on 10/16/26.
+//  Copyright 2026 Jens Alfke. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+@class MYPrivateKey, MYPublicKey;
+
+
+/** A prepared form of a MYCertificateRequest, for issuing large numbers of certificates that
+    differ only in serial number, validity period, subject common name and public key.
+    Everything else -- version, issuer, the rest of the subject, extensions, algorithms -- is
+    DER-encoded once when the template is created. Issuing a certificate just writes the variable
+    fields between those pre-encoded pieces, computing the enclosing lengths arithmetically, and
+    signs the result; no object tree is built and MYDEREncoder isn't involved.
+    Get one from -[MYCertificateRequest templateWithIssuer:signingKey:]. Instances are immutable,
+    so they can be used from any thread. */
+@interface MYCertificateTemplate : NSObject
+{
+    @private
+    MYPrivateKey *_signingKey;
+    NSData *_version, *_signatureAlgorithm, *_issuer;
+    NSData *_subjectPrefix, *_subjectSuffix;
+    NSData *_keyAlgorithm, *_extensions;
+}
+
+/** Encodes and signs a single certificate.
+    @param publicKey  The subject's public key.
+    @param commonName  The subject's common name; the other subject attributes come from the template.
+    @param serialNumber  The serial number, which should be unique among the issuer's certificates.
+    @param validFrom  The date/time at which the certificate becomes valid.
+    @param validTo  The date/time at which the certificate expires.
+    @return  The encoded certificate, or nil on error. */
+- (NSData*) issueCertificateWithPublicKey: (MYPublicKey*)publicKey
+                               commonName: (NSString*)commonName
+                             serialNumber: (UInt64)serialNumber
+                                validFrom: (NSDate*)validFrom
+                                  validTo: (NSDate*)validTo
+                                    error: (NSError**)outError;
+
+/** Issues a batch of certificates, encoding and signing them in parallel on all available cores.
+    The i'th certificate gets the i'th public key and common name, and serial number
+    firstSerialNumber+i; all share the same validity period.
+    @return  An array of encoded certificates in the same order as the keys, or nil if any of
+            them failed. */
+- (NSArray*) issueCertificatesWithPublicKeys: (NSArray*)publicKeys
+                                 commonNames: (NSArray*)commonNames
+                           firstSerialNumber: (UInt64)firstSerialNumber
+                                   validFrom: (NSDate*)validFrom
+                                     validTo: (NSDate*)validTo
+                                       error: (NSError**)outError;
+
+/** Encodes the TBSCertificate (the part that gets signed) without signing it.
+    Useful if the signature is to be made elsewhere, such as in an HSM. */
+- (NSData*) encodeTBSCertificateWithPublicKey: (MYPublicKey*)publicKey
+                                   commonName: (NSString*)commonName
+                                 serialNumber: (UInt64)serialNumber
+                                    validFrom: (NSDate*)validFrom
+                                      validTo: (NSDate*)validTo;
+
+@end
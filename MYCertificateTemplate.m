@@ -0,0 +1,478 @@
+//
+//  MYCertificateTemplate.m
+//  MYCrypto
+//
+//  Created by Jens Alfke on 10/16/26.
+//  Copyright 2026 Jens Alfke. All rights reserved.
+//
+
+#import "MYCertificateTemplate.h"
+#import "MYCrypto_Private.h"
+#import "MYASN1Object.h"
+#import "MYASN1Time.h"
+#import "MYBERParser.h"
+#import "MYDEREncoder.h"
+#import "MYOID.h"
+#import "MYErrorUtils.h"
+#import "CollectionUtils.h"
+#import "Test.h"
+
+
+/* The DER encoding of the common-name attribute type, 2.5.4.3 */
+static const uint8_t kCommonNameOIDBytes[] = {0x06, 0x03, 0x55, 0x04, 0x03};
+
+/* The signature algorithm of the certificate itself. This matches what
+   -[MYPrivateKey signData:] produces and what -selfSignWithPrivateKey:error: writes. */
+static const uint8_t kSHA1WithRSAAlgorithm[] = {0x30, 0x0D, 0x06, 0x09, 0x2A, 0x86, 0x48, 0x86,
+                                                0xF7, 0x0D, 0x01, 0x01, 0x05, 0x05, 0x00};
+
+
+/* Length of a DER tag+length header for contents of the given length. */
+static inline size_t headerLength (size_t length) {
+    size_t n = 2;
+    if (length >= 0x80)
+        for (; length > 0; length >>= 8)
+            ++n;
+    return n;
+}
+
+/* Total encoded length of a value with the given contents length. */
+static inline size_t encodedLength (size_t length) {
+    return headerLength(length) + length;
+}
+
+static inline uint8_t* writeHeader (uint8_t *dst, uint8_t tag, size_t length) {
+    *dst++ = tag;
+    if (length < 0x80) {
+        *dst++ = (uint8_t)length;
+    } else {
+        unsigned n = (unsigned)headerLength(length) - 2;
+        *dst++ = 0x80 | n;
+        while (n-- > 0)
+            *dst++ = (uint8_t)(length >> (8*n));
+    }
+    return dst;
+}
+
+static inline uint8_t* writeBytes (uint8_t *dst, const void *src, size_t length) {
+    memcpy(dst, src, length);
+    return dst + length;
+}
+
+static inline uint8_t* writeData (uint8_t *dst, NSData *data) {
+    return writeBytes(dst, data.bytes, data.length);
+}
+
+
+/* Writes the contents of a DER INTEGER with the given non-negative value; returns the length. */
+static size_t encodeSerialNumber (UInt64 n, uint8_t buf[9]) {
+    uint8_t bytes[9];
+    bytes[0] = 0;
+    for (int i = 0; i < 8; i++)
+        bytes[1+i] = (uint8_t)(n >> (56 - 8*i));
+    size_t start = 0;
+    while (start < 8 && bytes[start] == 0 && !(bytes[start+1] & 0x80))
+        ++start;
+    memcpy(buf, bytes + start, 9 - start);
+    return 9 - start;
+}
+
+
+/* The string type MYDEREncoder would use: PrintableString if possible, else IA5String for other
+   ASCII, else UTF8String. */
+static uint8_t stringTag (const uint8_t *chars, size_t length) {
+    uint8_t tag = 19;
+    for (size_t i = 0; i < length; i++) {
+        uint8_t c = chars[i];
+        if (c >= 0x80)
+            return 12;
+        if (!isalnum(c) && !strchr(" '()+,-./:=?", c))
+            tag = 20;
+    }
+    return tag;
+}
+
+
+/* Appends the encodings of the given objects, without any enclosing header. */
+static NSData* encodeEach (NSArray *objects) {
+    NSMutableData *output = [NSMutableData data];
+    for (id object in objects) {
+        NSData *encoded = [MYDEREncoder encodeRootObject: object error: NULL];
+        if (!encoded)
+            return nil;
+        [output appendData: encoded];
+    }
+    return output;
+}
+
+
+
+
+@implementation MYCertificateTemplate
+
+
+- (id) initWithTBSCertificate: (NSArray*)info
+                   issuerData: (NSData*)issuerData
+                   signingKey: (MYPrivateKey*)signingKey
+{
+    Assert(signingKey);
+    self = [super init];
+    if (self) {
+        _signingKey = signingKey;
+        _version = encodeEach(@[info[0]]);
+        _signatureAlgorithm = encodeEach(@[info[2]]);
+        _issuer = [issuerData copy];
+        _keyAlgorithm = encodeEach(@[info[6][0]]);
+        _extensions = info.count > 7 ? encodeEach(@[info[7]]) : [NSData data];
+
+        // Split the subject around its common name, which will be filled in per certificate:
+        MYOID *commonNameOID = [MYOID OIDWithKnownID: kMYOIDCommonName];
+        NSArray *rdns = info[5];
+        NSUInteger cnIndex = rdns.count;
+        for (NSUInteger i = 0; i < rdns.count && cnIndex == rdns.count; i++) {
+            for (NSArray *pair in $castIf(NSSet, rdns[i])) {
+                if ([$castIf(NSArray, pair).firstObject isEqual: commonNameOID])
+                    cnIndex = i;
+            }
+        }
+        _subjectPrefix = encodeEach([rdns subarrayWithRange: NSMakeRange(0, cnIndex)]);
+        NSUInteger rest = MIN(cnIndex + 1, rdns.count);
+        _subjectSuffix = encodeEach([rdns subarrayWithRange: NSMakeRange(rest, rdns.count - rest)]);
+
+        if (!_version || !_signatureAlgorithm || !_issuer || !_keyAlgorithm || !_extensions
+                || !_subjectPrefix || !_subjectSuffix)
+            return nil;
+    }
+    return self;
+}
+
+
+- (NSData*) encodeTBSCertificateWithPublicKey: (MYPublicKey*)publicKey
+                                   commonName: (NSString*)commonName
+                                 serialNumber: (UInt64)serialNumber
+                                    validFrom: (NSDate*)validFrom
+                                      validTo: (NSDate*)validTo
+{
+    // Encode the variable fields' contents:
+    uint8_t serial[9];
+    size_t serialLength = encodeSerialNumber(serialNumber, serial);
+    char from[kMYASN1TimeMaxLength], to[kMYASN1TimeMaxLength];
+    size_t fromLength = MYASN1FormatTime(validFrom.timeIntervalSince1970,
+                                         kMYASN1GeneralizedTimeTag, from);
+    size_t toLength = MYASN1FormatTime(validTo.timeIntervalSince1970,
+                                       kMYASN1GeneralizedTimeTag, to);
+    NSData *name = [commonName dataUsingEncoding: NSUTF8StringEncoding];
+    NSData *keyData = publicKey.keyData;
+    if (fromLength == 0 || toLength == 0 || !name || !keyData)
+        return nil;
+
+    // Compute the lengths, innermost first:
+    size_t validityLength = encodedLength(fromLength) + encodedLength(toLength);
+    size_t attributeLength = sizeof(kCommonNameOIDBytes) + encodedLength(name.length);
+    size_t rdnLength = encodedLength(attributeLength);
+    size_t subjectLength = _subjectPrefix.length + encodedLength(rdnLength) + _subjectSuffix.length;
+    size_t bitStringLength = 1 + keyData.length;
+    size_t keyInfoLength = _keyAlgorithm.length + encodedLength(bitStringLength);
+    size_t tbsLength = _version.length + encodedLength(serialLength) + _signatureAlgorithm.length
+                     + _issuer.length + encodedLength(validityLength)
+                     + encodedLength(subjectLength) + encodedLength(keyInfoLength)
+                     + _extensions.length;
+
+    // Then write everything out in order:
+    NSMutableData *output = [NSMutableData dataWithLength: encodedLength(tbsLength)];
+    uint8_t *dst = output.mutableBytes;
+    dst = writeHeader(dst, 0x30, tbsLength);
+    dst = writeData(dst, _version);
+    dst = writeHeader(dst, 0x02, serialLength);
+    dst = writeBytes(dst, serial, serialLength);
+    dst = writeData(dst, _signatureAlgorithm);
+    dst = writeData(dst, _issuer);
+    dst = writeHeader(dst, 0x30, validityLength);
+    dst = writeHeader(dst, kMYASN1GeneralizedTimeTag, fromLength);
+    dst = writeBytes(dst, from, fromLength);
+    dst = writeHeader(dst, kMYASN1GeneralizedTimeTag, toLength);
+    dst = writeBytes(dst, to, toLength);
+    dst = writeHeader(dst, 0x30, subjectLength);
+    dst = writeData(dst, _subjectPrefix);
+    dst = writeHeader(dst, 0x31, rdnLength);
+    dst = writeHeader(dst, 0x30, attributeLength);
+    dst = writeBytes(dst, kCommonNameOIDBytes, sizeof(kCommonNameOIDBytes));
+    dst = writeHeader(dst, stringTag(name.bytes, name.length), name.length);
+    dst = writeData(dst, name);
+    dst = writeData(dst, _subjectSuffix);
+    dst = writeHeader(dst, 0x30, keyInfoLength);
+    dst = writeData(dst, _keyAlgorithm);
+    dst = writeHeader(dst, 0x03, bitStringLength);
+    *dst++ = 0;                                     // (no unused bits)
+    dst = writeData(dst, keyData);
+    dst = writeData(dst, _extensions);
+    Assert(dst == (uint8_t*)output.mutableBytes + output.length);
+    return output;
+}
+
+
+- (NSData*) issueCertificateWithPublicKey: (MYPublicKey*)publicKey
+                               commonName: (NSString*)commonName
+                             serialNumber: (UInt64)serialNumber
+                                validFrom: (NSDate*)validFrom
+                                  validTo: (NSDate*)validTo
+                                    error: (NSError**)outError
+{
+    NSData *tbs = [self encodeTBSCertificateWithPublicKey: publicKey
+                                               commonName: commonName
+                                             serialNumber: serialNumber
+                                                validFrom: validFrom
+                                                  validTo: validTo];
+    if (!tbs) {
+        if (outError) *outError = MYError(3, MYASN1ErrorDomain, @"Can't encode certificate");
+        return nil;
+    }
+    NSData *signature = [_signingKey signData: tbs];
+    if (!signature) {
+        if (outError) *outError = MYError(errSecInternalComponent, NSOSStatusErrorDomain,
+                                          @"Couldn't sign certificate");
+        return nil;
+    }
+
+    size_t bitStringLength = 1 + signature.length;
+    size_t certLength = tbs.length + sizeof(kSHA1WithRSAAlgorithm) + encodedLength(bitStringLength);
+    NSMutableData *output = [NSMutableData dataWithLength: encodedLength(certLength)];
+    uint8_t *dst = output.mutableBytes;
+    dst = writeHeader(dst, 0x30, certLength);
+    dst = writeData(dst, tbs);
+    dst = writeBytes(dst, kSHA1WithRSAAlgorithm, sizeof(kSHA1WithRSAAlgorithm));
+    dst = writeHeader(dst, 0x03, bitStringLength);
+    *dst++ = 0;
+    dst = writeData(dst, signature);
+    if (outError) *outError = nil;
+    return output;
+}
+
+
+- (NSArray*) issueCertificatesWithPublicKeys: (NSArray*)publicKeys
+                                 commonNames: (NSArray*)commonNames
+                           firstSerialNumber: (UInt64)firstSerialNumber
+                                   validFrom: (NSDate*)validFrom
+                                     validTo: (NSDate*)validTo
+                                       error: (NSError**)outError
+{
+    Assert(commonNames.count == publicKeys.count);
+    size_t count = publicKeys.count;
+    // The results go into a C array, since the blocks run concurrently:
+    CFTypeRef *results = calloc(count, sizeof(CFTypeRef));
+    __block NSError *firstError = nil;
+    dispatch_apply(count, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0),
+                   ^(size_t i) {
+        @autoreleasepool {
+            NSError *error;
+            NSData *cert = [self issueCertificateWithPublicKey: publicKeys[i]
+                                                    commonName: commonNames[i]
+                                                  serialNumber: firstSerialNumber + i
+                                                     validFrom: validFrom
+                                                       validTo: validTo
+                                                         error: &error];
+            if (cert) {
+                results[i] = CFBridgingRetain(cert);
+            } else {
+                @synchronized(self) {
+                    if (!firstError)
+                        firstError = error;
+                }
+            }
+        }
+    });
+
+    NSMutableArray *certs = [NSMutableArray arrayWithCapacity: count];
+    for (size_t i = 0; i < count; i++) {
+        if (results[i])
+            [certs addObject: CFBridgingRelease(results[i])];
+    }
+    free(results);
+    if (outError) *outError = firstError;
+    return firstError ? nil : certs;
+}
+
+
+@end
+
+
+
+
+#pragma mark -
+#pragma mark TEST CASES:
+
+
+#define $data(BYTES...)    ({const uint8_t bytes[] = {BYTES}; [NSData dataWithBytes: bytes length: sizeof(bytes)];})
+
+
+static MYCertificateRequest* makeRequest (MYPublicKey *publicKey, NSString *commonName) {
+    MYCertificateRequest *request = [[MYCertificateRequest alloc] initWithPublicKey: publicKey];
+    request.subject.commonName = commonName;
+    request.subject.surname = @"Case";
+    request.subject.emailAddress = @"testcase@example.com";
+    request.keyUsage = kKeyUsageDigitalSignature | kKeyUsageKeyEncipherment;
+    request.extendedKeyUsage = [NSSet setWithObject: kExtendedKeyUsageClientAuthOID];
+    request.validFrom = [NSDate dateWithTimeIntervalSinceReferenceDate: 814000000];
+    request.validTo = [NSDate dateWithTimeIntervalSinceReferenceDate: 814000000 + 3600];
+    return request;
+}
+
+
+TestCase(MYCertificateTemplate) {
+    RequireTestCase(CreateCert);
+    MYPrivateKey *privateKey = [[MYKeychain defaultKeychain] generateRSAKeyPairOfSize: 512];
+    CAssert(privateKey);
+    MYPublicKey *publicKey = privateKey.publicKey;
+
+    // A certificate from a template must be identical to one made the usual way:
+    MYCertificateRequest *request = makeRequest(publicKey, @"template");
+    MYCertificateTemplate *template = [request templateWithIssuer: nil signingKey: privateKey];
+    CAssert(template);
+    NSError *error;
+    NSData *certData = [request selfSignWithPrivateKey: privateKey error: &error];
+    CAssert(certData, @"selfSign failed: %@", error);
+    NSData *tbs = [request requestData: &error];
+    UInt64 serial = [MYBERParse(tbs, NULL)[1] unsignedLongLongValue];
+    CAssertEqual([template encodeTBSCertificateWithPublicKey: publicKey
+                                                  commonName: @"template"
+                                                serialNumber: serial
+                                                   validFrom: request.validFrom
+                                                     validTo: request.validTo], tbs);
+    CAssertEqual([template issueCertificateWithPublicKey: publicKey
+                                              commonName: @"template"
+                                            serialNumber: serial
+                                               validFrom: request.validFrom
+                                                 validTo: request.validTo
+                                                   error: &error], certData);
+
+    // Vary the fields, including a non-ASCII name and a serial number with its high bit set:
+    NSDate *validFrom = [NSDate dateWithTimeIntervalSinceReferenceDate: 814100000];
+    NSDate *validTo = [validFrom dateByAddingTimeInterval: 600];
+    certData = [template issueCertificateWithPublicKey: publicKey
+                                            commonName: @"Ünïcødé"
+                                          serialNumber: 0x8000000000000001ull
+                                             validFrom: validFrom
+                                               validTo: validTo
+                                                 error: &error];
+    CAssert(certData, @"Template issue failed: %@", error);
+    MYCertificateInfo *cert = [[MYCertificateInfo alloc] initWithCertificateData: certData
+                                                                           error: &error];
+    CAssert(cert, @"Couldn't parse issued cert: %@", error);
+    CAssertEqual(cert.subject.commonName, @"Ünïcødé");
+    CAssertEqual(cert.subject.surname, @"Case");
+    CAssertEqual(cert.subject.emailAddress, @"testcase@example.com");
+    CAssertEqual(cert.serialNumber, $data(0x00, 0x80, 0, 0, 0, 0, 0, 0, 0x01));
+    CAssertEqual(cert.validFrom, validFrom);
+    CAssertEqual(cert.validTo, validTo);
+    CAssertEqual(cert.subjectPublicKeyData, publicKey.keyData);
+    CAssertEq(cert.keyUsage, kKeyUsageDigitalSignature | kKeyUsageKeyEncipherment);
+    CAssertEqual(cert.issuer.commonName, @"template");
+    CAssert([cert verifySignatureWithKey: publicKey]);
+
+    // Issued by another certificate:
+    MYCertificateInfo *issuer = [[MYCertificateInfo alloc] initWithCertificateData:
+                                        [NSData dataWithContentsOfFile: @"testca.cer"] error: NULL];
+    template = [request templateWithIssuer: issuer signingKey: privateKey];
+    NSArray *batch = [template issueCertificatesWithPublicKeys: @[publicKey, publicKey, publicKey]
+                                                   commonNames: @[@"one", @"two", @"three"]
+                                             firstSerialNumber: 1000
+                                                     validFrom: validFrom
+                                                       validTo: validTo
+                                                         error: &error];
+    CAssertEq(batch.count, (NSUInteger)3);
+    cert = [[MYCertificateInfo alloc] initWithCertificateData: batch[2] error: &error];
+    CAssertEqual(cert.subject.commonName, @"three");
+    CAssertEqual(cert.serialNumber, $data(0x03, 0xEA));
+    CAssertEqual(cert.canonicalIssuer, issuer.canonicalSubject);
+    CAssert([cert verifySignatureWithKey: publicKey]);
+}
+
+
+TestCase(MYCertificateTemplateBenchmark) {
+    RequireTestCase(MYCertificateTemplate);
+    static const int kCount = 200;
+    MYPrivateKey *privateKey = [[MYKeychain defaultKeychain] generateRSAKeyPairOfSize: 1024];
+    MYPublicKey *publicKey = privateKey.publicKey;
+    NSMutableArray *keys = $marray(), *names = $marray();
+    for (int i = 0; i < kCount; i++) {
+        [keys addObject: publicKey];
+        [names addObject: $sprintf(@"client-%d.example.com", i)];
+    }
+
+    // The current way: build and encode a request object graph per certificate.
+    CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+    for (int i = 0; i < kCount; i++) {
+        @autoreleasepool {
+            [makeRequest(publicKey, names[i]) selfSignWithPrivateKey: privateKey error: NULL];
+        }
+    }
+    CFAbsoluteTime requestTime = CFAbsoluteTimeGetCurrent() - start;
+
+    MYCertificateRequest *request = makeRequest(publicKey, @"template");
+    MYCertificateTemplate *template = [request templateWithIssuer: nil signingKey: privateKey];
+    NSDate *validFrom = request.validFrom, *validTo = request.validTo;
+    start = CFAbsoluteTimeGetCurrent();
+    for (int i = 0; i < kCount; i++) {
+        @autoreleasepool {
+            [template issueCertificateWithPublicKey: publicKey commonName: names[i]
+                                       serialNumber: i validFrom: validFrom validTo: validTo
+                                              error: NULL];
+        }
+    }
+    CFAbsoluteTime templateTime = CFAbsoluteTimeGetCurrent() - start;
+
+    start = CFAbsoluteTimeGetCurrent();
+    NSArray *certs = [template issueCertificatesWithPublicKeys: keys commonNames: names
+                                             firstSerialNumber: 0 validFrom: validFrom
+                                                       validTo: validTo error: NULL];
+    CFAbsoluteTime batchTime = CFAbsoluteTimeGetCurrent() - start;
+    CAssertEq(certs.count, (NSUInteger)kCount);
+
+    // Encoding alone, without the RSA signature that dominates the above:
+    start = CFAbsoluteTimeGetCurrent();
+    for (int i = 0; i < kCount; i++) {
+        @autoreleasepool {
+            [makeRequest(publicKey, names[i]) requestData: NULL];
+        }
+    }
+    CFAbsoluteTime requestEncodeTime = CFAbsoluteTimeGetCurrent() - start;
+    start = CFAbsoluteTimeGetCurrent();
+    for (int i = 0; i < kCount; i++) {
+        @autoreleasepool {
+            [template encodeTBSCertificateWithPublicKey: publicKey commonName: names[i]
+                                           serialNumber: i validFrom: validFrom validTo: validTo];
+        }
+    }
+    CFAbsoluteTime templateEncodeTime = CFAbsoluteTimeGetCurrent() - start;
+
+    Log(@"Issuing %d certs: request %.0f/sec, template %.0f/sec (%.1fx), batch %.0f/sec (%.1fx)",
+        kCount, kCount/requestTime, kCount/templateTime, requestTime/templateTime,
+        kCount/batchTime, requestTime/batchTime);
+    Log(@"Encoding TBSCertificate: request %.2fus, template %.2fus (%.1fx)",
+        requestEncodeTime/kCount*1e6, templateEncodeTime/kCount*1e6,
+        requestEncodeTime/templateEncodeTime);
+}
+
+
+
+/*
+ Copyright (c) 2009, Jens Alfke <jens@mooseyard.com>. All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification, are permitted
+ provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice, this list of conditions
+ and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions
+ and the following disclaimer in the documentation and/or other materials provided with the
+ distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRI-
+ BUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
@@ -9,6 +9,9 @@
 #import "MYCertificateInfo.h"
 #import "MYCrypto.h"
 #import "MYCrypto_Private.h"
+#import "MYX509Decoder.h"
+#import "MYSignatureCache.h"
+#import "MYCanonicalName.h"
 
 
 #if DEBUG
@@ -39,6 +42,24 @@ static MYCertificateInfo* testCertData(NSData *certData, BOOL selfSigned) {
         CAssert(value != nil);
         Log(@"Extension %@%@ = %@", oid, (isCritical ?@" (critical)" :@""), value);
     }
+
+    // Field accessors are created once, and point into the certificate data instead of copying:
+    const MYX509Fields *fields = pcert.x509Fields;
+    CAssert(fields != NULL);
+    CAssert(pcert.subject == pcert.subject);
+    CAssert(pcert.issuer == pcert.issuer);
+    CAssert(pcert.signedData == pcert.signedData);
+    CAssert(pcert.signedData.bytes == MYBERSliceGetEncoding(&fields->tbsCertificate));
+    CAssert(pcert.subjectData.bytes == MYBERSliceGetEncoding(&fields->subject));
+    CAssert(pcert.issuerData.bytes == MYBERSliceGetEncoding(&fields->issuer));
+    CAssert(pcert.subjectPublicKeyInfoData.bytes == MYBERSliceGetEncoding(&fields->subjectPublicKeyInfo));
+    if ([pcert.subjectData isEqual: pcert.issuerData])
+        CAssert(pcert.isRoot);      // (but a root's names may also differ in encoding)
+    CAssert(pcert.canonicalSubject == pcert.canonicalSubject);
+    CAssertEq(pcert.isRoot, [pcert.canonicalSubject isEqual: pcert.canonicalIssuer]);
+    CAssertEq(pcert.isRoot, [pcert.subject isEqual: pcert.issuer]);
+    CAssertEq(pcert.subject.hash, (NSUInteger)pcert.canonicalSubject.hash64);
+
     Log(@"Key Usage = 0x%x", pcert.keyUsage);
     Log(@"Extended Key Usage = %@", pcert.extendedKeyUsage);
     Log(@"Subject Alt Name = %@", pcert.subjectAlternativeName);
@@ -105,9 +126,29 @@ TestCase(ParsedCert) {
     CAssert(![pcert allowsExtendedKeyUsage:[NSSet setWithObject: kExtendedKeyUsageServerAuthOID]]);
     CAssert(![pcert allowsExtendedKeyUsage:([NSSet setWithObjects: kExtendedKeyUsageEmailProtectionOID,kExtendedKeyUsageServerAuthOID, nil])]);
 
-    testCert(@"selfsigned", YES);
+    MYCertificateInfo *selfSigned = testCert(@"selfsigned", YES);
     testCert(@"iphonedev", NO);
     
+    // Names match by their canonical forms, regardless of encoding. This cert's issuer is the
+    // same name as its subject, but in UTF8Strings with different case and spacing:
+    MYCertificateInfo *canonical = testCert(@"selfsigned_canonical", YES);
+    CAssert(![canonical.issuerData isEqual: canonical.subjectData]);
+    CAssertEqual(canonical.canonicalIssuer, canonical.canonicalSubject);
+    CAssertEqual(canonical.issuer, canonical.subject);
+    CAssertEq(canonical.issuer.hash, canonical.subject.hash);
+    CAssert([canonical verifySignatureWithKey: canonical.subjectPublicKey]);
+    CAssert(![canonical.subject isEqual: selfSigned.subject]);
+
+    // Verifying the same signature again is answered by the cache:
+    MYSignatureCache *sigCache = [MYSignatureCache sharedCache];
+    CAssert([selfSigned verifySignatureWithKey: selfSigned.subjectPublicKey]);
+    uint64_t hits = sigCache.hits;
+    CAssert([selfSigned verifySignatureWithKey: selfSigned.subjectPublicKey]);
+    CAssertEq(sigCache.hits, hits + 1);
+    [sigCache removeEntriesForIssuerKeyDigest: selfSigned.subjectPublicKey.publicKeyDigest];
+    CAssert([selfSigned verifySignatureWithKey: selfSigned.subjectPublicKey]);
+    CAssertEq(sigCache.hits, hits + 1);
+
     // Now test a self-signed cert with a bad signature:
     MYCertificate *cert = [[MYCertificate alloc] initWithCertificateData: readTestFile(@"selfsigned_altered")];
     Log(@"MYCertificate = %@", cert);
@@ -115,6 +156,27 @@ TestCase(ParsedCert) {
 }
 
 
+TestCase(SHA2Certs) {
+    RequireTestCase(ParsedCert);
+    NSDictionary *certs = @{@"selfsigned_sha384": @(kMYOIDRSAWithSHA384),
+                            @"selfsigned_sha512": @(kMYOIDRSAWithSHA512)};
+    for (NSString *name in certs) {
+        NSData *certData = readTestFile(name);
+        MYCertificateInfo *pcert = testCertData(certData, YES);
+        CAssertEq(pcert.signatureAlgorithmID.knownID, (MYOIDKnownID)[certs[name] intValue]);
+        CAssert([pcert verifySignatureWithKey: pcert.subjectPublicKey]);
+
+        // Damage the signature, which is at the end of the certificate:
+        NSMutableData *altered = [certData mutableCopy];
+        ((uint8_t*)altered.mutableBytes)[altered.length - 1] ^= 0x01;
+        MYCertificateInfo *alteredCert = [[MYCertificateInfo alloc] initWithCertificateData: altered
+                                                                                      error: NULL];
+        CAssert(alteredCert != nil);
+        CAssert(![alteredCert verifySignatureWithKey: alteredCert.subjectPublicKey]);
+    }
+}
+
+
 #import "MYCrypto_Private.h"
 
 TestCase(CreateCert) {
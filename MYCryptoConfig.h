@@ -21,4 +21,18 @@
 #define MYCRYPTO_USE_IPHONE_API 0
 #endif
 
-#endif
\ No newline at end of file
+#endif
+
+/*  Whether MYDigest computes SHA-1 and SHA-256 with MYCrypto's own implementation (MYSHA.h)
+    instead of CommonCrypto. CommonCrypto is already hardware-accelerated on Apple platforms, so
+    by default this is only enabled on others. */
+
+#ifndef MYCRYPTO_USE_PORTABLE_SHA
+
+#ifdef __APPLE__
+#define MYCRYPTO_USE_PORTABLE_SHA 0
+#else
+#define MYCRYPTO_USE_PORTABLE_SHA 1
+#endif
+
+#endif
@@ -14,6 +14,7 @@
 #import "MYPrivateKey.h"
 #import "MYCertificate.h"
 #import "MYCertificateInfo.h"
+#import "MYCertificateTemplate.h"
 #import "MYIdentity.h"
 
 #import "Test.h"
@@ -125,11 +126,36 @@ typedef OSType MYKeychainAttrType;
 
 
 @interface MYCertificateInfo (Private)
+/* The contents of the subjectPublicKey BIT STRING, whatever the key algorithm. */
+- (NSData*) subjectPublicKeyBits;
+/* The same, but nil unless it's an RSA key. */
 - (NSData*) subjectPublicKeyData;
 - (MYPublicKey*) subjectPublicKey;
 - (NSData*) signedData;
 - (MYOID*) signatureAlgorithmID;
 - (NSData*) signature;
+/* These return the DER encodings of the fields. Like the above data accessors, they point into the
+   certificate data instead of copying it, and are created once and cached. */
+- (NSData*) subjectData;
+- (NSData*) issuerData;
+- (NSData*) subjectPublicKeyInfoData;
+/* The decoded field locations, or NULL if this isn't a parsed certificate (i.e. it's a request.) */
+- (const struct MYX509Fields*) x509Fields;
+@end
+
+/* Verifies the signature of the signed part of a certificate, CRL or similar structure, made
+   with the signature algorithm with the given OID. Successful verifications are remembered in
+   MYSignatureCache's shared cache. (Implemented in MYCertificateInfo.m.) */
+BOOL MYVerifySignedData (NSData *signedData, NSData *signature, MYOID *algorithm,
+                         MYPublicKey *issuerPublicKey);
+
+
+@interface MYCertificateTemplate (Private)
+/* Called by -[MYCertificateRequest templateWithIssuer:signingKey:]. `info` is the request's
+   TBSCertificate object tree, and issuerData the DER encoding of the issuer's Name. */
+- (id) initWithTBSCertificate: (NSArray*)info
+                   issuerData: (NSData*)issuerData
+                   signingKey: (MYPrivateKey*)signingKey;
 @end
 
 
@@ -146,6 +172,12 @@ typedef OSType MYKeychainAttrType;
 #undef check
 BOOL check(OSStatus err, NSString *what);
 
+#if !TARGET_OS_IPHONE
+/** The PEM label to wrap an export in this format with, or nil if Security's own PEM armour
+    has to be used instead (for formats like kSecFormatWrappedOpenSSL that need PEM headers.) */
+NSString* MYPEMLabelForExternalFormat(SecExternalFormat format);
+#endif
+
 #define checksave(CALL) ({OSStatus err=(CALL); check(err,@""#CALL) || (_error=err, NO);})
 
 #if !MYCRYPTO_USE_IPHONE_API
@@ -7,8 +7,12 @@
 //
 
 #import <Foundation/Foundation.h>
+struct iovec;
 
 
+/** Encodes an object tree (of the kinds MYBERParse produces) as DER.
+    Encoding takes two passes over the tree: the first computes the length of every constructed
+    value, and the second writes each byte exactly once into a single buffer of the exact size. */
 @interface MYDEREncoder : NSObject
 {
     @private
@@ -16,12 +20,46 @@
     NSMutableData *_output;
     NSError *_error;
     BOOL _forcePrintableStrings;
+    BOOL _measuring, _measured;
+    size_t _length, _encodedLength;
+    uint8_t *_dst;
+    size_t *_lengths;
+    unsigned _lengthCount, _lengthCapacity, _nextLength;
+    size_t _minReferencedLength, _referencedBytes;
+    unsigned _referencedCount;
+    NSMutableData *_scratch;
+    struct iovec *_iov;
+    unsigned _iovCount;
+    uint8_t *_segmentStart;
 }
 
 - (id) initWithRootObject: (id)object;
 + (NSData*) encodeRootObject: (id)rootObject error: (NSError**)outError;
 
+/** The encoded data, in a newly allocated NSData. */
 @property (weak, readonly) NSData* output;
 @property (readonly, strong) NSError *error;
 
+/** The exact number of bytes the encoding will occupy, or 0 if the object can't be encoded.
+    Computing this doesn't encode anything, and the work isn't repeated by a subsequent call to
+    -encodeIntoBuffer:length: or -getIOVecs:. */
+@property (readonly) size_t encodedLength;
+
+/** Encodes directly into a caller-provided buffer.
+    @return  The number of bytes written, or 0 if the buffer is too small (in which case the
+            error property isn't set; compare bufferLength against encodedLength) or on error. */
+- (size_t) encodeIntoBuffer: (void*)buffer length: (size_t)bufferLength;
+
+/** Encodes as a scatter/gather list suitable for writev() or sendmsg().
+    Headers and small values are written into a buffer owned by the encoder, but NSData values
+    (and MYASN1Object values and bit-strings) at least minReferencedLength bytes long are not
+    copied; their iovecs point directly to their bytes.
+    @param outCount  On return, the number of iovecs.
+    @return  An array of iovecs, owned by the encoder and valid as long as it is; or NULL on error. */
+- (const struct iovec*) getIOVecs: (unsigned*)outCount;
+
+/** Values at least this long are referenced by -getIOVecs: rather than copied. Defaults to 1024.
+    Must be set before encoding. */
+@property (nonatomic) size_t minReferencedLength;
+
 @end
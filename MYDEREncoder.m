@@ -11,10 +11,12 @@
 
 #import "MYDEREncoder.h"
 #import "MYASN1Object.h"
+#import "MYASN1Time.h"
 #import "MYBERParser.h"
 #import "MYOID.h"
 #import "MYErrorUtils.h"
 #import "Test.h"
+#import <sys/uio.h>
 
 
 #define MYDEREncoderException @"MYDEREncoderException"
@@ -40,6 +42,7 @@
     self = [super init];
     if (self != nil) {
         _rootObject = rootObject;
+        _minReferencedLength = 1024;
     }
     return self;
 }
@@ -52,41 +55,52 @@
 }
 
 
-static unsigned sizeOfUnsignedInt (UInt64 n) {
-    unsigned bytes = 0;
-    for (; n; n >>= 8)
-        bytes++;
-    return bytes;
+/* Number of significant bits in n (at least 1, so that zero still takes a byte.) */
+static inline unsigned bitsInUnsignedInt (UInt64 n) {
+    return n ? 64 - __builtin_clzll(n) : 1;
 }
 
-static unsigned encodeUnsignedInt (UInt64 n, UInt8 buf[], BOOL padHighBit) {
-    unsigned size = MAX(1U, sizeOfUnsignedInt(n));
+/* Writes the big-endian representation of the low `size` bytes of n, with no loops. */
+static inline void writeBigEndian (UInt64 n, unsigned size, UInt8 buf[]) {
     UInt64 bigEndian = NSSwapHostLongLongToBig(n);
-    const UInt8* src = (UInt8*)&bigEndian + (8-size);
-    UInt8 *dst = &buf[0];
-    if (padHighBit && (*src & 0x80)) {
-        *dst++ = 0;
-        size++;
+    memcpy(buf, (const UInt8*)&bigEndian + (8-size), size);
+}
+
+static unsigned encodeUnsignedInt (UInt64 n, UInt8 buf[], BOOL padHighBit) {
+    unsigned bits = bitsInUnsignedInt(n);
+    unsigned size = (bits + 7) / 8;
+    if (padHighBit && bits % 8 == 0) {
+        // High bit is set, so prefix a 00 byte to keep it from being read as a sign bit:
+        buf[0] = 0;
+        writeBigEndian(n, size, buf+1);
+        return size + 1;
     }
-    memcpy(dst, src, size);
+    writeBigEndian(n, size, buf);
     return size;
 }
 
 static unsigned encodeSignedInt (SInt64 n, UInt8 buf[]) {
-    if (n >= 0)
-        return encodeUnsignedInt(n, buf, YES);
-    else {
-        unsigned size = MAX(1U, sizeOfUnsignedInt(~n));
-        UInt64 bigEndian = NSSwapHostLongLongToBig(n);
-        const UInt8* src = (UInt8*)&bigEndian + (8-size);
-        UInt8 *dst = &buf[0];
-        if (!(*src & 0x80)) {
-            *dst++ = 0xFF;
-            size++;
-        }
-        memcpy(dst, src, size);
-        return size;
+    // A negative number needs as many bits as its complement, plus the sign bit:
+    UInt64 magnitude = (n < 0) ? ~(UInt64)n : (UInt64)n;
+    unsigned size = (magnitude ? bitsInUnsignedInt(magnitude) : 0) / 8 + 1;
+    writeBigEndian((UInt64)n, size, buf);
+    return size;
+}
+
+
+- (void) dealloc {
+    free(_lengths);
+    free(_iov);
+}
+
+
+/* All output goes through here. While measuring, this just counts the bytes. */
+- (void) _writeBytes: (const void*)bytes length: (size_t)length {
+    if (_dst) {
+        memcpy(_dst, bytes, length);
+        _dst += length;
     }
+    _length += length;
 }
 
 
@@ -95,28 +109,32 @@ static unsigned encodeSignedInt (SInt64 n, UInt8 buf[]) {
        constructed: (BOOL) constructed
             length: (size_t)length 
 {
-    struct {
-        unsigned tag            :5;
-        unsigned isConstructed  :1;
-        unsigned tagClass       :2;
-        unsigned length         :7;
-        unsigned isLengthLong   :1;
-        UInt8    extraLength[9];
-    } header;
-    size_t headerSize = 2;
-    
-    header.tag = tag;
-    header.isConstructed = constructed;
-    header.tagClass = tagClass;
+    UInt8 header[16];
+    size_t headerSize = 0;
+    UInt8 firstByte = (UInt8)((tagClass << 6) | (constructed ? 0x20 : 0));
+    if (tag < 0x1F) {
+        header[headerSize++] = firstByte | tag;
+    } else {
+        // High tag number: write it in base-128, most significant digit first
+        header[headerSize++] = firstByte | 0x1F;
+        UInt8 digits[5];
+        int n = 0;
+        do {
+            digits[n++] = tag & 0x7F;
+            tag >>= 7;
+        } while (tag);
+        while (n > 1)
+            header[headerSize++] = digits[--n] | 0x80;
+        header[headerSize++] = digits[0];
+    }
     if (length < 128) {
-        header.isLengthLong = NO;
-        header.length = (unsigned)length;
+        header[headerSize++] = (UInt8)length;
     } else {
-        header.isLengthLong = YES;
-        header.length = encodeUnsignedInt(length, header.extraLength, NO);
-        headerSize += header.length;
+        unsigned size = encodeUnsignedInt(length, &header[headerSize+1], NO);
+        header[headerSize] = (UInt8)(0x80 | size);
+        headerSize += 1 + size;
     }
-    [_output appendBytes: &header length: headerSize];
+    [self _writeBytes: header length: headerSize];
 }
 
 - (void) _writeTag: (unsigned)tag
@@ -126,7 +144,7 @@ static unsigned encodeSignedInt (SInt64 n, UInt8 buf[]) {
             length: (size_t)length 
 {
     [self _writeTag: tag class: tagClass constructed: constructed length: length];
-    [_output appendBytes: bytes length: length];
+    [self _writeBytes: bytes length: length];
 }
 
 - (void) _writeTag: (unsigned)tag
@@ -138,6 +156,42 @@ static unsigned encodeSignedInt (SInt64 n, UInt8 buf[]) {
     [self _writeTag: tag class: tagClass constructed: constructed bytes: data.bytes length: data.length];
 }
 
+/* Writes a value that's part of the object tree being encoded. Unlike the methods above, this
+   can add a reference to the data instead of copying it, when producing iovecs. */
+- (void) _writeTag: (unsigned)tag
+             class: (unsigned)tagClass
+       constructed: (BOOL) constructed
+           payload: (NSData*)data
+{
+    Assert(data);
+    size_t length = data.length;
+    [self _writeTag: tag class: tagClass constructed: constructed length: length];
+    [self _writePayloadBytes: data.bytes length: length];
+}
+
+- (void) _writePayloadBytes: (const void*)bytes length: (size_t)length {
+    if (length < _minReferencedLength || !(_measuring || _segmentStart)) {
+        [self _writeBytes: bytes length: length];
+        return;
+    }
+    if (_measuring) {
+        _referencedCount++;
+        _referencedBytes += length;
+    } else {
+        [self _endSegment];
+        _iov[_iovCount++] = (struct iovec){(void*)bytes, length};
+    }
+    _length += length;
+}
+
+/* Adds an iovec for the bytes written to the scratch buffer since the last one. */
+- (void) _endSegment {
+    if (_dst > _segmentStart) {
+        _iov[_iovCount++] = (struct iovec){_segmentStart, _dst - _segmentStart};
+        _segmentStart = _dst;
+    }
+}
+
 
 - (void) _encodeNumber: (NSNumber*)number {
     // Special-case detection of booleans by pointer equality, because otherwise they appear
@@ -192,49 +246,93 @@ static unsigned encodeSignedInt (SInt64 n, UInt8 buf[]) {
         [kNotPrintableCharSet formUnionWithCharacterSet: [NSCharacterSet alphanumericCharacterSet]];
         [kNotPrintableCharSet invert];
     }
-    NSData *data = [string dataUsingEncoding: NSASCIIStringEncoding];
-    if (data) {
-        unsigned tag = 19; // printablestring (a silly arbitrary subset of ASCII defined by ASN.1)
+    unsigned tag;
+    NSStringEncoding encoding;
+    if ([string canBeConvertedToEncoding: NSASCIIStringEncoding]) {
+        encoding = NSASCIIStringEncoding;
+        tag = 19; // printablestring (a silly arbitrary subset of ASCII defined by ASN.1)
         if (!_forcePrintableStrings && [string rangeOfCharacterFromSet: kNotPrintableCharSet].length > 0)
             tag = 20; // IA5string (full 7-bit ASCII)
-        [self _writeTag: tag class: 0 constructed: NO data: data];
     } else {
         // fall back to UTF-8:
-        [self _writeTag: 12 class: 0 constructed: NO data: [string dataUsingEncoding: NSUTF8StringEncoding]];
+        encoding = NSUTF8StringEncoding;
+        tag = 12;
+    }
+    size_t length = [string lengthOfBytesUsingEncoding: encoding];
+    [self _writeTag: tag class: 0 constructed: NO length: length];
+    if (_dst) {
+        // Convert the string directly into the output buffer:
+        NSUInteger used = 0;
+        [string getBytes: _dst maxLength: length usedLength: &used encoding: encoding
+                 options: 0 range: NSMakeRange(0, string.length) remainingRange: NULL];
+        Assert(used == length);
+        _dst += length;
+    }
+    _length += length;
+}
+
+
+- (void) _encodeBigInteger: (MYASN1BigInteger*)integer {
+    size_t length;
+    const uint8_t *bytes = [integer signedBytes: &length];
+    if (length <= kMYASN1BigIntegerInlineSize) {
+        // Small integers are stored inside the object; copy them without creating an NSData:
+        [self _writeTag: 2 class: 0 constructed: NO bytes: bytes length: length];
+    } else {
+        [self _writeTag: 2 class: 0 constructed: NO payload: integer.signedData];
     }
 }
 
 
 - (void) _encodeBitString: (MYBitString*)bitString {
     NSUInteger bitCount = bitString.bitCount;
-    [self _writeTag: 3 class: 0 constructed: NO length: 1 + (bitCount/8)];
+    NSUInteger byteCount = (bitCount + 7) / 8;
+    [self _writeTag: 3 class: 0 constructed: NO length: 1 + byteCount];
     UInt8 unused = (8 - (bitCount % 8)) % 8;
-    [_output appendBytes: &unused length: 1];
-    [_output appendBytes: bitString.bits.bytes length: bitCount/8];
+    [self _writeBytes: &unused length: 1];
+    [self _writePayloadBytes: bitString.bits.bytes length: byteCount];
 }
 
 - (void) _encodeDate: (NSDate*)date {
-    NSString *dateStr = [MYBERGeneralizedTimeFormatter() stringFromDate: date];
-    [self _writeTag: 24 class: 0 constructed: NO data: [dateStr dataUsingEncoding: NSASCIIStringEncoding]];
+    char dateStr[kMYASN1TimeMaxLength];
+    size_t length = MYASN1FormatTime(date.timeIntervalSince1970, kMYASN1GeneralizedTimeTag, dateStr);
+    if (length == 0)
+        [NSException raise: MYDEREncoderException format: @"Can't DER-encode date %@", date];
+    [self _writeTag: kMYASN1GeneralizedTimeTag class: 0 constructed: NO bytes: dateStr length: length];
 }
 
 
 - (void) _encodeCollection: (id)collection tag: (unsigned)tag class: (unsigned)tagClass {
-    MYDEREncoder *subEncoder = [[[self class] alloc] init];
-    subEncoder->_forcePrintableStrings = _forcePrintableStrings;
-    for (id object in collection)
-        [subEncoder _encode: object];
-    [self _writeTag: tag class: tagClass constructed: YES data: subEncoder.output];
+    if (_measuring) {
+        // Reserve a slot for the contents' length, which isn't known till the items are measured.
+        // Slots are assigned in the same (pre-)order the writing pass will visit collections in.
+        if (_lengthCount >= _lengthCapacity) {
+            _lengthCapacity = MAX(16u, 2*_lengthCapacity);
+            _lengths = realloc(_lengths, _lengthCapacity * sizeof(size_t));
+            if (!_lengths)
+                [NSException raise: NSMallocException format: @"Out of memory"];
+        }
+        unsigned slot = _lengthCount++;
+        size_t start = _length;
+        for (id object in collection)
+            [self _encode: object];
+        _lengths[slot] = _length - start;
+        [self _writeTag: tag class: tagClass constructed: YES length: _lengths[slot]];
+
+    } else {
+        Assert(_nextLength < _lengthCount);
+        [self _writeTag: tag class: tagClass constructed: YES length: _lengths[_nextLength++]];
+        for (id object in collection)
+            [self _encode: object];
+    }
 }
 
 
 - (void) _encode: (id)object {
-    if (!_output)
-        _output = [[NSMutableData alloc] initWithCapacity: 1024];
     if ([object isKindOfClass: [NSNumber class]]) {
         [self _encodeNumber: object];
     } else if ([object isKindOfClass: [NSData class]]) {
-        [self _writeTag: 4 class: 0 constructed: NO data: object];
+        [self _writeTag: 4 class: 0 constructed: NO payload: object];
     } else if ([object isKindOfClass: [MYBitString class]]) {
         [self _encodeBitString: object];
     } else if ([object isKindOfClass: [NSString class]]) {
@@ -249,6 +347,8 @@ static unsigned encodeSignedInt (SInt64 n, UInt8 buf[]) {
         [self _encodeCollection: object tag: 17 class: 0];
     } else if ([object isKindOfClass: [MYOID class]]) {
         [self _writeTag: 6 class: 0 constructed: NO data: [object DEREncoding]];
+    } else if ([object isKindOfClass: [MYASN1BigInteger class]]) {
+        [self _encodeBigInteger: object];
     } else if ([object isKindOfClass: [MYASN1Object class]]) {
         MYASN1Object *asn = object;
         if (asn.components)
@@ -257,24 +357,72 @@ static unsigned encodeSignedInt (SInt64 n, UInt8 buf[]) {
             [self _writeTag: asn.tag 
                       class: asn.tagClass
                 constructed: asn.constructed
-                       data: asn.value];
+                    payload: asn.value];
     } else {
         [NSException raise: MYDEREncoderException format: @"Can't DER-encode a %@", [object class]];
     }
 }
 
 
+/* First pass: computes the length of everything, without writing anything.
+   The results are kept, so this only happens once. */
+- (void) _measure {
+    if (_measured)
+        return;
+    _measuring = YES;
+    _length = 0;
+    _lengthCount = 0;
+    _referencedCount = 0;
+    _referencedBytes = 0;
+    @try {
+        [self _encode: _rootObject];
+    } @finally {
+        _measuring = NO;
+    }
+    _encodedLength = _length;
+    _measured = YES;
+}
+
+/* Second pass: writes into a buffer, which must have room for _encodedLength bytes.
+   If `gather` is true, large values are referenced in _iov instead of being copied, so the
+   buffer only needs room for the rest. */
+- (void) _writeTo: (uint8_t*)dst gather: (BOOL)gather {
+    Assert(_measured);
+    _dst = dst;
+    _segmentStart = gather ? dst : NULL;
+    _length = 0;
+    _nextLength = 0;
+    @try {
+        [self _encode: _rootObject];
+        if (gather)
+            [self _endSegment];
+    } @finally {
+        _dst = _segmentStart = NULL;
+    }
+    AssertEq(_length, _encodedLength);
+    AssertEq(_nextLength, _lengthCount);
+}
+
+/* Converts an encoder exception into an NSError; re-raises any other exception. */
+- (void) _handleException: (NSException*)x {
+    if ($equal(x.name, MYDEREncoderException))
+        self.error = MYError(2,MYASN1ErrorDomain, @"%@", x.reason);
+    else
+        @throw(x);
+}
+
+
 - (NSData*) output {
     if (!_output && !_error) {
         if (_rootObject) {
             @try{
-                [self _encode: _rootObject];
+                [self _measure];
+                NSMutableData *output = [[NSMutableData alloc] initWithLength: _encodedLength];
+                [self _writeTo: output.mutableBytes gather: NO];
+                _output = output;
             }@catch (NSException *x) {
-                if ($equal(x.name, MYDEREncoderException)) {
-                    self.error = MYError(2,MYASN1ErrorDomain, @"%@", x.reason);
-                    return nil;
-                } else
-                    @throw(x);
+                [self _handleException: x];
+                return nil;
             }
         } else {
             _output = [[NSMutableData alloc] init];
@@ -283,7 +431,57 @@ static unsigned encodeSignedInt (SInt64 n, UInt8 buf[]) {
     return _output;
 }
 
-@synthesize error=_error, _forcePrintableStrings;
+
+- (size_t) encodedLength {
+    if (!_measured) {
+        if (_error)
+            return 0;
+        @try{
+            [self _measure];
+        }@catch (NSException *x) {
+            [self _handleException: x];
+            return 0;
+        }
+    }
+    return _encodedLength;
+}
+
+
+- (size_t) encodeIntoBuffer: (void*)buffer length: (size_t)bufferLength {
+    size_t length = self.encodedLength;
+    if (length == 0)
+        return 0;
+    if (length > bufferLength)
+        return 0;       // Not an encoding error; the caller can check encodedLength and retry
+    [self _writeTo: buffer gather: NO];
+    return length;
+}
+
+
+- (const struct iovec*) getIOVecs: (unsigned*)outCount {
+    if (!_iov) {
+        if (self.encodedLength == 0)
+            return NULL;
+        // Referenced values split the scratch buffer, so there can be up to 2n+1 segments:
+        _iov = malloc((2*_referencedCount + 1) * sizeof(struct iovec));
+        if (!_iov)
+            return NULL;
+        _iovCount = 0;
+        _scratch = [[NSMutableData alloc] initWithLength: _encodedLength - _referencedBytes];
+        [self _writeTo: _scratch.mutableBytes gather: YES];
+    }
+    *outCount = _iovCount;
+    return _iov;
+}
+
+
+- (void) setMinReferencedLength: (size_t)minReferencedLength {
+    Assert(!_measured, @"Too late to change minReferencedLength");
+    _minReferencedLength = minReferencedLength;
+}
+
+
+@synthesize error=_error, _forcePrintableStrings, minReferencedLength=_minReferencedLength;
 
 
 @end
@@ -327,6 +525,18 @@ TestCase(DEREncoder) {
                  $data(0x02, 0x04, 0xF8, 0xA4, 0x32, 0xEB));
     CAssertEqual([MYDEREncoder encodeRootObject: @(-123456789) error: nil],
                  $data(0x02, 0x04, 0xF8, 0xA4, 0x32, 0xEB));
+    CAssertEqual([MYDEREncoder encodeRootObject: @(2147483648LL) error: nil],
+                 $data(0x02, 0x05, 0x00, 0x80, 0x00, 0x00, 0x00));
+    CAssertEqual([MYDEREncoder encodeRootObject: @(INT64_MAX) error: nil],
+                 $data(0x02, 0x08, 0x7F, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF));
+    CAssertEqual([MYDEREncoder encodeRootObject: @(INT64_MIN) error: nil],
+                 $data(0x02, 0x08, 0x80, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00));
+    CAssertEqual([MYDEREncoder encodeRootObject: @(UINT64_MAX) error: nil],
+                 $data(0x02, 0x09, 0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF));
+    MYASN1BigInteger *big = [[MYASN1BigInteger alloc] initWithUnsignedData:
+                                                $data(0x80, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01)];
+    CAssertEqual([MYDEREncoder encodeRootObject: big error: nil],
+                 $data(0x02, 0x0A, 0x00, 0x80, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01));
 
     // Strings:
     CAssertEqual([MYDEREncoder encodeRootObject: @"hello" error: nil],
@@ -370,6 +580,108 @@ TestCase(EncodeCert) {
 }
 
 
+TestCase(DEREncoderBuffers) {
+    RequireTestCase(EncodeCert);
+    NSData *cert = [NSData dataWithContentsOfFile: @"selfsigned.cer"];
+    id certObjects = MYBERParse(cert, NULL);
+
+    // Encoding into a caller-provided buffer:
+    MYDEREncoder *encoder = [[MYDEREncoder alloc] initWithRootObject: certObjects];
+    encoder._forcePrintableStrings = YES;
+    CAssertEq(encoder.encodedLength, cert.length);
+    NSMutableData *buffer = [NSMutableData dataWithLength: cert.length];
+    CAssertEq([encoder encodeIntoBuffer: buffer.mutableBytes length: cert.length - 1], (size_t)0);
+    CAssertNil(encoder.error);
+    CAssertEq([encoder encodeIntoBuffer: buffer.mutableBytes length: buffer.length], cert.length);
+    CAssertEqual(buffer, cert);
+    // A too-small buffer doesn't spoil the encoder for other calls:
+    encoder = [[MYDEREncoder alloc] initWithRootObject: certObjects];
+    encoder._forcePrintableStrings = YES;
+    CAssertEq([encoder encodeIntoBuffer: buffer.mutableBytes length: 10], (size_t)0);
+    CAssertEqual(encoder.output, cert);
+    CAssertNil(encoder.error);
+
+    // Encoding into iovecs:
+    NSMutableData *payload = [NSMutableData dataWithLength: 5000];
+    memset(payload.mutableBytes, 'x', payload.length);
+    NSArray *root = @[@(72), payload, @"end"];
+    encoder = [[MYDEREncoder alloc] initWithRootObject: root];
+    unsigned count;
+    const struct iovec *iov = [encoder getIOVecs: &count];
+    CAssert(iov);
+    CAssertEq(count, 3u);
+    CAssert(iov[1].iov_base == payload.bytes);
+    CAssertEq(iov[1].iov_len, payload.length);
+    NSMutableData *gathered = [NSMutableData data];
+    for (unsigned i=0; i<count; i++)
+        [gathered appendBytes: iov[i].iov_base length: iov[i].iov_len];
+    CAssertEqual(gathered, [MYDEREncoder encodeRootObject: root error: NULL]);
+}
+
+
+/* The old way of encoding, kept here for comparison by the benchmark: every constructed value
+   gets its own encoder, whose output is then copied into its parent's. The constructed children
+   of a collection are encoded first, and handed to the collection's encoder as MYASN1Objects
+   whose value is their encoded contents. */
+static id encodeWithSubEncoders (id object) {
+    NSArray *components;
+    uint32_t tag;
+    uint8_t tagClass = 0;
+    if ([object isKindOfClass: [NSArray class]]) {
+        components = object;
+        tag = 16;
+    } else if ([object isKindOfClass: [NSSet class]]) {
+        components = [object allObjects];
+        tag = 17;
+    } else if ([object isKindOfClass: [MYASN1Object class]] && [object components]) {
+        components = [object components];
+        tag = [object tag];
+        tagClass = [object tagClass];
+    } else {
+        return object;
+    }
+    NSMutableArray *children = [NSMutableArray arrayWithCapacity: components.count];
+    for (id child in components)
+        [children addObject: encodeWithSubEncoders(child)];
+    MYDEREncoder *subEncoder = [[MYDEREncoder alloc] initWithRootObject: children];
+    subEncoder._forcePrintableStrings = YES;
+    NSData *sequence = subEncoder.output;
+    // Strip the SEQUENCE header, leaving the contents:
+    const uint8_t *bytes = sequence.bytes;
+    size_t headerLength = 2 + ((bytes[1] & 0x80) ? (bytes[1] & 0x7F) : 0);
+    NSData *contents = [sequence subdataWithRange: NSMakeRange(headerLength,
+                                                               sequence.length - headerLength)];
+    return [[MYASN1Object alloc] initWithTag: tag ofClass: tagClass constructed: YES value: contents];
+}
+
+
+TestCase(DEREncoderBenchmark) {
+    RequireTestCase(EncodeCert);
+    static const int kIterations = 2000;
+    NSData *cert = [NSData dataWithContentsOfFile: @"selfsigned.cer"];
+    id certObjects = MYBERParse(cert, NULL);
+    CAssert(certObjects);
+
+    CFAbsoluteTime times[2];
+    for (int useSubEncoders = 1; useSubEncoders >= 0; useSubEncoders--) {
+        CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+        for (int i=0; i<kIterations; i++) {
+            @autoreleasepool {
+                id root = useSubEncoders ? encodeWithSubEncoders(certObjects) : certObjects;
+                MYDEREncoder *encoder = [[MYDEREncoder alloc] initWithRootObject: root];
+                encoder._forcePrintableStrings = YES;
+                NSData *encoded = encoder.output;
+                if (i == 0)
+                    CAssertEqual(encoded, cert);
+            }
+        }
+        times[useSubEncoders] = CFAbsoluteTimeGetCurrent() - start;
+    }
+    Log(@"Encoding selfsigned.cer (%u bytes): sub-encoders %.2fus, single buffer %.2fus (%.1fx faster)",
+        (unsigned)cert.length, times[1]/kIterations*1e6, times[0]/kIterations*1e6, times[1]/times[0]);
+}
+
+
 
 /*
  Copyright (c) 2009, Jens Alfke <jens@mooseyard.com>. All rights reserved.
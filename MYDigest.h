@@ -7,6 +7,14 @@
 //
 
 #import <Foundation/Foundation.h>
+@class MYDigestBuilder;
+
+
+/** A message to be digested by +computeDigests:ofBuffers:count:. */
+typedef struct {
+    const void *bytes;
+    size_t length;
+} MYDigestBuffer;
 
 
 /** Abstract superclass for cryptographic digests (aka hashes).
@@ -36,6 +44,27 @@
 /** Computes a cryptographic digest of the given data. */
 + (id) digestOfBytes: (const void*)bytes length: (size_t)length;
 
+/** Computes a cryptographic digest of everything that can be read from the stream.
+    The stream is opened if necessary (and then closed again.) The data is read in chunks, so
+    memory use doesn't depend on its length. Returns nil on a read error. */
++ (id) digestOfInputStream: (NSInputStream*)stream error: (NSError**)outError;
+
+/** Computes a cryptographic digest of everything that can be read from a file descriptor,
+    starting at its current position. The descriptor is not closed. Returns nil on a read error. */
++ (id) digestOfFileDescriptor: (int)fd error: (NSError**)outError;
+
+/** Computes the digests of many separate messages, writing the raw digests to a C array.
+    This is much faster than calling +digestOfBytes:length: on each one: no objects are
+    created, and the SHA subclasses hash several messages at once in SIMD lanes.
+    @param outDigests  Must have room for count * [self length] bytes; for example an array of
+            RawSHA256Digest for MYSHA256Digest.
+    @param buffers  The messages.
+    @param count  The number of messages. */
++ (void) computeDigests: (void*)outDigests ofBuffers: (const MYDigestBuffer*)buffers count: (size_t)count;
+
+/** Returns a new MYDigestBuilder for computing a digest of this subclass's type incrementally. */
++ (MYDigestBuilder*) builder;
+
 /** Returns the digest as an NSData object. */
 @property (weak, readonly) NSData *asData;
 
@@ -49,7 +78,7 @@
 
 /** The algorithm that created this digest. There is no universal way to name these,
     so on Mac OS values are interpreted as CSSM_ALGORITHMS; on iOS, as CCHmacAlgorithm.
-    (Abstract method.) */
+    (BLAKE3 has neither; see kMYBLAKE3DigestAlgorithm.) (Abstract method.) */
 @property (readonly) uint32_t algorithm;
 
 /** The length (in bytes, not bits!) of this digest. */
@@ -71,6 +100,15 @@
 /** Primitive digest generation method. (Abstract.) */
 + (void) computeDigest: (void*)dstDigest ofBytes: (const void*)bytes length: (size_t)length;
 
+/** The size of the state used for incremental digesting. The state is a plain C struct, so it can
+    be copied with memcpy. (Abstract.) */
++ (size_t) contextSize;
+
+/** Primitive incremental digest methods, used by MYDigestBuilder. (Abstract.) */
++ (void) initContext: (void*)context;
++ (void) updateContext: (void*)context withBytes: (const void*)bytes length: (size_t)length;
++ (void) finishContext: (void*)context digest: (void*)dstDigest;
+
 @end
 
 
@@ -116,6 +154,77 @@ typedef struct {
 @end
 
 
+// A simple C struct containing a 384-bit SHA-384 digest. Used by the MYSHA384Digest class.
+typedef struct {
+    UInt8 bytes[48];
+} RawSHA384Digest;
+
+/** A 384-bit SHA-384 digest encapsulated in an object. */
+@interface MYSHA384Digest : MYDigest
+{ }
+
+/** Initialize a MYSHA384Digest object given an existing raw SHA-384 digest. */
+- (MYSHA384Digest*) initWithRawSHA384Digest: (const RawSHA384Digest*)rawDigest;
+
+/** Create a MYSHA384Digest object given an existing raw SHA-384 digest. */
++ (MYSHA384Digest*) digestFromRawSHA384Digest: (const RawSHA384Digest*)rawDigest;
+
+/** The SHA-384 digest as a C struct */
+@property (readonly) const RawSHA384Digest* rawSHA384Digest;
+
+@end
+
+
+// A simple C struct containing a 512-bit SHA-512 digest. Used by the MYSHA512Digest class.
+typedef struct {
+    UInt8 bytes[64];
+} RawSHA512Digest;
+
+/** A 512-bit SHA-512 digest encapsulated in an object.
+    On 64-bit CPUs without SHA-256 instructions, SHA-512 is faster per byte than SHA-256. */
+@interface MYSHA512Digest : MYDigest
+{ }
+
+/** Initialize a MYSHA512Digest object given an existing raw SHA-512 digest. */
+- (MYSHA512Digest*) initWithRawSHA512Digest: (const RawSHA512Digest*)rawDigest;
+
+/** Create a MYSHA512Digest object given an existing raw SHA-512 digest. */
++ (MYSHA512Digest*) digestFromRawSHA512Digest: (const RawSHA512Digest*)rawDigest;
+
+/** The SHA-512 digest as a C struct */
+@property (readonly) const RawSHA512Digest* rawSHA512Digest;
+
+@end
+
+
+/** The value of +[MYBLAKE3Digest algorithm]. BLAKE3 has no CSSM or CommonCrypto identifier, so
+    this is a vendor-defined CSSM_ALGORITHMS value (CSSM_ALGID_VENDOR_DEFINED + 0x3B3.) */
+#define kMYBLAKE3DigestAlgorithm 0x800003B3
+
+// A simple C struct containing a 256-bit BLAKE3 digest. Used by the MYBLAKE3Digest class.
+typedef struct {
+    UInt8 bytes[32];
+} RawBLAKE3Digest;
+
+/** A 256-bit BLAKE3 digest encapsulated in an object.
+    BLAKE3 is much faster than the SHA family without hardware support, and large inputs given to
+    +digestOfData: or +digestOfBytes:length: are hashed on all available cores. (See MYBLAKE3.h.)
+    It's not used in X.509, so it's only for MYCrypto's own purposes, like content addressing. */
+@interface MYBLAKE3Digest : MYDigest
+{ }
+
+/** Initialize a MYBLAKE3Digest object given an existing raw BLAKE3 digest. */
+- (MYBLAKE3Digest*) initWithRawBLAKE3Digest: (const RawBLAKE3Digest*)rawDigest;
+
+/** Create a MYBLAKE3Digest object given an existing raw BLAKE3 digest. */
++ (MYBLAKE3Digest*) digestFromRawBLAKE3Digest: (const RawBLAKE3Digest*)rawDigest;
+
+/** The BLAKE3 digest as a C struct */
+@property (readonly) const RawBLAKE3Digest* rawBLAKE3Digest;
+
+@end
+
+
 /** Convenience methods for computing digests of NSData objects. */
 @interface NSData (MYDigest)
 
@@ -125,4 +234,52 @@ typedef struct {
 /** The SHA-256 digest of the receiver's data. */
 @property (readonly) MYSHA256Digest* my_SHA256Digest;
 
+/** The SHA-384 digest of the receiver's data. */
+@property (readonly) MYSHA384Digest* my_SHA384Digest;
+
+/** The SHA-512 digest of the receiver's data. */
+@property (readonly) MYSHA512Digest* my_SHA512Digest;
+
+/** The BLAKE3 digest of the receiver's data. */
+@property (readonly) MYBLAKE3Digest* my_BLAKE3Digest;
+
+@end
+
+
+
+/** Computes a digest incrementally, from data given to it a piece at a time.
+    Copying a builder copies its state, so a digest of a common prefix can be computed once
+    and then extended in different ways. */
+@interface MYDigestBuilder : NSObject <NSCopying>
+{
+    @private
+    Class _digestClass;
+    void *_context;
+    BOOL _finished;
+}
+
+/** Initializes a builder for the given MYDigest subclass. (Usually you'd call +builder on the
+    subclass instead.) */
+- (id) initWithDigestClass: (Class)digestClass;
+
+@property (readonly) Class digestClass;
+
+/** Adds data to the digest. */
+- (void) addBytes: (const void*)bytes length: (size_t)length;
+
+/** Adds data to the digest. */
+- (void) addData: (NSData*)data;
+
+/** Adds everything that can be read from the stream, opening it if necessary.
+    Returns NO on a read error, after which the builder shouldn't be used. */
+- (BOOL) addContentsOfInputStream: (NSInputStream*)stream error: (NSError**)outError;
+
+/** Adds everything that can be read from the file descriptor, from its current position.
+    Returns NO on a read error, after which the builder shouldn't be used. */
+- (BOOL) addContentsOfFileDescriptor: (int)fd error: (NSError**)outError;
+
+/** Returns the digest of all the data added. No more data can be added afterwards; to keep
+    going, call -finish on a copy instead. */
+- (MYDigest*) finish;
+
 @end
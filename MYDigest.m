@@ -7,14 +7,26 @@
 //
 
 #import "MYDigest.h"
+#import "MYCryptoConfig.h"
+#import "MYSHA.h"
+#import "MYBLAKE3.h"
 #import "Test.h"
 #import <CommonCrypto/CommonDigest.h>
+#import <fcntl.h>
+#import <unistd.h>
 
 #if TARGET_OS_IPHONE
 #import <CommonCrypto/CommonHMAC.h>
 #endif
 
 
+/* Size of the buffer used to read streams and files. */
+#define kReadChunkSize (1024*1024)
+
+/* CommonCrypto's update functions take 32-bit lengths, so larger inputs are passed in pieces. */
+#define kMaxUpdateLength ((size_t)1 << 30)
+
+
 @implementation MYDigest
 
 + (uint32_t) algorithm {
@@ -29,6 +41,22 @@
     AssertAbstractMethod();
 }
 
++ (size_t) contextSize {
+    AssertAbstractMethod();
+}
+
++ (void) initContext: (void*)context {
+    AssertAbstractMethod();
+}
+
++ (void) updateContext: (void*)context withBytes: (const void*)bytes length: (size_t)length {
+    AssertAbstractMethod();
+}
+
++ (void) finishContext: (void*)context digest: (void*)dstDigest {
+    AssertAbstractMethod();
+}
+
 
 - (id) initWithRawDigest: (const void*)rawDigest length: (size_t)length {
     Assert([self class] != [MYDigest class], @"MYDigest is an abstract class");
@@ -99,6 +127,33 @@
     return [[self alloc] initWithRawDigest: &digest length: digestLength];
 }
 
++ (id) digestOfInputStream: (NSInputStream*)stream error: (NSError**)outError {
+    BOOL opened = (stream.streamStatus == NSStreamStatusNotOpen);
+    MYDigestBuilder *builder = [self builder];
+    BOOL ok = [builder addContentsOfInputStream: stream error: outError];
+    if (opened)
+        [stream close];
+    return ok ? [builder finish] : nil;
+}
+
++ (id) digestOfFileDescriptor: (int)fd error: (NSError**)outError {
+    MYDigestBuilder *builder = [self builder];
+    if (![builder addContentsOfFileDescriptor: fd error: outError])
+        return nil;
+    return [builder finish];
+}
+
++ (void) computeDigests: (void*)outDigests ofBuffers: (const MYDigestBuffer*)buffers count: (size_t)count {
+    const size_t digestLength = [self length];
+    for (size_t i = 0; i < count; i++)
+        [self computeDigest: (uint8_t*)outDigests + i * digestLength
+                    ofBytes: buffers[i].bytes length: buffers[i].length];
+}
+
++ (MYDigestBuilder*) builder {
+    return [[MYDigestBuilder alloc] initWithDigestClass: self];
+}
+
 - (uint32_t) algorithm {
     return [[self class] algorithm];
 }
@@ -169,9 +224,58 @@
 
 + (void) computeDigest: (void*)dstDigest ofBytes: (const void*)bytes length: (size_t)length {
     NSParameterAssert(bytes != NULL || length == 0);
+#if MYCRYPTO_USE_PORTABLE_SHA
+    MYSHA1(bytes, length, dstDigest);
+#else
     CC_SHA1(bytes,(CC_LONG)length, dstDigest);
+#endif
+}
+
++ (void) computeDigests: (void*)outDigests ofBuffers: (const MYDigestBuffer*)buffers count: (size_t)count {
+    MYSHA1Batch(buffers, count, outDigests);
+}
+
+#if MYCRYPTO_USE_PORTABLE_SHA
+
++ (size_t) contextSize {
+    return sizeof(MYSHA1Context);
+}
+
++ (void) initContext: (void*)context {
+    MYSHA1Init(context);
+}
+
++ (void) updateContext: (void*)context withBytes: (const void*)bytes length: (size_t)length {
+    MYSHA1Update(context, bytes, length);
+}
+
++ (void) finishContext: (void*)context digest: (void*)dstDigest {
+    MYSHA1Final(context, dstDigest);
+}
+
+#else
+
++ (size_t) contextSize {
+    return sizeof(CC_SHA1_CTX);
 }
 
++ (void) initContext: (void*)context {
+    CC_SHA1_Init(context);
+}
+
++ (void) updateContext: (void*)context withBytes: (const void*)bytes length: (size_t)length {
+    for (size_t n; length > 0; bytes = (const uint8_t*)bytes + n, length -= n) {
+        n = MIN(length, kMaxUpdateLength);
+        CC_SHA1_Update(context, bytes, (CC_LONG)n);
+    }
+}
+
++ (void) finishContext: (void*)context digest: (void*)dstDigest {
+    CC_SHA1_Final(dstDigest, context);
+}
+
+#endif
+
 #if TARGET_OS_IPHONE
 + (uint32_t) algorithm          {return kCCHmacAlgSHA1;}
 #else
@@ -201,9 +305,58 @@
 + (void) computeDigest: (void*)dstDigest ofBytes: (const void*)bytes length: (size_t)length {
     NSParameterAssert(bytes!=NULL);
     NSParameterAssert(length>0);
+#if MYCRYPTO_USE_PORTABLE_SHA
+    MYSHA256(bytes, length, dstDigest);
+#else
     CC_SHA256(bytes,(CC_LONG)length, dstDigest);
+#endif
+}
+
++ (void) computeDigests: (void*)outDigests ofBuffers: (const MYDigestBuffer*)buffers count: (size_t)count {
+    MYSHA256Batch(buffers, count, outDigests);
+}
+
+#if MYCRYPTO_USE_PORTABLE_SHA
+
++ (size_t) contextSize {
+    return sizeof(MYSHA256Context);
 }
 
++ (void) initContext: (void*)context {
+    MYSHA256Init(context);
+}
+
++ (void) updateContext: (void*)context withBytes: (const void*)bytes length: (size_t)length {
+    MYSHA256Update(context, bytes, length);
+}
+
++ (void) finishContext: (void*)context digest: (void*)dstDigest {
+    MYSHA256Final(context, dstDigest);
+}
+
+#else
+
++ (size_t) contextSize {
+    return sizeof(CC_SHA256_CTX);
+}
+
++ (void) initContext: (void*)context {
+    CC_SHA256_Init(context);
+}
+
++ (void) updateContext: (void*)context withBytes: (const void*)bytes length: (size_t)length {
+    for (size_t n; length > 0; bytes = (const uint8_t*)bytes + n, length -= n) {
+        n = MIN(length, kMaxUpdateLength);
+        CC_SHA256_Update(context, bytes, (CC_LONG)n);
+    }
+}
+
++ (void) finishContext: (void*)context digest: (void*)dstDigest {
+    CC_SHA256_Final(dstDigest, context);
+}
+
+#endif
+
 #if TARGET_OS_IPHONE
 + (uint32_t) algorithm          {return kCCHmacAlgSHA256;}
 #else
@@ -227,6 +380,304 @@
 @end
 
 
+@implementation MYSHA384Digest
+
++ (void) computeDigest: (void*)dstDigest ofBytes: (const void*)bytes length: (size_t)length {
+    NSParameterAssert(bytes != NULL || length == 0);
+#if MYCRYPTO_USE_PORTABLE_SHA
+    MYSHA384(bytes, length, dstDigest);
+#else
+    CC_SHA384(bytes,(CC_LONG)length, dstDigest);
+#endif
+}
+
+#if MYCRYPTO_USE_PORTABLE_SHA
+
++ (size_t) contextSize {
+    return sizeof(MYSHA512Context);
+}
+
++ (void) initContext: (void*)context {
+    MYSHA384Init(context);
+}
+
++ (void) updateContext: (void*)context withBytes: (const void*)bytes length: (size_t)length {
+    MYSHA384Update(context, bytes, length);
+}
+
++ (void) finishContext: (void*)context digest: (void*)dstDigest {
+    MYSHA384Final(context, dstDigest);
+}
+
+#else
+
++ (size_t) contextSize {
+    return sizeof(CC_SHA512_CTX);
+}
+
++ (void) initContext: (void*)context {
+    CC_SHA384_Init(context);
+}
+
++ (void) updateContext: (void*)context withBytes: (const void*)bytes length: (size_t)length {
+    for (size_t n; length > 0; bytes = (const uint8_t*)bytes + n, length -= n) {
+        n = MIN(length, kMaxUpdateLength);
+        CC_SHA384_Update(context, bytes, (CC_LONG)n);
+    }
+}
+
++ (void) finishContext: (void*)context digest: (void*)dstDigest {
+    CC_SHA384_Final(dstDigest, context);
+}
+
+#endif
+
+#if TARGET_OS_IPHONE
++ (uint32_t) algorithm          {return kCCHmacAlgSHA384;}
+#else
++ (uint32_t) algorithm          {return CSSM_ALGID_SHA384;}
+#endif
++ (size_t) length               {return sizeof(RawSHA384Digest);}
+
+- (MYSHA384Digest*) initWithRawSHA384Digest: (const RawSHA384Digest*)rawDigest {
+    return [super initWithRawDigest: rawDigest length: sizeof(*rawDigest)];
+}
+
++ (MYSHA384Digest*) digestFromRawSHA384Digest: (const RawSHA384Digest*)rawDigest {
+    return [[self alloc] initWithRawSHA384Digest: rawDigest];
+}
+
+- (const RawSHA384Digest*) rawSHA384Digest {
+    return self.bytes;
+}
+
+
+@end
+
+
+
+@implementation MYSHA512Digest
+
++ (void) computeDigest: (void*)dstDigest ofBytes: (const void*)bytes length: (size_t)length {
+    NSParameterAssert(bytes != NULL || length == 0);
+#if MYCRYPTO_USE_PORTABLE_SHA
+    MYSHA512(bytes, length, dstDigest);
+#else
+    CC_SHA512(bytes,(CC_LONG)length, dstDigest);
+#endif
+}
+
+#if MYCRYPTO_USE_PORTABLE_SHA
+
++ (size_t) contextSize {
+    return sizeof(MYSHA512Context);
+}
+
++ (void) initContext: (void*)context {
+    MYSHA512Init(context);
+}
+
++ (void) updateContext: (void*)context withBytes: (const void*)bytes length: (size_t)length {
+    MYSHA512Update(context, bytes, length);
+}
+
++ (void) finishContext: (void*)context digest: (void*)dstDigest {
+    MYSHA512Final(context, dstDigest);
+}
+
+#else
+
++ (size_t) contextSize {
+    return sizeof(CC_SHA512_CTX);
+}
+
++ (void) initContext: (void*)context {
+    CC_SHA512_Init(context);
+}
+
++ (void) updateContext: (void*)context withBytes: (const void*)bytes length: (size_t)length {
+    for (size_t n; length > 0; bytes = (const uint8_t*)bytes + n, length -= n) {
+        n = MIN(length, kMaxUpdateLength);
+        CC_SHA512_Update(context, bytes, (CC_LONG)n);
+    }
+}
+
++ (void) finishContext: (void*)context digest: (void*)dstDigest {
+    CC_SHA512_Final(dstDigest, context);
+}
+
+#endif
+
+#if TARGET_OS_IPHONE
++ (uint32_t) algorithm          {return kCCHmacAlgSHA512;}
+#else
++ (uint32_t) algorithm          {return CSSM_ALGID_SHA512;}
+#endif
++ (size_t) length               {return sizeof(RawSHA512Digest);}
+
+- (MYSHA512Digest*) initWithRawSHA512Digest: (const RawSHA512Digest*)rawDigest {
+    return [super initWithRawDigest: rawDigest length: sizeof(*rawDigest)];
+}
+
++ (MYSHA512Digest*) digestFromRawSHA512Digest: (const RawSHA512Digest*)rawDigest {
+    return [[self alloc] initWithRawSHA512Digest: rawDigest];
+}
+
+- (const RawSHA512Digest*) rawSHA512Digest {
+    return self.bytes;
+}
+
+
+@end
+
+
+
+@implementation MYBLAKE3Digest
+
++ (void) computeDigest: (void*)dstDigest ofBytes: (const void*)bytes length: (size_t)length {
+    NSParameterAssert(bytes != NULL || length == 0);
+    MYBLAKE3(bytes, length, dstDigest);
+}
+
++ (size_t) contextSize {
+    return sizeof(MYBLAKE3Context);
+}
+
++ (void) initContext: (void*)context {
+    MYBLAKE3Init(context);
+}
+
++ (void) updateContext: (void*)context withBytes: (const void*)bytes length: (size_t)length {
+    MYBLAKE3Update(context, bytes, length);
+}
+
++ (void) finishContext: (void*)context digest: (void*)dstDigest {
+    MYBLAKE3Final(context, dstDigest);
+}
+
++ (uint32_t) algorithm          {return kMYBLAKE3DigestAlgorithm;}
++ (size_t) length               {return sizeof(RawBLAKE3Digest);}
+
+- (MYBLAKE3Digest*) initWithRawBLAKE3Digest: (const RawBLAKE3Digest*)rawDigest {
+    return [super initWithRawDigest: rawDigest length: sizeof(*rawDigest)];
+}
+
++ (MYBLAKE3Digest*) digestFromRawBLAKE3Digest: (const RawBLAKE3Digest*)rawDigest {
+    return [[self alloc] initWithRawBLAKE3Digest: rawDigest];
+}
+
+- (const RawBLAKE3Digest*) rawBLAKE3Digest {
+    return self.bytes;
+}
+
+
+@end
+
+
+@implementation MYDigestBuilder
+
+
+- (id) initWithDigestClass: (Class)digestClass {
+    Assert([digestClass isSubclassOfClass: [MYDigest class]] && digestClass != [MYDigest class]);
+    self = [super init];
+    if (self) {
+        _digestClass = digestClass;
+        _context = malloc([digestClass contextSize]);
+        Assert(_context);
+        [digestClass initContext: _context];
+    }
+    return self;
+}
+
+- (void) dealloc
+{
+    if (_context) free(_context);
+}
+
+- (id) copyWithZone: (NSZone*)zone
+{
+    Assert(!_finished, @"Can't copy a finished MYDigestBuilder");
+    MYDigestBuilder *copy = [[[self class] alloc] initWithDigestClass: _digestClass];
+    memcpy(copy->_context, _context, [_digestClass contextSize]);
+    return copy;
+}
+
+
+@synthesize digestClass=_digestClass;
+
+
+- (void) addBytes: (const void*)bytes length: (size_t)length {
+    Assert(!_finished, @"Can't add to a finished MYDigestBuilder");
+    NSParameterAssert(bytes != NULL || length == 0);
+    if (length > 0)
+        [_digestClass updateContext: _context withBytes: bytes length: length];
+}
+
+- (void) addData: (NSData*)data {
+    [self addBytes: data.bytes length: data.length];
+}
+
+
+- (BOOL) addContentsOfInputStream: (NSInputStream*)stream error: (NSError**)outError {
+    if (stream.streamStatus == NSStreamStatusNotOpen)
+        [stream open];
+    uint8_t *buffer = malloc(kReadChunkSize);
+    if (!buffer) {
+        if (outError) *outError = [NSError errorWithDomain: NSPOSIXErrorDomain code: ENOMEM
+                                                  userInfo: nil];
+        return NO;
+    }
+    NSInteger bytesRead;
+    while ((bytesRead = [stream read: buffer maxLength: kReadChunkSize]) > 0)
+        [self addBytes: buffer length: bytesRead];
+    free(buffer);
+    if (bytesRead < 0) {
+        if (outError) *outError = stream.streamError;
+        return NO;
+    }
+    return YES;
+}
+
+
+- (BOOL) addContentsOfFileDescriptor: (int)fd error: (NSError**)outError {
+    uint8_t *buffer = malloc(kReadChunkSize);
+    if (!buffer) {
+        if (outError) *outError = [NSError errorWithDomain: NSPOSIXErrorDomain code: ENOMEM
+                                                  userInfo: nil];
+        return NO;
+    }
+    ssize_t bytesRead;
+    for (;;) {
+        bytesRead = read(fd, buffer, kReadChunkSize);
+        if (bytesRead > 0)
+            [self addBytes: buffer length: bytesRead];
+        else if (bytesRead == 0 || errno != EINTR)
+            break;
+    }
+    int err = errno;
+    free(buffer);
+    if (bytesRead < 0) {
+        if (outError) *outError = [NSError errorWithDomain: NSPOSIXErrorDomain code: err
+                                                  userInfo: nil];
+        return NO;
+    }
+    return YES;
+}
+
+
+- (MYDigest*) finish {
+    Assert(!_finished, @"MYDigestBuilder was already finished");
+    _finished = YES;
+    const size_t digestLength = [_digestClass length];
+    uint8_t digest[digestLength];
+    [_digestClass finishContext: _context digest: digest];
+    return [[_digestClass alloc] initWithRawDigest: digest length: digestLength];
+}
+
+
+@end
+
+
 
 @implementation NSData (MYDigest)
 
@@ -240,6 +691,21 @@
     return (MYSHA256Digest*) [MYSHA256Digest digestOfData: self];
 }
 
+- (MYSHA384Digest*) my_SHA384Digest
+{
+    return (MYSHA384Digest*) [MYSHA384Digest digestOfData: self];
+}
+
+- (MYSHA512Digest*) my_SHA512Digest
+{
+    return (MYSHA512Digest*) [MYSHA512Digest digestOfData: self];
+}
+
+- (MYBLAKE3Digest*) my_BLAKE3Digest
+{
+    return (MYBLAKE3Digest*) [MYBLAKE3Digest digestOfData: self];
+}
+
 @end
 
 
@@ -270,6 +736,45 @@ static void testDigestOf( NSData *src, NSString *expectedSHA1Hex, NSString *expe
 }
 
 
+static void testBuilderOf (Class digestClass, NSData *src) {
+    MYDigest *expected = [digestClass digestOfData: src];
+
+    // Feed it in uneven pieces:
+    MYDigestBuilder *builder = [digestClass builder];
+    const uint8_t *bytes = src.bytes;
+    size_t pos = 0;
+    for (size_t n = 1; pos < src.length; n = n * 3 + 1) {
+        size_t len = MIN(n, src.length - pos);
+        [builder addBytes: bytes + pos length: len];
+        pos += len;
+    }
+    CAssertEqual([builder finish], expected);
+
+    // Reuse the state after a prefix:
+    size_t half = src.length / 2;
+    MYDigestBuilder *prefix = [digestClass builder];
+    [prefix addBytes: bytes length: half];
+    MYDigestBuilder *rest = [prefix copy];
+    [rest addBytes: bytes + half length: src.length - half];
+    CAssertEqual([rest finish], expected);
+    [prefix addBytes: bytes + half length: src.length - half];
+    CAssertEqual([prefix finish], expected);
+
+    // Streams and files:
+    NSError *error;
+    NSInputStream *stream = [NSInputStream inputStreamWithData: src];
+    CAssertEqual([digestClass digestOfInputStream: stream error: &error], expected);
+
+    NSString *path = [NSTemporaryDirectory() stringByAppendingPathComponent: @"MYDigestTest"];
+    CAssert([src writeToFile: path atomically: NO]);
+    int fd = open(path.fileSystemRepresentation, O_RDONLY);
+    CAssert(fd >= 0);
+    CAssertEqual([digestClass digestOfFileDescriptor: fd error: &error], expected);
+    close(fd);
+    [[NSFileManager defaultManager] removeItemAtPath: path error: NULL];
+}
+
+
 TestCase(MYDigest) {
     testDigestOf([@"Pack my box with five dozen liquor jugs, you ugly potatoe pie!" 
                           dataUsingEncoding: NSUTF8StringEncoding],
@@ -281,6 +786,77 @@ TestCase(MYDigest) {
 }
 
 
+TestCase(MYDigestBuilder) {
+    RequireTestCase(MYDigest);
+    CAssertEqual([[MYSHA256Digest builder] finish].hexString,
+                 @"E3B0C44298FC1C149AFBF4C8996FB92427AE41E4649B934CA495991B7852B855");
+    CAssertEqual([[MYSHA1Digest builder] finish].hexString,
+                 @"DA39A3EE5E6B4B0D3255BFEF95601890AFD80709");
+    NSMutableData *src = [NSMutableData dataWithLength: 3*kReadChunkSize + 12345];
+    uint8_t *bytes = src.mutableBytes;
+    for (size_t i = 0; i < src.length; i++)
+        bytes[i] = (uint8_t)(i * 7 + (i >> 11));
+    testBuilderOf([MYSHA1Digest class], src);
+    testBuilderOf([MYSHA256Digest class], src);
+}
+
+
+static void testValueSemanticsOf (MYDigest *digest, NSString *expectedHex) {
+    Class digestClass = [digest class];
+    CAssertEqual(digest.hexString, expectedHex);
+    CAssertEq(digest.length, expectedHex.length / 2);
+    MYDigest *copy = [digestClass digestFromHexString: expectedHex];
+    CAssertEqual(copy, digest);
+    CAssertEq(copy.hash, digest.hash);
+    CAssertEq([copy compare: digest], (NSComparisonResult)NSOrderedSame);
+    CAssertEqual([digestClass digestFromDigestData: digest.asData], digest);
+
+    NSData *archive = [NSKeyedArchiver archivedDataWithRootObject: digest];
+    MYDigest *unarchived = [NSKeyedUnarchiver unarchiveObjectWithData: archive];
+    CAssertEq([unarchived class], digestClass);
+    CAssertEqual(unarchived, digest);
+
+    // Digests of different types are never equal, even with the same bytes:
+    if (digest.length == sizeof(RawSHA256Digest)) {
+        MYDigest *other = [[MYSHA256Digest alloc] initWithRawDigest: digest.bytes
+                                                             length: digest.length];
+        CAssert(![other isEqual: digest]);
+    }
+}
+
+
+TestCase(MYDigestSHA512AndBLAKE3) {
+    RequireTestCase(MYDigestBuilder);
+    NSData *src = [@"Pack my box with five dozen liquor jugs, you ugly potatoe pie!"
+                        dataUsingEncoding: NSUTF8StringEncoding];
+    testValueSemanticsOf([src my_SHA384Digest],
+                         @"473B3A91B5688CE0236B69A650D9555AB659D9C9EAA63101"
+                          "149A834553D1407D811B500A4A54408FB950C3D72C93C9B4");
+    testValueSemanticsOf([src my_SHA512Digest],
+                         @"30B3C84A34328336E8D4FF19A3823B60C865F76F69056B5D0C19F0ECF5EA7E23"
+                          "1C79DC7F5771770D5846923343D2E1A571C410DDE2C389882086F0E0AC08B30A");
+    testValueSemanticsOf([src my_BLAKE3Digest],
+                         @"DF525F523B6B207AE8F9EFC5AF21838E9153338FBCDB38B6FF445411CA99FCDB");
+
+    CAssertEqual([[MYSHA384Digest builder] finish].hexString,
+                 @"38B060A751AC96384CD9327EB1B1E36A21FDB71114BE0743"
+                  "4C0CC7BF63F6E1DA274EDEBFE76F65FBD51AD2F14898B95B");
+    CAssertEqual([[MYSHA512Digest builder] finish].hexString,
+                 @"CF83E1357EEFB8BDF1542850D66D8007D620E4050B5715DC83F4A921D36CE9CE"
+                  "47D0D13C5D85F2B0FF8318D2877EEC2F63B931BD47417A81A538327AF927DA3E");
+    CAssertEqual([[MYBLAKE3Digest builder] finish].hexString,
+                 @"AF1349B9F5F9A1A6A0404DEA36DCC9499BCB25C9ADC112B7CC9A93CAE41F3262");
+
+    NSMutableData *big = [NSMutableData dataWithLength: 3*kReadChunkSize + 12345];
+    uint8_t *bytes = big.mutableBytes;
+    for (size_t i = 0; i < big.length; i++)
+        bytes[i] = (uint8_t)(i * 7 + (i >> 11));
+    testBuilderOf([MYSHA384Digest class], big);
+    testBuilderOf([MYSHA512Digest class], big);
+    testBuilderOf([MYBLAKE3Digest class], big);
+}
+
+
 
 /*
  Copyright (c) 2009, Jens Alfke <jens@mooseyard.com>. All rights reserved.
@@ -9,6 +9,7 @@
 #import "MYIdentity.h"
 #import "MYCrypto_Private.h"
 #import "MYDigest.h"
+#import "MYPEM.h"
 
 #import "MYErrorUtils.h"
 
@@ -166,13 +167,14 @@ static SecIdentityRef importIdentity(NSData *data,
         .alertTitle = (__bridge CFStringRef)title,
         .alertPrompt = (__bridge CFStringRef)prompt
     };
+    NSString *pemLabel = withPEM ? MYPEMLabelForExternalFormat(format) : nil;
     CFDataRef data = NULL;
-    if (check(SecItemExport(self.identityRef,
-                            format, (withPEM ?kSecItemPemArmour :0),
-                            &params, &data), @"SecItemExport"))
-        return (NSData*)CFBridgingRelease(data);
-    else
+    if (!check(SecItemExport(self.identityRef,
+                             format, ((withPEM && !pemLabel) ?kSecItemPemArmour :0),
+                             &params, &data), @"SecItemExport"))
         return nil;
+    NSData *result = CFBridgingRelease(data);
+    return pemLabel ? MYPEMEncode(result, pemLabel) : result;
 }
 
 
@@ -278,6 +278,20 @@ BOOL checkcssm(CSSM_RETURN err, NSString *what) {
 #endif
 
 
+#if !TARGET_OS_IPHONE
+NSString* MYPEMLabelForExternalFormat (SecExternalFormat format) {
+    switch (format) {
+        case kSecFormatX509Cert:        return @"CERTIFICATE";
+        case kSecFormatPKCS7:           return @"PKCS7";
+        case kSecFormatPKCS12:          return @"PKCS12";
+        case kSecFormatWrappedPKCS8:    return @"ENCRYPTED PRIVATE KEY";
+        case kSecFormatOpenSSL:         return @"RSA PRIVATE KEY";
+        default:                        return nil;     // needs PEM headers, or isn't PEM-able
+    }
+}
+#endif
+
+
 
 /*
  Copyright (c) 2009, Jens Alfke <jens@mooseyard.com>. All rights reserved.
@@ -0,0 +1,79 @@
+//
+//  MYMerkleTree.h
+//  MYCrypto
+//
+//  Created by Jens Alfke on 10/16/26.
+//  Copyright 2026 Jens Alfke. All rights reserved.
+//
+
+#import "MYDigest.h"
+
+
+/** The default chunk size for tree hashing: 1MB. */
+#define kMYMerkleTreeDefaultChunkSize (1024*1024)
+
+
+/** A SHA-256 Merkle tree ("tree hash") of some data divided into fixed-size chunks.
+    The chunks are hashed in parallel on all available cores, so for large inputs this is much
+    faster than a plain digest, which is inherently sequential.
+    The tree has the shape and hashing rules of RFC 6962 (Certificate Transparency): a leaf is
+    SHA-256(0x00 || chunk), an interior node is SHA-256(0x01 || left || right), and a level with
+    an odd number of nodes passes the last one up unchanged. The root of empty data is SHA-256 of
+    nothing. Any chunk can be proven to belong to the tree with an inclusion proof of about
+    log2(chunkCount) digests.
+    Instances are immutable, so they can be used from any thread. */
+@interface MYMerkleTree : NSObject
+{
+    @private
+    size_t _chunkSize;
+    uint64_t _dataLength;
+    NSArray *_levels;           // NSData arrays of RawSHA256Digest, leaves first, root last
+}
+
+/** Builds the tree of some data in memory. */
+- (id) initWithData: (NSData*)data chunkSize: (size_t)chunkSize;
+
+/** Builds the tree of a file's contents. The file is memory-mapped rather than read, so the
+    chunks are paged in by the threads hashing them. */
+- (id) initWithContentsOfFile: (NSString*)path
+                    chunkSize: (size_t)chunkSize
+                        error: (NSError**)outError;
+
+@property (readonly) size_t chunkSize;
+
+/** The total length of the data. */
+@property (readonly) uint64_t dataLength;
+
+/** The number of chunks; the last one may be shorter than chunkSize. */
+@property (readonly) NSUInteger chunkCount;
+
+/** The root of the tree, which identifies the entire data. */
+@property (readonly) MYSHA256Digest *rootDigest;
+
+/** The leaf hash of one chunk. */
+- (MYSHA256Digest*) digestOfChunk: (NSUInteger)index;
+
+/** Returns the digests needed to prove that a chunk is part of the tree, as an array of
+    MYSHA256Digests ordered from the leaf's sibling upwards. */
+- (NSArray*) inclusionProofForChunk: (NSUInteger)index;
+
+/** Checks an inclusion proof: that the chunk's data is chunk number 'index' of a tree of
+    'chunkCount' chunks with the given root. */
++ (BOOL) verifyChunk: (NSData*)chunk
+             atIndex: (NSUInteger)index
+          chunkCount: (NSUInteger)chunkCount
+               proof: (NSArray*)proof
+          rootDigest: (MYSHA256Digest*)rootDigest;
+
+@end
+
+
+@interface MYSHA256Digest (MYMerkleTree)
+
+/** Computes the Merkle tree root of a file's contents, hashing chunks in parallel.
+    This is NOT the same value as the file's plain SHA-256 digest. */
++ (MYSHA256Digest*) treeDigestOfContentsOfFile: (NSString*)path
+                                     chunkSize: (size_t)chunkSize
+                                         error: (NSError**)outError;
+
+@end
@@ -0,0 +1,342 @@
+//
+//  MYMerkleTree.m
+//  MYCrypto
+//
+//  Created by Jens Alfke on 10/16/26.
+//  Copyright 2026 Jens Alfke. All rights reserved.
+//
+
+// References:
+// <http://tools.ietf.org/html/rfc6962#section-2.1> "Merkle Hash Trees"
+
+#import "MYMerkleTree.h"
+#import "CollectionUtils.h"
+#import "Test.h"
+
+
+/* Each block given to dispatch_apply hashes at least this many bytes of chunks, so that small
+   chunk sizes don't drown in scheduling overhead. */
+#define kMinBytesPerWorkItem (1024*1024)
+
+
+static const uint8_t kLeafPrefix = 0x00, kNodePrefix = 0x01;
+
+
+static void hashLeaf (const void *bytes, size_t length, RawSHA256Digest *outDigest) {
+    Class digestClass = [MYSHA256Digest class];
+    uint64_t context[([digestClass contextSize] + 7) / 8];
+    [digestClass initContext: context];
+    [digestClass updateContext: context withBytes: &kLeafPrefix length: 1];
+    [digestClass updateContext: context withBytes: bytes length: length];
+    [digestClass finishContext: context digest: outDigest];
+}
+
+static void hashNode (const RawSHA256Digest *left, const RawSHA256Digest *right,
+                      RawSHA256Digest *outDigest)
+{
+    uint8_t message[1 + 2*sizeof(RawSHA256Digest)];
+    message[0] = kNodePrefix;
+    memcpy(&message[1], left, sizeof(*left));
+    memcpy(&message[1 + sizeof(*left)], right, sizeof(*right));
+    [MYSHA256Digest computeDigest: outDigest ofBytes: message length: sizeof(message)];
+}
+
+
+/* Computes the level above the given one. The node pairs are hashed as a batch, which uses
+   multi-buffer SIMD where available. */
+static NSData* hashLevel (NSData *level) {
+    const RawSHA256Digest *nodes = level.bytes;
+    size_t count = level.length / sizeof(RawSHA256Digest);
+    size_t pairs = count / 2;
+    const size_t messageSize = 1 + 2*sizeof(RawSHA256Digest);
+    NSMutableData *next = [NSMutableData dataWithLength: (count + 1) / 2 * sizeof(RawSHA256Digest)];
+    RawSHA256Digest *outNodes = next.mutableBytes;
+
+    uint8_t *messages = malloc(pairs * messageSize);
+    MYDigestBuffer *buffers = malloc(pairs * sizeof(MYDigestBuffer));
+    for (size_t i = 0; i < pairs; i++) {
+        uint8_t *message = messages + i * messageSize;
+        message[0] = kNodePrefix;
+        memcpy(message + 1, &nodes[2*i], 2*sizeof(RawSHA256Digest));
+        buffers[i] = (MYDigestBuffer){message, messageSize};
+    }
+    [MYSHA256Digest computeDigests: outNodes ofBuffers: buffers count: pairs];
+    free(buffers);
+    free(messages);
+
+    if (count % 2)
+        outNodes[pairs] = nodes[count - 1];     // An odd node out moves up unchanged
+    return next;
+}
+
+
+@implementation MYMerkleTree
+
+
+- (id) initWithData: (NSData*)data chunkSize: (size_t)chunkSize {
+    NSParameterAssert(chunkSize > 0);
+    self = [super init];
+    if (self) {
+        _chunkSize = chunkSize;
+        _dataLength = data.length;
+        size_t chunkCount = (size_t)((_dataLength + chunkSize - 1) / chunkSize);
+
+        // Hash the chunks in parallel:
+        NSMutableData *leaves = [NSMutableData dataWithLength: chunkCount * sizeof(RawSHA256Digest)];
+        RawSHA256Digest *leafDigests = leaves.mutableBytes;
+        const uint8_t *bytes = data.bytes;
+        const uint64_t length = _dataLength;
+        size_t chunksPerItem = MAX((size_t)1, kMinBytesPerWorkItem / chunkSize);
+        size_t nWorkItems = (chunkCount + chunksPerItem - 1) / chunksPerItem;
+        dispatch_apply(nWorkItems, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0),
+                       ^(size_t item) {
+            size_t end = MIN(chunkCount, (item + 1) * chunksPerItem);
+            for (size_t i = item * chunksPerItem; i < end; i++) {
+                uint64_t start = (uint64_t)i * chunkSize;
+                hashLeaf(bytes + start, (size_t)MIN(chunkSize, length - start), &leafDigests[i]);
+            }
+        });
+
+        // Then combine them:
+        NSMutableArray *levels = [NSMutableArray array];
+        if (chunkCount > 0) {
+            NSData *level = leaves;
+            [levels addObject: level];
+            while (level.length > sizeof(RawSHA256Digest)) {
+                level = hashLevel(level);
+                [levels addObject: level];
+            }
+        }
+        _levels = [levels copy];
+    }
+    return self;
+}
+
+
+- (id) initWithContentsOfFile: (NSString*)path
+                    chunkSize: (size_t)chunkSize
+                        error: (NSError**)outError
+{
+    NSData *data = [NSData dataWithContentsOfFile: path
+                                          options: NSDataReadingMappedAlways
+                                            error: outError];
+    if (!data)
+        return nil;
+    return [self initWithData: data chunkSize: chunkSize];
+}
+
+
+@synthesize chunkSize=_chunkSize, dataLength=_dataLength;
+
+
+- (NSUInteger) chunkCount {
+    if (_levels.count == 0)
+        return 0;
+    return [_levels[0] length] / sizeof(RawSHA256Digest);
+}
+
+
+static MYSHA256Digest* nodeDigest (NSData *level, NSUInteger index) {
+    return [MYSHA256Digest digestFromRawSHA256Digest: (const RawSHA256Digest*)level.bytes + index];
+}
+
+
+- (MYSHA256Digest*) rootDigest {
+    if (_levels.count == 0)
+        return (MYSHA256Digest*)[[MYSHA256Digest builder] finish];
+    return nodeDigest(_levels.lastObject, 0);
+}
+
+
+- (MYSHA256Digest*) digestOfChunk: (NSUInteger)index {
+    NSParameterAssert(index < self.chunkCount);
+    return nodeDigest(_levels[0], index);
+}
+
+
+- (NSArray*) inclusionProofForChunk: (NSUInteger)index {
+    NSParameterAssert(index < self.chunkCount);
+    NSMutableArray *proof = [NSMutableArray array];
+    for (NSUInteger l = 0; l + 1 < _levels.count; l++) {
+        NSData *level = _levels[l];
+        NSUInteger sibling = index ^ 1;
+        if (sibling < level.length / sizeof(RawSHA256Digest))
+            [proof addObject: nodeDigest(level, sibling)];
+        index /= 2;
+    }
+    return proof;
+}
+
+
++ (BOOL) verifyChunk: (NSData*)chunk
+             atIndex: (NSUInteger)index
+          chunkCount: (NSUInteger)chunkCount
+               proof: (NSArray*)proof
+          rootDigest: (MYSHA256Digest*)rootDigest
+{
+    if (index >= chunkCount)
+        return NO;
+    RawSHA256Digest node;
+    hashLeaf(chunk.bytes, chunk.length, &node);
+    NSUInteger next = 0;
+    for (NSUInteger count = chunkCount; count > 1; count = (count + 1) / 2, index /= 2) {
+        if ((index & 1) == 0 && index + 1 == count)
+            continue;                           // No sibling; the node moves up unchanged
+        if (next >= proof.count)
+            return NO;
+        MYSHA256Digest *sibling = $castIf(MYSHA256Digest, proof[next++]);
+        if (!sibling)
+            return NO;
+        if (index & 1)
+            hashNode(sibling.rawSHA256Digest, &node, &node);
+        else
+            hashNode(&node, sibling.rawSHA256Digest, &node);
+    }
+    return next == proof.count
+        && memcmp(&node, rootDigest.rawSHA256Digest, sizeof(node)) == 0;
+}
+
+
+@end
+
+
+
+@implementation MYSHA256Digest (MYMerkleTree)
+
++ (MYSHA256Digest*) treeDigestOfContentsOfFile: (NSString*)path
+                                     chunkSize: (size_t)chunkSize
+                                         error: (NSError**)outError
+{
+    return [[MYMerkleTree alloc] initWithContentsOfFile: path
+                                              chunkSize: chunkSize
+                                                  error: outError].rootDigest;
+}
+
+@end
+
+
+
+
+#pragma mark -
+#pragma mark TEST CASES:
+
+
+/* The tree hash as defined recursively by RFC 6962: the left subtree holds the largest power of
+   two leaves less than the total. */
+static MYSHA256Digest* referenceTreeHash (NSData *data, size_t chunkSize, NSRange chunks) {
+    if (chunks.length == 1) {
+        NSUInteger start = chunks.location * chunkSize;
+        NSMutableData *leaf = [NSMutableData dataWithBytes: &kLeafPrefix length: 1];
+        [leaf appendData: [data subdataWithRange: NSMakeRange(start, MIN(chunkSize, data.length - start))]];
+        return leaf.my_SHA256Digest;
+    }
+    NSUInteger k = 1;
+    while (2*k < chunks.length)
+        k *= 2;
+    MYSHA256Digest *left = referenceTreeHash(data, chunkSize, NSMakeRange(chunks.location, k));
+    MYSHA256Digest *right = referenceTreeHash(data, chunkSize,
+                                              NSMakeRange(chunks.location + k, chunks.length - k));
+    NSMutableData *node = [NSMutableData dataWithBytes: &kNodePrefix length: 1];
+    [node appendData: left.asData];
+    [node appendData: right.asData];
+    return node.my_SHA256Digest;
+}
+
+
+TestCase(MYMerkleTree) {
+    RequireTestCase(MYDigestBuilder);
+    NSMutableData *data = [NSMutableData dataWithLength: 100 * 64 + 17];
+    for (size_t i = 0; i < data.length; i++)
+        ((uint8_t*)data.mutableBytes)[i] = (uint8_t)random();
+
+    // Empty data:
+    MYMerkleTree *tree = [[MYMerkleTree alloc] initWithData: [NSData data] chunkSize: 64];
+    CAssertEq(tree.chunkCount, (NSUInteger)0);
+    CAssertEqual(tree.rootDigest.hexString,
+                 @"E3B0C44298FC1C149AFBF4C8996FB92427AE41E4649B934CA495991B7852B855");
+
+    // Assorted tree sizes up to 101 leaves, compared with the recursive definition:
+    for (NSUInteger length = 1; length <= data.length; length += (length < 1000) ? 63 : 317) {
+        NSData *input = [data subdataWithRange: NSMakeRange(0, length)];
+        tree = [[MYMerkleTree alloc] initWithData: input chunkSize: 64];
+        NSUInteger chunkCount = (length + 63) / 64;
+        CAssertEq(tree.chunkCount, chunkCount);
+        CAssertEqual(tree.rootDigest, referenceTreeHash(input, 64, NSMakeRange(0, chunkCount)));
+
+        for (NSUInteger i = 0; i < chunkCount; i++) {
+            NSData *chunk = [input subdataWithRange: NSMakeRange(64*i, MIN(64, length - 64*i))];
+            NSArray *proof = [tree inclusionProofForChunk: i];
+            CAssert([MYMerkleTree verifyChunk: chunk atIndex: i chunkCount: chunkCount
+                                        proof: proof rootDigest: tree.rootDigest]);
+            // Wrong index, wrong data, wrong tree size, truncated proof:
+            CAssert(![MYMerkleTree verifyChunk: chunk atIndex: i ^ 1 chunkCount: chunkCount
+                                         proof: proof rootDigest: tree.rootDigest]);
+            CAssert(![MYMerkleTree verifyChunk: [chunk subdataWithRange: NSMakeRange(1, chunk.length - 1)]
+                                       atIndex: i chunkCount: chunkCount
+                                         proof: proof rootDigest: tree.rootDigest]);
+            CAssert(![MYMerkleTree verifyChunk: chunk atIndex: i chunkCount: 2*chunkCount
+                                         proof: proof rootDigest: tree.rootDigest]);
+            if (proof.count > 0)
+                CAssert(![MYMerkleTree verifyChunk: chunk atIndex: i chunkCount: chunkCount
+                                             proof: [proof subarrayWithRange: NSMakeRange(0, proof.count - 1)]
+                                        rootDigest: tree.rootDigest]);
+        }
+    }
+
+    // From a file:
+    NSString *path = [NSTemporaryDirectory() stringByAppendingPathComponent: @"MYMerkleTreeTest"];
+    CAssert([data writeToFile: path atomically: NO]);
+    NSError *error;
+    CAssertEqual([MYSHA256Digest treeDigestOfContentsOfFile: path chunkSize: 64 error: &error],
+                 [[MYMerkleTree alloc] initWithData: data chunkSize: 64].rootDigest);
+    [[NSFileManager defaultManager] removeItemAtPath: path error: NULL];
+    CAssertEqual([MYSHA256Digest treeDigestOfContentsOfFile: path chunkSize: 64 error: &error], nil);
+    CAssert(error != nil);
+}
+
+
+TestCase(MYMerkleTreeBenchmark) {
+    RequireTestCase(MYMerkleTree);
+    NSMutableData *data = [NSMutableData dataWithLength: 256 * 1024 * 1024];
+    memset(data.mutableBytes, 0x55, data.length);
+
+    CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+    MYSHA256Digest *digest = data.my_SHA256Digest;
+    CFAbsoluteTime sequentialTime = CFAbsoluteTimeGetCurrent() - start;
+    CAssert(digest);
+
+    start = CFAbsoluteTimeGetCurrent();
+    MYMerkleTree *tree = [[MYMerkleTree alloc] initWithData: data
+                                                  chunkSize: kMYMerkleTreeDefaultChunkSize];
+    CFAbsoluteTime treeTime = CFAbsoluteTimeGetCurrent() - start;
+    CAssertEq(tree.chunkCount, (NSUInteger)256);
+
+    Log(@"Hashing %lu MB: SHA-256 %.0f MB/sec, tree hash %.0f MB/sec on %lu cores (%.1fx)",
+        (unsigned long)(data.length >> 20), data.length / sequentialTime / 1e6,
+        data.length / treeTime / 1e6, (unsigned long)[NSProcessInfo processInfo].activeProcessorCount,
+        sequentialTime / treeTime);
+}
+
+
+
+/*
+ Copyright (c) 2009, Jens Alfke <jens@mooseyard.com>. All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification, are permitted
+ provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice, this list of conditions
+ and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions
+ and the following disclaimer in the documentation and/or other materials provided with the
+ distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRI-
+ BUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
@@ -0,0 +1,201 @@
+//
+//  MYOCSP.h
+//  MYCrypto
+//
+//  Created by Jens Alfke on 10/16/26.
+//  Copyright 2026 Jens Alfke. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+#import "MYCRL.h"
+@class MYCertificateInfo, MYOID;
+
+
+/** Identifies a certificate in an OCSP request or response, by hashes of its issuer's name and
+    public key, plus its serial number. Instances are immutable and can be used as dictionary keys. */
+@interface MYOCSPCertID : NSObject <NSCopying>
+{
+    @private
+    MYOID *_hashAlgorithm;
+    NSData *_issuerNameHash, *_issuerKeyHash, *_serialNumber;
+    NSUInteger _hash;
+}
+
+/** Creates the CertID of a certificate, given the certificate of its issuer.
+    The hashes are SHA-1, as required by the RFC 5019 profile that nearly all responders use. */
++ (MYOCSPCertID*) certIDForCertificate: (MYCertificateInfo*)certificate
+                                issuer: (MYCertificateInfo*)issuer;
+
+/** Returns nil if any of the components is missing. */
+- (id) initWithHashAlgorithm: (MYOID*)hashAlgorithm
+              issuerNameHash: (NSData*)issuerNameHash
+               issuerKeyHash: (NSData*)issuerKeyHash
+                serialNumber: (NSData*)serialNumber;
+
+@property (readonly) MYOID *hashAlgorithm;
+@property (readonly) NSData *issuerNameHash, *issuerKeyHash;
+
+/** The serial number, in the form of -[MYCertificateInfo serialNumber]. */
+@property (readonly) NSData *serialNumber;
+
+@end
+
+
+/** Encodes an OCSP request for the given MYOCSPCertIDs. The request is unsigned and has no
+    nonce, so identical requests can be answered from an HTTP cache. */
+NSData* MYOCSPEncodeRequest (NSArray *certIDs);
+
+
+
+/** The status of one certificate, from an OCSP response. */
+@interface MYOCSPSingleResponse : NSObject
+{
+    @private
+    MYOCSPCertID *_certID;
+    MYRevocationStatus _status;
+    NSDate *_thisUpdate, *_nextUpdate, *_revocationTime;
+    int _revocationReason;
+}
+
+@property (readonly) MYOCSPCertID *certID;
+
+/** The certificate's status. (kMYRevocationUnknown means the responder doesn't know it.) */
+@property (readonly) MYRevocationStatus status;
+
+/** The time at which the status was known to be correct. */
+@property (readonly) NSDate *thisUpdate;
+
+/** The time at or before which newer status will be available, or nil if not specified. */
+@property (readonly) NSDate *nextUpdate;
+
+/** The time the certificate was revoked, or nil if it isn't. */
+@property (readonly) NSDate *revocationTime;
+
+/** The CRLReason code of a revocation, or -1 if not given. */
+@property (readonly) int revocationReason;
+
+@end
+
+
+
+/** The possible values of -[MYOCSPResponse responseStatus]. */
+typedef enum {
+    kMYOCSPSuccessful       = 0,    ///< Response has valid confirmations
+    kMYOCSPMalformedRequest = 1,    ///< Illegal confirmation request
+    kMYOCSPInternalError    = 2,    ///< Internal error in issuer
+    kMYOCSPTryLater         = 3,    ///< Try again later
+    kMYOCSPSigRequired      = 5,    ///< Must sign the request
+    kMYOCSPUnauthorized     = 6     ///< Request unauthorized
+} MYOCSPResponseStatus;
+
+
+/** A parsed OCSP response. Only the basic response type is supported.
+    Instances are immutable, so they can be used from any thread. */
+@interface MYOCSPResponse : NSObject
+{
+    @private
+    NSData *_data;
+    struct MYX509OCSPResponseFields *_fields;
+    NSArray *_responses, *_responderCertificates;
+}
+
+/** Parses a DER-encoded OCSP response.
+    The signature is not checked; call -verifyWithIssuer: for that. */
+- (id) initWithResponseData: (NSData*)data error: (NSError**)outError;
+
+/** The encoded response this was parsed from. */
+@property (readonly) NSData *responseData;
+
+/** The responder's status code. If it's not kMYOCSPSuccessful, there are no other contents. */
+@property (readonly) MYOCSPResponseStatus responseStatus;
+
+/** The time the response was signed. */
+@property (readonly) NSDate *producedAt;
+
+/** The MYOCSPSingleResponses, one per certificate. */
+@property (readonly) NSArray *responses;
+
+/** The certificates included by the responder (MYCertificateInfo objects); usually either empty
+    or a delegated responder certificate. */
+@property (readonly) NSArray *responderCertificates;
+
+@property (readonly) MYOID *signatureAlgorithmID;
+
+/** Returns the status of the certificate with the given CertID, or nil if it isn't included. */
+- (MYOCSPSingleResponse*) responseForCertID: (MYOCSPCertID*)certID;
+
+/** Verifies that the response was signed either by the issuer itself, or by a responder whose
+    certificate is included in the response, was issued by the issuer, and is authorized for
+    OCSP signing. */
+- (BOOL) verifyWithIssuer: (MYCertificateInfo*)issuer;
+
+@end
+
+
+
+/** A callback that sends an OCSP request to a responder and returns the response data.
+    Runs on the thread that asked for the status. */
+typedef NSData* (^MYOCSPFetcher)(NSURL *responderURL, NSData *requestData, NSError **outError);
+
+
+/** A thread-safe, in-memory cache of verified OCSP responses, keyed by CertID.
+    Responses stay usable until their nextUpdate time. The table is split into shards with their
+    own locks, so lookups from many threads don't contend.
+    Network access is up to the client, via the 'fetcher' property. */
+@interface MYOCSPCache : NSObject
+{
+    @private
+    NSArray *_shards;
+    MYOCSPFetcher _fetcher;
+    NSURL *_defaultResponderURL;
+    NSTimeInterval _defaultLifetime;
+}
+
+- (id) init;
+
+/** Initializes a cache with a specific number of shards (the default is 16.) */
+- (id) initWithShardCount: (NSUInteger)shardCount;
+
+/** Called to contact a responder when the cache doesn't have a certificate's status. */
+@property (copy) MYOCSPFetcher fetcher;
+
+/** The responder to ask about certificates that don't name one in their AuthorityInfoAccess. */
+@property (copy) NSURL *defaultResponderURL;
+
+/** How long to keep responses that have no nextUpdate time. Defaults to one hour. */
+@property NSTimeInterval defaultLifetime;
+
+/** The number of certificate statuses cached, including any expired ones not yet removed. */
+@property (readonly) NSUInteger count;
+
+/** The numbers of lookups that were and weren't answered from the cache. */
+@property (readonly) uint64_t hits, misses;
+
+/** Returns the cached status of a certificate, or nil if none is cached or it's expired. */
+- (MYOCSPSingleResponse*) cachedResponseForCertID: (MYOCSPCertID*)certID;
+
+/** Verifies the response against the issuer and caches the statuses it contains for
+    certificates of that issuer. Returns the number of statuses added. */
+- (NSUInteger) addResponse: (MYOCSPResponse*)response issuer: (MYCertificateInfo*)issuer;
+
+/** Returns the status of a certificate, from the cache if possible, else by fetching, verifying
+    and caching a response from its OCSP responder.
+    Concurrent misses on the same certificate may each fetch. */
+- (MYOCSPSingleResponse*) statusOfCertificate: (MYCertificateInfo*)certificate
+                                       issuer: (MYCertificateInfo*)issuer
+                                        error: (NSError**)outError;
+
+/** Returns the status of a certificate from a "stapled" OCSP response, such as one sent by a TLS
+    peer. If the same response has been seen before, the result comes from the cache without
+    parsing or verifying it again. Otherwise the response is parsed, verified and cached. */
+- (MYOCSPSingleResponse*) statusOfCertificate: (MYCertificateInfo*)certificate
+                                       issuer: (MYCertificateInfo*)issuer
+                              stapledResponse: (NSData*)responseData
+                                        error: (NSError**)outError;
+
+/** Removes statuses whose nextUpdate has passed. */
+- (void) removeExpiredResponses;
+
+- (void) removeAllResponses;
+
+@end
@@ -0,0 +1,847 @@
+//
+//  MYOCSP.m
+//  MYCrypto
+//
+//  Created by Jens Alfke on 10/16/26.
+//  Copyright 2026 Jens Alfke. All rights reserved.
+//
+
+// References:
+// <http://tools.ietf.org/html/rfc6960> "X.509 Internet PKI Online Certificate Status Protocol"
+// <http://tools.ietf.org/html/rfc5019> "The Lightweight OCSP Profile for High-Volume Environments"
+
+#import "MYOCSP.h"
+#import "MYCrypto_Private.h"
+#import "MYX509Decoder.h"
+#import "MYCertificateInfo.h"
+#import "MYCertificateExtensions.h"
+#import "MYCanonicalName.h"
+#import "MYDigest.h"
+#import "MYOID.h"
+#import "MYASN1Object.h"
+#import "MYDEREncoder.h"
+#import "MYErrorUtils.h"
+#import "CollectionUtils.h"
+#import "Test.h"
+
+
+#define kDefaultShardCount 16
+#define kDefaultLifetime (60.0*60.0)
+
+
+static NSData* sliceContents (const MYBERSlice *slice) {
+    return [NSData dataWithBytes: slice->contents length: slice->length];
+}
+
+static NSDate* dateOrNil (NSTimeInterval time) {
+    return time ? [NSDate dateWithTimeIntervalSince1970: time] : nil;
+}
+
+/* The SHA-1 digest of the value of a certificate's subjectPublicKey BIT STRING, for any type of
+   key. This is how OCSP identifies an issuer's or responder's key (RFC 6960 sec. 4.1.1.) */
+static NSData* keyHashOf (MYCertificateInfo *cert) {
+    return cert.subjectPublicKeyBits.my_SHA1Digest.asData;
+}
+
+
+
+@implementation MYOCSPCertID
+
+
++ (MYOCSPCertID*) certIDForCertificate: (MYCertificateInfo*)certificate
+                                issuer: (MYCertificateInfo*)issuer
+{
+    NSData *serialNumber = certificate.serialNumber;
+    if (!serialNumber)
+        return nil;
+    return [[self alloc] initWithHashAlgorithm: [MYOID OIDWithKnownID: kMYOIDSHA1]
+                                issuerNameHash: certificate.issuerData.my_SHA1Digest.asData
+                                 issuerKeyHash: keyHashOf(issuer)
+                                  serialNumber: serialNumber];
+}
+
+
+- (id) initWithHashAlgorithm: (MYOID*)hashAlgorithm
+              issuerNameHash: (NSData*)issuerNameHash
+               issuerKeyHash: (NSData*)issuerKeyHash
+                serialNumber: (NSData*)serialNumber
+{
+    if (!hashAlgorithm || !issuerNameHash || !issuerKeyHash || !serialNumber)
+        return nil;
+    self = [super init];
+    if (self) {
+        _hashAlgorithm = hashAlgorithm;
+        _issuerNameHash = [issuerNameHash copy];
+        _issuerKeyHash = [issuerKeyHash copy];
+        _serialNumber = [serialNumber copy];
+        // FNV-1a over the serial number and key hash; the name hash adds nothing, since a
+        // key hash already identifies the issuer.
+        uint64_t h = 14695981039346656037ull;
+        for (NSData *data in @[_serialNumber, _issuerKeyHash]) {
+            const uint8_t *bytes = data.bytes;
+            for (NSUInteger i = 0; i < data.length; i++)
+                h = (h ^ bytes[i]) * 1099511628211ull;
+        }
+        _hash = (NSUInteger)h;
+    }
+    return self;
+}
+
+
+- (id) copyWithZone: (NSZone*)zone {
+    return self;
+}
+
+
+@synthesize hashAlgorithm=_hashAlgorithm, issuerNameHash=_issuerNameHash,
+            issuerKeyHash=_issuerKeyHash, serialNumber=_serialNumber;
+
+
+- (NSUInteger) hash {
+    return _hash;
+}
+
+- (BOOL) isEqual: (id)object {
+    if (object == self)
+        return YES;
+    MYOCSPCertID *other = $castIf(MYOCSPCertID, object);
+    return other && other->_hash == _hash
+        && [other->_serialNumber isEqual: _serialNumber]
+        && [other->_issuerKeyHash isEqual: _issuerKeyHash]
+        && [other->_issuerNameHash isEqual: _issuerNameHash]
+        && [other->_hashAlgorithm isEqual: _hashAlgorithm];
+}
+
+
+- (NSString*) description {
+    return $sprintf(@"%@[serial %@, issuer key %@]", self.class, _serialNumber, _issuerKeyHash);
+}
+
+
+@end
+
+
+
+/*  OCSPRequest ::= SEQUENCE {
+        tbsRequest                  TBSRequest,
+        optionalSignature   [0]     EXPLICIT Signature OPTIONAL }
+    TBSRequest ::= SEQUENCE {
+        version             [0]     EXPLICIT Version DEFAULT v1,
+        requestorName       [1]     EXPLICIT GeneralName OPTIONAL,
+        requestList                 SEQUENCE OF Request,
+        requestExtensions   [2]     EXPLICIT Extensions OPTIONAL }
+    Request ::= SEQUENCE {
+        reqCert                     CertID,
+        singleRequestExtensions [0] EXPLICIT Extensions OPTIONAL } */
+NSData* MYOCSPEncodeRequest (NSArray *certIDs) {
+    NSMutableArray *requestList = [NSMutableArray arrayWithCapacity: certIDs.count];
+    for (MYOCSPCertID *certID in certIDs) {
+        MYASN1BigInteger *serial = [[MYASN1BigInteger alloc] initWithSignedData: certID.serialNumber];
+        NSArray *reqCert = @[ @[certID.hashAlgorithm, [NSNull null]],
+                              certID.issuerNameHash,
+                              certID.issuerKeyHash,
+                              serial ];
+        [requestList addObject: @[reqCert]];
+    }
+    return [MYDEREncoder encodeRootObject: @[ @[requestList] ] error: NULL];
+}
+
+
+
+
+@interface MYOCSPSingleResponse ()
+- (id) initWithFields: (const MYX509OCSPSingleResponse*)fields;
+@end
+
+
+@implementation MYOCSPSingleResponse
+
+
+- (id) initWithFields: (const MYX509OCSPSingleResponse*)f {
+    self = [super init];
+    if (self) {
+        MYOID *algorithm = [MYOID OIDWithBERBytes: f->hashAlgorithmOID.contents
+                                           length: f->hashAlgorithmOID.length];
+        _certID = [[MYOCSPCertID alloc] initWithHashAlgorithm: algorithm
+                                               issuerNameHash: sliceContents(&f->issuerNameHash)
+                                                issuerKeyHash: sliceContents(&f->issuerKeyHash)
+                                                 serialNumber: sliceContents(&f->serialNumber)];
+        static const MYRevocationStatus kStatuses[3] = {kMYRevocationGood, kMYRevocationRevoked,
+                                                        kMYRevocationUnknown};
+        _status = kStatuses[f->certStatus];
+        _thisUpdate = dateOrNil(f->thisUpdate);
+        _nextUpdate = dateOrNil(f->nextUpdate);
+        _revocationTime = dateOrNil(f->revocationTime);
+        _revocationReason = f->revocationReason;
+    }
+    return self;
+}
+
+
+@synthesize certID=_certID, status=_status, thisUpdate=_thisUpdate, nextUpdate=_nextUpdate,
+            revocationTime=_revocationTime, revocationReason=_revocationReason;
+
+
+- (NSString*) description {
+    static NSString* const kNames[3] = {@"unknown", @"good", @"revoked"};
+    return $sprintf(@"%@[%@: %@, until %@]",
+                    self.class, _certID.serialNumber, kNames[_status], _nextUpdate);
+}
+
+
+@end
+
+
+
+
+@implementation MYOCSPResponse
+
+
+- (id) initWithResponseData: (NSData*)data error: (NSError**)outError {
+    if (outError) *outError = nil;
+    self = [super init];
+    if (self) {
+        _data = [data copy];
+        _fields = malloc(sizeof(MYX509OCSPResponseFields));
+        if (!_fields) {
+            if (outError) *outError = MYError(1, MYASN1ErrorDomain, @"Out of memory");
+            return nil;
+        }
+        if (!MYX509DecodeOCSPResponse(_data.bytes, _data.length, _fields, outError))
+            return nil;
+
+        NSMutableArray *responses = $marray();
+        MYX509OCSPSingleResponse single;
+        MYBERCursor cursor = MYBERSliceGetCursor(&_fields->responses);
+        while (MYX509NextOCSPSingleResponse(&cursor, &single))
+            [responses addObject: [[MYOCSPSingleResponse alloc] initWithFields: &single]];
+        if (!MYBERCursorAtEnd(&cursor)) {
+            if (outError) *outError = MYError(2, MYASN1ErrorDomain,
+                                              @"Invalid OCSP response: bad SingleResponse");
+            return nil;
+        }
+        _responses = [responses copy];
+
+        NSMutableArray *certs = $marray();
+        MYBERSlice certSlice;
+        cursor = MYBERSliceGetCursor(&_fields->certs);
+        while (MYBERCursorNext(&cursor, &certSlice, NULL)) {
+            NSData *certData = [NSData dataWithBytes: MYBERSliceGetEncoding(&certSlice)
+                                              length: MYBERSliceGetEncodingLength(&certSlice)];
+            MYCertificateInfo *cert = [[MYCertificateInfo alloc] initWithCertificateData: certData
+                                                                                   error: outError];
+            if (!cert)
+                return nil;
+            [certs addObject: cert];
+        }
+        _responderCertificates = [certs copy];
+    }
+    return self;
+}
+
+- (void) dealloc {
+    free(_fields);
+}
+
+
+- (NSData*) responseData                    {return _data;}
+- (MYOCSPResponseStatus) responseStatus     {return _fields->responseStatus;}
+- (NSDate*) producedAt                      {return dateOrNil(_fields->producedAt);}
+- (NSArray*) responses                      {return _responses;}
+- (NSArray*) responderCertificates          {return _responderCertificates;}
+
+- (MYOID*) signatureAlgorithmID {
+    const MYBERSlice *oid = &_fields->signatureAlgorithmOID;
+    if (!MYX509FieldIsPresent(oid))
+        return nil;
+    return [MYOID OIDWithBERBytes: oid->contents length: oid->length];
+}
+
+
+- (MYOCSPSingleResponse*) responseForCertID: (MYOCSPCertID*)certID {
+    for (MYOCSPSingleResponse *response in _responses) {
+        if ([response.certID isEqual: certID])
+            return response;
+    }
+    return nil;
+}
+
+
+/* Does the responderID identify the subject of this certificate? */
+- (BOOL) _responderIs: (MYCertificateInfo*)cert {
+    const MYBERSlice *keyHash = &_fields->responderKeyHash;
+    if (MYX509FieldIsPresent(keyHash)) {
+        NSData *digest = keyHashOf(cert);
+        return digest.length == keyHash->length
+            && memcmp(digest.bytes, keyHash->contents, keyHash->length) == 0;
+    } else {
+        const MYBERSlice *name = &_fields->responderName;
+        NSData *nameData = [NSData dataWithBytesNoCopy: (void*)MYBERSliceGetEncoding(name)
+                                                length: MYBERSliceGetEncodingLength(name)
+                                          freeWhenDone: NO];
+        MYCanonicalName *canonical = [[MYCanonicalName alloc] initWithEncodedName: nameData];
+        return [canonical isEqual: cert.canonicalSubject];
+    }
+}
+
+
+- (BOOL) verifyWithIssuer: (MYCertificateInfo*)issuer {
+    if (_fields->responseStatus != kMYOCSPSuccessful)
+        return NO;
+    // Find the signer: either the issuer, or a responder it has authorized (RFC 6960 4.2.2.2):
+    MYPublicKey *issuerKey = issuer.subjectPublicKey;
+    MYPublicKey *signerKey = nil;
+    if ([self _responderIs: issuer]) {
+        signerKey = issuerKey;
+    } else {
+        MYOID *OCSPSigning = [MYOID OIDWithKnownID: kMYOIDOCSPSigning];
+        for (MYCertificateInfo *cert in _responderCertificates) {
+            if ([self _responderIs: cert]
+                    && [cert.canonicalIssuer isEqual: issuer.canonicalSubject]
+                    && [cert.extensions.extendedKeyUsage containsObject: OCSPSigning]
+                    && [cert verifySignatureWithKey: issuerKey]) {
+                signerKey = cert.subjectPublicKey;
+                break;
+            }
+        }
+    }
+    if (!signerKey)
+        return NO;
+
+    const MYBERSlice *tbs = &_fields->tbsResponseData;
+    NSData *signedData = [NSData dataWithBytesNoCopy: (void*)MYBERSliceGetEncoding(tbs)
+                                              length: MYBERSliceGetEncodingLength(tbs)
+                                        freeWhenDone: NO];
+    size_t sigLength;
+    const uint8_t *sig = MYX509BitStringBytes(&_fields->signature, &sigLength);
+    NSData *signature = [NSData dataWithBytesNoCopy: (void*)sig length: sigLength freeWhenDone: NO];
+    return MYVerifySignedData(signedData, signature, self.signatureAlgorithmID, signerKey);
+}
+
+
+- (NSString*) description {
+    return $sprintf(@"%@[status %d, %lu responses]",
+                    self.class, _fields->responseStatus, (unsigned long)_responses.count);
+}
+
+
+@end
+
+
+
+
+/** A cached status. Also remembers the response it came from, so a stapled copy of the same
+    response can be recognized with a byte comparison instead of being parsed. */
+@interface MYOCSPCacheEntry : NSObject
+{
+    @public
+    MYOCSPSingleResponse *_response;
+    NSData *_responseData;
+    CFAbsoluteTime _expires;
+}
+@end
+
+@implementation MYOCSPCacheEntry
+@end
+
+
+/** One shard of the cache: a dictionary and its statistics, guarded by @synchronized(shard). */
+@interface MYOCSPCacheShard : NSObject
+{
+    @public
+    NSMutableDictionary *_entries;          // MYOCSPCertID -> MYOCSPCacheEntry
+    uint64_t _hits, _misses;
+}
+@end
+
+@implementation MYOCSPCacheShard
+@end
+
+
+
+@interface MYOCSPCache ()
+- (MYOCSPSingleResponse*) _cachedResponseForCertID: (MYOCSPCertID*)certID
+                                      responseData: (NSData*)responseData
+                                            atTime: (CFAbsoluteTime)now;
+- (CFAbsoluteTime) _expirationOfResponse: (MYOCSPSingleResponse*)single;
+@end
+
+
+@implementation MYOCSPCache
+
+
+- (id) init {
+    return [self initWithShardCount: kDefaultShardCount];
+}
+
+- (id) initWithShardCount: (NSUInteger)shardCount {
+    Assert(shardCount > 0);
+    self = [super init];
+    if (self) {
+        NSMutableArray *shards = [NSMutableArray arrayWithCapacity: shardCount];
+        for (NSUInteger i = 0; i < shardCount; i++) {
+            MYOCSPCacheShard *shard = [[MYOCSPCacheShard alloc] init];
+            shard->_entries = [[NSMutableDictionary alloc] init];
+            [shards addObject: shard];
+        }
+        _shards = [shards copy];
+        _defaultLifetime = kDefaultLifetime;
+    }
+    return self;
+}
+
+
+@synthesize fetcher=_fetcher, defaultResponderURL=_defaultResponderURL,
+            defaultLifetime=_defaultLifetime;
+
+
+- (MYOCSPCacheShard*) _shardForCertID: (MYOCSPCertID*)certID {
+    // Use the high bits of the hash, since NSDictionary uses the low ones:
+    uint64_t h = certID.hash;
+    return _shards[(NSUInteger)((h >> 32) ^ (h >> 16)) % _shards.count];
+}
+
+
+- (NSUInteger) count {
+    NSUInteger count = 0;
+    for (MYOCSPCacheShard *shard in _shards) {
+        @synchronized(shard) {
+            count += shard->_entries.count;
+        }
+    }
+    return count;
+}
+
+- (uint64_t) hits {
+    uint64_t hits = 0;
+    for (MYOCSPCacheShard *shard in _shards) {
+        @synchronized(shard) {
+            hits += shard->_hits;
+        }
+    }
+    return hits;
+}
+
+- (uint64_t) misses {
+    uint64_t misses = 0;
+    for (MYOCSPCacheShard *shard in _shards) {
+        @synchronized(shard) {
+            misses += shard->_misses;
+        }
+    }
+    return misses;
+}
+
+
+/* Looks up a status that's still current at the given time. If responseData is non-nil, the
+   status only counts if it came from that same response. */
+- (MYOCSPSingleResponse*) _cachedResponseForCertID: (MYOCSPCertID*)certID
+                                      responseData: (NSData*)responseData
+                                            atTime: (CFAbsoluteTime)now
+{
+    if (!certID)
+        return nil;
+    MYOCSPCacheShard *shard = [self _shardForCertID: certID];
+    @synchronized(shard) {
+        MYOCSPCacheEntry *entry = shard->_entries[certID];
+        if (entry && now < entry->_expires
+                  && (!responseData || [responseData isEqual: entry->_responseData])) {
+            ++shard->_hits;
+            return entry->_response;
+        }
+        ++shard->_misses;
+        return nil;
+    }
+}
+
+- (MYOCSPSingleResponse*) cachedResponseForCertID: (MYOCSPCertID*)certID {
+    return [self _cachedResponseForCertID: certID
+                             responseData: nil
+                                   atTime: CFAbsoluteTimeGetCurrent()];
+}
+
+
+/* The time a status stops being usable: its nextUpdate, or if it has none, its thisUpdate plus
+   the default lifetime. */
+- (CFAbsoluteTime) _expirationOfResponse: (MYOCSPSingleResponse*)single {
+    if (single.nextUpdate)
+        return single.nextUpdate.timeIntervalSinceReferenceDate;
+    else
+        return single.thisUpdate.timeIntervalSinceReferenceDate + _defaultLifetime;
+}
+
+
+/* Adds the statuses of an already-verified response that apply to the issuer's certificates.
+   An older status never replaces a newer one. */
+- (NSUInteger) _addVerifiedResponse: (MYOCSPResponse*)response issuer: (MYCertificateInfo*)issuer {
+    NSData *issuerKeyHash = keyHashOf(issuer);
+    if (!issuerKeyHash)
+        return 0;
+    CFAbsoluteTime now = CFAbsoluteTimeGetCurrent();
+    NSUInteger added = 0;
+    for (MYOCSPSingleResponse *single in response.responses) {
+        MYOCSPCertID *certID = single.certID;
+        if (certID.hashAlgorithm.knownID != kMYOIDSHA1
+                || ![certID.issuerKeyHash isEqual: issuerKeyHash])
+            continue;
+        CFAbsoluteTime expires = [self _expirationOfResponse: single];
+        if (expires <= now)
+            continue;
+        MYOCSPCacheEntry *entry = [[MYOCSPCacheEntry alloc] init];
+        entry->_response = single;
+        entry->_responseData = response.responseData;
+        entry->_expires = expires;
+        MYOCSPCacheShard *shard = [self _shardForCertID: certID];
+        @synchronized(shard) {
+            MYOCSPCacheEntry *existing = shard->_entries[certID];
+            if (!existing || [existing->_response.thisUpdate compare: single.thisUpdate]
+                                != NSOrderedDescending) {
+                shard->_entries[certID] = entry;
+                ++added;
+            }
+        }
+    }
+    return added;
+}
+
+- (NSUInteger) addResponse: (MYOCSPResponse*)response issuer: (MYCertificateInfo*)issuer {
+    if (![response verifyWithIssuer: issuer])
+        return 0;
+    return [self _addVerifiedResponse: response issuer: issuer];
+}
+
+
+/* Parses, verifies and caches a response, and returns its status for the given certificate. */
+- (MYOCSPSingleResponse*) _statusOfCertID: (MYOCSPCertID*)certID
+                                   issuer: (MYCertificateInfo*)issuer
+                             responseData: (NSData*)responseData
+                                    error: (NSError**)outError
+{
+    MYOCSPResponse *response = [[MYOCSPResponse alloc] initWithResponseData: responseData
+                                                                      error: outError];
+    if (!response)
+        return nil;
+    if (response.responseStatus != kMYOCSPSuccessful) {
+        if (outError) *outError = MYError(7, MYASN1ErrorDomain,
+                                          @"OCSP responder returned error %d",
+                                          response.responseStatus);
+        return nil;
+    }
+    if (![response verifyWithIssuer: issuer]) {
+        if (outError) *outError = MYError(4, MYASN1ErrorDomain,
+                                          @"OCSP response signature is not valid");
+        return nil;
+    }
+    [self _addVerifiedResponse: response issuer: issuer];
+    MYOCSPSingleResponse *single = [response responseForCertID: certID];
+    if (!single || [self _expirationOfResponse: single] <= CFAbsoluteTimeGetCurrent()) {
+        if (outError) *outError = MYError(8, MYASN1ErrorDomain,
+                                          @"OCSP response has no current status for the certificate");
+        return nil;
+    }
+    return single;
+}
+
+
+- (MYOCSPSingleResponse*) statusOfCertificate: (MYCertificateInfo*)certificate
+                                       issuer: (MYCertificateInfo*)issuer
+                                        error: (NSError**)outError
+{
+    if (outError) *outError = nil;
+    MYOCSPCertID *certID = [MYOCSPCertID certIDForCertificate: certificate issuer: issuer];
+    MYOCSPSingleResponse *single = [self cachedResponseForCertID: certID];
+    if (single)
+        return single;
+
+    MYOCSPFetcher fetcher = self.fetcher;
+    NSString *location = certificate.extensions.OCSPResponders.firstObject;
+    NSURL *responderURL = location ? [NSURL URLWithString: location] : self.defaultResponderURL;
+    if (!certID || !fetcher || !responderURL) {
+        if (outError) *outError = MYError(6, MYASN1ErrorDomain,
+                                          @"No OCSP responder is available for the certificate");
+        return nil;
+    }
+    NSData *responseData = fetcher(responderURL, MYOCSPEncodeRequest(@[certID]), outError);
+    if (!responseData)
+        return nil;
+    return [self _statusOfCertID: certID issuer: issuer responseData: responseData error: outError];
+}
+
+
+- (MYOCSPSingleResponse*) statusOfCertificate: (MYCertificateInfo*)certificate
+                                       issuer: (MYCertificateInfo*)issuer
+                              stapledResponse: (NSData*)responseData
+                                        error: (NSError**)outError
+{
+    if (outError) *outError = nil;
+    MYOCSPCertID *certID = [MYOCSPCertID certIDForCertificate: certificate issuer: issuer];
+    MYOCSPSingleResponse *single = [self _cachedResponseForCertID: certID
+                                                     responseData: responseData
+                                                           atTime: CFAbsoluteTimeGetCurrent()];
+    if (single)
+        return single;
+    return [self _statusOfCertID: certID issuer: issuer responseData: responseData error: outError];
+}
+
+
+- (void) removeExpiredResponses {
+    CFAbsoluteTime now = CFAbsoluteTimeGetCurrent();
+    for (MYOCSPCacheShard *shard in _shards) {
+        @synchronized(shard) {
+            NSMutableArray *expired = $marray();
+            [shard->_entries enumerateKeysAndObjectsUsingBlock: ^(id certID, id obj, BOOL *stop) {
+                MYOCSPCacheEntry *entry = obj;
+                if (entry->_expires <= now)
+                    [expired addObject: certID];
+            }];
+            [shard->_entries removeObjectsForKeys: expired];
+        }
+    }
+}
+
+- (void) removeAllResponses {
+    for (MYOCSPCacheShard *shard in _shards) {
+        @synchronized(shard) {
+            [shard->_entries removeAllObjects];
+        }
+    }
+}
+
+
+@end
+
+
+
+
+#pragma mark -
+#pragma mark TEST CASES:
+
+
+#define $data(BYTES...)    ({const uint8_t bytes[] = {BYTES}; [NSData dataWithBytes: bytes length: sizeof(bytes)];})
+
+static MYCertificateInfo* readCert (NSString *name) {
+    NSData *data = [NSData dataWithContentsOfFile: [name stringByAppendingPathExtension: @"cer"]];
+    CAssert(data, @"Couldn't read %@", name);
+    MYCertificateInfo *cert = [[MYCertificateInfo alloc] initWithCertificateData: data error: NULL];
+    CAssert(cert);
+    return cert;
+}
+
+static NSData* readResponse (NSString *name) {
+    NSData *data = [NSData dataWithContentsOfFile: [name stringByAppendingPathExtension: @"der"]];
+    CAssert(data, @"Couldn't read %@", name);
+    return data;
+}
+
+
+TestCase(MYOCSPRequest) {
+    MYCertificateInfo *ca = readCert(@"testca");
+    MYCertificateInfo *good = readCert(@"testca_good");
+    MYOCSPCertID *certID = [MYOCSPCertID certIDForCertificate: good issuer: ca];
+    CAssertEqual(certID.serialNumber, $data(0x12, 0x35));
+    CAssertEqual(certID.issuerKeyHash, ca.subjectKeyIdentifier);
+    CAssertEqual(certID, [certID copy]);
+    CAssert(![certID isEqual: [MYOCSPCertID certIDForCertificate: readCert(@"testca_revoked")
+                                                          issuer: ca]]);
+    // Must match the request OpenSSL generates:
+    CAssertEqual(MYOCSPEncodeRequest(@[certID]), readResponse(@"testca_ocsp_request"));
+
+    // An issuer with an EC key is identified by the hash of its key bits just the same:
+    MYCertificateInfo *ecCA = readCert(@"testca_ec");
+    CAssertNil(ecCA.subjectPublicKeyData);
+    MYOCSPCertID *ecCertID = [MYOCSPCertID certIDForCertificate: readCert(@"testca_ec_leaf")
+                                                         issuer: ecCA];
+    CAssert(ecCertID);
+    CAssertEqual(ecCertID.issuerKeyHash, ecCA.subjectKeyIdentifier);
+    CAssertEqual(MYOCSPEncodeRequest(@[ecCertID]), readResponse(@"testca_ec_ocsp_request"));
+
+    // A missing component makes the initializer fail instead of raising:
+    CAssertNil([[MYOCSPCertID alloc] initWithHashAlgorithm: certID.hashAlgorithm
+                                            issuerNameHash: certID.issuerNameHash
+                                             issuerKeyHash: nil
+                                              serialNumber: certID.serialNumber]);
+}
+
+
+TestCase(MYOCSPResponse) {
+    RequireTestCase(X509DecodeOCSPResponse);
+    RequireTestCase(MYOCSPRequest);
+    MYCertificateInfo *ca = readCert(@"testca");
+    MYCertificateInfo *revoked = readCert(@"testca_revoked");
+    MYCertificateInfo *good = readCert(@"testca_good");
+    MYCertificateInfo *other = readCert(@"selfsigned");
+
+    // Signed by the CA itself:
+    NSError *error = nil;
+    NSData *data = readResponse(@"testca_ocsp_revoked");
+    MYOCSPResponse *response = [[MYOCSPResponse alloc] initWithResponseData: data error: &error];
+    CAssert(response, @"Couldn't parse OCSP response: %@", error);
+    Log(@"Response = %@", response);
+    CAssertEq(response.responseStatus, kMYOCSPSuccessful);
+    CAssertEq(response.responses.count, (NSUInteger)1);
+    CAssertEq(response.responderCertificates.count, (NSUInteger)0);
+    CAssertEq(response.signatureAlgorithmID.knownID, kMYOIDRSAWithSHA256);
+    MYOCSPSingleResponse *single = [response responseForCertID:
+                                        [MYOCSPCertID certIDForCertificate: revoked issuer: ca]];
+    CAssert(single);
+    CAssertEq(single.status, kMYRevocationRevoked);
+    CAssertEqual(single.revocationTime,
+                 [NSDate dateWithTimeIntervalSince1970: 1790856000]);    // 2026-10-01 12:00:00Z
+    CAssertEq(single.revocationReason, -1);
+    CAssert([single.nextUpdate compare: single.thisUpdate] == NSOrderedDescending);
+    CAssertEqual([response responseForCertID: [MYOCSPCertID certIDForCertificate: good issuer: ca]],
+                 nil);
+    CAssert([response verifyWithIssuer: ca]);
+    CAssert(![response verifyWithIssuer: other]);
+
+    NSMutableData *altered = [data mutableCopy];
+    ((uint8_t*)altered.mutableBytes)[altered.length - 1] ^= 0x01;
+    response = [[MYOCSPResponse alloc] initWithResponseData: altered error: NULL];
+    CAssert(response);
+    CAssert(![response verifyWithIssuer: ca]);
+
+    // Signed by a delegated responder, whose certificate is included:
+    response = [[MYOCSPResponse alloc] initWithResponseData: readResponse(@"testca_ocsp_good")
+                                                      error: &error];
+    CAssert(response, @"Couldn't parse OCSP response: %@", error);
+    CAssertEq(response.responderCertificates.count, (NSUInteger)1);
+    single = [response responseForCertID: [MYOCSPCertID certIDForCertificate: good issuer: ca]];
+    CAssertEq(single.status, kMYRevocationGood);
+    CAssertEqual(single.revocationTime, nil);
+    CAssert([response verifyWithIssuer: ca]);
+    CAssert(![response verifyWithIssuer: other]);
+
+    // Error responses:
+    response = [[MYOCSPResponse alloc] initWithResponseData: $data(0x30, 0x03, 0x0A, 0x01, 0x03)
+                                                      error: &error];
+    CAssertEq(response.responseStatus, kMYOCSPTryLater);
+    CAssertEq(response.responses.count, (NSUInteger)0);
+    CAssert(![response verifyWithIssuer: ca]);
+    CAssertEqual([[MYOCSPResponse alloc] initWithResponseData: $data(0x30, 0x00) error: &error],
+                 nil);
+    CAssertEqual(error.domain, MYASN1ErrorDomain);
+}
+
+
+TestCase(MYOCSPCache) {
+    RequireTestCase(MYOCSPResponse);
+    MYCertificateInfo *ca = readCert(@"testca");
+    MYCertificateInfo *revoked = readCert(@"testca_revoked");
+    MYCertificateInfo *good = readCert(@"testca_good");
+    NSData *revokedResponse = readResponse(@"testca_ocsp_revoked");
+    NSData *goodResponse = readResponse(@"testca_ocsp_good");
+    NSData *goodRequest = readResponse(@"testca_ocsp_request");
+
+    // A stand-in for a responder, serving the canned responses:
+    MYOCSPCache *cache = [[MYOCSPCache alloc] init];
+    NSError *error = nil;
+    CAssertEqual([cache statusOfCertificate: good issuer: ca error: &error], nil);
+    CAssertEq(error.code, 6);
+    __block int fetches = 0;
+    cache.defaultResponderURL = [NSURL URLWithString: @"http://ocsp.example.com"];
+    cache.fetcher = ^NSData*(NSURL *url, NSData *request, NSError **outError) {
+        ++fetches;
+        CAssertEqual(url.host, @"ocsp.example.com");
+        return [request isEqual: goodRequest] ? goodResponse : revokedResponse;
+    };
+
+    MYOCSPSingleResponse *status = [cache statusOfCertificate: good issuer: ca error: &error];
+    CAssert(status, @"Status lookup failed: %@", error);
+    CAssertEq(status.status, kMYRevocationGood);
+    CAssertEq(fetches, 1);
+    CAssert([cache statusOfCertificate: good issuer: ca error: &error] == status);
+    CAssertEq(fetches, 1);
+    status = [cache statusOfCertificate: revoked issuer: ca error: &error];
+    CAssertEq(status.status, kMYRevocationRevoked);
+    CAssertEq(fetches, 2);
+    CAssertEq(cache.count, (NSUInteger)2);
+    CAssertEq(cache.hits, (uint64_t)1);
+    CAssertEq(cache.misses, (uint64_t)3);
+
+    // A response that fails verification isn't used or cached:
+    MYCertificateInfo *other = readCert(@"selfsigned");
+    CAssertEqual([cache statusOfCertificate: good issuer: other error: &error], nil);
+    CAssertEq(error.code, 4);
+    CAssertEq(cache.count, (NSUInteger)2);
+
+    // Statuses expire at their nextUpdate:
+    MYOCSPCertID *certID = [MYOCSPCertID certIDForCertificate: good issuer: ca];
+    CFAbsoluteTime nextUpdate = [cache cachedResponseForCertID: certID].nextUpdate
+                                                                     .timeIntervalSinceReferenceDate;
+    CAssert([cache _cachedResponseForCertID: certID responseData: nil atTime: nextUpdate - 1]);
+    CAssertEqual([cache _cachedResponseForCertID: certID responseData: nil atTime: nextUpdate],
+                 nil);
+    // ...or, if they have none, at thisUpdate plus the default lifetime:
+    MYX509OCSPResponseFields f;
+    CAssert(MYX509DecodeOCSPResponse(goodResponse.bytes, goodResponse.length, &f, NULL));
+    MYBERCursor cursor = MYBERSliceGetCursor(&f.responses);
+    MYX509OCSPSingleResponse fields;
+    CAssert(MYX509NextOCSPSingleResponse(&cursor, &fields));
+    fields.nextUpdate = 0;
+    fields.thisUpdate = [NSDate date].timeIntervalSince1970 - 10;
+    MYOCSPSingleResponse *recent = [[MYOCSPSingleResponse alloc] initWithFields: &fields];
+    fields.thisUpdate -= cache.defaultLifetime;
+    MYOCSPSingleResponse *old = [[MYOCSPSingleResponse alloc] initWithFields: &fields];
+    CAssertEqual(recent.nextUpdate, nil);
+    CAssert([cache _expirationOfResponse: recent] > CFAbsoluteTimeGetCurrent());
+    CAssert([cache _expirationOfResponse: old] <= CFAbsoluteTimeGetCurrent());
+
+    // Stapled responses: the first is parsed and cached, the same bytes again are a hit:
+    [cache removeAllResponses];
+    CAssertEq(cache.count, (NSUInteger)0);
+    status = [cache statusOfCertificate: revoked issuer: ca
+                        stapledResponse: revokedResponse error: &error];
+    CAssertEq(status.status, kMYRevocationRevoked);
+    uint64_t hits = cache.hits;
+    CAssert([cache statusOfCertificate: revoked issuer: ca
+                       stapledResponse: [revokedResponse mutableCopy] error: &error] == status);
+    CAssertEq(cache.hits, hits + 1);
+    // ...but a stapled response that doesn't cover the certificate is an error:
+    CAssertEqual([cache statusOfCertificate: good issuer: ca
+                            stapledResponse: revokedResponse error: &error], nil);
+    CAssertEq(error.code, 8);
+    CAssertEq(fetches, 3);
+
+    CAssertEq([cache addResponse: [[MYOCSPResponse alloc] initWithResponseData: goodResponse
+                                                                         error: NULL]
+                          issuer: ca], (NSUInteger)1);
+    CAssertEq(cache.count, (NSUInteger)2);
+    [cache removeExpiredResponses];
+    CAssertEq(cache.count, (NSUInteger)2);
+
+    // Time stapled-status lookups, which is what a busy TLS endpoint would do:
+    static const int kIterations = 100000;
+    CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+    for (int i = 0; i < kIterations; i++) {
+        @autoreleasepool {
+            [cache statusOfCertificate: revoked issuer: ca stapledResponse: revokedResponse
+                                 error: NULL];
+        }
+    }
+    Log(@"Stapled OCSP status lookup: %.2fus",
+        (CFAbsoluteTimeGetCurrent() - start) / kIterations * 1e6);
+}
+
+
+
+/*
+ Copyright (c) 2009, Jens Alfke <jens@mooseyard.com>. All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification, are permitted
+ provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice, this list of conditions
+ and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions
+ and the following disclaimer in the documentation and/or other materials provided with the
+ distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRI-
+ BUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
@@ -9,17 +9,70 @@
 #import <Foundation/Foundation.h>
 
 
+/** Small integer IDs of well-known OIDs. Every MYOID with one of these values -- whether parsed,
+    created from components, or obtained from +OIDWithKnownID: -- is the same shared instance,
+    so they can be compared with == or dispatched on with a switch statement. */
+typedef enum {
+    kMYOIDUnknown = 0,          ///< Not a well-known OID
+    // Algorithms:
+    kMYOIDRSAEncryption,        ///< 1.2.840.113549.1.1.1
+    kMYOIDRSAWithMD2,           ///< 1.2.840.113549.1.1.2
+    kMYOIDRSAWithMD5,           ///< 1.2.840.113549.1.1.4
+    kMYOIDRSAWithSHA1,          ///< 1.2.840.113549.1.1.5
+    kMYOIDRSAWithSHA256,        ///< 1.2.840.113549.1.1.11
+    kMYOIDRSAWithSHA384,        ///< 1.2.840.113549.1.1.12
+    kMYOIDRSAWithSHA512,        ///< 1.2.840.113549.1.1.13
+    kMYOIDSHA1,                 ///< 1.3.14.3.2.26
+    // Name attributes:
+    kMYOIDCommonName,           ///< 2.5.4.3
+    kMYOIDSurname,              ///< 2.5.4.4
+    kMYOIDDescription,          ///< 2.5.4.13
+    kMYOIDGivenName,            ///< 2.5.4.42
+    kMYOIDEmailAddress,         ///< 1.2.840.113549.1.9.1
+    // Extensions:
+    kMYOIDSubjectKeyIdentifier, ///< 2.5.29.14
+    kMYOIDKeyUsage,             ///< 2.5.29.15
+    kMYOIDSubjectAltName,       ///< 2.5.29.17
+    kMYOIDBasicConstraints,     ///< 2.5.29.19
+    kMYOIDCRLDistributionPoints, ///< 2.5.29.31
+    kMYOIDAuthorityKeyIdentifier, ///< 2.5.29.35
+    kMYOIDExtendedKeyUsage,     ///< 2.5.29.37
+    kMYOIDAuthorityInfoAccess,  ///< 1.3.6.1.5.5.7.1.1
+    // Extended key usages:
+    kMYOIDAnyExtendedKeyUsage,  ///< 2.5.29.37.0
+    kMYOIDServerAuth,           ///< 1.3.6.1.5.5.7.3.1
+    kMYOIDClientAuth,           ///< 1.3.6.1.5.5.7.3.2
+    kMYOIDCodeSigning,          ///< 1.3.6.1.5.5.7.3.3
+    kMYOIDEmailProtection,      ///< 1.3.6.1.5.5.7.3.4
+    kMYOIDOCSPSigning,          ///< 1.3.6.1.5.5.7.3.9
+    // OCSP:
+    kMYOIDOCSP,                 ///< 1.3.6.1.5.5.7.48.1
+    kMYOIDOCSPBasicResponse,    ///< 1.3.6.1.5.5.7.48.1.1
+
+    kMYOIDKnownCount
+} MYOIDKnownID;
+
+
 /** An ASN.1 Object-ID, which is a sequence of integer components that define namespaces.
     This is mostly used internally by MYCertificateInfo. */
 @interface MYOID : NSObject <NSCopying>
 {
     NSData *_data;
+    MYOIDKnownID _knownID;
+    NSData *_DEREncoding;
 }
 
 #if !TARGET_OS_IPHONE
 + (MYOID*) OIDFromCSSM: (CSSM_OID)cssmOid;
 #endif
 
+/** Returns the shared instance of a well-known OID. */
++ (MYOID*) OIDWithKnownID: (MYOIDKnownID)knownID;
+
+/** Decodes an OID from its BER encoding. Well-known OIDs are looked up in a table by their
+    encoded bytes, and return a shared instance without allocating anything. */
++ (MYOID*) OIDWithBERBytes: (const void*)bytes length: (size_t)length;
+
 - (id) initWithComponents: (const UInt32*)components count: (unsigned)componentCount;
 - (id) initWithBEREncoding: (NSData*)encoding;
 - (NSData*) DEREncoding;
@@ -27,4 +80,7 @@
 - (const UInt32*) components;
 - (unsigned) componentCount;
 
+/** The well-known ID of this OID, or kMYOIDUnknown. */
+@property (readonly) MYOIDKnownID knownID;
+
 @end
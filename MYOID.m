@@ -10,11 +10,154 @@
 #import "Test.h"
 
 
+#pragma mark WELL-KNOWN OIDS:
+
+
+/* DER encodings of the well-known OIDs, indexed by MYOIDKnownID. */
+typedef struct {
+    uint8_t length;
+    uint8_t bytes[11];
+} KnownOIDEncoding;
+
+#define DER(BYTES...)    {sizeof((const uint8_t[]){BYTES}), {BYTES}}
+
+static const KnownOIDEncoding kKnownEncodings[kMYOIDKnownCount] = {
+    [kMYOIDRSAEncryption]       = DER(0x2a, 0x86, 0x48, 0x86, 0xf7, 0x0d, 0x01, 0x01, 0x01),
+    [kMYOIDRSAWithMD2]          = DER(0x2a, 0x86, 0x48, 0x86, 0xf7, 0x0d, 0x01, 0x01, 0x02),
+    [kMYOIDRSAWithMD5]          = DER(0x2a, 0x86, 0x48, 0x86, 0xf7, 0x0d, 0x01, 0x01, 0x04),
+    [kMYOIDRSAWithSHA1]         = DER(0x2a, 0x86, 0x48, 0x86, 0xf7, 0x0d, 0x01, 0x01, 0x05),
+    [kMYOIDRSAWithSHA256]       = DER(0x2a, 0x86, 0x48, 0x86, 0xf7, 0x0d, 0x01, 0x01, 0x0b),
+    [kMYOIDRSAWithSHA384]       = DER(0x2a, 0x86, 0x48, 0x86, 0xf7, 0x0d, 0x01, 0x01, 0x0c),
+    [kMYOIDRSAWithSHA512]       = DER(0x2a, 0x86, 0x48, 0x86, 0xf7, 0x0d, 0x01, 0x01, 0x0d),
+    [kMYOIDSHA1]                = DER(0x2b, 0x0e, 0x03, 0x02, 0x1a),
+    [kMYOIDCommonName]          = DER(0x55, 0x04, 0x03),
+    [kMYOIDSurname]             = DER(0x55, 0x04, 0x04),
+    [kMYOIDDescription]         = DER(0x55, 0x04, 0x0d),
+    [kMYOIDGivenName]           = DER(0x55, 0x04, 0x2a),
+    [kMYOIDEmailAddress]        = DER(0x2a, 0x86, 0x48, 0x86, 0xf7, 0x0d, 0x01, 0x09, 0x01),
+    [kMYOIDSubjectKeyIdentifier] = DER(0x55, 0x1d, 0x0e),
+    [kMYOIDKeyUsage]            = DER(0x55, 0x1d, 0x0f),
+    [kMYOIDSubjectAltName]      = DER(0x55, 0x1d, 0x11),
+    [kMYOIDBasicConstraints]    = DER(0x55, 0x1d, 0x13),
+    [kMYOIDCRLDistributionPoints] = DER(0x55, 0x1d, 0x1f),
+    [kMYOIDAuthorityKeyIdentifier] = DER(0x55, 0x1d, 0x23),
+    [kMYOIDExtendedKeyUsage]    = DER(0x55, 0x1d, 0x25),
+    [kMYOIDAuthorityInfoAccess] = DER(0x2b, 0x06, 0x01, 0x05, 0x05, 0x07, 0x01, 0x01),
+    [kMYOIDAnyExtendedKeyUsage] = DER(0x55, 0x1d, 0x25, 0x00),
+    [kMYOIDServerAuth]          = DER(0x2b, 0x06, 0x01, 0x05, 0x05, 0x07, 0x03, 0x01),
+    [kMYOIDClientAuth]          = DER(0x2b, 0x06, 0x01, 0x05, 0x05, 0x07, 0x03, 0x02),
+    [kMYOIDCodeSigning]         = DER(0x2b, 0x06, 0x01, 0x05, 0x05, 0x07, 0x03, 0x03),
+    [kMYOIDEmailProtection]     = DER(0x2b, 0x06, 0x01, 0x05, 0x05, 0x07, 0x03, 0x04),
+    [kMYOIDOCSPSigning]         = DER(0x2b, 0x06, 0x01, 0x05, 0x05, 0x07, 0x03, 0x09),
+    [kMYOIDOCSP]                = DER(0x2b, 0x06, 0x01, 0x05, 0x05, 0x07, 0x30, 0x01),
+    [kMYOIDOCSPBasicResponse]   = DER(0x2b, 0x06, 0x01, 0x05, 0x05, 0x07, 0x30, 0x01, 0x01),
+};
+
+/* Open-addressed hash table mapping DER encodings to MYOIDKnownIDs (0 marks an empty slot.)
+   It's filled in once, and is read-only after that. */
+#define kInternTableSize 64
+static uint8_t sInternTable[kInternTableSize];
+
+static MYOID* sKnownOIDs[kMYOIDKnownCount];
+
+
+static inline uint32_t hashBytes (const uint8_t *bytes, size_t length) {
+    uint32_t hash = 2166136261u;     // FNV-1a
+    for (size_t i=0; i<length; i++)
+        hash = (hash ^ bytes[i]) * 16777619u;
+    return hash;
+}
+
+
+@interface MYOID ()
+- (id) _initWithBERBytes: (const UInt8*)src length: (size_t)len;
+@end
+
+
+static void initKnownOIDs (void) {
+    static dispatch_once_t once;
+    dispatch_once(&once, ^{
+        for (unsigned knownID = 1; knownID < kMYOIDKnownCount; knownID++) {
+            const KnownOIDEncoding *enc = &kKnownEncodings[knownID];
+            Assert(enc->length > 0, @"Missing encoding for known OID %u", knownID);
+            MYOID *oid = [[MYOID alloc] _initWithBERBytes: enc->bytes length: enc->length];
+            oid->_knownID = knownID;
+            oid->_DEREncoding = [[NSData alloc] initWithBytesNoCopy: (void*)enc->bytes
+                                                             length: enc->length
+                                                       freeWhenDone: NO];
+            sKnownOIDs[knownID] = oid;
+
+            uint32_t slot = hashBytes(enc->bytes, enc->length) % kInternTableSize;
+            while (sInternTable[slot])
+                slot = (slot + 1) % kInternTableSize;
+            sInternTable[slot] = knownID;
+        }
+    });
+}
+
+/* Returns the well-known ID of the OID with the given DER encoding, or kMYOIDUnknown. */
+static MYOIDKnownID lookUpKnownOID (const UInt8 *bytes, size_t length) {
+    if (length == 0 || length > sizeof(kKnownEncodings[0].bytes))
+        return kMYOIDUnknown;
+    initKnownOIDs();
+    for (uint32_t slot = hashBytes(bytes, length) % kInternTableSize; ;
+                  slot = (slot + 1) % kInternTableSize) {
+        MYOIDKnownID knownID = sInternTable[slot];
+        if (knownID == kMYOIDUnknown)
+            return kMYOIDUnknown;
+        const KnownOIDEncoding *enc = &kKnownEncodings[knownID];
+        if (enc->length == length && memcmp(enc->bytes, bytes, length) == 0)
+            return knownID;
+    }
+}
+
+
+/* Writes the DER encoding of the components to dst, which must have room for 5*count bytes.
+   Returns the number of bytes written. */
+static size_t encodeComponents (const UInt32 *src, unsigned count, UInt8 *dst) {
+    const UInt32 *end = src + count;
+    UInt8 *start = dst;
+    if (count >= 2 && src[0]<=3 && src[1]<40) {
+        // Weird collapsing of 1st two components into one byte:
+        *dst++ = src[0]*40 + src[1];
+        src += 2;
+    }
+    while (src<end) {
+        UInt32 component = *src++;
+        // Write the component in 7-bit groups, most significant first:
+        BOOL any = NO;
+        for (int shift=28; shift>=0; shift -= 7) {
+            UInt8 byte = (component >> shift) & 0x7F;
+            if (byte || any || shift == 0) {
+                if (any)
+                    dst[-1] |= 0x80;
+                *dst++ = byte;
+                any = YES;
+            }
+        }
+    }
+    return dst - start;
+}
+
+
+
+#pragma mark -
 @implementation MYOID
 
 
++ (MYOID*) OIDWithKnownID: (MYOIDKnownID)knownID {
+    Assert(knownID > kMYOIDUnknown && knownID < kMYOIDKnownCount);
+    initKnownOIDs();
+    return sKnownOIDs[knownID];
+}
+
+
 - (id) initWithComponents: (const UInt32*)components count: (unsigned)count
 {
+    UInt8 encoding[5*count + 1];
+    MYOIDKnownID knownID = lookUpKnownOID(encoding, encodeComponents(components, count, encoding));
+    if (knownID)
+        return sKnownOIDs[knownID];
     self = [super init];
     if (self != nil) {
         _data = [[NSData alloc] initWithBytes: components length: count*sizeof(UInt32)];
@@ -23,11 +166,17 @@
 }
 
 - (id) initWithBEREncoding: (NSData*)encoding
+{
+    MYOIDKnownID knownID = lookUpKnownOID(encoding.bytes, encoding.length);
+    if (knownID)
+        return sKnownOIDs[knownID];
+    return [self _initWithBERBytes: encoding.bytes length: encoding.length];
+}
+
+- (id) _initWithBERBytes: (const UInt8*)src length: (size_t)len
 {
     self = [super init];
     if (self != nil) {
-        size_t len = encoding.length;
-        const UInt8 *src = encoding.bytes;
         const UInt8 *end = src+len;
         NSMutableData *data = [NSMutableData dataWithLength: (len+1)*sizeof(UInt32)];
         UInt32* dst = data.mutableBytes;
@@ -59,12 +208,17 @@
     return [[self alloc] initWithBEREncoding: encoding];
 }
 
++ (MYOID*) OIDWithBERBytes: (const void*)bytes length: (size_t)length {
+    MYOIDKnownID knownID = lookUpKnownOID(bytes, length);
+    if (knownID)
+        return sKnownOIDs[knownID];
+    return [[self alloc] _initWithBERBytes: bytes length: length];
+}
+
 #if !TARGET_OS_IPHONE
 + (MYOID*) OIDFromCSSM: (CSSM_OID)cssmOid
 {
-    NSData *ber = [[NSData alloc] initWithBytesNoCopy: cssmOid.Data length: cssmOid.Length freeWhenDone: NO];
-    MYOID *oid = [[self alloc] initWithBEREncoding: ber];
-    return oid;
+    return [self OIDWithBERBytes: cssmOid.Data length: cssmOid.Length];
 }
 #endif
 
@@ -89,6 +243,8 @@
 }
 
 
+@synthesize knownID=_knownID;
+
 - (NSData*) componentData       {return _data;}
 - (const UInt32*) components    {return (const UInt32*)_data.bytes;}
 - (unsigned) componentCount     {return (unsigned)(_data.length / sizeof(UInt32));}
@@ -98,35 +254,25 @@
 }
 
 - (BOOL)isEqual:(id)object {
-    return [object isKindOfClass: [MYOID class]] && [_data isEqual: [object componentData]];
+    if (object == self)
+        return YES;
+    if (![object isKindOfClass: [MYOID class]])
+        return NO;
+    // Well-known OIDs are interned, so two different known ones can't be equal:
+    MYOID *other = object;
+    if (_knownID && other->_knownID)
+        return NO;
+    return [_data isEqual: other->_data];
 }
 
 
 - (NSData*) DEREncoding {
+    if (_DEREncoding)
+        return _DEREncoding;
     unsigned count = self.componentCount;
     UInt8 encoding[5*count]; // worst-case size
-    const UInt32 *src=self.components, *end=src+count;
-    UInt8 *dst = encoding;
-    if (count >= 2 && src[0]<=3 && src[1]<40) {
-        // Weird collapsing of 1st two components into one byte:
-        *dst++ = src[0]*40 + src[1];
-        src += 2;
-    }
-    while (src<end) {
-        UInt32 component = *src++;
-        // Write the component in 7-bit groups, most significant first:
-        BOOL any = NO;
-        for (int shift=28; shift>=0; shift -= 7) {
-            UInt8 byte = (component >> shift) & 0x7F;
-            if (byte || any) {
-                if (any)
-                    dst[-1] |= 0x80;
-                *dst++ = byte;
-                any = YES;
-            }
-        }
-    }
-    return [NSData dataWithBytes: encoding length: dst-encoding];
+    size_t length = encodeComponents(self.components, count, encoding);
+    return [NSData dataWithBytes: encoding length: length];
 }
 
 
@@ -153,6 +299,31 @@ TestCase(OID) {
                  $data(0x2a, 0x86, 0x48, 0x86,  0xf7, 0x0d, 0x01, 0x01,  0x01));
     CAssertEqual([[[MYOID alloc] initWithComponents: $components(2,5,4,4) count: 4] DEREncoding],
                  $data(0x55,0x04,0x04));
+    CAssertEqual([[[MYOID alloc] initWithComponents: $components(2,5,29,37,0) count: 5] DEREncoding],
+                 $data(0x55,0x1d,0x25,0x00));
+}
+
+TestCase(OIDInterning) {
+    RequireTestCase(OID);
+    // Every known OID's table entry must decode to the right components:
+    for (unsigned knownID = 1; knownID < kMYOIDKnownCount; knownID++) {
+        MYOID *oid = [MYOID OIDWithKnownID: knownID];
+        CAssertEq(oid.knownID, (MYOIDKnownID)knownID);
+        CAssertEq([[MYOID alloc] initWithComponents: oid.components count: oid.componentCount], oid);
+        CAssertEq([MYOID OIDWithEncoding: oid.DEREncoding], oid);
+    }
+    MYOID *rsa = [MYOID OIDWithBERBytes: "\x2a\x86\x48\x86\xf7\x0d\x01\x01\x01" length: 9];
+    CAssertEq(rsa, [MYOID OIDWithKnownID: kMYOIDRSAEncryption]);
+    CAssertEq([[MYOID alloc] initWithComponents: $components(1,2,840,113549,1,1,1) count: 7], rsa);
+
+    MYOID *unknown = [MYOID OIDWithBERBytes: "\x2a\x86\x48\x86\xf7\x0d\x01\x01\x63" length: 9];
+    CAssertEq(unknown.knownID, kMYOIDUnknown);
+    CAssert(![unknown isEqual: rsa]);
+    CAssertEqual(unknown, [[MYOID alloc] initWithComponents: $components(1,2,840,113549,1,1,99)
+                                                      count: 7]);
+
+    MYOID *sha512 = [MYOID OIDWithBERBytes: "\x2a\x86\x48\x86\xf7\x0d\x01\x01\x0d" length: 9];
+    CAssertEq(sha512.knownID, kMYOIDRSAWithSHA512);
 }
 
 
@@ -0,0 +1,114 @@
+//
+//  MYPEM.h
+//  MYCrypto
+//
+//  Created by Jens Alfke on 10/16/26.
+//  Copyright 2026 Jens Alfke. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+
+#pragma mark BASE64:
+
+/** State of an incremental base64 decode. Initialize with MYBase64DecoderInit. */
+typedef struct {
+    uint32_t bits;          ///< Bits of the partial group of 4 characters
+    uint8_t pending;        ///< Number of characters in the partial group
+    uint8_t padding;        ///< Number of '=' characters seen
+    BOOL failed;            ///< Set once invalid input has been seen
+} MYBase64Decoder;
+
+/** The most bytes MYBase64DecodeUpdate can write when given this many characters. */
+static inline size_t MYBase64DecodedMaxLength (size_t length) {
+    return (length + 3) / 4 * 3;
+}
+
+void MYBase64DecoderInit (MYBase64Decoder *decoder);
+
+/** Decodes a chunk of base64 text, which may end in the middle of a 4-character group.
+    Whitespace, including line breaks, is skipped. Long runs of base64 characters are decoded with
+    SIMD instructions where the CPU supports them.
+    @param output  Must have room for MYBase64DecodedMaxLength(length) bytes.
+    @param outLength  On return, the number of bytes written.
+    @return  YES on success, NO if the input isn't valid base64. */
+BOOL MYBase64DecodeUpdate (MYBase64Decoder *decoder, const void *input, size_t length,
+                           void *output, size_t *outLength);
+
+/** Finishes decoding, writing any bytes of a final group that had no '=' padding.
+    @param output  Must have room for 2 bytes.
+    @return  YES on success, NO if the input was invalid or ended in the middle of a group. */
+BOOL MYBase64DecodeFinal (MYBase64Decoder *decoder, void *output, size_t *outLength);
+
+/** Decodes base64 text in one call. Returns nil if it's invalid. */
+NSData* MYBase64DecodeData (const void *input, size_t length);
+
+
+/** The number of characters MYBase64Encode will write.
+    @param lineLength  The number of characters per line (a multiple of 4), or 0 for no line breaks. */
+size_t MYBase64EncodedLength (size_t length, size_t lineLength);
+
+/** Encodes bytes as base64. If lineLength is nonzero, a newline is written after every line,
+    including the last. Does not write a trailing null byte.
+    @return  The number of characters written, which is MYBase64EncodedLength(length,lineLength). */
+size_t MYBase64Encode (const void *input, size_t length, char *output, size_t lineLength);
+
+/** The name of the decoding kernel in use: "AVX2", "SSSE3" or "scalar". */
+const char* MYBase64DecoderKernelName (void);
+
+
+#pragma mark PEM:
+
+/** Encodes data in PEM format: a "-----BEGIN label-----" line, the base64-encoded data in
+    64-character lines, and an "-----END label-----" line. */
+NSData* MYPEMEncode (NSData *data, NSString *label);
+
+
+/** One block of a PEM file, as read by MYPEMReader. */
+@interface MYPEMBlock : NSObject
+{
+    @private
+    NSString *_label;
+    NSDictionary *_headers;
+    NSData *_data;
+}
+
+/** The type of data, from the BEGIN line, e.g. "CERTIFICATE" or "RSA PRIVATE KEY". */
+@property (readonly) NSString *label;
+
+/** RFC 1421 header fields preceding the data, such as "Proc-Type" and "DEK-Info", or nil if
+    there were none. (OpenSSL uses these for encrypted keys.) */
+@property (readonly) NSDictionary *headers;
+
+/** The decoded contents of the block. */
+@property (readonly) NSData *data;
+
+@end
+
+
+/** Reads the blocks from PEM-formatted input, one at a time. Text outside of the blocks is
+    ignored. Input is read as needed, in large chunks, so a stream of any size can be read in a
+    bounded amount of memory (apart from the blocks themselves), and the base64 text is decoded
+    directly into each block's data. */
+@interface MYPEMReader : NSObject
+{
+    @private
+    NSInputStream *_stream;
+    NSData *_input;
+    NSUInteger _start;
+}
+
+- (id) initWithData: (NSData*)data;
+
+/** Initializes a reader that reads from a stream. The stream will be opened if necessary. */
+- (id) initWithInputStream: (NSInputStream*)stream;
+
+/** Reads the next block.
+    @return  The block, or nil if there are no more blocks or if an error occurred. To tell these
+        apart, check whether *outError was set. */
+- (MYPEMBlock*) nextBlock: (NSError**)outError;
+
+/** Reads all the blocks from PEM data. Returns nil on error. */
++ (NSArray*) blocksInData: (NSData*)data error: (NSError**)outError;
+
+@end
@@ -9,6 +9,7 @@
 #import "MYPrivateKey.h"
 #import "MYCrypto_Private.h"
 #import "MYDigest.h"
+#import "MYPEM.h"
 #import <CommonCrypto/CommonDigest.h>
 
 @implementation MYPrivateKey
@@ -264,14 +265,15 @@
         .alertTitle = (__bridge CFStringRef)title,
         .alertPrompt = (__bridge CFStringRef)prompt
     };
+    NSString *pemLabel = withPEM ? MYPEMLabelForExternalFormat(format) : nil;
     CFDataRef data = NULL;
-    if (check(SecKeychainItemExport(self.keyRef,
-                                    format, (withPEM ?kSecItemPemArmour :0), 
-                                    &params, &data),
-              @"SecKeychainItemExport"))
-        return (NSData*)CFBridgingRelease(data);
-    else
+    if (!check(SecKeychainItemExport(self.keyRef,
+                                     format, ((withPEM && !pemLabel) ?kSecItemPemArmour :0),
+                                     &params, &data),
+               @"SecKeychainItemExport"))
         return nil;
+    NSData *result = CFBridgingRelease(data);
+    return pemLabel ? MYPEMEncode(result, pemLabel) : result;
 }
 
 - (NSData*) exportKey {
@@ -292,14 +294,15 @@
         .version = SEC_KEY_IMPORT_EXPORT_PARAMS_VERSION,
         .passphrase = (__bridge CFStringRef)passphrase
     };
+    NSString *pemLabel = withPEM ? MYPEMLabelForExternalFormat(format) : nil;
     CFDataRef data = NULL;
-    if (check(SecKeychainItemExport(self.keyRef,
-                                    format, (withPEM ?kSecItemPemArmour :0), 
-                                    &params, &data),
-              @"SecKeychainItemExport"))
-        return (NSData*)CFBridgingRelease(data);
-    else
+    if (!check(SecKeychainItemExport(self.keyRef,
+                                     format, ((withPEM && !pemLabel) ?kSecItemPemArmour :0),
+                                     &params, &data),
+               @"SecKeychainItemExport"))
         return nil;
+    NSData *result = CFBridgingRelease(data);
+    return pemLabel ? MYPEMEncode(result, pemLabel) : result;
 }
 
 
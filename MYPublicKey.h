@@ -70,7 +70,8 @@
 #if !TARGET_OS_IPHONE
 
 /** Verifies a signature, using the specified signature algorithm, for example
-    CSSM_ALGID_SHA1WithRSA, CSSM_ALGID_SHA256WithRSA or CSSM_ALGID_MD5WithRSA. */
+    CSSM_ALGID_SHA1WithRSA, CSSM_ALGID_SHA256WithRSA, CSSM_ALGID_SHA512WithRSA or
+    CSSM_ALGID_MD5WithRSA. */
 - (BOOL) verifySignature: (NSData*)signature 
                   ofData: (NSData*)data
            withAlgorithm: (CSSM_ALGORITHMS)algorithm;
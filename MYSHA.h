@@ -0,0 +1,91 @@
+//
+//  MYSHA.h
+//  MYCrypto
+//
+//  Created by Jens Alfke on 10/16/26.
+//  Copyright 2026 Jens Alfke. All rights reserved.
+//
+
+#import "MYDigest.h"
+
+
+/*  Portable SHA-1, SHA-256 and SHA-384/512 implementations, for platforms without CommonCrypto.
+    The block function is chosen at runtime, the first time a context is initialized, from the
+    fastest the CPU supports: the x86 SHA extensions (SHA-NI), the ARMv8 cryptography
+    extensions, AVX2, or plain C. MYDigest uses these if MYCRYPTO_USE_PORTABLE_SHA is set.
+    SHA-512 only has a plain C implementation; it's already faster per byte than plain SHA-256 on
+    64-bit CPUs, since it processes twice as much data per round.
+    The contexts are plain structs, so they can be copied with memcpy to fork a digest.
+    The batch functions have no CommonCrypto equivalent, so MYDigest uses them everywhere. */
+
+
+/** State of an incremental SHA-1 digest. Initialize with MYSHA1Init. */
+typedef struct {
+    uint32_t state[5];
+    uint64_t length;            // Total number of bytes added
+    uint8_t buffer[64];         // Partial block; holds (length % 64) bytes
+} MYSHA1Context;
+
+void MYSHA1Init (MYSHA1Context *context);
+void MYSHA1Update (MYSHA1Context *context, const void *bytes, size_t length);
+void MYSHA1Final (MYSHA1Context *context, void *outDigest);
+
+/** Computes the 20-byte SHA-1 digest of a buffer. */
+void MYSHA1 (const void *bytes, size_t length, void *outDigest);
+
+
+/** State of an incremental SHA-256 digest. Initialize with MYSHA256Init. */
+typedef struct {
+    uint32_t state[8];
+    uint64_t length;            // Total number of bytes added
+    uint8_t buffer[64];         // Partial block; holds (length % 64) bytes
+} MYSHA256Context;
+
+void MYSHA256Init (MYSHA256Context *context);
+void MYSHA256Update (MYSHA256Context *context, const void *bytes, size_t length);
+void MYSHA256Final (MYSHA256Context *context, void *outDigest);
+
+/** Computes the 32-byte SHA-256 digest of a buffer. */
+void MYSHA256 (const void *bytes, size_t length, void *outDigest);
+
+
+/** State of an incremental SHA-512 or SHA-384 digest. Initialize with MYSHA512Init or MYSHA384Init.
+    (SHA-384 is SHA-512 with a different initial state, truncated to 48 bytes.) */
+typedef struct {
+    uint64_t state[8];
+    uint64_t length;            // Total number of bytes added
+    uint8_t buffer[128];        // Partial block; holds (length % 128) bytes
+} MYSHA512Context;
+
+void MYSHA512Init (MYSHA512Context *context);
+void MYSHA512Update (MYSHA512Context *context, const void *bytes, size_t length);
+void MYSHA512Final (MYSHA512Context *context, void *outDigest);
+
+/** Computes the 64-byte SHA-512 digest of a buffer. */
+void MYSHA512 (const void *bytes, size_t length, void *outDigest);
+
+void MYSHA384Init (MYSHA512Context *context);
+#define MYSHA384Update MYSHA512Update
+void MYSHA384Final (MYSHA512Context *context, void *outDigest);
+
+/** Computes the 48-byte SHA-384 digest of a buffer. */
+void MYSHA384 (const void *bytes, size_t length, void *outDigest);
+
+
+/** Computes the SHA-1 digests of many messages at once, hashing several of them in parallel
+    in SIMD lanes. The messages can be any mixture of lengths.
+    @param outDigests  Receives count digests of 20 bytes each, in the same order as the inputs. */
+void MYSHA1Batch (const MYDigestBuffer *inputs, size_t count, void *outDigests);
+
+/** Computes the SHA-256 digests of many messages at once, hashing several of them in parallel
+    in SIMD lanes. The messages can be any mixture of lengths.
+    @param outDigests  Receives count digests of 32 bytes each, in the same order as the inputs. */
+void MYSHA256Batch (const MYDigestBuffer *inputs, size_t count, void *outDigests);
+
+
+/** The name of the implementation in use ("SHA-NI", "ARMv8", "AVX2" or "scalar"), for logging. */
+const char* MYSHAKernelName (void);
+
+/** The name of the multi-buffer implementation used by the batch functions, such as "AVX2 x8",
+    or "serial" if messages are hashed one at a time. */
+const char* MYSHABatchKernelName (void);
@@ -0,0 +1,1372 @@
+//
+//  MYSHA.m
+//  MYCrypto
+//
+//  Created by Jens Alfke on 10/16/26.
+//  Copyright 2026 Jens Alfke. All rights reserved.
+//
+
+// References:
+// <http://csrc.nist.gov/publications/fips/fips180-4/fips-180-4.pdf> "Secure Hash Standard"
+// <https://www.intel.com/content/dam/develop/external/us/en/documents/intel-sha-extensions-white-paper-402097.pdf>
+//      "Intel SHA Extensions"
+// <https://github.com/noloader/SHA-Intrinsics> (public-domain SHA-NI and ARMv8 examples)
+
+#import "MYSHA.h"
+#import "Test.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#include <cpuid.h>
+#define MY_SHA_X86 1
+#elif defined(__aarch64__) || defined(__arm64__)
+#include <arm_neon.h>
+#define MY_SHA_ARM 1
+// The kernels are compiled for the crypto extensions even if the rest of the file isn't, and
+// are only called if the CPU has them:
+#if defined(__clang__)
+#define MY_SHA_ARM_TARGET __attribute__((target("sha2")))
+#else
+#define MY_SHA_ARM_TARGET __attribute__((target("+crypto")))
+#endif
+#if defined(__APPLE__)
+#include <sys/sysctl.h>
+#elif defined(__linux__)
+#include <sys/auxv.h>
+#include <asm/hwcap.h>
+#endif
+#endif
+
+
+/* A block function processes any number of complete 64-byte blocks, updating the state. */
+typedef void (*SHAKernel)(uint32_t *state, const uint8_t *blocks, size_t nBlocks);
+
+
+static const uint32_t kSHA1InitialState[5] = {
+    0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0
+};
+
+static const uint32_t kSHA1K[4] = {0x5A827999, 0x6ED9EBA1, 0x8F1BBCDC, 0xCA62C1D6};
+
+static const uint32_t kSHA256InitialState[8] = {
+    0x6A09E667, 0xBB67AE85, 0x3C6EF372, 0xA54FF53A, 0x510E527F, 0x9B05688C, 0x1F83D9AB, 0x5BE0CD19
+};
+
+static const uint32_t kSHA256K[64] __attribute__((aligned(16))) = {
+    0x428A2F98, 0x71374491, 0xB5C0FBCF, 0xE9B5DBA5, 0x3956C25B, 0x59F111F1, 0x923F82A4, 0xAB1C5ED5,
+    0xD807AA98, 0x12835B01, 0x243185BE, 0x550C7DC3, 0x72BE5D74, 0x80DEB1FE, 0x9BDC06A7, 0xC19BF174,
+    0xE49B69C1, 0xEFBE4786, 0x0FC19DC6, 0x240CA1CC, 0x2DE92C6F, 0x4A7484AA, 0x5CB0A9DC, 0x76F988DA,
+    0x983E5152, 0xA831C66D, 0xB00327C8, 0xBF597FC7, 0xC6E00BF3, 0xD5A79147, 0x06CA6351, 0x14292967,
+    0x27B70A85, 0x2E1B2138, 0x4D2C6DFC, 0x53380D13, 0x650A7354, 0x766A0ABB, 0x81C2C92E, 0x92722C85,
+    0xA2BFE8A1, 0xA81A664B, 0xC24B8B70, 0xC76C51A3, 0xD192E819, 0xD6990624, 0xF40E3585, 0x106AA070,
+    0x19A4C116, 0x1E376C08, 0x2748774C, 0x34B0BCB5, 0x391C0CB3, 0x4ED8AA4A, 0x5B9CCA4F, 0x682E6FF3,
+    0x748F82EE, 0x78A5636F, 0x84C87814, 0x8CC70208, 0x90BEFFFA, 0xA4506CEB, 0xBEF9A3F7, 0xC67178F2,
+};
+
+
+static inline uint32_t rol32 (uint32_t x, unsigned n)   {return (x << n) | (x >> (32 - n));}
+static inline uint32_t ror32 (uint32_t x, unsigned n)   {return (x >> n) | (x << (32 - n));}
+
+static inline uint32_t readBE32 (const uint8_t *p) {
+    return (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 8 | p[3];
+}
+
+static inline void writeBE32 (uint8_t *p, uint32_t n) {
+    p[0] = (uint8_t)(n >> 24);  p[1] = (uint8_t)(n >> 16);  p[2] = (uint8_t)(n >> 8);  p[3] = (uint8_t)n;
+}
+
+
+#pragma mark -
+#pragma mark SCALAR:
+
+
+/* The round functions are shared with the AVX2 kernels, which only vectorize the message
+   schedule; they take W[t]+K[t] precomputed. */
+
+static inline void sha1Rounds (uint32_t *state, const uint32_t wk[80]) {
+    uint32_t a = state[0], b = state[1], c = state[2], d = state[3], e = state[4];
+#define SHA1_ROUNDS(FIRST, F) \
+    for (int t = FIRST; t < FIRST + 20; t++) { \
+        uint32_t temp = rol32(a, 5) + (F) + e + wk[t]; \
+        e = d;  d = c;  c = rol32(b, 30);  b = a;  a = temp; \
+    }
+    SHA1_ROUNDS( 0, d ^ (b & (c ^ d)))
+    SHA1_ROUNDS(20, b ^ c ^ d)
+    SHA1_ROUNDS(40, (b & c) | (d & (b | c)))
+    SHA1_ROUNDS(60, b ^ c ^ d)
+#undef SHA1_ROUNDS
+    state[0] += a;  state[1] += b;  state[2] += c;  state[3] += d;  state[4] += e;
+}
+
+static inline void sha256Rounds (uint32_t *state, const uint32_t wk[64]) {
+    uint32_t a = state[0], b = state[1], c = state[2], d = state[3],
+             e = state[4], f = state[5], g = state[6], h = state[7];
+    for (int t = 0; t < 64; t++) {
+        uint32_t t1 = h + (ror32(e, 6) ^ ror32(e, 11) ^ ror32(e, 25)) + (g ^ (e & (f ^ g))) + wk[t];
+        uint32_t t2 = (ror32(a, 2) ^ ror32(a, 13) ^ ror32(a, 22)) + ((a & b) | (c & (a | b)));
+        h = g;  g = f;  f = e;  e = d + t1;  d = c;  c = b;  b = a;  a = t1 + t2;
+    }
+    state[0] += a;  state[1] += b;  state[2] += c;  state[3] += d;
+    state[4] += e;  state[5] += f;  state[6] += g;  state[7] += h;
+}
+
+
+static void sha1Scalar (uint32_t *state, const uint8_t *blocks, size_t nBlocks) {
+    uint32_t w[80];
+    for (; nBlocks > 0; --nBlocks, blocks += 64) {
+        for (int t = 0; t < 16; t++)
+            w[t] = readBE32(blocks + 4*t);
+        for (int t = 16; t < 80; t++)
+            w[t] = rol32(w[t-3] ^ w[t-8] ^ w[t-14] ^ w[t-16], 1);
+        for (int t = 0; t < 80; t++)
+            w[t] += kSHA1K[t / 20];
+        sha1Rounds(state, w);
+    }
+}
+
+static void sha256Scalar (uint32_t *state, const uint8_t *blocks, size_t nBlocks) {
+    uint32_t w[64];
+    for (; nBlocks > 0; --nBlocks, blocks += 64) {
+        for (int t = 0; t < 16; t++)
+            w[t] = readBE32(blocks + 4*t);
+        for (int t = 16; t < 64; t++) {
+            uint32_t s0 = ror32(w[t-15], 7) ^ ror32(w[t-15], 18) ^ (w[t-15] >> 3);
+            uint32_t s1 = ror32(w[t-2], 17) ^ ror32(w[t-2], 19) ^ (w[t-2] >> 10);
+            w[t] = w[t-16] + s0 + w[t-7] + s1;
+        }
+        for (int t = 0; t < 64; t++)
+            w[t] += kSHA256K[t];
+        sha256Rounds(state, w);
+    }
+}
+
+
+#if MY_SHA_X86
+
+#pragma mark -
+#pragma mark AVX2:
+
+
+/* The AVX2 kernels compute the message schedules of two blocks at once, one per 128-bit lane,
+   then run the scalar rounds over each. (The rounds themselves are inherently serial; compiled
+   with BMI2 they use RORX.) */
+
+#define ROR256(X, N)    _mm256_or_si256(_mm256_srli_epi32(X, N), _mm256_slli_epi32(X, 32 - (N)))
+#define ROL256(X, N)    ROR256(X, 32 - (N))
+
+__attribute__((target("avx2,bmi2")))
+static inline __m256i loadTwoBlocks (const uint8_t *blocks, size_t nBlocks, int i) {
+    const __m256i bswap = _mm256_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+                                           3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+    __m128i lo = _mm_loadu_si128((const __m128i*)(blocks + 16*i));
+    __m128i hi = (nBlocks > 1) ? _mm_loadu_si128((const __m128i*)(blocks + 64 + 16*i)) : lo;
+    return _mm256_shuffle_epi8(_mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1), bswap);
+}
+
+__attribute__((target("avx2,bmi2")))
+static inline void storeTwoBlocks (uint32_t wk[2][80], int t, __m256i x) {
+    _mm_store_si128((__m128i*)&wk[0][t], _mm256_castsi256_si128(x));
+    _mm_store_si128((__m128i*)&wk[1][t], _mm256_extracti128_si256(x, 1));
+}
+
+__attribute__((target("avx2,bmi2")))
+static void sha1AVX2 (uint32_t *state, const uint8_t *blocks, size_t nBlocks) {
+    uint32_t wk[2][80] __attribute__((aligned(32)));
+    __m256i w[20];
+    while (nBlocks > 0) {
+        for (int i = 0; i < 4; i++)
+            w[i] = loadTwoBlocks(blocks, nBlocks, i);
+        // W[16..31]: the W[t-3] term of the last word in each group is the first word of the
+        // same group, so it's patched in afterwards.
+        for (int i = 4; i < 8; i++) {
+            __m256i x = _mm256_xor_si256(_mm256_xor_si256(w[i-4], _mm256_alignr_epi8(w[i-3], w[i-4], 8)),
+                                         _mm256_xor_si256(w[i-2], _mm256_srli_si256(w[i-1], 4)));
+            x = ROL256(x, 1);
+            w[i] = _mm256_xor_si256(x, ROL256(_mm256_slli_si256(x, 12), 1));
+        }
+        // W[32..79] use the equivalent W[t] = (W[t-6] ^ W[t-16] ^ W[t-28] ^ W[t-32]) <<< 2,
+        // which has no dependencies within a group.
+        for (int i = 8; i < 20; i++) {
+            __m256i x = _mm256_xor_si256(_mm256_xor_si256(_mm256_alignr_epi8(w[i-1], w[i-2], 8), w[i-4]),
+                                         _mm256_xor_si256(w[i-7], w[i-8]));
+            w[i] = ROL256(x, 2);
+        }
+        for (int i = 0; i < 20; i++)
+            storeTwoBlocks(wk, 4*i, _mm256_add_epi32(w[i], _mm256_set1_epi32((int)kSHA1K[i / 5])));
+
+        sha1Rounds(state, wk[0]);
+        if (nBlocks == 1)
+            break;
+        sha1Rounds(state, wk[1]);
+        blocks += 128;
+        nBlocks -= 2;
+    }
+}
+
+__attribute__((target("avx2,bmi2")))
+static void sha256AVX2 (uint32_t *state, const uint8_t *blocks, size_t nBlocks) {
+    uint32_t wk[2][80] __attribute__((aligned(32)));
+    while (nBlocks > 0) {
+        __m256i x0 = loadTwoBlocks(blocks, nBlocks, 0), x1 = loadTwoBlocks(blocks, nBlocks, 1),
+                x2 = loadTwoBlocks(blocks, nBlocks, 2), x3 = loadTwoBlocks(blocks, nBlocks, 3);
+        for (int t = 0; t < 64; t += 4) {
+            storeTwoBlocks(wk, t, _mm256_add_epi32(x0, _mm256_broadcastsi128_si256(
+                                                        _mm_load_si128((const __m128i*)&kSHA256K[t]))));
+            if (t >= 48) {
+                x0 = x1;  x1 = x2;  x2 = x3;
+                continue;
+            }
+            // W[t+16..t+19] from x0 = W[t..t+3], ... x3 = W[t+12..t+15]:
+            __m256i w15 = _mm256_alignr_epi8(x1, x0, 4);            // W[t+1..t+4]
+            __m256i w7 = _mm256_alignr_epi8(x3, x2, 4);             // W[t+9..t+12]
+            __m256i s0 = _mm256_xor_si256(_mm256_xor_si256(ROR256(w15, 7), ROR256(w15, 18)),
+                                          _mm256_srli_epi32(w15, 3));
+            __m256i x = _mm256_add_epi32(_mm256_add_epi32(x0, w7), s0);
+            // σ1 depends on W[t-2], so the new words are finished two at a time:
+            __m256i w2 = _mm256_shuffle_epi32(x3, _MM_SHUFFLE(3, 2, 3, 2));
+            __m256i s1 = _mm256_xor_si256(_mm256_xor_si256(ROR256(w2, 17), ROR256(w2, 19)),
+                                          _mm256_srli_epi32(w2, 10));
+            x = _mm256_add_epi32(x, _mm256_blend_epi32(s1, _mm256_setzero_si256(), 0xCC));
+            w2 = _mm256_shuffle_epi32(x, _MM_SHUFFLE(1, 0, 1, 0));
+            s1 = _mm256_xor_si256(_mm256_xor_si256(ROR256(w2, 17), ROR256(w2, 19)),
+                                  _mm256_srli_epi32(w2, 10));
+            x = _mm256_add_epi32(x, _mm256_blend_epi32(s1, _mm256_setzero_si256(), 0x33));
+            x0 = x1;  x1 = x2;  x2 = x3;  x3 = x;
+        }
+
+        sha256Rounds(state, wk[0]);
+        if (nBlocks == 1)
+            break;
+        sha256Rounds(state, wk[1]);
+        blocks += 128;
+        nBlocks -= 2;
+    }
+}
+
+
+#pragma mark -
+#pragma mark SHA-NI:
+
+
+/* One group of four SHA-1 rounds. G is the group number 0..19; M0..M3 are the message vectors
+   starting with group G's; E_IN holds E for this group and E_OUT receives it for the next. */
+#define SHA1NI_GROUP(G, M0, M1, M2, M3, E_IN, E_OUT) do {                                  \
+        if ((G) < 4)                                                                        \
+            M0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(blocks + 16*(G))), mask);\
+        E_IN = ((G) == 0) ? _mm_add_epi32(E_IN, M0) : _mm_sha1nexte_epu32(E_IN, M0);        \
+        E_OUT = abcd;                                                                       \
+        if ((G) >= 3 && (G) <= 18)                                                          \
+            M1 = _mm_sha1msg2_epu32(M1, M0);                                                \
+        abcd = _mm_sha1rnds4_epu32(abcd, E_IN, (G) / 5);                                    \
+        if ((G) >= 1 && (G) <= 16)                                                          \
+            M3 = _mm_sha1msg1_epu32(M3, M0);                                                \
+        if ((G) >= 2 && (G) <= 17)                                                          \
+            M2 = _mm_xor_si128(M2, M0);                                                     \
+    } while (0)
+
+__attribute__((target("sha,sse4.1")))
+static void sha1SHANI (uint32_t *state, const uint8_t *blocks, size_t nBlocks) {
+    const __m128i mask = _mm_set_epi64x(0x0001020304050607ULL, 0x08090A0B0C0D0E0FULL);
+    __m128i abcd = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i*)state), 0x1B);
+    __m128i e0 = _mm_set_epi32((int)state[4], 0, 0, 0), e1;
+    __m128i m0, m1, m2, m3;
+    for (; nBlocks > 0; --nBlocks, blocks += 64) {
+        __m128i abcdSaved = abcd, e0Saved = e0;
+        SHA1NI_GROUP( 0, m0, m1, m2, m3, e0, e1);
+        SHA1NI_GROUP( 1, m1, m2, m3, m0, e1, e0);
+        SHA1NI_GROUP( 2, m2, m3, m0, m1, e0, e1);
+        SHA1NI_GROUP( 3, m3, m0, m1, m2, e1, e0);
+        SHA1NI_GROUP( 4, m0, m1, m2, m3, e0, e1);
+        SHA1NI_GROUP( 5, m1, m2, m3, m0, e1, e0);
+        SHA1NI_GROUP( 6, m2, m3, m0, m1, e0, e1);
+        SHA1NI_GROUP( 7, m3, m0, m1, m2, e1, e0);
+        SHA1NI_GROUP( 8, m0, m1, m2, m3, e0, e1);
+        SHA1NI_GROUP( 9, m1, m2, m3, m0, e1, e0);
+        SHA1NI_GROUP(10, m2, m3, m0, m1, e0, e1);
+        SHA1NI_GROUP(11, m3, m0, m1, m2, e1, e0);
+        SHA1NI_GROUP(12, m0, m1, m2, m3, e0, e1);
+        SHA1NI_GROUP(13, m1, m2, m3, m0, e1, e0);
+        SHA1NI_GROUP(14, m2, m3, m0, m1, e0, e1);
+        SHA1NI_GROUP(15, m3, m0, m1, m2, e1, e0);
+        SHA1NI_GROUP(16, m0, m1, m2, m3, e0, e1);
+        SHA1NI_GROUP(17, m1, m2, m3, m0, e1, e0);
+        SHA1NI_GROUP(18, m2, m3, m0, m1, e0, e1);
+        SHA1NI_GROUP(19, m3, m0, m1, m2, e1, e0);
+        e0 = _mm_sha1nexte_epu32(e0, e0Saved);
+        abcd = _mm_add_epi32(abcd, abcdSaved);
+    }
+    _mm_storeu_si128((__m128i*)state, _mm_shuffle_epi32(abcd, 0x1B));
+    state[4] = (uint32_t)_mm_extract_epi32(e0, 3);
+}
+
+
+/* One group of four SHA-256 rounds. G is the group number 0..15; M0..M3 are the message vectors
+   starting with group G's, so M3 is the previous group's. */
+#define SHA256NI_GROUP(G, M0, M1, M2, M3) do {                                              \
+        if ((G) < 4)                                                                        \
+            M0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(blocks + 16*(G))), mask);\
+        __m128i msg = _mm_add_epi32(M0, _mm_load_si128((const __m128i*)&kSHA256K[4*(G)]));  \
+        state1 = _mm_sha256rnds2_epu32(state1, state0, msg);                                \
+        if ((G) >= 3 && (G) <= 14) {                                                        \
+            M1 = _mm_add_epi32(M1, _mm_alignr_epi8(M0, M3, 4));                             \
+            M1 = _mm_sha256msg2_epu32(M1, M0);                                              \
+        }                                                                                   \
+        state0 = _mm_sha256rnds2_epu32(state0, state1, _mm_shuffle_epi32(msg, 0x0E));       \
+        if ((G) >= 1 && (G) <= 12)                                                          \
+            M3 = _mm_sha256msg1_epu32(M3, M0);                                              \
+    } while (0)
+
+__attribute__((target("sha,sse4.1")))
+static void sha256SHANI (uint32_t *state, const uint8_t *blocks, size_t nBlocks) {
+    const __m128i mask = _mm_set_epi64x(0x0C0D0E0F08090A0BULL, 0x0405060700010203ULL);
+    // The instructions want the state as ABEF and CDGH:
+    __m128i tmp = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i*)&state[0]), 0xB1);     // CDAB
+    __m128i state1 = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i*)&state[4]), 0x1B);  // EFGH
+    __m128i state0 = _mm_alignr_epi8(tmp, state1, 8);                                       // ABEF
+    state1 = _mm_blend_epi16(state1, tmp, 0xF0);                                            // CDGH
+    __m128i m0, m1, m2, m3;
+    for (; nBlocks > 0; --nBlocks, blocks += 64) {
+        __m128i abefSaved = state0, cdghSaved = state1;
+        SHA256NI_GROUP( 0, m0, m1, m2, m3);
+        SHA256NI_GROUP( 1, m1, m2, m3, m0);
+        SHA256NI_GROUP( 2, m2, m3, m0, m1);
+        SHA256NI_GROUP( 3, m3, m0, m1, m2);
+        SHA256NI_GROUP( 4, m0, m1, m2, m3);
+        SHA256NI_GROUP( 5, m1, m2, m3, m0);
+        SHA256NI_GROUP( 6, m2, m3, m0, m1);
+        SHA256NI_GROUP( 7, m3, m0, m1, m2);
+        SHA256NI_GROUP( 8, m0, m1, m2, m3);
+        SHA256NI_GROUP( 9, m1, m2, m3, m0);
+        SHA256NI_GROUP(10, m2, m3, m0, m1);
+        SHA256NI_GROUP(11, m3, m0, m1, m2);
+        SHA256NI_GROUP(12, m0, m1, m2, m3);
+        SHA256NI_GROUP(13, m1, m2, m3, m0);
+        SHA256NI_GROUP(14, m2, m3, m0, m1);
+        SHA256NI_GROUP(15, m3, m0, m1, m2);
+        state0 = _mm_add_epi32(state0, abefSaved);
+        state1 = _mm_add_epi32(state1, cdghSaved);
+    }
+    tmp = _mm_shuffle_epi32(state0, 0x1B);                                                  // FEBA
+    state1 = _mm_shuffle_epi32(state1, 0xB1);                                               // DCHG
+    _mm_storeu_si128((__m128i*)&state[0], _mm_blend_epi16(tmp, state1, 0xF0));              // DCBA
+    _mm_storeu_si128((__m128i*)&state[4], _mm_alignr_epi8(state1, tmp, 8));                 // HGFE
+}
+
+#endif // MY_SHA_X86
+
+
+#if MY_SHA_ARM
+
+#pragma mark -
+#pragma mark ARMv8:
+
+
+static inline uint32x4_t loadBE32x4 (const uint8_t *p) {
+    return vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(p)));
+}
+
+
+/* One group of four SHA-1 rounds. G is the group number 0..19; M0..M3 are the message vectors
+   starting with group G's. K_CUR holds group G's words plus the round constant, and K_NEXT2
+   receives group G+2's. */
+#define SHA1ARM_GROUP(G, OP, M0, M1, M2, M3, E_IN, E_OUT, K_CUR, K_NEXT2) do {              \
+        E_OUT = vsha1h_u32(vgetq_lane_u32(abcd, 0));                                        \
+        abcd = OP(abcd, E_IN, K_CUR);                                                       \
+        if ((G) <= 17)                                                                      \
+            K_NEXT2 = vaddq_u32(M2, vdupq_n_u32(kSHA1K[((G) + 2) / 5]));                    \
+        if ((G) >= 1 && (G) <= 16)                                                          \
+            M3 = vsha1su1q_u32(M3, M2);                                                     \
+        if ((G) <= 15)                                                                      \
+            M0 = vsha1su0q_u32(M0, M1, M2);                                                 \
+    } while (0)
+
+MY_SHA_ARM_TARGET
+static void sha1ARM (uint32_t *state, const uint8_t *blocks, size_t nBlocks) {
+    uint32x4_t abcd = vld1q_u32(state);
+    uint32_t e0 = state[4], e1;
+    for (; nBlocks > 0; --nBlocks, blocks += 64) {
+        uint32x4_t abcdSaved = abcd;
+        uint32_t e0Saved = e0;
+        uint32x4_t m0 = loadBE32x4(blocks),      m1 = loadBE32x4(blocks + 16),
+                   m2 = loadBE32x4(blocks + 32), m3 = loadBE32x4(blocks + 48);
+        uint32x4_t k0 = vaddq_u32(m0, vdupq_n_u32(kSHA1K[0]));
+        uint32x4_t k1 = vaddq_u32(m1, vdupq_n_u32(kSHA1K[0]));
+        SHA1ARM_GROUP( 0, vsha1cq_u32, m0, m1, m2, m3, e0, e1, k0, k0);
+        SHA1ARM_GROUP( 1, vsha1cq_u32, m1, m2, m3, m0, e1, e0, k1, k1);
+        SHA1ARM_GROUP( 2, vsha1cq_u32, m2, m3, m0, m1, e0, e1, k0, k0);
+        SHA1ARM_GROUP( 3, vsha1cq_u32, m3, m0, m1, m2, e1, e0, k1, k1);
+        SHA1ARM_GROUP( 4, vsha1cq_u32, m0, m1, m2, m3, e0, e1, k0, k0);
+        SHA1ARM_GROUP( 5, vsha1pq_u32, m1, m2, m3, m0, e1, e0, k1, k1);
+        SHA1ARM_GROUP( 6, vsha1pq_u32, m2, m3, m0, m1, e0, e1, k0, k0);
+        SHA1ARM_GROUP( 7, vsha1pq_u32, m3, m0, m1, m2, e1, e0, k1, k1);
+        SHA1ARM_GROUP( 8, vsha1pq_u32, m0, m1, m2, m3, e0, e1, k0, k0);
+        SHA1ARM_GROUP( 9, vsha1pq_u32, m1, m2, m3, m0, e1, e0, k1, k1);
+        SHA1ARM_GROUP(10, vsha1mq_u32, m2, m3, m0, m1, e0, e1, k0, k0);
+        SHA1ARM_GROUP(11, vsha1mq_u32, m3, m0, m1, m2, e1, e0, k1, k1);
+        SHA1ARM_GROUP(12, vsha1mq_u32, m0, m1, m2, m3, e0, e1, k0, k0);
+        SHA1ARM_GROUP(13, vsha1mq_u32, m1, m2, m3, m0, e1, e0, k1, k1);
+        SHA1ARM_GROUP(14, vsha1mq_u32, m2, m3, m0, m1, e0, e1, k0, k0);
+        SHA1ARM_GROUP(15, vsha1pq_u32, m3, m0, m1, m2, e1, e0, k1, k1);
+        SHA1ARM_GROUP(16, vsha1pq_u32, m0, m1, m2, m3, e0, e1, k0, k0);
+        SHA1ARM_GROUP(17, vsha1pq_u32, m1, m2, m3, m0, e1, e0, k1, k1);
+        SHA1ARM_GROUP(18, vsha1pq_u32, m2, m3, m0, m1, e0, e1, k0, k0);
+        SHA1ARM_GROUP(19, vsha1pq_u32, m3, m0, m1, m2, e1, e0, k1, k1);
+        abcd = vaddq_u32(abcd, abcdSaved);
+        e0 += e0Saved;
+    }
+    vst1q_u32(state, abcd);
+    state[4] = e0;
+}
+
+
+/* One group of four SHA-256 rounds. G is the group number 0..15; M0..M3 are the message vectors
+   starting with group G's. K_CUR holds group G's words plus constants; K_NEXT receives G+1's. */
+#define SHA256ARM_GROUP(G, M0, M1, M2, M3, K_CUR, K_NEXT) do {                              \
+        if ((G) < 12)                                                                       \
+            M0 = vsha256su0q_u32(M0, M1);                                                   \
+        uint32x4_t abcd = state0;                                                           \
+        if ((G) < 15)                                                                       \
+            K_NEXT = vaddq_u32(M1, vld1q_u32(&kSHA256K[4*((G) + 1)]));                      \
+        state0 = vsha256hq_u32(state0, state1, K_CUR);                                      \
+        state1 = vsha256h2q_u32(state1, abcd, K_CUR);                                       \
+        if ((G) < 12)                                                                       \
+            M0 = vsha256su1q_u32(M0, M2, M3);                                               \
+    } while (0)
+
+MY_SHA_ARM_TARGET
+static void sha256ARM (uint32_t *state, const uint8_t *blocks, size_t nBlocks) {
+    uint32x4_t state0 = vld1q_u32(&state[0]), state1 = vld1q_u32(&state[4]);
+    for (; nBlocks > 0; --nBlocks, blocks += 64) {
+        uint32x4_t abcdSaved = state0, efghSaved = state1;
+        uint32x4_t m0 = loadBE32x4(blocks),      m1 = loadBE32x4(blocks + 16),
+                   m2 = loadBE32x4(blocks + 32), m3 = loadBE32x4(blocks + 48);
+        uint32x4_t k0 = vaddq_u32(m0, vld1q_u32(&kSHA256K[0])), k1;
+        SHA256ARM_GROUP( 0, m0, m1, m2, m3, k0, k1);
+        SHA256ARM_GROUP( 1, m1, m2, m3, m0, k1, k0);
+        SHA256ARM_GROUP( 2, m2, m3, m0, m1, k0, k1);
+        SHA256ARM_GROUP( 3, m3, m0, m1, m2, k1, k0);
+        SHA256ARM_GROUP( 4, m0, m1, m2, m3, k0, k1);
+        SHA256ARM_GROUP( 5, m1, m2, m3, m0, k1, k0);
+        SHA256ARM_GROUP( 6, m2, m3, m0, m1, k0, k1);
+        SHA256ARM_GROUP( 7, m3, m0, m1, m2, k1, k0);
+        SHA256ARM_GROUP( 8, m0, m1, m2, m3, k0, k1);
+        SHA256ARM_GROUP( 9, m1, m2, m3, m0, k1, k0);
+        SHA256ARM_GROUP(10, m2, m3, m0, m1, k0, k1);
+        SHA256ARM_GROUP(11, m3, m0, m1, m2, k1, k0);
+        SHA256ARM_GROUP(12, m0, m1, m2, m3, k0, k1);
+        SHA256ARM_GROUP(13, m1, m2, m3, m0, k1, k0);
+        SHA256ARM_GROUP(14, m2, m3, m0, m1, k0, k1);
+        SHA256ARM_GROUP(15, m3, m0, m1, m2, k1, k0);
+        state0 = vaddq_u32(state0, abcdSaved);
+        state1 = vaddq_u32(state1, efghSaved);
+    }
+    vst1q_u32(&state[0], state0);
+    vst1q_u32(&state[4], state1);
+}
+
+static BOOL cpuHasARMSHA (void) {
+#if defined(__APPLE__)
+    int value = 0;
+    size_t size = sizeof(value);
+    if (sysctlbyname("hw.optional.arm.FEAT_SHA256", &value, &size, NULL, 0) == 0)
+        return value != 0;
+    return YES;     // Older OS versions don't have the key, but every arm64 Apple CPU has SHA
+#elif defined(__linux__)
+    unsigned long hwcap = getauxval(AT_HWCAP);
+    return (hwcap & HWCAP_SHA1) && (hwcap & HWCAP_SHA2);
+#elif defined(__ARM_FEATURE_CRYPTO) || defined(__ARM_FEATURE_SHA2)
+    return YES;     // The compiler was told to assume it
+#else
+    return NO;      // No way to ask
+#endif
+}
+
+#endif // MY_SHA_ARM
+
+
+#pragma mark -
+#pragma mark DISPATCH:
+
+
+static SHAKernel sSHA1Kernel = sha1Scalar, sSHA256Kernel = sha256Scalar;
+static const char *sKernelName = "scalar";
+
+static void chooseKernels (void) {
+    static dispatch_once_t once;
+    dispatch_once(&once, ^{
+#if MY_SHA_X86
+        __builtin_cpu_init();
+        unsigned eax, ebx = 0, ecx, edx;
+        BOOL hasSHA = NO;
+        if (__get_cpuid_max(0, NULL) >= 7) {
+            __cpuid_count(7, 0, eax, ebx, ecx, edx);
+            hasSHA = (ebx & (1 << 29)) != 0;        // (__builtin_cpu_supports doesn't know "sha")
+        }
+        if (hasSHA && __builtin_cpu_supports("sse4.1")) {
+            sSHA1Kernel = sha1SHANI;
+            sSHA256Kernel = sha256SHANI;
+            sKernelName = "SHA-NI";
+        } else if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("bmi2")) {
+            sSHA1Kernel = sha1AVX2;
+            sSHA256Kernel = sha256AVX2;
+            sKernelName = "AVX2";
+        }
+#elif MY_SHA_ARM
+        if (cpuHasARMSHA()) {
+            sSHA1Kernel = sha1ARM;
+            sSHA256Kernel = sha256ARM;
+            sKernelName = "ARMv8";
+        }
+#endif
+    });
+}
+
+const char* MYSHAKernelName (void) {
+    chooseKernels();
+    return sKernelName;
+}
+
+
+#pragma mark -
+#pragma mark CONTEXTS:
+
+
+/* Adds bytes to a context's buffer and state. The SHA-1 and SHA-256 contexts differ only in the
+   size of the state, which comes first, so this works on both. */
+static void shaUpdate (uint32_t *state, uint64_t *ioLength, uint8_t buffer[64],
+                       SHAKernel kernel, const uint8_t *bytes, size_t length)
+{
+    size_t used = (size_t)(*ioLength % 64);
+    *ioLength += length;
+    if (used > 0) {
+        size_t n = MIN(length, 64 - used);
+        memcpy(buffer + used, bytes, n);
+        bytes += n;
+        length -= n;
+        if (used + n < 64)
+            return;
+        kernel(state, buffer, 1);
+    }
+    if (length >= 64) {
+        kernel(state, bytes, length / 64);
+        bytes += length & ~(size_t)63;
+        length %= 64;
+    }
+    memcpy(buffer, bytes, length);
+}
+
+/* Appends the padding and length, and processes the final block(s). */
+static void shaFinal (uint32_t *state, uint64_t length, uint8_t buffer[64], SHAKernel kernel) {
+    size_t used = (size_t)(length % 64);
+    buffer[used++] = 0x80;
+    if (used > 56) {
+        memset(buffer + used, 0, 64 - used);
+        kernel(state, buffer, 1);
+        used = 0;
+    }
+    memset(buffer + used, 0, 56 - used);
+    writeBE32(buffer + 56, (uint32_t)(length >> 29));
+    writeBE32(buffer + 60, (uint32_t)(length << 3));
+    kernel(state, buffer, 1);
+}
+
+
+void MYSHA1Init (MYSHA1Context *context) {
+    chooseKernels();
+    memcpy(context->state, kSHA1InitialState, sizeof(context->state));
+    context->length = 0;
+}
+
+void MYSHA1Update (MYSHA1Context *context, const void *bytes, size_t length) {
+    shaUpdate(context->state, &context->length, context->buffer, sSHA1Kernel, bytes, length);
+}
+
+void MYSHA1Final (MYSHA1Context *context, void *outDigest) {
+    shaFinal(context->state, context->length, context->buffer, sSHA1Kernel);
+    for (int i = 0; i < 5; i++)
+        writeBE32((uint8_t*)outDigest + 4*i, context->state[i]);
+}
+
+void MYSHA1 (const void *bytes, size_t length, void *outDigest) {
+    MYSHA1Context context;
+    MYSHA1Init(&context);
+    MYSHA1Update(&context, bytes, length);
+    MYSHA1Final(&context, outDigest);
+}
+
+
+void MYSHA256Init (MYSHA256Context *context) {
+    chooseKernels();
+    memcpy(context->state, kSHA256InitialState, sizeof(context->state));
+    context->length = 0;
+}
+
+void MYSHA256Update (MYSHA256Context *context, const void *bytes, size_t length) {
+    shaUpdate(context->state, &context->length, context->buffer, sSHA256Kernel, bytes, length);
+}
+
+void MYSHA256Final (MYSHA256Context *context, void *outDigest) {
+    shaFinal(context->state, context->length, context->buffer, sSHA256Kernel);
+    for (int i = 0; i < 8; i++)
+        writeBE32((uint8_t*)outDigest + 4*i, context->state[i]);
+}
+
+void MYSHA256 (const void *bytes, size_t length, void *outDigest) {
+    MYSHA256Context context;
+    MYSHA256Init(&context);
+    MYSHA256Update(&context, bytes, length);
+    MYSHA256Final(&context, outDigest);
+}
+
+
+#pragma mark -
+#pragma mark SHA-512:
+
+
+static const uint64_t kSHA512InitialState[8] = {
+    0x6A09E667F3BCC908, 0xBB67AE8584CAA73B, 0x3C6EF372FE94F82B, 0xA54FF53A5F1D36F1,
+    0x510E527FADE682D1, 0x9B05688C2B3E6C1F, 0x1F83D9ABFB41BD6B, 0x5BE0CD19137E2179
+};
+
+static const uint64_t kSHA384InitialState[8] = {
+    0xCBBB9D5DC1059ED8, 0x629A292A367CD507, 0x9159015A3070DD17, 0x152FECD8F70E5939,
+    0x67332667FFC00B31, 0x8EB44A8768581511, 0xDB0C2E0D64F98FA7, 0x47B5481DBEFA4FA4
+};
+
+static const uint64_t kSHA512K[80] = {
+    0x428A2F98D728AE22, 0x7137449123EF65CD, 0xB5C0FBCFEC4D3B2F, 0xE9B5DBA58189DBBC,
+    0x3956C25BF348B538, 0x59F111F1B605D019, 0x923F82A4AF194F9B, 0xAB1C5ED5DA6D8118,
+    0xD807AA98A3030242, 0x12835B0145706FBE, 0x243185BE4EE4B28C, 0x550C7DC3D5FFB4E2,
+    0x72BE5D74F27B896F, 0x80DEB1FE3B1696B1, 0x9BDC06A725C71235, 0xC19BF174CF692694,
+    0xE49B69C19EF14AD2, 0xEFBE4786384F25E3, 0x0FC19DC68B8CD5B5, 0x240CA1CC77AC9C65,
+    0x2DE92C6F592B0275, 0x4A7484AA6EA6E483, 0x5CB0A9DCBD41FBD4, 0x76F988DA831153B5,
+    0x983E5152EE66DFAB, 0xA831C66D2DB43210, 0xB00327C898FB213F, 0xBF597FC7BEEF0EE4,
+    0xC6E00BF33DA88FC2, 0xD5A79147930AA725, 0x06CA6351E003826F, 0x142929670A0E6E70,
+    0x27B70A8546D22FFC, 0x2E1B21385C26C926, 0x4D2C6DFC5AC42AED, 0x53380D139D95B3DF,
+    0x650A73548BAF63DE, 0x766A0ABB3C77B2A8, 0x81C2C92E47EDAEE6, 0x92722C851482353B,
+    0xA2BFE8A14CF10364, 0xA81A664BBC423001, 0xC24B8B70D0F89791, 0xC76C51A30654BE30,
+    0xD192E819D6EF5218, 0xD69906245565A910, 0xF40E35855771202A, 0x106AA07032BBD1B8,
+    0x19A4C116B8D2D0C8, 0x1E376C085141AB53, 0x2748774CDF8EEB99, 0x34B0BCB5E19B48A8,
+    0x391C0CB3C5C95A63, 0x4ED8AA4AE3418ACB, 0x5B9CCA4F7763E373, 0x682E6FF3D6B2B8A3,
+    0x748F82EE5DEFB2FC, 0x78A5636F43172F60, 0x84C87814A1F0AB72, 0x8CC702081A6439EC,
+    0x90BEFFFA23631E28, 0xA4506CEBDE82BDE9, 0xBEF9A3F7B2C67915, 0xC67178F2E372532B,
+    0xCA273ECEEA26619C, 0xD186B8C721C0C207, 0xEADA7DD6CDE0EB1E, 0xF57D4F7FEE6ED178,
+    0x06F067AA72176FBA, 0x0A637DC5A2C898A6, 0x113F9804BEF90DAE, 0x1B710B35131C471B,
+    0x28DB77F523047D84, 0x32CAAB7B40C72493, 0x3C9EBE0A15C9BEBC, 0x431D67C49C100D4C,
+    0x4CC5D4BECB3E42B6, 0x597F299CFC657E2A, 0x5FCB6FAB3AD6FAEC, 0x6C44198C4A475817,
+};
+
+
+static inline uint64_t ror64 (uint64_t x, unsigned n)   {return (x >> n) | (x << (64 - n));}
+
+static inline uint64_t readBE64 (const uint8_t *p) {
+    return (uint64_t)readBE32(p) << 32 | readBE32(p + 4);
+}
+
+static inline void writeBE64 (uint8_t *p, uint64_t n) {
+    writeBE32(p, (uint32_t)(n >> 32));
+    writeBE32(p + 4, (uint32_t)n);
+}
+
+
+static void sha512Blocks (uint64_t *state, const uint8_t *blocks, size_t nBlocks) {
+    uint64_t w[80];
+    for (; nBlocks > 0; --nBlocks, blocks += 128) {
+        for (int t = 0; t < 16; t++)
+            w[t] = readBE64(blocks + 8*t);
+        for (int t = 16; t < 80; t++) {
+            uint64_t s0 = ror64(w[t-15], 1) ^ ror64(w[t-15], 8) ^ (w[t-15] >> 7);
+            uint64_t s1 = ror64(w[t-2], 19) ^ ror64(w[t-2], 61) ^ (w[t-2] >> 6);
+            w[t] = w[t-16] + s0 + w[t-7] + s1;
+        }
+        uint64_t a = state[0], b = state[1], c = state[2], d = state[3],
+                 e = state[4], f = state[5], g = state[6], h = state[7];
+        for (int t = 0; t < 80; t++) {
+            uint64_t t1 = h + (ror64(e, 14) ^ ror64(e, 18) ^ ror64(e, 41)) + (g ^ (e & (f ^ g)))
+                            + kSHA512K[t] + w[t];
+            uint64_t t2 = (ror64(a, 28) ^ ror64(a, 34) ^ ror64(a, 39)) + ((a & b) | (c & (a | b)));
+            h = g;  g = f;  f = e;  e = d + t1;  d = c;  c = b;  b = a;  a = t1 + t2;
+        }
+        state[0] += a;  state[1] += b;  state[2] += c;  state[3] += d;
+        state[4] += e;  state[5] += f;  state[6] += g;  state[7] += h;
+    }
+}
+
+
+void MYSHA512Init (MYSHA512Context *context) {
+    memcpy(context->state, kSHA512InitialState, sizeof(context->state));
+    context->length = 0;
+}
+
+void MYSHA384Init (MYSHA512Context *context) {
+    memcpy(context->state, kSHA384InitialState, sizeof(context->state));
+    context->length = 0;
+}
+
+void MYSHA512Update (MYSHA512Context *context, const void *bytes, size_t length) {
+    size_t used = (size_t)(context->length % 128);
+    context->length += length;
+    if (used > 0) {
+        size_t n = MIN(length, 128 - used);
+        memcpy(context->buffer + used, bytes, n);
+        bytes = (const uint8_t*)bytes + n;
+        length -= n;
+        if (used + n < 128)
+            return;
+        sha512Blocks(context->state, context->buffer, 1);
+    }
+    if (length >= 128) {
+        sha512Blocks(context->state, bytes, length / 128);
+        bytes = (const uint8_t*)bytes + (length & ~(size_t)127);
+        length %= 128;
+    }
+    memcpy(context->buffer, bytes, length);
+}
+
+/* Appends the padding and the 128-bit length, and processes the final block(s). */
+static void sha512Final (MYSHA512Context *context) {
+    uint8_t *buffer = context->buffer;
+    size_t used = (size_t)(context->length % 128);
+    buffer[used++] = 0x80;
+    if (used > 112) {
+        memset(buffer + used, 0, 128 - used);
+        sha512Blocks(context->state, buffer, 1);
+        used = 0;
+    }
+    memset(buffer + used, 0, 120 - used);
+    writeBE64(buffer + 120, context->length << 3);
+    buffer[119] = (uint8_t)(context->length >> 61);
+    sha512Blocks(context->state, buffer, 1);
+}
+
+void MYSHA512Final (MYSHA512Context *context, void *outDigest) {
+    sha512Final(context);
+    for (int i = 0; i < 8; i++)
+        writeBE64((uint8_t*)outDigest + 8*i, context->state[i]);
+}
+
+void MYSHA384Final (MYSHA512Context *context, void *outDigest) {
+    sha512Final(context);
+    for (int i = 0; i < 6; i++)
+        writeBE64((uint8_t*)outDigest + 8*i, context->state[i]);
+}
+
+void MYSHA512 (const void *bytes, size_t length, void *outDigest) {
+    MYSHA512Context context;
+    MYSHA512Init(&context);
+    MYSHA512Update(&context, bytes, length);
+    MYSHA512Final(&context, outDigest);
+}
+
+void MYSHA384 (const void *bytes, size_t length, void *outDigest) {
+    MYSHA512Context context;
+    MYSHA384Init(&context);
+    MYSHA384Update(&context, bytes, length);
+    MYSHA384Final(&context, outDigest);
+}
+
+
+#pragma mark -
+#pragma mark MULTI-BUFFER:
+
+
+/* A multi-buffer kernel processes one block from each of N independent messages at once, with
+   lane i of every vector working on message i. They're written with the compiler's generic
+   vector extensions, so one definition serves for SSE2 or NEON (4 lanes), AVX2 (8 lanes) and
+   AVX-512 (16 lanes.) The state is stored transposed: word w of lane i is at state[w*N + i]. */
+typedef void (*MultiBlockKernel)(uint32_t *state, const uint8_t * const *blocks);
+
+typedef struct {
+    MultiBlockKernel sha1, sha256;
+    unsigned lanes;
+    const char *name;
+} MultiBufferKernels;
+
+#define kMaxLanes 16
+
+#define VROR(X, N)  (((X) >> (N)) | ((X) << (32 - (N))))
+#define VROL(X, N)  (((X) << (N)) | ((X) >> (32 - (N))))
+
+#define SHA1_MULTI_ROUNDS(FIRST, F, K)                                                      \
+        for (int t = FIRST; t < FIRST + 20; t++) {                                          \
+            if (t >= 16)                                                                    \
+                w[t & 15] = VROL(w[(t+13) & 15] ^ w[(t+8) & 15] ^ w[(t+2) & 15] ^ w[t & 15], 1); \
+            V temp = VROL(a, 5) + (F) + e + (K) + w[t & 15];                                \
+            e = d;  d = c;  c = VROL(b, 30);  b = a;  a = temp;                             \
+        }
+
+#define DEFINE_MULTI_KERNELS(SUFFIX, LANES, ATTRIBUTES)                                     \
+    typedef uint32_t Vector##SUFFIX __attribute__((vector_size(4 * (LANES))));              \
+                                                                                            \
+    ATTRIBUTES                                                                              \
+    static void sha1Multi##SUFFIX (uint32_t *state, const uint8_t * const *blocks) {        \
+        typedef Vector##SUFFIX V;                                                           \
+        V w[16], s[5];                                                                      \
+        for (int t = 0; t < 16; t++)                                                        \
+            for (int l = 0; l < (LANES); l++)                                               \
+                w[t][l] = readBE32(blocks[l] + 4*t);                                        \
+        memcpy(s, state, sizeof(s));                                                        \
+        V a = s[0], b = s[1], c = s[2], d = s[3], e = s[4];                                 \
+        SHA1_MULTI_ROUNDS( 0, d ^ (b & (c ^ d)),       kSHA1K[0])                           \
+        SHA1_MULTI_ROUNDS(20, b ^ c ^ d,               kSHA1K[1])                           \
+        SHA1_MULTI_ROUNDS(40, (b & c) | (d & (b | c)), kSHA1K[2])                           \
+        SHA1_MULTI_ROUNDS(60, b ^ c ^ d,               kSHA1K[3])                           \
+        s[0] += a;  s[1] += b;  s[2] += c;  s[3] += d;  s[4] += e;                          \
+        memcpy(state, s, sizeof(s));                                                        \
+    }                                                                                       \
+                                                                                            \
+    ATTRIBUTES                                                                              \
+    static void sha256Multi##SUFFIX (uint32_t *state, const uint8_t * const *blocks) {      \
+        typedef Vector##SUFFIX V;                                                           \
+        V w[16], s[8];                                                                      \
+        for (int t = 0; t < 16; t++)                                                        \
+            for (int l = 0; l < (LANES); l++)                                               \
+                w[t][l] = readBE32(blocks[l] + 4*t);                                        \
+        memcpy(s, state, sizeof(s));                                                        \
+        V a = s[0], b = s[1], c = s[2], d = s[3], e = s[4], f = s[5], g = s[6], h = s[7];   \
+        for (int t = 0; t < 64; t++) {                                                      \
+            if (t >= 16) {                                                                  \
+                V w15 = w[(t+1) & 15], w2 = w[(t+14) & 15];                                 \
+                w[t & 15] += (VROR(w15, 7) ^ VROR(w15, 18) ^ (w15 >> 3)) + w[(t+9) & 15]    \
+                           + (VROR(w2, 17) ^ VROR(w2, 19) ^ (w2 >> 10));                    \
+            }                                                                               \
+            V t1 = h + (VROR(e, 6) ^ VROR(e, 11) ^ VROR(e, 25)) + (g ^ (e & (f ^ g)))       \
+                     + kSHA256K[t] + w[t & 15];                                             \
+            V t2 = (VROR(a, 2) ^ VROR(a, 13) ^ VROR(a, 22)) + ((a & b) | (c & (a | b)));    \
+            h = g;  g = f;  f = e;  e = d + t1;  d = c;  c = b;  b = a;  a = t1 + t2;       \
+        }                                                                                   \
+        s[0] += a;  s[1] += b;  s[2] += c;  s[3] += d;                                      \
+        s[4] += e;  s[5] += f;  s[6] += g;  s[7] += h;                                      \
+        memcpy(state, s, sizeof(s));                                                        \
+    }
+
+#if MY_SHA_X86
+DEFINE_MULTI_KERNELS(x4, 4, )                       // SSE2 is always available on x86-64
+DEFINE_MULTI_KERNELS(x8, 8, __attribute__((target("avx2"))))
+DEFINE_MULTI_KERNELS(x16, 16, __attribute__((target("avx512f"))))
+#define MY_SHA_MULTI 1
+#elif defined(__aarch64__) || defined(__arm64__)
+DEFINE_MULTI_KERNELS(x4, 4, )                       // NEON is always available on ARM64
+#define MY_SHA_MULTI 1
+#endif
+
+
+static MultiBufferKernels sMultiKernels = {NULL, NULL, 1, "serial"};
+
+static void chooseMultiBufferKernels (void) {
+    static dispatch_once_t once;
+    dispatch_once(&once, ^{
+        chooseKernels();
+#if MY_SHA_X86
+        if (__builtin_cpu_supports("avx512f"))
+            sMultiKernels = (MultiBufferKernels){sha1Multix16, sha256Multix16, 16, "AVX-512 x16"};
+        else if (__builtin_cpu_supports("avx2") && sSHA256Kernel != sha256SHANI)
+            sMultiKernels = (MultiBufferKernels){sha1Multix8, sha256Multix8, 8, "AVX2 x8"};
+        else if (sSHA256Kernel != sha256SHANI)
+            sMultiKernels = (MultiBufferKernels){sha1Multix4, sha256Multix4, 4, "SSE2 x4"};
+        // (Eight lanes of AVX2 don't beat one SHA-NI unit, so with SHA-NI and no AVX-512 the
+        // messages are just hashed one after another.)
+#elif MY_SHA_MULTI
+        if (sSHA256Kernel == sha256Scalar)
+            sMultiKernels = (MultiBufferKernels){sha1Multix4, sha256Multix4, 4, "NEON x4"};
+#endif
+    });
+}
+
+const char* MYSHABatchKernelName (void) {
+    chooseMultiBufferKernels();
+    return sMultiKernels.name;
+}
+
+
+/* The progress of one message through a lane. */
+typedef struct {
+    const uint8_t *data;        // The next full block of the message
+    size_t fullBlocks;          // The number of full blocks left at 'data'
+    const uint8_t *tailNext;    // The next block of 'tail'
+    unsigned tailBlocks;        // The number of blocks left at 'tailNext'
+    size_t job;                 // Index of the message, or SIZE_MAX if the lane is idle
+    uint8_t tail[128];          // The last partial block of the message, padding and length
+} Lane;
+
+static void startLane (Lane *lane, size_t job, const MYDigestBuffer *input) {
+    size_t length = input->length;
+    size_t remainder = length % 64;
+    lane->job = job;
+    lane->data = input->bytes;
+    lane->fullBlocks = length / 64;
+    lane->tailNext = lane->tail;
+    lane->tailBlocks = (remainder + 9 <= 64) ? 1 : 2;
+    size_t end = 64 * lane->tailBlocks;
+    if (remainder > 0)
+        memcpy(lane->tail, lane->data + length - remainder, remainder);
+    lane->tail[remainder] = 0x80;
+    memset(lane->tail + remainder + 1, 0, end - 8 - (remainder + 1));
+    writeBE32(lane->tail + end - 8, (uint32_t)((uint64_t)length >> 29));
+    writeBE32(lane->tail + end - 4, (uint32_t)(length << 3));
+}
+
+static inline const uint8_t* nextBlock (Lane *lane) {
+    const uint8_t *block;
+    if (lane->fullBlocks > 0) {
+        block = lane->data;
+        lane->data += 64;
+        --lane->fullBlocks;
+    } else {
+        block = lane->tailNext;
+        lane->tailNext += 64;
+        --lane->tailBlocks;
+    }
+    return block;
+}
+
+/* Hashes a batch of messages using a multi-buffer kernel. Each lane takes the next message as
+   soon as it finishes one, so messages of different lengths keep all the lanes busy; once only
+   one message is left, it's finished with the single-buffer kernel. */
+static void hashBatch (MultiBlockKernel kernel, unsigned nLanes, SHAKernel serialKernel,
+                       const uint32_t *initialState, unsigned stateWords,
+                       const MYDigestBuffer *inputs, size_t count, uint8_t *outDigests)
+{
+    static const uint8_t kIdleBlock[64];
+    Lane lanes[kMaxLanes];
+    uint32_t state[8 * kMaxLanes] __attribute__((aligned(64)));
+    const uint8_t *blocks[kMaxLanes];
+    const size_t digestLength = 4 * stateWords;
+
+    size_t nextJob = 0;
+    unsigned active = 0;
+    for (unsigned l = 0; l < nLanes; l++) {
+        lanes[l].job = SIZE_MAX;
+        if (nextJob < count) {
+            startLane(&lanes[l], nextJob, &inputs[nextJob]);
+            ++nextJob;
+            ++active;
+        }
+        for (unsigned w = 0; w < stateWords; w++)
+            state[w*nLanes + l] = initialState[w];
+    }
+
+    while (active > 1 || (active == 1 && nextJob < count)) {
+        for (unsigned l = 0; l < nLanes; l++)
+            blocks[l] = (lanes[l].job != SIZE_MAX) ? nextBlock(&lanes[l]) : kIdleBlock;
+        kernel(state, blocks);
+        for (unsigned l = 0; l < nLanes; l++) {
+            Lane *lane = &lanes[l];
+            if (lane->job == SIZE_MAX || lane->fullBlocks > 0 || lane->tailBlocks > 0)
+                continue;
+            uint8_t *digest = outDigests + lane->job * digestLength;
+            for (unsigned w = 0; w < stateWords; w++) {
+                writeBE32(digest + 4*w, state[w*nLanes + l]);
+                state[w*nLanes + l] = initialState[w];
+            }
+            if (nextJob < count) {
+                startLane(lane, nextJob, &inputs[nextJob]);
+                ++nextJob;
+            } else {
+                lane->job = SIZE_MAX;
+                --active;
+            }
+        }
+    }
+
+    // Finish the last message, if any, by itself:
+    for (unsigned l = 0; l < nLanes && active > 0; l++) {
+        Lane *lane = &lanes[l];
+        if (lane->job == SIZE_MAX)
+            continue;
+        uint32_t s[8];
+        for (unsigned w = 0; w < stateWords; w++)
+            s[w] = state[w*nLanes + l];
+        if (lane->fullBlocks > 0)
+            serialKernel(s, lane->data, lane->fullBlocks);
+        serialKernel(s, lane->tailNext, lane->tailBlocks);
+        for (unsigned w = 0; w < stateWords; w++)
+            writeBE32(outDigests + lane->job * digestLength + 4*w, s[w]);
+        --active;
+    }
+}
+
+
+void MYSHA1Batch (const MYDigestBuffer *inputs, size_t count, void *outDigests) {
+    chooseMultiBufferKernels();
+    if (sMultiKernels.sha1 && count > 1) {
+        hashBatch(sMultiKernels.sha1, sMultiKernels.lanes, sSHA1Kernel, kSHA1InitialState, 5,
+                  inputs, count, outDigests);
+    } else {
+        for (size_t i = 0; i < count; i++)
+            MYSHA1(inputs[i].bytes, inputs[i].length, (uint8_t*)outDigests + 20*i);
+    }
+}
+
+void MYSHA256Batch (const MYDigestBuffer *inputs, size_t count, void *outDigests) {
+    chooseMultiBufferKernels();
+    if (sMultiKernels.sha256 && count > 1) {
+        hashBatch(sMultiKernels.sha256, sMultiKernels.lanes, sSHA256Kernel, kSHA256InitialState, 8,
+                  inputs, count, outDigests);
+    } else {
+        for (size_t i = 0; i < count; i++)
+            MYSHA256(inputs[i].bytes, inputs[i].length, (uint8_t*)outDigests + 32*i);
+    }
+}
+
+
+
+#pragma mark -
+#pragma mark TEST CASES:
+
+
+#import <CommonCrypto/CommonDigest.h>
+
+
+typedef struct {
+    const char *name;
+    SHAKernel sha1, sha256;
+} KernelPair;
+
+static NSArray* availableKernels (void) {
+    chooseKernels();
+    NSMutableArray *kernels = [NSMutableArray array];
+    [kernels addObject: [NSValue valueWithBytes: &(KernelPair){"scalar", sha1Scalar, sha256Scalar}
+                                       objCType: @encode(KernelPair)]];
+#if MY_SHA_X86
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("bmi2"))
+        [kernels addObject: [NSValue valueWithBytes: &(KernelPair){"AVX2", sha1AVX2, sha256AVX2}
+                                           objCType: @encode(KernelPair)]];
+    if (sSHA1Kernel == sha1SHANI)
+        [kernels addObject: [NSValue valueWithBytes: &(KernelPair){"SHA-NI", sha1SHANI, sha256SHANI}
+                                           objCType: @encode(KernelPair)]];
+#elif MY_SHA_ARM
+    if (sSHA1Kernel == sha1ARM)
+        [kernels addObject: [NSValue valueWithBytes: &(KernelPair){"ARMv8", sha1ARM, sha256ARM}
+                                           objCType: @encode(KernelPair)]];
+#endif
+    return kernels;
+}
+
+static NSString* hexDigest (const void *bytes, size_t length) {
+    NSMutableString *hex = [NSMutableString string];
+    for (size_t i = 0; i < length; i++)
+        [hex appendFormat: @"%02x", ((const uint8_t*)bytes)[i]];
+    return hex;
+}
+
+static NSString* sha1Hex (NSData *data) {
+    uint8_t digest[20];
+    MYSHA1(data.bytes, data.length, digest);
+    return hexDigest(digest, sizeof(digest));
+}
+
+static NSString* sha256Hex (NSData *data) {
+    uint8_t digest[32];
+    MYSHA256(data.bytes, data.length, digest);
+    return hexDigest(digest, sizeof(digest));
+}
+
+
+TestCase(MYSHA) {
+    Log(@"SHA kernel is %s", MYSHAKernelName());
+    NSData *empty = [NSData data];
+    NSData *abc = [@"abc" dataUsingEncoding: NSASCIIStringEncoding];
+    NSData *abc448 = [@"abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq"
+                            dataUsingEncoding: NSASCIIStringEncoding];
+    NSData *abc896 = [@"abcdefghbcdefghicdefghijdefghijkefghijklfghijklmghijklmnhijklmno"
+                       "ijklmnopjklmnopqklmnopqrlmnopqrsmnopqrstnopqrstu"
+                            dataUsingEncoding: NSASCIIStringEncoding];
+    NSMutableData *million = [NSMutableData dataWithLength: 1000000];
+    memset(million.mutableBytes, 'a', million.length);
+    NSMutableData *noise = [NSMutableData dataWithLength: 4096];
+    for (size_t i = 0; i < noise.length; i++)
+        ((uint8_t*)noise.mutableBytes)[i] = (uint8_t)random();
+
+    SHAKernel savedSHA1 = sSHA1Kernel, savedSHA256 = sSHA256Kernel;
+    for (NSValue *value in availableKernels()) {
+        KernelPair kernels;
+        [value getValue: &kernels];
+        Log(@"Testing %s kernels", kernels.name);
+        sSHA1Kernel = kernels.sha1;
+        sSHA256Kernel = kernels.sha256;
+
+        // FIPS 180 test vectors:
+        CAssertEqual(sha1Hex(empty), @"da39a3ee5e6b4b0d3255bfef95601890afd80709");
+        CAssertEqual(sha1Hex(abc), @"a9993e364706816aba3e25717850c26c9cd0d89d");
+        CAssertEqual(sha1Hex(abc448), @"84983e441c3bd26ebaae4aa1f95129e5e54670f1");
+        CAssertEqual(sha1Hex(abc896), @"a49b2446a02c645bf419f995b67091253a04a259");
+        CAssertEqual(sha1Hex(million), @"34aa973cd4c4daa4f61eeb2bdbad27316534016f");
+        CAssertEqual(sha256Hex(empty),
+                     @"e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855");
+        CAssertEqual(sha256Hex(abc),
+                     @"ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+        CAssertEqual(sha256Hex(abc448),
+                     @"248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1");
+        CAssertEqual(sha256Hex(abc896),
+                     @"cf5b16a778af8380036ce59e7b0492370b249b11e8f07a51afac45037afee9d1");
+        CAssertEqual(sha256Hex(million),
+                     @"cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0");
+
+        // Every length and alignment through a few blocks, against CommonCrypto:
+        for (size_t offset = 0; offset < 4; offset++) {
+            for (size_t length = 0; length < 300; length++) {
+                const uint8_t *bytes = (const uint8_t*)noise.bytes + offset;
+                uint8_t mine[32], theirs[32];
+                MYSHA1(bytes, length, mine);
+                CC_SHA1(bytes, (CC_LONG)length, theirs);
+                CAssert(memcmp(mine, theirs, 20) == 0, @"SHA-1 of %zu bytes", length);
+                MYSHA256(bytes, length, mine);
+                CC_SHA256(bytes, (CC_LONG)length, theirs);
+                CAssert(memcmp(mine, theirs, 32) == 0, @"SHA-256 of %zu bytes", length);
+            }
+        }
+
+        // Incremental updates in odd-sized pieces:
+        MYSHA256Context context;
+        MYSHA256Init(&context);
+        for (size_t pos = 0, n = 1; pos < noise.length; pos += n, n = n * 2 + 1)
+            MYSHA256Update(&context, (const uint8_t*)noise.bytes + pos, MIN(n, noise.length - pos));
+        uint8_t digest[32];
+        MYSHA256Final(&context, digest);
+        CAssertEqual(hexDigest(digest, 32), sha256Hex(noise));
+    }
+    sSHA1Kernel = savedSHA1;
+    sSHA256Kernel = savedSHA256;
+}
+
+
+static NSString* sha384Hex (NSData *data) {
+    uint8_t digest[48];
+    MYSHA384(data.bytes, data.length, digest);
+    return hexDigest(digest, sizeof(digest));
+}
+
+static NSString* sha512Hex (NSData *data) {
+    uint8_t digest[64];
+    MYSHA512(data.bytes, data.length, digest);
+    return hexDigest(digest, sizeof(digest));
+}
+
+
+TestCase(MYSHA512) {
+    NSData *empty = [NSData data];
+    NSData *abc = [@"abc" dataUsingEncoding: NSASCIIStringEncoding];
+    NSData *abc896 = [@"abcdefghbcdefghicdefghijdefghijkefghijklfghijklmghijklmnhijklmno"
+                       "ijklmnopjklmnopqklmnopqrlmnopqrsmnopqrstnopqrstu"
+                            dataUsingEncoding: NSASCIIStringEncoding];
+    NSMutableData *noise = [NSMutableData dataWithLength: 4096];
+    for (size_t i = 0; i < noise.length; i++)
+        ((uint8_t*)noise.mutableBytes)[i] = (uint8_t)random();
+
+    // FIPS 180 test vectors:
+    CAssertEqual(sha384Hex(empty), @"38b060a751ac96384cd9327eb1b1e36a21fdb71114be0743"
+                                    "4c0cc7bf63f6e1da274edebfe76f65fbd51ad2f14898b95b");
+    CAssertEqual(sha384Hex(abc), @"cb00753f45a35e8bb5a03d699ac65007272c32ab0eded163"
+                                  "1a8b605a43ff5bed8086072ba1e7cc2358baeca134c825a7");
+    CAssertEqual(sha384Hex(abc896), @"09330c33f71147e83d192fc782cd1b4753111b173b3b05d2"
+                                     "2fa08086e3b0f712fcc7c71a557e2db966c3e9fa91746039");
+    CAssertEqual(sha512Hex(empty), @"cf83e1357eefb8bdf1542850d66d8007d620e4050b5715dc83f4a921d36ce9ce"
+                                    "47d0d13c5d85f2b0ff8318d2877eec2f63b931bd47417a81a538327af927da3e");
+    CAssertEqual(sha512Hex(abc), @"ddaf35a193617abacc417349ae20413112e6fa4e89a97ea20a9eeee64b55d39a"
+                                  "2192992a274fc1a836ba3c23a3feebbd454d4423643ce80e2a9ac94fa54ca49f");
+    CAssertEqual(sha512Hex(abc896), @"8e959b75dae313da8cf4f72814fc143f8f7779c6eb9f7fa17299aeadb6889018"
+                                     "501d289e4900f7e4331b99dec4b5433ac7d329eeb6dd26545e96e55b874be909");
+
+    // Every length and alignment through a few blocks, against CommonCrypto:
+    for (size_t offset = 0; offset < 4; offset++) {
+        for (size_t length = 0; length < 400; length++) {
+            const uint8_t *bytes = (const uint8_t*)noise.bytes + offset;
+            uint8_t mine[64], theirs[64];
+            MYSHA384(bytes, length, mine);
+            CC_SHA384(bytes, (CC_LONG)length, theirs);
+            CAssert(memcmp(mine, theirs, 48) == 0, @"SHA-384 of %zu bytes", length);
+            MYSHA512(bytes, length, mine);
+            CC_SHA512(bytes, (CC_LONG)length, theirs);
+            CAssert(memcmp(mine, theirs, 64) == 0, @"SHA-512 of %zu bytes", length);
+        }
+    }
+
+    // Incremental updates in odd-sized pieces:
+    MYSHA512Context context;
+    MYSHA512Init(&context);
+    for (size_t pos = 0, n = 1; pos < noise.length; pos += n, n = n * 2 + 1)
+        MYSHA512Update(&context, (const uint8_t*)noise.bytes + pos, MIN(n, noise.length - pos));
+    uint8_t digest[64];
+    MYSHA512Final(&context, digest);
+    CAssertEqual(hexDigest(digest, 64), sha512Hex(noise));
+}
+
+TestCase(MYSHABenchmark) {
+    RequireTestCase(MYSHA);
+    static const size_t kSize = 64 * 1024 * 1024;
+    void *buffer = malloc(kSize);
+    memset(buffer, 0x55, kSize);
+    uint8_t digest[32];
+
+    SHAKernel savedSHA1 = sSHA1Kernel, savedSHA256 = sSHA256Kernel;
+    for (NSValue *value in availableKernels()) {
+        KernelPair kernels;
+        [value getValue: &kernels];
+        sSHA1Kernel = kernels.sha1;
+        sSHA256Kernel = kernels.sha256;
+        CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+        MYSHA1(buffer, kSize, digest);
+        CFAbsoluteTime sha1Time = CFAbsoluteTimeGetCurrent() - start;
+        start = CFAbsoluteTimeGetCurrent();
+        MYSHA256(buffer, kSize, digest);
+        CFAbsoluteTime sha256Time = CFAbsoluteTimeGetCurrent() - start;
+        Log(@"%-8s SHA-1: %6.0f MB/sec, SHA-256: %6.0f MB/sec",
+            kernels.name, kSize / sha1Time / 1e6, kSize / sha256Time / 1e6);
+    }
+    sSHA1Kernel = savedSHA1;
+    sSHA256Kernel = savedSHA256;
+
+    CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+    CC_SHA1(buffer, (CC_LONG)kSize, digest);
+    CFAbsoluteTime sha1Time = CFAbsoluteTimeGetCurrent() - start;
+    start = CFAbsoluteTimeGetCurrent();
+    CC_SHA256(buffer, (CC_LONG)kSize, digest);
+    CFAbsoluteTime sha256Time = CFAbsoluteTimeGetCurrent() - start;
+    Log(@"%-8s SHA-1: %6.0f MB/sec, SHA-256: %6.0f MB/sec",
+        "CommonCrypto", kSize / sha1Time / 1e6, kSize / sha256Time / 1e6);
+
+    uint8_t digest512[64];
+    start = CFAbsoluteTimeGetCurrent();
+    MYSHA512(buffer, kSize, digest512);
+    CFAbsoluteTime sha512Time = CFAbsoluteTimeGetCurrent() - start;
+    start = CFAbsoluteTimeGetCurrent();
+    CC_SHA512(buffer, (CC_LONG)kSize, digest512);
+    CFAbsoluteTime ccSHA512Time = CFAbsoluteTimeGetCurrent() - start;
+    Log(@"SHA-512: %6.0f MB/sec (CommonCrypto: %6.0f MB/sec)",
+        kSize / sha512Time / 1e6, kSize / ccSHA512Time / 1e6);
+    free(buffer);
+}
+
+
+static NSArray* availableMultiBufferKernels (void) {
+    NSMutableArray *kernels = [NSMutableArray array];
+#if MY_SHA_X86
+    [kernels addObject: [NSValue valueWithBytes: &(MultiBufferKernels){sha1Multix4, sha256Multix4, 4, "SSE2 x4"}
+                                       objCType: @encode(MultiBufferKernels)]];
+    if (__builtin_cpu_supports("avx2"))
+        [kernels addObject: [NSValue valueWithBytes: &(MultiBufferKernels){sha1Multix8, sha256Multix8, 8, "AVX2 x8"}
+                                           objCType: @encode(MultiBufferKernels)]];
+    if (__builtin_cpu_supports("avx512f"))
+        [kernels addObject: [NSValue valueWithBytes: &(MultiBufferKernels){sha1Multix16, sha256Multix16, 16, "AVX-512 x16"}
+                                           objCType: @encode(MultiBufferKernels)]];
+#elif MY_SHA_MULTI
+    [kernels addObject: [NSValue valueWithBytes: &(MultiBufferKernels){sha1Multix4, sha256Multix4, 4, "NEON x4"}
+                                       objCType: @encode(MultiBufferKernels)]];
+#endif
+    return kernels;
+}
+
+
+TestCase(MYSHABatch) {
+    RequireTestCase(MYSHA);
+    Log(@"SHA batch kernel is %s", MYSHABatchKernelName());
+    // Messages of assorted lengths, including empty ones and ones needing two padding blocks:
+    enum {kCount = 1000};
+    NSMutableData *data = [NSMutableData dataWithLength: kCount * 300];
+    for (size_t i = 0; i < data.length; i++)
+        ((uint8_t*)data.mutableBytes)[i] = (uint8_t)random();
+    MYDigestBuffer inputs[kCount];
+    size_t pos = 0;
+    for (int i = 0; i < kCount; i++) {
+        size_t length = (i % 97 == 0) ? 0 : (i * 37) % 290;
+        inputs[i] = (MYDigestBuffer){(const uint8_t*)data.bytes + pos, length};
+        pos += length;
+    }
+    static uint8_t expected1[kCount][20], expected256[kCount][32], digests1[kCount][20], digests256[kCount][32];
+    for (int i = 0; i < kCount; i++) {
+        MYSHA1(inputs[i].bytes, inputs[i].length, expected1[i]);
+        MYSHA256(inputs[i].bytes, inputs[i].length, expected256[i]);
+    }
+
+    MultiBufferKernels saved = sMultiKernels;
+    for (NSValue *value in availableMultiBufferKernels()) {
+        [value getValue: &sMultiKernels];
+        Log(@"Testing %s", sMultiKernels.name);
+        // Every batch size up to a few times the lane count, then some bigger ones:
+        for (size_t count = 0; count <= kCount; count = (count < 40) ? count + 1 : count + 321) {
+            memset(digests1, 0, sizeof(digests1));
+            memset(digests256, 0, sizeof(digests256));
+            MYSHA1Batch(inputs, count, digests1);
+            MYSHA256Batch(inputs, count, digests256);
+            CAssert(memcmp(digests1, expected1, 20*count) == 0, @"SHA-1 batch of %zu", count);
+            CAssert(memcmp(digests256, expected256, 32*count) == 0, @"SHA-256 batch of %zu", count);
+        }
+    }
+    sMultiKernels = saved;
+
+    // The MYDigest API:
+    RawSHA256Digest raw[3];
+    MYDigestBuffer three[3] = {{"a", 1}, {"abc", 3}, {"", 0}};
+    [MYSHA256Digest computeDigests: raw ofBuffers: three count: 3];
+    CAssertEqual([MYSHA256Digest digestFromRawSHA256Digest: &raw[1]].hexString,
+                 @"BA7816BF8F01CFEA414140DE5DAE2223B00361A396177A9CB410FF61F20015AD");
+}
+
+
+TestCase(MYSHABatchBenchmark) {
+    RequireTestCase(MYSHABatch);
+    // Lots of small messages, like keys or Merkle-tree leaves:
+    enum {kCount = 200000, kLength = 64};
+    uint8_t *data = malloc(kCount * kLength);
+    MYDigestBuffer *inputs = malloc(kCount * sizeof(MYDigestBuffer));
+    RawSHA256Digest *digests = malloc(kCount * sizeof(RawSHA256Digest));
+    for (size_t i = 0; i < kCount * kLength; i++)
+        data[i] = (uint8_t)i;
+    for (size_t i = 0; i < kCount; i++)
+        inputs[i] = (MYDigestBuffer){data + i * kLength, kLength};
+
+    CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+    for (size_t i = 0; i < kCount; i++) {
+        @autoreleasepool {
+            [MYSHA256Digest digestOfBytes: inputs[i].bytes length: kLength];
+        }
+    }
+    CFAbsoluteTime objectTime = CFAbsoluteTimeGetCurrent() - start;
+
+    start = CFAbsoluteTimeGetCurrent();
+    for (size_t i = 0; i < kCount; i++)
+        MYSHA256(inputs[i].bytes, kLength, &digests[i]);
+    CFAbsoluteTime serialTime = CFAbsoluteTimeGetCurrent() - start;
+    Log(@"SHA-256 of %d %d-byte messages: MYDigest objects %.2f M/sec, %s serial %.2f M/sec",
+        kCount, kLength, kCount/objectTime/1e6, MYSHAKernelName(), kCount/serialTime/1e6);
+
+    MultiBufferKernels saved = sMultiKernels;
+    for (NSValue *value in availableMultiBufferKernels()) {
+        [value getValue: &sMultiKernels];
+        start = CFAbsoluteTimeGetCurrent();
+        MYSHA256Batch(inputs, kCount, digests);
+        CFAbsoluteTime batchTime = CFAbsoluteTimeGetCurrent() - start;
+        Log(@"    %-12s batch %.2f M/sec (%.1fx objects, %.1fx serial)",
+            sMultiKernels.name, kCount/batchTime/1e6, objectTime/batchTime, serialTime/batchTime);
+    }
+    sMultiKernels = saved;
+    free(data);
+    free(inputs);
+    free(digests);
+}
+
+
+
+
+/*
+ Copyright (c) 2009, Jens Alfke <jens@mooseyard.com>. All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification, are permitted
+ provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice, this list of conditions
+ and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions
+ and the following disclaimer in the documentation and/or other materials provided with the
+ distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRI-
+ BUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
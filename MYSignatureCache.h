@@ -0,0 +1,65 @@
+//
+//  MYSignatureCache.h
+//  MYCrypto
+//
+//  Created by Jens Alfke on 10/16/26.
+//  Copyright 2026 Jens Alfke. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+@class MYDigest, MYOID;
+
+
+/** A bounded, thread-safe LRU cache of signatures that have been verified, so that certificates
+    seen over and over (like the intermediates of common chains) only need the expensive
+    public-key operation once.
+    Only successful verifications are remembered. An entry is keyed by a SHA-256 digest of the
+    signed data plus signature, the signature algorithm, and the digest of the signer's public
+    key; any difference in these is a miss. */
+@interface MYSignatureCache : NSObject
+{
+    @private
+    NSUInteger _capacity;
+    NSMutableDictionary *_entries;
+    id _newest, _oldest;
+    uint64_t _hits, _misses;
+}
+
+/** The cache used by -[MYCertificateInfo verifySignatureWithKey:]. Holds 4096 entries. */
++ (MYSignatureCache*) sharedCache;
+
+- (id) initWithCapacity: (NSUInteger)capacity;
+
+/** The maximum number of entries; beyond this, the least recently used ones are dropped. */
+@property (readonly) NSUInteger capacity;
+
+/** The number of entries currently in the cache. */
+@property (readonly) NSUInteger count;
+
+/** The number of lookups that found (or missed) a cached result. */
+@property (readonly) uint64_t hits, misses;
+
+/** Verifies a signature, using a cached result if there is one.
+    @param signature  The signature.
+    @param signedData  The data that was signed.
+    @param algorithm  The OID of the signature algorithm.
+    @param keyDigest  The digest of the signer's public key (MYPublicKey's publicKeyDigest.)
+    @param verify  Called on a cache miss to do the actual verification; its result is returned,
+        and remembered if it's YES.
+    @return  YES if the signature is valid. */
+- (BOOL) verifySignature: (NSData*)signature
+                  ofData: (NSData*)signedData
+               algorithm: (MYOID*)algorithm
+         issuerKeyDigest: (MYDigest*)keyDigest
+              usingBlock: (BOOL(^)(void))verify;
+
+/** Removes all entries, e.g. after the set of trusted keys changes. */
+- (void) removeAllEntries;
+
+/** Removes the entries for signatures made with one key, e.g. after the key is revoked. */
+- (void) removeEntriesForIssuerKeyDigest: (MYDigest*)keyDigest;
+
+/** Sets the hits and misses counters back to zero. */
+- (void) resetStatistics;
+
+@end
@@ -0,0 +1,326 @@
+//
+//  MYSignatureCache.m
+//  MYCrypto
+//
+//  Created by Jens Alfke on 10/16/26.
+//  Copyright 2026 Jens Alfke. All rights reserved.
+//
+
+#import "MYSignatureCache.h"
+#import "MYDigest.h"
+#import "MYOID.h"
+#import "Test.h"
+#import <CommonCrypto/CommonDigest.h>
+
+
+#define kSharedCacheCapacity 4096
+
+
+/** A cache entry; also a node in the doubly-linked list that tracks recency of use. The links
+    are unretained since the entries are owned by the cache's dictionary. */
+@interface MYSignatureCacheEntry : NSObject
+{
+    @public
+    NSData *_key;
+    __unsafe_unretained MYSignatureCacheEntry *_older, *_newer;
+}
+@end
+
+@implementation MYSignatureCacheEntry
+@end
+
+
+
+@implementation MYSignatureCache
+
+
++ (MYSignatureCache*) sharedCache {
+    static MYSignatureCache *sShared;
+    static dispatch_once_t once;
+    dispatch_once(&once, ^{
+        sShared = [[self alloc] initWithCapacity: kSharedCacheCapacity];
+    });
+    return sShared;
+}
+
+
+- (id) initWithCapacity: (NSUInteger)capacity {
+    Assert(capacity > 0);
+    self = [super init];
+    if (self) {
+        _capacity = capacity;
+        _entries = [[NSMutableDictionary alloc] initWithCapacity: capacity];
+    }
+    return self;
+}
+
+
+@synthesize capacity=_capacity;
+
+- (NSUInteger) count {
+    @synchronized(self) {
+        return _entries.count;
+    }
+}
+
+- (uint64_t) hits {
+    @synchronized(self) {
+        return _hits;
+    }
+}
+
+- (uint64_t) misses {
+    @synchronized(self) {
+        return _misses;
+    }
+}
+
+- (void) resetStatistics {
+    @synchronized(self) {
+        _hits = _misses = 0;
+    }
+}
+
+
+/* CC_SHA256_Update takes a 32-bit length, so large data is fed to it in pieces. */
+static void updateSHA256 (CC_SHA256_CTX *ctx, NSData *data) {
+    const uint8_t *bytes = data.bytes;
+    for (size_t length = data.length, n; length > 0; bytes += n, length -= n) {
+        n = MIN(length, (size_t)1 << 30);
+        CC_SHA256_Update(ctx, bytes, (CC_LONG)n);
+    }
+}
+
+/* The key is the SHA-256 digest of the signed data's length, the signed data and the signature,
+   then the length and bytes of the key digest, then the DER encoding of the algorithm OID.
+   (Without the length, moving bytes between the end of the data and the start of the signature
+   wouldn't change the key.) */
+static NSData* cacheKey (NSData *signature, NSData *signedData, MYOID *algorithm, MYDigest *keyDigest) {
+    NSData *algorithmData = algorithm.DEREncoding;
+    size_t keyDigestLength = keyDigest.length;
+    NSMutableData *key = [NSMutableData dataWithLength: CC_SHA256_DIGEST_LENGTH + 1 + keyDigestLength
+                                                       + algorithmData.length];
+    uint8_t *bytes = key.mutableBytes;
+    uint64_t signedLength = NSSwapHostLongLongToBig(signedData.length);
+    CC_SHA256_CTX ctx;
+    CC_SHA256_Init(&ctx);
+    CC_SHA256_Update(&ctx, &signedLength, sizeof(signedLength));
+    updateSHA256(&ctx, signedData);
+    updateSHA256(&ctx, signature);
+    CC_SHA256_Final(bytes, &ctx);
+    bytes += CC_SHA256_DIGEST_LENGTH;
+    *bytes++ = (uint8_t)keyDigestLength;
+    memcpy(bytes, keyDigest.bytes, keyDigestLength);
+    memcpy(bytes + keyDigestLength, algorithmData.bytes, algorithmData.length);
+    return key;
+}
+
+static BOOL keyHasKeyDigest (NSData *key, MYDigest *keyDigest) {
+    const uint8_t *bytes = (const uint8_t*)key.bytes + CC_SHA256_DIGEST_LENGTH;
+    return bytes[0] == keyDigest.length && memcmp(bytes + 1, keyDigest.bytes, keyDigest.length) == 0;
+}
+
+
+// List manipulation; must be called while synchronized.
+
+- (void) _unlink: (MYSignatureCacheEntry*)entry {
+    if (entry->_newer)
+        entry->_newer->_older = entry->_older;
+    else
+        _newest = entry->_older;
+    if (entry->_older)
+        entry->_older->_newer = entry->_newer;
+    else
+        _oldest = entry->_newer;
+    entry->_older = entry->_newer = nil;
+}
+
+- (void) _linkAsNewest: (MYSignatureCacheEntry*)entry {
+    MYSignatureCacheEntry *newest = _newest;
+    entry->_older = newest;
+    if (newest)
+        newest->_newer = entry;
+    else
+        _oldest = entry;
+    _newest = entry;
+}
+
+- (void) _remove: (MYSignatureCacheEntry*)entry {
+    [self _unlink: entry];
+    [_entries removeObjectForKey: entry->_key];
+}
+
+
+- (BOOL) verifySignature: (NSData*)signature
+                  ofData: (NSData*)signedData
+               algorithm: (MYOID*)algorithm
+         issuerKeyDigest: (MYDigest*)keyDigest
+              usingBlock: (BOOL(^)(void))verify
+{
+    if (!signature || !signedData || !algorithm || !keyDigest)
+        return verify();
+    NSData *key = cacheKey(signature, signedData, algorithm, keyDigest);
+    @synchronized(self) {
+        MYSignatureCacheEntry *entry = _entries[key];
+        if (entry) {
+            ++_hits;
+            if (entry != _newest) {
+                [self _unlink: entry];
+                [self _linkAsNewest: entry];
+            }
+            return YES;
+        }
+        ++_misses;
+    }
+
+    // Verify without holding the lock, since this is the slow part:
+    if (!verify())
+        return NO;
+
+    @synchronized(self) {
+        if (!_entries[key]) {                   // (another thread may have added it meanwhile)
+            MYSignatureCacheEntry *entry = [[MYSignatureCacheEntry alloc] init];
+            entry->_key = key;
+            _entries[key] = entry;
+            [self _linkAsNewest: entry];
+            if (_entries.count > _capacity)
+                [self _remove: _oldest];
+        }
+    }
+    return YES;
+}
+
+
+- (void) removeAllEntries {
+    @synchronized(self) {
+        [_entries removeAllObjects];
+        _newest = _oldest = nil;
+    }
+}
+
+- (void) removeEntriesForIssuerKeyDigest: (MYDigest*)keyDigest {
+    @synchronized(self) {
+        for (MYSignatureCacheEntry *entry in _entries.allValues) {
+            if (keyHasKeyDigest(entry->_key, keyDigest))
+                [self _remove: entry];
+        }
+    }
+}
+
+
+@end
+
+
+
+
+#pragma mark -
+#pragma mark TEST CASES:
+
+
+TestCase(MYSignatureCache) {
+    MYSignatureCache *cache = [[MYSignatureCache alloc] initWithCapacity: 3];
+    MYOID *alg = [MYOID OIDWithKnownID: kMYOIDRSAWithSHA256];
+    MYDigest *key1 = [@"key1" dataUsingEncoding: NSUTF8StringEncoding].my_SHA1Digest;
+    MYDigest *key2 = [@"key2" dataUsingEncoding: NSUTF8StringEncoding].my_SHA1Digest;
+    __block int calls = 0;
+    BOOL (^valid)(void) = ^BOOL{ ++calls; return YES; };
+    BOOL (^invalid)(void) = ^BOOL{ ++calls; return NO; };
+    NSData* (^data)(int) = ^NSData*(int i) {
+        return [[NSString stringWithFormat: @"data %d", i] dataUsingEncoding: NSUTF8StringEncoding];
+    };
+    NSData *sig = [@"signature" dataUsingEncoding: NSUTF8StringEncoding];
+
+    // Misses, then hits:
+    for (int i = 1; i <= 3; i++)
+        CAssert([cache verifySignature: sig ofData: data(i) algorithm: alg issuerKeyDigest: key1
+                            usingBlock: valid]);
+    CAssertEq(calls, 3);
+    CAssertEq(cache.count, (NSUInteger)3);
+    CAssert([cache verifySignature: sig ofData: data(1) algorithm: alg issuerKeyDigest: key1
+                        usingBlock: valid]);
+    CAssertEq(calls, 3);
+    CAssertEq(cache.hits, (uint64_t)1);
+    CAssertEq(cache.misses, (uint64_t)3);
+
+    // Each part of the key matters:
+    CAssert([cache verifySignature: sig ofData: data(1) algorithm: alg issuerKeyDigest: key2
+                        usingBlock: valid]);
+    CAssertEq(calls, 4);
+    CAssert(![cache verifySignature: [@"other" dataUsingEncoding: NSUTF8StringEncoding]
+                             ofData: data(1) algorithm: alg issuerKeyDigest: key1 usingBlock: invalid]);
+    CAssert(![cache verifySignature: sig ofData: data(1)
+                          algorithm: [MYOID OIDWithKnownID: kMYOIDRSAWithSHA1] issuerKeyDigest: key1
+                         usingBlock: invalid]);
+    CAssertEq(calls, 6);
+
+    // Failures aren't cached:
+    CAssert(![cache verifySignature: sig ofData: data(9) algorithm: alg issuerKeyDigest: key1
+                         usingBlock: invalid]);
+    CAssert(![cache verifySignature: sig ofData: data(9) algorithm: alg issuerKeyDigest: key1
+                         usingBlock: invalid]);
+    CAssertEq(calls, 8);
+
+    // Adding (key2,data1) evicted the least recently used entry, (key1,data2):
+    CAssertEq(cache.count, (NSUInteger)3);
+    [cache verifySignature: sig ofData: data(2) algorithm: alg issuerKeyDigest: key1 usingBlock: valid];
+    CAssertEq(calls, 9);
+    // ...and that evicted (key1,data3), leaving data1 and data2 for key1:
+    [cache verifySignature: sig ofData: data(1) algorithm: alg issuerKeyDigest: key1 usingBlock: valid];
+    CAssertEq(calls, 9);
+
+    // Invalidation:
+    [cache removeEntriesForIssuerKeyDigest: key1];
+    CAssertEq(cache.count, (NSUInteger)1);
+    [cache verifySignature: sig ofData: data(1) algorithm: alg issuerKeyDigest: key2 usingBlock: valid];
+    [cache verifySignature: sig ofData: data(1) algorithm: alg issuerKeyDigest: key1 usingBlock: valid];
+    CAssertEq(cache.count, (NSUInteger)2);
+    [cache removeAllEntries];
+    CAssertEq(cache.count, (NSUInteger)0);
+    [cache resetStatistics];
+    CAssertEq(cache.hits, (uint64_t)0);
+    CAssertEq(cache.misses, (uint64_t)0);
+
+    // Where the data ends and the signature begins is part of the key:
+    NSData* (^utf8)(NSString*) = ^NSData*(NSString *str) {
+        return [str dataUsingEncoding: NSUTF8StringEncoding];
+    };
+    CAssert([cache verifySignature: utf8(@"ure") ofData: utf8(@"data 1signat") algorithm: alg
+                   issuerKeyDigest: key1 usingBlock: valid]);
+    calls = 0;
+    CAssert(![cache verifySignature: sig ofData: data(1) algorithm: alg issuerKeyDigest: key1
+                         usingBlock: invalid]);
+    CAssertEq(calls, 1);
+
+    // Concurrent use:
+    MYSignatureCache *bigCache = [[MYSignatureCache alloc] initWithCapacity: 100];
+    dispatch_apply(10000, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(size_t i) {
+        [bigCache verifySignature: sig ofData: data((int)(i % 150)) algorithm: alg
+                  issuerKeyDigest: key1 usingBlock: ^BOOL{return YES;}];
+    });
+    CAssertEq(bigCache.count, (NSUInteger)100);
+    CAssertEq(bigCache.hits + bigCache.misses, (uint64_t)10000);
+}
+
+
+
+/*
+ Copyright (c) 2009, Jens Alfke <jens@mooseyard.com>. All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification, are permitted
+ provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice, this list of conditions
+ and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions
+ and the following disclaimer in the documentation and/or other materials provided with the
+ distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRI-
+ BUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
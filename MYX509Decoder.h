@@ -0,0 +1,203 @@
+//
+//  MYX509Decoder.h
+//  MYCrypto
+//
+//  Created by Jens Alfke on 10/16/26.
+//  Copyright 2026 Jens Alfke. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+#import "MYBERParser.h"
+
+
+/** The locations of the fields of an X.509 certificate, as found by MYX509DecodeCertificate.
+    Each slice points into the certificate data, which must stay valid as long as the slices
+    are used. An optional field that's not present has a NULL `contents` pointer.
+
+    Certificate  ::=  SEQUENCE  {
+        tbsCertificate       TBSCertificate,
+        signatureAlgorithm   AlgorithmIdentifier,
+        signatureValue       BIT STRING  }
+
+    TBSCertificate  ::=  SEQUENCE  {
+        version         [0]  EXPLICIT Version DEFAULT v1,
+        serialNumber         CertificateSerialNumber,
+        signature            AlgorithmIdentifier,
+        issuer               Name,
+        validity             Validity,
+        subject              Name,
+        subjectPublicKeyInfo SubjectPublicKeyInfo,
+        issuerUniqueID  [1]  IMPLICIT UniqueIdentifier OPTIONAL,
+        subjectUniqueID [2]  IMPLICIT UniqueIdentifier OPTIONAL,
+        extensions      [3]  EXPLICIT Extensions OPTIONAL  } */
+typedef struct MYX509Fields {
+    MYBERSlice tbsCertificate;          ///< The signed part of the certificate
+    unsigned version;                   ///< 0 for v1, 1 for v2, 2 for v3
+    MYBERSlice serialNumber;            ///< INTEGER
+    MYBERSlice tbsSignatureAlgorithm;   ///< AlgorithmIdentifier (SEQUENCE) inside the TBS
+    MYBERSlice issuer;                  ///< Name (SEQUENCE)
+    MYBERSlice validity;                ///< Validity (SEQUENCE)
+    NSTimeInterval notBefore;           ///< Start of the validity period, in seconds since 1970
+    NSTimeInterval notAfter;            ///< End of the validity period, in seconds since 1970
+    MYBERSlice subject;                 ///< Name (SEQUENCE)
+    MYBERSlice subjectPublicKeyInfo;    ///< SubjectPublicKeyInfo (SEQUENCE)
+    MYBERSlice publicKeyAlgorithmOID;   ///< OID of the key algorithm, inside the SPKI
+    MYBERSlice publicKey;               ///< BIT STRING of the key, inside the SPKI
+    MYBERSlice issuerUniqueID;          ///< [1] (optional)
+    MYBERSlice subjectUniqueID;         ///< [2] (optional)
+    MYBERSlice extensions;              ///< SEQUENCE OF Extension, inside [3] (optional)
+    MYBERSlice signatureAlgorithm;      ///< AlgorithmIdentifier (SEQUENCE)
+    MYBERSlice signatureAlgorithmOID;   ///< OID inside signatureAlgorithm
+    MYBERSlice signature;               ///< BIT STRING
+} MYX509Fields;
+
+
+/** Decodes an X.509 certificate in a single pass, checking its structure against the schema
+    and recording the location of each field. Nothing is allocated and no objects are created;
+    field values can be read from the slices as needed.
+    Only the first value in the data is decoded; any data after it is ignored. */
+BOOL MYX509DecodeCertificate (const void *bytes, size_t length,
+                              MYX509Fields *outFields, NSError **outError);
+
+/** The locations of the fields of an X.509 certificate revocation list, as found by
+    MYX509DecodeCRL. As with MYX509Fields, the slices point into the CRL data.
+
+    CertificateList  ::=  SEQUENCE  {
+        tbsCertList          TBSCertList,
+        signatureAlgorithm   AlgorithmIdentifier,
+        signatureValue       BIT STRING  }
+
+    TBSCertList  ::=  SEQUENCE  {
+        version                 Version OPTIONAL,  -- if present, MUST be v2
+        signature               AlgorithmIdentifier,
+        issuer                  Name,
+        thisUpdate              Time,
+        nextUpdate              Time OPTIONAL,
+        revokedCertificates     SEQUENCE OF SEQUENCE  {
+             userCertificate         CertificateSerialNumber,
+             revocationDate          Time,
+             crlEntryExtensions      Extensions OPTIONAL  }  OPTIONAL,
+        crlExtensions           [0]  EXPLICIT Extensions OPTIONAL  } */
+typedef struct MYX509CRLFields {
+    MYBERSlice tbsCertList;             ///< The signed part of the CRL
+    unsigned version;                   ///< 0 for v1, 1 for v2
+    MYBERSlice tbsSignatureAlgorithm;   ///< AlgorithmIdentifier (SEQUENCE) inside the TBS
+    MYBERSlice issuer;                  ///< Name (SEQUENCE)
+    NSTimeInterval thisUpdate;          ///< Issue date, in seconds since 1970
+    NSTimeInterval nextUpdate;          ///< Date of the next update, or 0 if not given
+    MYBERSlice revokedCertificates;     ///< SEQUENCE OF entries (optional)
+    MYBERSlice extensions;              ///< SEQUENCE OF Extension, inside [0] (optional)
+    MYBERSlice signatureAlgorithm;      ///< AlgorithmIdentifier (SEQUENCE)
+    MYBERSlice signatureAlgorithmOID;   ///< OID inside signatureAlgorithm
+    MYBERSlice signature;               ///< BIT STRING
+} MYX509CRLFields;
+
+
+/** Decodes the outer structure of an X.509 CRL, the same way MYX509DecodeCertificate does.
+    The revokedCertificates list is only located, not decoded; iterate over it with
+    MYX509NextRevokedCertificate. */
+BOOL MYX509DecodeCRL (const void *bytes, size_t length,
+                      MYX509CRLFields *outFields, NSError **outError);
+
+/** Reads the next entry from a cursor over a CRL's revokedCertificates, returning the slice of
+    its serial number, and its revocation date if outDate is non-NULL. Entry extensions are
+    skipped. Returns NO at the end of the list or if the entry is malformed. */
+BOOL MYX509NextRevokedCertificate (MYBERCursor *cursor,
+                                   MYBERSlice *outSerialNumber,
+                                   NSTimeInterval *outDate);
+
+
+/** The locations of the fields of an OCSP response, as found by MYX509DecodeOCSPResponse.
+    Only the basic response type is understood. If the responseStatus isn't 0 (successful),
+    the other fields are empty.
+
+    OCSPResponse ::= SEQUENCE {
+        responseStatus         OCSPResponseStatus,              -- ENUMERATED
+        responseBytes          [0] EXPLICIT ResponseBytes OPTIONAL }
+
+    ResponseBytes ::= SEQUENCE {
+        responseType           OBJECT IDENTIFIER,               -- id-pkix-ocsp-basic
+        response               OCTET STRING }                   -- containing:
+
+    BasicOCSPResponse ::= SEQUENCE {
+        tbsResponseData        ResponseData,
+        signatureAlgorithm     AlgorithmIdentifier,
+        signature              BIT STRING,
+        certs              [0] EXPLICIT SEQUENCE OF Certificate OPTIONAL }
+
+    ResponseData ::= SEQUENCE {
+        version            [0] EXPLICIT Version DEFAULT v1,
+        responderID            CHOICE { byName [1] EXPLICIT Name,
+                                        byKey  [2] EXPLICIT OCTET STRING },
+        producedAt             GeneralizedTime,
+        responses              SEQUENCE OF SingleResponse,
+        responseExtensions [1] EXPLICIT Extensions OPTIONAL } */
+typedef struct MYX509OCSPResponseFields {
+    unsigned responseStatus;            ///< 0 for successful, else an error from the responder
+    MYBERSlice tbsResponseData;         ///< The signed part of the response
+    MYBERSlice responderName;           ///< Name (SEQUENCE), if the responder is identified by name
+    MYBERSlice responderKeyHash;        ///< OCTET STRING, if the responder is identified by key
+    NSTimeInterval producedAt;          ///< Date the response was signed, in seconds since 1970
+    MYBERSlice responses;               ///< SEQUENCE OF SingleResponse
+    MYBERSlice extensions;              ///< SEQUENCE OF Extension, inside [1] (optional)
+    MYBERSlice signatureAlgorithm;      ///< AlgorithmIdentifier (SEQUENCE)
+    MYBERSlice signatureAlgorithmOID;   ///< OID inside signatureAlgorithm
+    MYBERSlice signature;               ///< BIT STRING
+    MYBERSlice certs;                   ///< SEQUENCE OF Certificate, inside [0] (optional)
+} MYX509OCSPResponseFields;
+
+/** Decodes an OCSP response, the same way MYX509DecodeCertificate does. The list of responses
+    is only located; iterate over it with MYX509NextOCSPSingleResponse. */
+BOOL MYX509DecodeOCSPResponse (const void *bytes, size_t length,
+                               MYX509OCSPResponseFields *outFields, NSError **outError);
+
+/** The status of one certificate in an OCSP response.
+
+    SingleResponse ::= SEQUENCE {
+        certID                 CertID,
+        certStatus             CHOICE { good    [0] IMPLICIT NULL,
+                                        revoked [1] IMPLICIT RevokedInfo,
+                                        unknown [2] IMPLICIT NULL },
+        thisUpdate             GeneralizedTime,
+        nextUpdate         [0] EXPLICIT GeneralizedTime OPTIONAL,
+        singleExtensions   [1] EXPLICIT Extensions OPTIONAL }
+
+    CertID ::= SEQUENCE {
+        hashAlgorithm          AlgorithmIdentifier,
+        issuerNameHash         OCTET STRING,
+        issuerKeyHash          OCTET STRING,
+        serialNumber           CertificateSerialNumber }
+
+    RevokedInfo ::= SEQUENCE {
+        revocationTime         GeneralizedTime,
+        revocationReason   [0] EXPLICIT CRLReason OPTIONAL } */
+typedef struct MYX509OCSPSingleResponse {
+    MYBERSlice hashAlgorithmOID;        ///< OID of the CertID's hash algorithm
+    MYBERSlice issuerNameHash;          ///< OCTET STRING
+    MYBERSlice issuerKeyHash;           ///< OCTET STRING
+    MYBERSlice serialNumber;            ///< INTEGER
+    unsigned certStatus;                ///< 0 = good, 1 = revoked, 2 = unknown
+    NSTimeInterval thisUpdate;          ///< Date the status was known to be correct
+    NSTimeInterval nextUpdate;          ///< Date newer status will be available, or 0 if not given
+    NSTimeInterval revocationTime;      ///< Date of revocation, or 0 if not revoked
+    int revocationReason;               ///< CRLReason code, or -1 if not given
+} MYX509OCSPSingleResponse;
+
+/** Reads the next SingleResponse from a cursor over an OCSP response's list of responses.
+    Returns NO at the end of the list or if the entry is malformed. */
+BOOL MYX509NextOCSPSingleResponse (MYBERCursor *cursor, MYX509OCSPSingleResponse *outResponse);
+
+
+/** Returns YES if an optional field is present. */
+static inline BOOL MYX509FieldIsPresent (const MYBERSlice *field) {
+    return field->contents != NULL;
+}
+
+/** Returns the bytes of a BIT STRING field, skipping the initial unused-bits count.
+    (X.509 bit strings are always a whole number of bytes.) */
+static inline const uint8_t* MYX509BitStringBytes (const MYBERSlice *bitString,
+                                                   size_t *outLength)
+{
+    *outLength = bitString->length - 1;     // (the decoder ensures length >= 1)
+    return bitString->contents + 1;
+}
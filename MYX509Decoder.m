@@ -0,0 +1,620 @@
+//
+//  MYX509Decoder.m
+//  MYCrypto
+//
+//  Created by Jens Alfke on 10/16/26.
+//  Copyright 2026 Jens Alfke. All rights reserved.
+//
+
+#import "MYX509Decoder.h"
+#import "MYASN1Time.h"
+#import "MYASN1Object.h"
+#import "MYErrorUtils.h"
+#import "Test.h"
+
+
+enum {
+    kUniversal = 0,
+    kContextSpecific = 2,
+
+    kIntegerTag = 2,
+    kBitStringTag = 3,
+    kOctetStringTag = 4,
+    kOIDTag = 6,
+    kEnumeratedTag = 10,
+    kSequenceTag = 16,
+    kUTCTimeTag = 23,
+    kGeneralizedTimeTag = 24,
+};
+
+
+/* Reads the next value, returning NO if it isn't there or doesn't have the given tag. */
+static BOOL readField (MYBERCursor *cursor, uint8_t tagClass, uint32_t tag, BOOL constructed,
+                       MYBERSlice *outField)
+{
+    MYBERSlice slice;
+    if (!MYBERCursorNext(cursor, &slice, NULL))
+        return NO;
+    if (slice.tagClass != tagClass || slice.tag != tag || slice.isConstructed != constructed)
+        return NO;
+    *outField = slice;
+    return YES;
+}
+
+/* Reads the next value only if it has the given context-specific tag; otherwise leaves the
+   cursor alone and the field empty. */
+static void readOptionalField (MYBERCursor *cursor, uint32_t tag, MYBERSlice *outField) {
+    MYBERCursor peek = *cursor;
+    MYBERSlice slice;
+    if (MYBERCursorNext(&peek, &slice, NULL) && slice.tagClass == kContextSpecific
+                                             && slice.tag == tag) {
+        *outField = slice;
+        *cursor = peek;
+    }
+}
+
+/* Returns YES if the next value is a universal one with the given tag, without consuming it. */
+static BOOL nextIsUniversal (const MYBERCursor *cursor, uint32_t tag) {
+    MYBERCursor peek = *cursor;
+    MYBERSlice slice;
+    return MYBERCursorNext(&peek, &slice, NULL) && slice.tagClass == kUniversal
+                                                && slice.tag == tag;
+}
+
+static BOOL readTime (MYBERCursor *cursor, NSTimeInterval *outTime) {
+    MYBERSlice slice;
+    if (!MYBERCursorNext(cursor, &slice, NULL) || slice.tagClass != kUniversal
+            || slice.isConstructed)
+        return NO;
+    return MYASN1ParseTime(slice.contents, slice.length, slice.tag, outTime);
+}
+
+/* Reads an AlgorithmIdentifier, which is a SEQUENCE starting with an OID. */
+static BOOL readAlgorithm (MYBERCursor *cursor, MYBERSlice *outField, MYBERSlice *outOID) {
+    if (!readField(cursor, kUniversal, kSequenceTag, YES, outField))
+        return NO;
+    MYBERCursor contents = MYBERSliceGetCursor(outField);
+    return readField(&contents, kUniversal, kOIDTag, NO, outOID);
+}
+
+
+/* Does the actual work; returns an error message or NULL on success. */
+static const char* decodeCertificate (MYBERCursor *input, MYX509Fields *f) {
+    MYBERSlice cert;
+    if (!readField(input, kUniversal, kSequenceTag, YES, &cert))
+        return "not a SEQUENCE";
+    MYBERCursor certCursor = MYBERSliceGetCursor(&cert);
+    if (!readField(&certCursor, kUniversal, kSequenceTag, YES, &f->tbsCertificate))
+        return "missing TBSCertificate";
+
+    MYBERCursor tbs = MYBERSliceGetCursor(&f->tbsCertificate);
+    MYBERSlice version = {};
+    readOptionalField(&tbs, 0, &version);
+    if (MYX509FieldIsPresent(&version)) {
+        MYBERCursor versionCursor = MYBERSliceGetCursor(&version);
+        MYBERSlice number;
+        if (!version.isConstructed
+                || !readField(&versionCursor, kUniversal, kIntegerTag, NO, &number)
+                || number.length != 1 || !MYBERCursorAtEnd(&versionCursor))
+            return "invalid version";
+        f->version = number.contents[0];
+        if (f->version > 2)
+            return "unrecognized version number";
+    }
+    if (!readField(&tbs, kUniversal, kIntegerTag, NO, &f->serialNumber) || f->serialNumber.length == 0)
+        return "missing serial number";
+    MYBERSlice tbsAlgorithmOID;
+    if (!readAlgorithm(&tbs, &f->tbsSignatureAlgorithm, &tbsAlgorithmOID))
+        return "missing signature algorithm";
+    if (!readField(&tbs, kUniversal, kSequenceTag, YES, &f->issuer))
+        return "missing issuer";
+
+    if (!readField(&tbs, kUniversal, kSequenceTag, YES, &f->validity))
+        return "missing validity";
+    MYBERCursor validity = MYBERSliceGetCursor(&f->validity);
+    if (!readTime(&validity, &f->notBefore) || !readTime(&validity, &f->notAfter)
+            || !MYBERCursorAtEnd(&validity))
+        return "invalid validity";
+
+    if (!readField(&tbs, kUniversal, kSequenceTag, YES, &f->subject))
+        return "missing subject";
+
+    if (!readField(&tbs, kUniversal, kSequenceTag, YES, &f->subjectPublicKeyInfo))
+        return "missing public key info";
+    MYBERCursor spki = MYBERSliceGetCursor(&f->subjectPublicKeyInfo);
+    MYBERSlice keyAlgorithm;
+    if (!readAlgorithm(&spki, &keyAlgorithm, &f->publicKeyAlgorithmOID)
+            || !readField(&spki, kUniversal, kBitStringTag, NO, &f->publicKey)
+            || f->publicKey.length == 0 || !MYBERCursorAtEnd(&spki))
+        return "invalid public key info";
+
+    readOptionalField(&tbs, 1, &f->issuerUniqueID);
+    readOptionalField(&tbs, 2, &f->subjectUniqueID);
+    MYBERSlice extensions = {};
+    readOptionalField(&tbs, 3, &extensions);
+    if (MYX509FieldIsPresent(&extensions)) {
+        MYBERCursor extCursor = MYBERSliceGetCursor(&extensions);
+        if (!extensions.isConstructed
+                || !readField(&extCursor, kUniversal, kSequenceTag, YES, &f->extensions)
+                || !MYBERCursorAtEnd(&extCursor))
+            return "invalid extensions";
+    }
+    if (!MYBERCursorAtEnd(&tbs))
+        return "unexpected data in TBSCertificate";
+
+    if (!readAlgorithm(&certCursor, &f->signatureAlgorithm, &f->signatureAlgorithmOID))
+        return "missing signature algorithm";
+    if (!readField(&certCursor, kUniversal, kBitStringTag, NO, &f->signature)
+            || f->signature.length == 0)
+        return "missing signature";
+    if (!MYBERCursorAtEnd(&certCursor))
+        return "unexpected data after signature";
+    return NULL;
+}
+
+
+BOOL MYX509DecodeCertificate (const void *bytes, size_t length,
+                              MYX509Fields *outFields, NSError **outError)
+{
+    memset(outFields, 0, sizeof(*outFields));
+    MYBERCursor cursor = MYBERCursorMake(bytes, length);
+    const char *errorMsg = decodeCertificate(&cursor, outFields);
+    if (errorMsg) {
+        if (outError) *outError = MYError(2, MYASN1ErrorDomain, @"Invalid certificate: %s", errorMsg);
+        return NO;
+    }
+    return YES;
+}
+
+
+
+/* Does the actual work; returns an error message or NULL on success. */
+static const char* decodeCRL (MYBERCursor *input, MYX509CRLFields *f) {
+    MYBERSlice crl;
+    if (!readField(input, kUniversal, kSequenceTag, YES, &crl))
+        return "not a SEQUENCE";
+    MYBERCursor crlCursor = MYBERSliceGetCursor(&crl);
+    if (!readField(&crlCursor, kUniversal, kSequenceTag, YES, &f->tbsCertList))
+        return "missing TBSCertList";
+
+    MYBERCursor tbs = MYBERSliceGetCursor(&f->tbsCertList);
+    if (nextIsUniversal(&tbs, kIntegerTag)) {
+        MYBERSlice number;
+        if (!readField(&tbs, kUniversal, kIntegerTag, NO, &number)
+                || number.length != 1 || number.contents[0] != 1)
+            return "unrecognized version number";
+        f->version = 1;
+    }
+    MYBERSlice tbsAlgorithmOID;
+    if (!readAlgorithm(&tbs, &f->tbsSignatureAlgorithm, &tbsAlgorithmOID))
+        return "missing signature algorithm";
+    if (!readField(&tbs, kUniversal, kSequenceTag, YES, &f->issuer))
+        return "missing issuer";
+    if (!readTime(&tbs, &f->thisUpdate))
+        return "invalid thisUpdate";
+    if (nextIsUniversal(&tbs, kUTCTimeTag) || nextIsUniversal(&tbs, kGeneralizedTimeTag)) {
+        if (!readTime(&tbs, &f->nextUpdate))
+            return "invalid nextUpdate";
+    }
+    if (nextIsUniversal(&tbs, kSequenceTag)) {
+        if (!readField(&tbs, kUniversal, kSequenceTag, YES, &f->revokedCertificates))
+            return "invalid revokedCertificates";
+    }
+    MYBERSlice extensions = {};
+    readOptionalField(&tbs, 0, &extensions);
+    if (MYX509FieldIsPresent(&extensions)) {
+        MYBERCursor extCursor = MYBERSliceGetCursor(&extensions);
+        if (!extensions.isConstructed
+                || !readField(&extCursor, kUniversal, kSequenceTag, YES, &f->extensions)
+                || !MYBERCursorAtEnd(&extCursor))
+            return "invalid extensions";
+    }
+    if (!MYBERCursorAtEnd(&tbs))
+        return "unexpected data in TBSCertList";
+
+    if (!readAlgorithm(&crlCursor, &f->signatureAlgorithm, &f->signatureAlgorithmOID))
+        return "missing signature algorithm";
+    if (!readField(&crlCursor, kUniversal, kBitStringTag, NO, &f->signature)
+            || f->signature.length == 0)
+        return "missing signature";
+    if (!MYBERCursorAtEnd(&crlCursor))
+        return "unexpected data after signature";
+    return NULL;
+}
+
+
+BOOL MYX509DecodeCRL (const void *bytes, size_t length,
+                      MYX509CRLFields *outFields, NSError **outError)
+{
+    memset(outFields, 0, sizeof(*outFields));
+    MYBERCursor cursor = MYBERCursorMake(bytes, length);
+    const char *errorMsg = decodeCRL(&cursor, outFields);
+    if (errorMsg) {
+        if (outError) *outError = MYError(2, MYASN1ErrorDomain, @"Invalid CRL: %s", errorMsg);
+        return NO;
+    }
+    return YES;
+}
+
+
+BOOL MYX509NextRevokedCertificate (MYBERCursor *cursor,
+                                   MYBERSlice *outSerialNumber,
+                                   NSTimeInterval *outDate)
+{
+    MYBERSlice entry;
+    if (!readField(cursor, kUniversal, kSequenceTag, YES, &entry))
+        return NO;
+    MYBERCursor items = MYBERSliceGetCursor(&entry);
+    if (!readField(&items, kUniversal, kIntegerTag, NO, outSerialNumber)
+            || outSerialNumber->length == 0)
+        return NO;
+    if (outDate)
+        return readTime(&items, outDate);
+    return YES;
+}
+
+
+
+
+/* Reads an optional [tag] EXPLICIT SEQUENCE, such as an Extensions field. Returns NO only if the
+   field is present but malformed. */
+static BOOL readOptionalExplicitSequence (MYBERCursor *cursor, uint32_t tag, MYBERSlice *outField) {
+    MYBERSlice wrapper = {};
+    readOptionalField(cursor, tag, &wrapper);
+    if (!MYX509FieldIsPresent(&wrapper))
+        return YES;
+    MYBERCursor contents = MYBERSliceGetCursor(&wrapper);
+    return wrapper.isConstructed
+        && readField(&contents, kUniversal, kSequenceTag, YES, outField)
+        && MYBERCursorAtEnd(&contents);
+}
+
+
+static const uint8_t kBasicOCSPResponseOID[] = {0x2b, 0x06, 0x01, 0x05, 0x05, 0x07, 0x30, 0x01, 0x01};
+
+/* Does the actual work; returns an error message or NULL on success. */
+static const char* decodeOCSPResponse (MYBERCursor *input, MYX509OCSPResponseFields *f) {
+    MYBERSlice response;
+    if (!readField(input, kUniversal, kSequenceTag, YES, &response))
+        return "not a SEQUENCE";
+    MYBERCursor responseCursor = MYBERSliceGetCursor(&response);
+    MYBERSlice status;
+    if (!readField(&responseCursor, kUniversal, kEnumeratedTag, NO, &status) || status.length != 1)
+        return "missing responseStatus";
+    f->responseStatus = status.contents[0];
+    if (f->responseStatus != 0)
+        return NULL;                // Unsuccessful responses have no body
+
+    MYBERSlice wrapper, responseBytes, responseType, octets;
+    if (!readField(&responseCursor, kContextSpecific, 0, YES, &wrapper))
+        return "missing responseBytes";
+    MYBERCursor wrapperCursor = MYBERSliceGetCursor(&wrapper);
+    if (!readField(&wrapperCursor, kUniversal, kSequenceTag, YES, &responseBytes))
+        return "missing responseBytes";
+    MYBERCursor bytesCursor = MYBERSliceGetCursor(&responseBytes);
+    if (!readField(&bytesCursor, kUniversal, kOIDTag, NO, &responseType)
+            || !readField(&bytesCursor, kUniversal, kOctetStringTag, NO, &octets))
+        return "invalid responseBytes";
+    if (responseType.length != sizeof(kBasicOCSPResponseOID)
+            || memcmp(responseType.contents, kBasicOCSPResponseOID, responseType.length) != 0)
+        return "not a basic OCSP response";
+
+    MYBERCursor octetCursor = MYBERSliceGetCursor(&octets);
+    MYBERSlice basic;
+    if (!readField(&octetCursor, kUniversal, kSequenceTag, YES, &basic))
+        return "invalid BasicOCSPResponse";
+    MYBERCursor basicCursor = MYBERSliceGetCursor(&basic);
+    if (!readField(&basicCursor, kUniversal, kSequenceTag, YES, &f->tbsResponseData))
+        return "missing ResponseData";
+
+    MYBERCursor tbs = MYBERSliceGetCursor(&f->tbsResponseData);
+    MYBERSlice version = {};
+    readOptionalField(&tbs, 0, &version);
+    if (MYX509FieldIsPresent(&version)) {
+        MYBERCursor versionCursor = MYBERSliceGetCursor(&version);
+        MYBERSlice number;
+        if (!readField(&versionCursor, kUniversal, kIntegerTag, NO, &number)
+                || number.length != 1 || number.contents[0] != 0)
+            return "unrecognized version number";
+    }
+    MYBERSlice responderID;
+    if (!MYBERCursorNext(&tbs, &responderID, NULL) || responderID.tagClass != kContextSpecific
+            || !responderID.isConstructed)
+        return "missing responderID";
+    MYBERCursor idCursor = MYBERSliceGetCursor(&responderID);
+    BOOL validID;
+    if (responderID.tag == 1)
+        validID = readField(&idCursor, kUniversal, kSequenceTag, YES, &f->responderName);
+    else if (responderID.tag == 2)
+        validID = readField(&idCursor, kUniversal, kOctetStringTag, NO, &f->responderKeyHash);
+    else
+        validID = NO;
+    if (!validID || !MYBERCursorAtEnd(&idCursor))
+        return "invalid responderID";
+    if (!nextIsUniversal(&tbs, kGeneralizedTimeTag) || !readTime(&tbs, &f->producedAt))
+        return "invalid producedAt";
+    if (!readField(&tbs, kUniversal, kSequenceTag, YES, &f->responses))
+        return "missing responses";
+    if (!readOptionalExplicitSequence(&tbs, 1, &f->extensions))
+        return "invalid extensions";
+    if (!MYBERCursorAtEnd(&tbs))
+        return "unexpected data in ResponseData";
+
+    if (!readAlgorithm(&basicCursor, &f->signatureAlgorithm, &f->signatureAlgorithmOID))
+        return "missing signature algorithm";
+    if (!readField(&basicCursor, kUniversal, kBitStringTag, NO, &f->signature)
+            || f->signature.length == 0)
+        return "missing signature";
+    if (!readOptionalExplicitSequence(&basicCursor, 0, &f->certs))
+        return "invalid certs";
+    if (!MYBERCursorAtEnd(&basicCursor))
+        return "unexpected data after signature";
+    return NULL;
+}
+
+
+BOOL MYX509DecodeOCSPResponse (const void *bytes, size_t length,
+                               MYX509OCSPResponseFields *outFields, NSError **outError)
+{
+    memset(outFields, 0, sizeof(*outFields));
+    MYBERCursor cursor = MYBERCursorMake(bytes, length);
+    const char *errorMsg = decodeOCSPResponse(&cursor, outFields);
+    if (errorMsg) {
+        if (outError) *outError = MYError(2, MYASN1ErrorDomain, @"Invalid OCSP response: %s",
+                                          errorMsg);
+        return NO;
+    }
+    return YES;
+}
+
+
+BOOL MYX509NextOCSPSingleResponse (MYBERCursor *cursor, MYX509OCSPSingleResponse *r) {
+    memset(r, 0, sizeof(*r));
+    r->revocationReason = -1;
+    MYBERSlice entry, certID, algorithm, status;
+    if (!readField(cursor, kUniversal, kSequenceTag, YES, &entry))
+        return NO;
+    MYBERCursor items = MYBERSliceGetCursor(&entry);
+    if (!readField(&items, kUniversal, kSequenceTag, YES, &certID))
+        return NO;
+    MYBERCursor idItems = MYBERSliceGetCursor(&certID);
+    if (!readAlgorithm(&idItems, &algorithm, &r->hashAlgorithmOID)
+            || !readField(&idItems, kUniversal, kOctetStringTag, NO, &r->issuerNameHash)
+            || !readField(&idItems, kUniversal, kOctetStringTag, NO, &r->issuerKeyHash)
+            || !readField(&idItems, kUniversal, kIntegerTag, NO, &r->serialNumber)
+            || r->serialNumber.length == 0
+            || !MYBERCursorAtEnd(&idItems))
+        return NO;
+
+    if (!MYBERCursorNext(&items, &status, NULL) || status.tagClass != kContextSpecific
+            || status.tag > 2)
+        return NO;
+    r->certStatus = status.tag;
+    if (status.tag == 1) {
+        if (!status.isConstructed)
+            return NO;
+        MYBERCursor revoked = MYBERSliceGetCursor(&status);
+        if (!readTime(&revoked, &r->revocationTime))
+            return NO;
+        MYBERSlice reason = {};
+        readOptionalField(&revoked, 0, &reason);
+        if (MYX509FieldIsPresent(&reason)) {
+            MYBERCursor reasonCursor = MYBERSliceGetCursor(&reason);
+            MYBERSlice value;
+            if (!readField(&reasonCursor, kUniversal, kEnumeratedTag, NO, &value)
+                    || value.length != 1)
+                return NO;
+            r->revocationReason = value.contents[0];
+        }
+    } else if (status.isConstructed || status.length != 0) {
+        return NO;
+    }
+
+    if (!readTime(&items, &r->thisUpdate))
+        return NO;
+    MYBERSlice nextUpdate = {};
+    readOptionalField(&items, 0, &nextUpdate);
+    if (MYX509FieldIsPresent(&nextUpdate)) {
+        MYBERCursor nextCursor = MYBERSliceGetCursor(&nextUpdate);
+        if (!nextUpdate.isConstructed || !readTime(&nextCursor, &r->nextUpdate))
+            return NO;
+    }
+    return YES;                     // (singleExtensions are ignored)
+}
+
+
+#pragma mark -
+#pragma mark TEST CASES:
+
+
+static NSData* sliceEncoding (const MYBERSlice *slice) {
+    return [NSData dataWithBytes: MYBERSliceGetEncoding(slice)
+                          length: MYBERSliceGetEncodingLength(slice)];
+}
+
+TestCase(X509Decoder) {
+    RequireTestCase(BERCursor);
+    RequireTestCase(ASN1Time);
+    for (NSString *filename in @[@"selfsigned.cer", @"selfsigned_email.cer",
+                                 @"iphonedev.cer", @"generated.cer"]) {
+        NSData *cert = [NSData dataWithContentsOfFile: filename];
+        CAssert(cert, @"Couldn't read %@", filename);
+        MYX509Fields f;
+        NSError *error = nil;
+        CAssert(MYX509DecodeCertificate(cert.bytes, cert.length, &f, &error),
+                @"Couldn't decode %@: %@", filename, error);
+
+        // Compare with the object tree:
+        NSArray *root = MYBERParse(cert, NULL);
+        NSArray *info = root[0];
+        if (info.count < 7)
+            info = [@[@0] arrayByAddingObjectsFromArray: info];
+        CAssertEqual(MYBERSliceParse(&f.serialNumber, NULL), info[1]);
+        CAssertEqual(MYBERSliceParse(&f.issuer, NULL), info[3]);
+        CAssertEqual([NSDate dateWithTimeIntervalSince1970: f.notBefore], info[4][0]);
+        CAssertEqual([NSDate dateWithTimeIntervalSince1970: f.notAfter], info[4][1]);
+        CAssertEqual(MYBERSliceParse(&f.subject, NULL), info[5]);
+        CAssertEqual(MYBERSliceParse(&f.subjectPublicKeyInfo, NULL), info[6]);
+        CAssertEqual(MYBERSliceParse(&f.publicKeyAlgorithmOID, NULL), info[6][0][0]);
+        CAssertEqual(MYBERSliceParse(&f.signatureAlgorithmOID, NULL), root[1][0]);
+        size_t sigLength;
+        const uint8_t *sig = MYX509BitStringBytes(&f.signature, &sigLength);
+        CAssertEqual([NSData dataWithBytes: sig length: sigLength], [root[2] bits]);
+        CAssertEq(MYX509FieldIsPresent(&f.extensions), (info.count > 7));
+        CAssertEqual(MYBERParse(sliceEncoding(&f.tbsCertificate), NULL), root[0]);
+
+        // Truncating the data anywhere must make it fail:
+        for (size_t len = 0; len < cert.length; len += 1 + len/8)
+            CAssert(!MYX509DecodeCertificate(cert.bytes, len, &f, NULL));
+    }
+
+    // Wrong structure:
+    MYX509Fields f;
+    NSError *error = nil;
+    const uint8_t kNotACert[] = {0x30, 0x06,  0x30, 0x00,  0x30, 0x00,  0x03, 0x00};
+    CAssert(!MYX509DecodeCertificate(kNotACert, sizeof(kNotACert), &f, &error));
+    CAssertEqual(error.domain, MYASN1ErrorDomain);
+}
+
+
+TestCase(X509DecodeCRL) {
+    RequireTestCase(X509Decoder);
+    NSData *crl = [NSData dataWithContentsOfFile: @"testca.crl"];
+    CAssert(crl, @"Couldn't read testca.crl");
+    MYX509CRLFields f;
+    NSError *error = nil;
+    CAssert(MYX509DecodeCRL(crl.bytes, crl.length, &f, &error), @"Couldn't decode CRL: %@", error);
+    CAssertEq(f.version, 1u);
+    CAssert(f.nextUpdate > f.thisUpdate);
+    CAssert(MYX509FieldIsPresent(&f.extensions));
+
+    // Compare with the object tree:
+    NSArray *root = MYBERParse(crl, NULL);
+    NSArray *info = root[0];
+    CAssertEqual(MYBERSliceParse(&f.issuer, NULL), info[2]);
+    CAssertEqual([NSDate dateWithTimeIntervalSince1970: f.thisUpdate], info[3]);
+    CAssertEqual([NSDate dateWithTimeIntervalSince1970: f.nextUpdate], info[4]);
+    CAssertEqual(MYBERSliceParse(&f.signatureAlgorithmOID, NULL), root[1][0]);
+
+    NSArray *entries = info[5];
+    MYBERCursor cursor = MYBERSliceGetCursor(&f.revokedCertificates);
+    MYBERSlice serial;
+    NSTimeInterval date;
+    for (NSArray *entry in entries) {
+        CAssert(MYX509NextRevokedCertificate(&cursor, &serial, &date));
+        CAssertEqual(MYBERSliceParse(&serial, NULL), entry[0]);
+        CAssertEqual([NSDate dateWithTimeIntervalSince1970: date], entry[1]);
+    }
+    CAssert(!MYX509NextRevokedCertificate(&cursor, &serial, &date));
+    CAssertEq(entries.count, (NSUInteger)4);
+
+    for (size_t len = 0; len < crl.length; len += 1 + len/8)
+        CAssert(!MYX509DecodeCRL(crl.bytes, len, &f, NULL));
+    // A certificate isn't a CRL:
+    NSData *cert = [NSData dataWithContentsOfFile: @"testca.cer"];
+    CAssert(!MYX509DecodeCRL(cert.bytes, cert.length, &f, &error));
+    CAssertEqual(error.domain, MYASN1ErrorDomain);
+    // Nor is one whose version is a constructed INTEGER:
+    NSMutableData *badVersion = [crl mutableCopy];
+    CAssertEq(((uint8_t*)badVersion.mutableBytes)[8], (uint8_t)0x02);
+    ((uint8_t*)badVersion.mutableBytes)[8] = 0x22;
+    CAssert(!MYX509DecodeCRL(badVersion.bytes, badVersion.length, &f, NULL));
+}
+
+
+TestCase(X509DecodeOCSPResponse) {
+    RequireTestCase(X509Decoder);
+    NSData *data = [NSData dataWithContentsOfFile: @"testca_ocsp_revoked.der"];
+    CAssert(data, @"Couldn't read testca_ocsp_revoked.der");
+    MYX509OCSPResponseFields f;
+    NSError *error = nil;
+    CAssert(MYX509DecodeOCSPResponse(data.bytes, data.length, &f, &error),
+            @"Couldn't decode OCSP response: %@", error);
+    CAssertEq(f.responseStatus, 0u);
+    CAssert(MYX509FieldIsPresent(&f.responderName));
+    CAssert(!MYX509FieldIsPresent(&f.responderKeyHash));
+    CAssert(!MYX509FieldIsPresent(&f.certs));
+
+    MYBERCursor cursor = MYBERSliceGetCursor(&f.responses);
+    MYX509OCSPSingleResponse single;
+    CAssert(MYX509NextOCSPSingleResponse(&cursor, &single));
+    CAssertEq(single.certStatus, 1u);
+    CAssertEq(single.serialNumber.length, (size_t)2);
+    CAssertEq(single.serialNumber.contents[0], (uint8_t)0x12);
+    CAssertEq(single.serialNumber.contents[1], (uint8_t)0x34);
+    CAssertEq(single.issuerKeyHash.length, (size_t)20);
+    CAssert(single.revocationTime > 0 && single.revocationTime < single.thisUpdate);
+    CAssert(single.nextUpdate > single.thisUpdate);
+    CAssertEq(single.thisUpdate, f.producedAt);
+    CAssertEq(single.revocationReason, -1);
+    CAssert(!MYX509NextOCSPSingleResponse(&cursor, &single));
+
+    data = [NSData dataWithContentsOfFile: @"testca_ocsp_good.der"];
+    CAssert(MYX509DecodeOCSPResponse(data.bytes, data.length, &f, &error),
+            @"Couldn't decode OCSP response: %@", error);
+    CAssert(MYX509FieldIsPresent(&f.certs));
+    cursor = MYBERSliceGetCursor(&f.responses);
+    CAssert(MYX509NextOCSPSingleResponse(&cursor, &single));
+    CAssertEq(single.certStatus, 0u);
+    CAssertEq(single.revocationTime, 0.0);
+
+    for (size_t len = 0; len < data.length; len += 1 + len/8)
+        CAssert(!MYX509DecodeOCSPResponse(data.bytes, len, &f, NULL));
+    // An error response has a status and nothing else:
+    static const uint8_t kTryLater[] = {0x30, 0x03, 0x0A, 0x01, 0x03};
+    NSData *tryLater = [NSData dataWithBytes: kTryLater length: sizeof(kTryLater)];
+    CAssert(MYX509DecodeOCSPResponse(tryLater.bytes, tryLater.length, &f, NULL));
+    CAssertEq(f.responseStatus, 3u);
+    // A CRL isn't an OCSP response:
+    NSData *crl = [NSData dataWithContentsOfFile: @"testca.crl"];
+    CAssert(!MYX509DecodeOCSPResponse(crl.bytes, crl.length, &f, &error));
+    CAssertEqual(error.domain, MYASN1ErrorDomain);
+}
+
+
+TestCase(X509DecoderBenchmark) {
+    RequireTestCase(X509Decoder);
+    static const int kIterations = 2000;
+    for (NSString *filename in @[@"selfsigned.cer", @"iphonedev.cer"]) {
+        NSData *cert = [NSData dataWithContentsOfFile: filename];
+        CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+        for (int i=0; i<kIterations; i++) {
+            @autoreleasepool {
+                MYBERParse(cert, NULL);
+            }
+        }
+        CFAbsoluteTime treeTime = CFAbsoluteTimeGetCurrent() - start;
+        start = CFAbsoluteTimeGetCurrent();
+        MYX509Fields f;
+        for (int i=0; i<kIterations; i++)
+            MYX509DecodeCertificate(cert.bytes, cert.length, &f, NULL);
+        CFAbsoluteTime decodeTime = CFAbsoluteTimeGetCurrent() - start;
+        Log(@"%@: MYBERParse %.2fus, MYX509DecodeCertificate %.2fus (%.1f MB/s)",
+            filename, treeTime/kIterations*1e6, decodeTime/kIterations*1e6,
+            cert.length * kIterations / decodeTime / 1e6);
+    }
+}
+
+
+
+/*
+ Copyright (c) 2009, Jens Alfke <jens@mooseyard.com>. All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification, are permitted
+ provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice, this list of conditions
+ and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions
+ and the following disclaimer in the documentation and/or other materials provided with the
+ distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRI-
+ BUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */